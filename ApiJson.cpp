@@ -0,0 +1,166 @@
+#include "ApiJson.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+const char *bookingStatusName(LabManager::BookingStatus status) {
+    switch (status) {
+        case LabManager::BookingStatus::Borrowed: return "borrowed";
+        case LabManager::BookingStatus::Current:  return "current";
+        case LabManager::BookingStatus::Upcoming: return "upcoming";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+json devicesJson(const LabManager &mgr, std::time_t now) {
+    json arr = json::array();
+    mgr.forEachDevice([&](const Device &dev) {
+        const Device *d = &dev;
+        json item{{"id", d->id}, {"name", d->name}, {"type", (int)d->type}, {"health", d->health}, {"status", (int)d->getDynamicStatus(now)}, {"allowStudent", d->allowStudentReserve}};
+        // 附加派生设备状态
+        if (d->type == DeviceType::Consumable) {
+            item["materialLevel"] = static_cast<const ConsumableDevice*>(d)->materialLevel;
+        } else if (d->type == DeviceType::Precision) {
+            item["calibration"] = static_cast<const PrecisionDevice*>(d)->calibration;
+        } else if (d->type == DeviceType::Power) {
+            item["temperature"] = static_cast<const PowerDevice*>(d)->temperature;
+        }
+        // 预约概览
+        json rs = json::array();
+        for (const auto &r : d->reservations) {
+            rs.push_back({{"userId", r.userId}, {"startTime", (long long)r.startTime}, {"endTime", (long long)r.endTime}, {"borrowed", r.borrowed}});
+        }
+        item["reservations"] = rs;
+        arr.push_back(item);
+    });
+    return arr;
+}
+
+json applicationsJson(const LabManager &mgr) {
+    json arr = json::array();
+    for (const auto &a : mgr.applications) {
+        arr.push_back({{"id", a.id}, {"userId", a.userId}, {"deviceId", a.deviceId}, {"startTime", (long long)a.start}, {"endTime", (long long)a.end}, {"reason", a.reason}});
+    }
+    return arr;
+}
+
+json notificationsJson(const std::vector<LabManager::Notification> &list) {
+    json arr = json::array();
+    for (const auto &n : list) arr.push_back({{"id", n.id}, {"message", n.message}, {"createdAt", (long long)n.createdAt}});
+    return arr;
+}
+
+json userReservationsJson(const std::vector<LabManager::UserReservation> &list) {
+    json arr = json::array();
+    for (const auto &b : list) {
+        arr.push_back({{"deviceId", b.deviceId}, {"deviceName", b.deviceName}, {"startTime", (long long)b.reservation.startTime},
+                       {"endTime", (long long)b.reservation.endTime}, {"borrowed", b.reservation.borrowed}, {"status", bookingStatusName(b.status)}});
+    }
+    return arr;
+}
+
+void writeReservation(JsonWriter &w, const Reservation &r) {
+    w.beginObject();
+    w.field("borrowed", r.borrowed);
+    w.field("endTime", (long long)r.endTime);
+    w.field("startTime", (long long)r.startTime);
+    w.field("userId", r.userId);
+    w.endObject();
+}
+
+// 键顺序：allowStudent, calibration, health, id, materialLevel, name, reservations, status, temperature, type
+void writeDevice(JsonWriter &w, const Device &d, std::time_t now) {
+    w.beginObject();
+    w.field("allowStudent", d.allowStudentReserve);
+    if (d.type == DeviceType::Precision) w.field("calibration", static_cast<const PrecisionDevice &>(d).calibration);
+    w.field("health", d.health);
+    w.field("id", d.id);
+    if (d.type == DeviceType::Consumable) w.field("materialLevel", static_cast<const ConsumableDevice &>(d).materialLevel);
+    w.field("name", d.name);
+    w.key("reservations");
+    w.beginArray();
+    for (const auto &r : d.reservations) writeReservation(w, r);
+    w.endArray();
+    w.field("status", (int)d.getDynamicStatus(now));
+    if (d.type == DeviceType::Power) w.field("temperature", static_cast<const PowerDevice &>(d).temperature);
+    w.field("type", (int)d.type);
+    w.endObject();
+}
+
+void writeApplication(JsonWriter &w, const LabManager::Application &a) {
+    w.beginObject();
+    w.field("deviceId", a.deviceId);
+    w.field("endTime", (long long)a.end);
+    w.field("id", a.id);
+    w.field("reason", a.reason);
+    w.field("startTime", (long long)a.start);
+    w.field("userId", a.userId);
+    w.endObject();
+}
+
+void writeNotification(JsonWriter &w, const LabManager::Notification &n) {
+    w.beginObject();
+    w.field("createdAt", (long long)n.createdAt);
+    w.field("id", n.id);
+    w.field("message", n.message);
+    w.endObject();
+}
+
+// 键顺序：borrowed, deviceId, deviceName, endTime, startTime, status
+void writeUserReservation(JsonWriter &w, const LabManager::UserReservation &b) {
+    w.beginObject();
+    w.field("borrowed", b.reservation.borrowed);
+    w.field("deviceId", b.deviceId);
+    w.field("deviceName", b.deviceName);
+    w.field("endTime", (long long)b.reservation.endTime);
+    w.field("startTime", (long long)b.reservation.startTime);
+    w.field("status", bookingStatusName(b.status));
+    w.endObject();
+}
+
+void writeDevicesResponse(std::string &out, const LabManager &mgr, std::time_t now) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("devices");
+    w.beginArray();
+    mgr.forEachDevice([&](const Device &d) { writeDevice(w, d, now); });
+    w.endArray();
+    w.field("ok", true);
+    w.endObject();
+}
+
+void writeApplicationsResponse(std::string &out, const LabManager &mgr) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("applications");
+    w.beginArray();
+    for (const auto &a : mgr.applications) writeApplication(w, a);
+    w.endArray();
+    w.field("ok", true);
+    w.endObject();
+}
+
+void writeNotificationsResponse(std::string &out, const std::vector<LabManager::Notification> &list) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("notifications");
+    w.beginArray();
+    for (const auto &n : list) writeNotification(w, n);
+    w.endArray();
+    w.field("ok", true);
+    w.endObject();
+}
+
+void writeUserReservationsResponse(std::string &out, const std::vector<LabManager::UserReservation> &list) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.field("ok", true);
+    w.key("reservations");
+    w.beginArray();
+    for (const auto &b : list) writeUserReservation(w, b);
+    w.endArray();
+    w.endObject();
+}
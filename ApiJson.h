@@ -0,0 +1,42 @@
+#pragma once
+// 读接口的 JSON 构造：设备列表、申请列表、通知列表、用户预约列表，供 HTTP 处理函数与基准程序共用。
+// 提供两套实现：基于 nlohmann::json DOM 的参考实现，以及基于 JsonWriter 的流式快速路径；
+// 两者输出逐字节一致（键按字典序输出，与 nlohmann 的 std::map 对象顺序相同）
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "JsonWriter.h"
+#include "LabManager.h"
+
+// 设备列表（含派生设备状态与预约概览），对应 GET /api/devices 的 devices 数组
+nlohmann::json devicesJson(const LabManager &mgr, std::time_t now);
+
+// 待审批申请列表，对应 GET /api/admin/applications 的 applications 数组
+nlohmann::json applicationsJson(const LabManager &mgr);
+
+// 通知列表，对应 GET /api/notifications 的 notifications 数组
+nlohmann::json notificationsJson(const std::vector<LabManager::Notification> &list);
+
+// 用户预约列表，对应 GET /api/users/{id}/reservations 的 reservations 数组（status 为 borrowed / current / upcoming）
+nlohmann::json userReservationsJson(const std::vector<LabManager::UserReservation> &list);
+
+// ---- 流式快速路径 ----
+
+// 单个对象的序列化
+void writeReservation(JsonWriter &w, const Reservation &r);
+void writeDevice(JsonWriter &w, const Device &d, std::time_t now);
+void writeApplication(JsonWriter &w, const LabManager::Application &a);
+void writeNotification(JsonWriter &w, const LabManager::Notification &n);
+void writeUserReservation(JsonWriter &w, const LabManager::UserReservation &b);
+
+// 完整响应体：等价于 json({{"ok", true}, {"devices", devicesJson(mgr, now)}}).dump()，结果追加到 out
+void writeDevicesResponse(std::string &out, const LabManager &mgr, std::time_t now);
+// 等价于 json({{"ok", true}, {"applications", applicationsJson(mgr)}}).dump()
+void writeApplicationsResponse(std::string &out, const LabManager &mgr);
+// 等价于 json({{"ok", true}, {"notifications", notificationsJson(list)}}).dump()
+void writeNotificationsResponse(std::string &out, const std::vector<LabManager::Notification> &list);
+// 等价于 json({{"ok", true}, {"reservations", userReservationsJson(list)}}).dump()（键按字典序，ok 在前）
+void writeUserReservationsResponse(std::string &out, const std::vector<LabManager::UserReservation> &list);
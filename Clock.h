@@ -0,0 +1,45 @@
+#pragma once
+// 时钟接口：LabManager 通过它获取“当前时间”，而不是直接调用 std::time(nullptr)。
+// 线上使用系统时钟；回放与仿真使用手动时钟，由驱动程序设定或推进时间，使结果可重复
+#include <atomic>
+#include <ctime>
+
+class IClock {
+public:
+    virtual ~IClock() = default;
+    virtual std::time_t now() const = 0;
+};
+
+// 系统时钟：即 std::time(nullptr)
+class SystemClock : public IClock {
+public:
+    std::time_t now() const override { return std::time(nullptr); }
+};
+
+// 手动时钟：时间只在 set / advance 时变化；可被驱动线程修改、被处理线程并发读取
+class ManualClock : public IClock {
+public:
+    explicit ManualClock(std::time_t start = 0) : t_(start) {}
+    std::time_t now() const override { return t_.load(std::memory_order_acquire); }
+    void set(std::time_t t) { t_.store(t, std::memory_order_release); }
+    void advance(std::time_t seconds) { t_.fetch_add(seconds, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<std::time_t> t_;
+};
+
+// 可固定的系统时钟：未固定时即系统时间；固定期间返回固定值。
+// 主从复制时主节点在每次修改前把时间固定为写入复制日志的时间，副本按日志时间重放，
+// 两边处理函数读到的“当前时间”相同（见 Replication.h）
+class PinnableClock : public IClock {
+public:
+    std::time_t now() const override {
+        std::time_t t = pinned_.load(std::memory_order_acquire);
+        return t ? t : std::time(nullptr);
+    }
+    void pin(std::time_t t) { pinned_.store(t, std::memory_order_release); }
+    void unpin() { pinned_.store(0, std::memory_order_release); }
+
+private:
+    std::atomic<std::time_t> pinned_{0};
+};
@@ -0,0 +1,90 @@
+#include "CommandPipeline.h"
+#include <shared_mutex>
+
+CommandPipeline::CommandPipeline(LabManager &mgr, size_t maxBatch)
+    : mgr_(mgr), maxBatch_(maxBatch ? maxBatch : 1), head_(&stub_), tail_(&stub_) {
+    writer_ = std::thread([this] { writerLoop(); });
+}
+
+// 停止前执行完已入队的命令：提交方都在等待 future，不能丢弃
+CommandPipeline::~CommandPipeline() {
+    stopping_.store(true);
+    {
+        std::lock_guard<std::mutex> lk(wakeMutex_);
+        sleeping_.store(false);
+    }
+    wakeCv_.notify_one();
+    writer_.join();
+}
+
+void CommandPipeline::push(Node *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = head_.exchange(node);
+    prev->next.store(node, std::memory_order_release);
+    if (sleeping_.exchange(false)) {
+        std::lock_guard<std::mutex> lk(wakeMutex_);
+        wakeCv_.notify_one();
+    }
+}
+
+// 单消费者出队；生产者交换 head_ 后尚未链接 next 的瞬间返回 nullptr，下一轮再取
+CommandPipeline::Node *CommandPipeline::pop() {
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+        if (!next) return nullptr;
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void CommandPipeline::writerLoop() {
+    std::vector<Node *> batch;
+    batch.reserve(maxBatch_);
+    for (;;) {
+        batch.clear();
+        while (batch.size() < maxBatch_) {
+            Node *n = pop();
+            if (!n) break;
+            batch.push_back(n);
+        }
+        if (batch.empty()) {
+            if (stopping_.load() && head_.load(std::memory_order_acquire) == tail_) return;
+            // 先声明休眠再复查队列：与 push 中的 exchange 配合，不会错过唤醒
+            sleeping_.store(true);
+            if (tail_->next.load() || head_.load() != tail_) {
+                sleeping_.store(false);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(wakeMutex_);
+            wakeCv_.wait(lk, [this] { return !sleeping_.load() || stopping_.load(); });
+            sleeping_.store(false);
+            continue;
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+            for (Node *n : batch) n->run(mgr_);
+            // 在锁内发布版本：持共享锁的读者读到的版本号与其看到的状态一致
+            version_.fetch_add(1, std::memory_order_release);
+        }
+        commands_.fetch_add(batch.size(), std::memory_order_relaxed);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        for (Node *n : batch) {
+            n->complete();
+            delete n;
+        }
+    }
+}
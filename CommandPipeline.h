@@ -0,0 +1,105 @@
+#pragma once
+// 单写者命令管线（actor 模式）：对 LabManager 的修改不再由各 HTTP 线程分别加独占锁执行，
+// 而是封装为命令提交到无锁 MPSC 队列，由唯一的写线程按到达顺序成批执行；提交方通过 future 等待结果。
+//   - 顺序确定：命令的执行顺序即入队顺序，轨迹 / 日志在写线程中追加，天然与状态变化一一对应
+//   - 减少锁竞争：写线程每批只取一次独占锁（与持共享锁的读请求互斥），批内命令连续执行，缓存保持热
+//   - 写线程每批结束时发布版本号，读请求据此判断缓存的只读快照是否仍然有效
+// 一个进程一个 LabManager 即一个分片，对应一个写线程。
+// 命令在写线程上执行，抛出的异常经 future 传回提交方；结果在锁释放并发布版本之后才交付
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "LabManager.h"
+
+class CommandPipeline {
+public:
+    // maxBatch：每批最多执行的命令数（批越大吞吐越高，队尾命令的等待越长）
+    explicit CommandPipeline(LabManager &mgr, size_t maxBatch = 64);
+    ~CommandPipeline();
+
+    CommandPipeline(const CommandPipeline &) = delete;
+    CommandPipeline &operator=(const CommandPipeline &) = delete;
+
+    // 提交命令 fn(LabManager &)，返回其结果的 future；可在任意线程并发调用，不阻塞
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<std::invoke_result_t<Fn &, LabManager &>> {
+        using R = std::invoke_result_t<Fn &, LabManager &>;
+        auto *node = new Task<Fn, R>(std::move(fn));
+        auto future = node->promise.get_future();
+        push(node);
+        return future;
+    }
+
+    // 已发布的状态版本：每执行完一批（且批内有命令）加一
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // 统计
+    std::uint64_t commands() const { return commands_.load(std::memory_order_relaxed); }
+    std::uint64_t batches() const { return batches_.load(std::memory_order_relaxed); }
+    size_t maxBatch() const { return maxBatch_; }
+
+private:
+    // 队列节点：run 在写线程持锁时执行，complete 在锁释放后交付结果
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        virtual ~Node() = default;
+        virtual void run(LabManager &) {}
+        virtual void complete() {}
+    };
+
+    template <typename Fn, typename R>
+    struct Task : Node {
+        Fn fn;
+        std::promise<R> promise;
+        std::conditional_t<std::is_void_v<R>, bool, std::optional<R>> result{};
+        std::exception_ptr error;
+
+        explicit Task(Fn f) : fn(std::move(f)) {}
+        void run(LabManager &mgr) override {
+            try {
+                if constexpr (std::is_void_v<R>) { fn(mgr); result = true; }
+                else result.emplace(fn(mgr));
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        void complete() override {
+            if (error) promise.set_exception(error);
+            else if constexpr (std::is_void_v<R>) promise.set_value();
+            else promise.set_value(std::move(*result));
+        }
+    };
+
+    LabManager &mgr_;
+    size_t maxBatch_;
+
+    // Vyukov 侵入式 MPSC 队列：生产者只做一次原子交换，消费者（写线程）独占 tail_
+    std::atomic<Node *> head_;
+    Node *tail_;
+    Node stub_;
+
+    // 写线程空闲时休眠；生产者只有在其休眠时才需要加锁唤醒
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+
+    std::atomic<std::uint64_t> version_{0};
+    std::atomic<std::uint64_t> commands_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::thread writer_;
+
+    void push(Node *node);
+    Node *pop();
+    void writerLoop();
+};
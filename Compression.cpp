@@ -0,0 +1,154 @@
+#include "Compression.h"
+#include <cstdlib>
+
+#ifdef LAB_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+#ifdef LAB_WITH_ZLIB
+// 线程私有压缩状态：gzip 与 deflate(zlib 封装) 的 windowBits 不同，各持有一个 z_stream；
+// 压缩级别变化时用 deflateParams 调整，线程退出时统一释放
+struct ThreadDeflater {
+    z_stream gz{};
+    z_stream zl{};
+    bool gzReady{false};
+    bool zlReady{false};
+    int gzLevel{-1};
+    int zlLevel{-1};
+    std::string scratch;
+
+    ~ThreadDeflater() {
+        if (gzReady) deflateEnd(&gz);
+        if (zlReady) deflateEnd(&zl);
+    }
+
+    z_stream *acquire(ContentCoding coding, int level) {
+        bool gzip = coding == ContentCoding::Gzip;
+        z_stream &zs = gzip ? gz : zl;
+        bool &ready = gzip ? gzReady : zlReady;
+        int &cur = gzip ? gzLevel : zlLevel;
+        if (!ready) {
+            if (deflateInit2(&zs, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return nullptr;
+            ready = true;
+            cur = level;
+            return &zs;
+        }
+        if (deflateReset(&zs) != Z_OK) return nullptr;
+        if (cur != level) {
+            if (deflateParams(&zs, level, Z_DEFAULT_STRATEGY) != Z_OK) return nullptr;
+            cur = level;
+        }
+        return &zs;
+    }
+};
+
+ThreadDeflater &threadDeflater() {
+    thread_local ThreadDeflater d;
+    return d;
+}
+
+bool runDeflate(z_stream &zs, const char *data, size_t len, std::string &out) {
+    out.resize(deflateBound(&zs, static_cast<uLong>(len)));
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs.avail_in = static_cast<uInt>(len);
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    return rc == Z_STREAM_END;
+}
+
+bool isJsonContentType(const std::string &ct) {
+    return ct.compare(0, 16, "application/json") == 0;
+}
+#endif
+
+} // namespace
+
+// 明确列出的编码优先于通配符：扫描全部条目，* 的结果只在该编码没有单独列出时采用
+// （"*;q=0, gzip" 接受 gzip，"gzip;q=0, *" 不接受 gzip）
+bool acceptsEncoding(const std::string &header, const std::string &coding) {
+    int wildcard = -1;   // -1 未出现，否则为 * 是否可接受
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = header.find(',', pos);
+        if (end == std::string::npos) end = header.size();
+        std::string token = header.substr(pos, end - pos);
+        pos = end + 1;
+        size_t semi = token.find(';');
+        std::string name = token.substr(0, semi);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name != coding && name != "*") continue;
+        bool ok = true;
+        if (semi != std::string::npos) {
+            size_t q = token.find("q=", semi);
+            if (q != std::string::npos) ok = std::atof(token.c_str() + q + 2) > 0.0;
+        }
+        if (name == coding) return ok;
+        wildcard = ok ? 1 : 0;
+    }
+    return wildcard == 1;
+}
+
+ContentCoding negotiateCoding(const std::string &acceptEncoding) {
+    if (acceptEncoding.empty()) return ContentCoding::Identity;
+    if (acceptsEncoding(acceptEncoding, "gzip")) return ContentCoding::Gzip;
+    if (acceptsEncoding(acceptEncoding, "deflate")) return ContentCoding::Deflate;
+    return ContentCoding::Identity;
+}
+
+bool compressionAvailable() {
+#ifdef LAB_WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool compressWithThreadState(ContentCoding coding, int level, const char *data, size_t len, std::string &out) {
+#ifdef LAB_WITH_ZLIB
+    if (coding == ContentCoding::Identity) return false;
+    z_stream *zs = threadDeflater().acquire(coding, level);
+    return zs && runDeflate(*zs, data, len, out);
+#else
+    (void)coding; (void)level; (void)data; (void)len; (void)out;
+    return false;
+#endif
+}
+
+bool gzipOnce(const std::string &in, std::string &out, int level) {
+#ifdef LAB_WITH_ZLIB
+    z_stream zs{};
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    bool ok = runDeflate(zs, in.data(), in.size(), out);
+    deflateEnd(&zs);
+    return ok;
+#else
+    (void)in; (void)out; (void)level;
+    return false;
+#endif
+}
+
+bool compressResponse(const httplib::Request &req, httplib::Response &res, const CompressionConfig &cfg) {
+#ifdef LAB_WITH_ZLIB
+    if (!cfg.enabled || res.body.size() < cfg.threshold) return false;
+    if (res.has_header("Content-Encoding") || !isJsonContentType(res.get_header_value("Content-Type"))) return false;
+    ContentCoding coding = negotiateCoding(req.get_header_value("Accept-Encoding"));
+    if (coding == ContentCoding::Identity) return false;
+
+    // 压缩到线程私有的 scratch，再与 body 交换：旧 body 的缓冲区留给下一次请求复用
+    ThreadDeflater &d = threadDeflater();
+    if (!compressWithThreadState(coding, cfg.level, res.body.data(), res.body.size(), d.scratch)) return false;
+    if (d.scratch.size() >= res.body.size()) return false;
+    res.body.swap(d.scratch);
+    res.set_header("Content-Encoding", coding == ContentCoding::Gzip ? "gzip" : "deflate");
+    res.set_header("Vary", "Accept-Encoding");
+    return true;
+#else
+    (void)req; (void)res; (void)cfg;
+    return false;
+#endif
+}
@@ -0,0 +1,35 @@
+#pragma once
+// 响应压缩：按 Accept-Encoding 协商 gzip / deflate，对超过阈值的 JSON 响应透明压缩；
+// 每个工作线程持有一份可复用的 zlib 状态（deflateReset 代替反复 init/end），热路径上不再分配压缩器
+
+#include <cstddef>
+#include <string>
+
+#include "httplib.h"
+
+enum class ContentCoding { Identity, Gzip, Deflate };
+
+// 压缩配置：threshold 以下的响应原样返回；level 为 zlib 压缩级别（1-9）
+struct CompressionConfig {
+    bool enabled{true};
+    size_t threshold{1024};
+    int level{6};
+};
+
+// 判断 Accept-Encoding 中某编码是否可接受（存在且 q 不为 0；未单独列出时按通配符 * 判断）
+bool acceptsEncoding(const std::string &header, const std::string &coding);
+
+// 从 Accept-Encoding 选出服务端支持的编码：gzip 优先，其次 deflate
+ContentCoding negotiateCoding(const std::string &acceptEncoding);
+
+// 当前构建是否带 zlib 支持（LAB_WITH_ZLIB）
+bool compressionAvailable();
+
+// 使用当前线程的复用压缩状态压缩 data 到 out（out 原有内容被覆盖，容量被复用）
+bool compressWithThreadState(ContentCoding coding, int level, const char *data, size_t len, std::string &out);
+
+// 一次性 gzip 压缩（独立状态，供启动期预压缩等冷路径使用）
+bool gzipOnce(const std::string &in, std::string &out, int level);
+
+// 对已写入 res.body 的响应按配置与请求头进行透明压缩；返回是否实际压缩
+bool compressResponse(const httplib::Request &req, httplib::Response &res, const CompressionConfig &cfg);
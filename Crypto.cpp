@@ -0,0 +1,315 @@
+#include "Crypto.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// 增量式 SHA-256 上下文，HMAC 需要分两段输入（ipad 块 + 消息）
+struct Sha256 {
+    std::uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::uint8_t block[64];
+    size_t blockLen{0};
+    std::uint64_t totalLen{0};
+
+    void compress(const std::uint8_t *p) {
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (std::uint32_t(p[4 * i]) << 24) | (std::uint32_t(p[4 * i + 1]) << 16) | (std::uint32_t(p[4 * i + 2]) << 8) | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+        for (int i = 0; i < 64; ++i) {
+            std::uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRoundConstants[i] + w[i];
+            std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            k = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+    }
+
+    void update(const void *data, size_t len) {
+        const std::uint8_t *p = static_cast<const std::uint8_t *>(data);
+        totalLen += len;
+        if (blockLen) {
+            size_t take = std::min(len, sizeof(block) - blockLen);
+            std::memcpy(block + blockLen, p, take);
+            blockLen += take; p += take; len -= take;
+            if (blockLen < sizeof(block)) return;
+            compress(block);
+            blockLen = 0;
+        }
+        for (; len >= 64; p += 64, len -= 64) compress(p);
+        std::memcpy(block, p, len);
+        blockLen = len;
+    }
+
+    Sha256Digest finish() {
+        std::uint64_t bits = totalLen * 8;
+        std::uint8_t pad[72] = {0x80};
+        size_t padLen = (blockLen < 56 ? 56 : 120) - blockLen;
+        for (int i = 0; i < 8; ++i) pad[padLen + i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+        update(pad, padLen + 8);
+        Sha256Digest out;
+        for (int i = 0; i < 8; ++i) {
+            out[4 * i] = static_cast<std::uint8_t>(h[i] >> 24);
+            out[4 * i + 1] = static_cast<std::uint8_t>(h[i] >> 16);
+            out[4 * i + 2] = static_cast<std::uint8_t>(h[i] >> 8);
+            out[4 * i + 3] = static_cast<std::uint8_t>(h[i]);
+        }
+        return out;
+    }
+};
+
+// HMAC 的内外层哈希在密钥确定后即可预先吸收 ipad / opad 块，PBKDF2 每轮只需复制上下文
+struct HmacSha256 {
+    Sha256 inner, outer;
+
+    explicit HmacSha256(std::string_view key) {
+        std::uint8_t k[64] = {0};
+        if (key.size() > sizeof(k)) {
+            Sha256 kh;
+            kh.update(key.data(), key.size());
+            Sha256Digest d = kh.finish();
+            std::memcpy(k, d.data(), d.size());
+        } else {
+            std::memcpy(k, key.data(), key.size());
+        }
+        std::uint8_t pad[64];
+        for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x36;
+        inner.update(pad, sizeof(pad));
+        for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x5c;
+        outer.update(pad, sizeof(pad));
+    }
+
+    Sha256Digest mac(const void *a, size_t aLen, const void *b = nullptr, size_t bLen = 0) const {
+        Sha256 in = inner;
+        in.update(a, aLen);
+        if (bLen) in.update(b, bLen);
+        Sha256Digest ih = in.finish();
+        Sha256 out = outer;
+        out.update(ih.data(), ih.size());
+        return out.finish();
+    }
+};
+
+inline std::uint32_t rotl(std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+// Salsa20/8 核心（原地变换 16 个字）
+void salsa208(std::uint32_t b[16]) {
+    std::uint32_t x[16];
+    std::memcpy(x, b, sizeof(x));
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= rotl(x[0] + x[12], 7);   x[8] ^= rotl(x[4] + x[0], 9);
+        x[12] ^= rotl(x[8] + x[4], 13);  x[0] ^= rotl(x[12] + x[8], 18);
+        x[9] ^= rotl(x[5] + x[1], 7);    x[13] ^= rotl(x[9] + x[5], 9);
+        x[1] ^= rotl(x[13] + x[9], 13);  x[5] ^= rotl(x[1] + x[13], 18);
+        x[14] ^= rotl(x[10] + x[6], 7);  x[2] ^= rotl(x[14] + x[10], 9);
+        x[6] ^= rotl(x[2] + x[14], 13);  x[10] ^= rotl(x[6] + x[2], 18);
+        x[3] ^= rotl(x[15] + x[11], 7);  x[7] ^= rotl(x[3] + x[15], 9);
+        x[11] ^= rotl(x[7] + x[3], 13);  x[15] ^= rotl(x[11] + x[7], 18);
+        x[1] ^= rotl(x[0] + x[3], 7);    x[2] ^= rotl(x[1] + x[0], 9);
+        x[3] ^= rotl(x[2] + x[1], 13);   x[0] ^= rotl(x[3] + x[2], 18);
+        x[6] ^= rotl(x[5] + x[4], 7);    x[7] ^= rotl(x[6] + x[5], 9);
+        x[4] ^= rotl(x[7] + x[6], 13);   x[5] ^= rotl(x[4] + x[7], 18);
+        x[11] ^= rotl(x[10] + x[9], 7);  x[8] ^= rotl(x[11] + x[10], 9);
+        x[9] ^= rotl(x[8] + x[11], 13);  x[10] ^= rotl(x[9] + x[8], 18);
+        x[12] ^= rotl(x[15] + x[14], 7); x[13] ^= rotl(x[12] + x[15], 9);
+        x[14] ^= rotl(x[13] + x[12], 13); x[15] ^= rotl(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; ++i) b[i] += x[i];
+}
+
+// scryptBlockMix：in 与 out 各 2r 个 64 字节块，输出按偶数块在前、奇数块在后排列
+void blockMix(const std::uint32_t *in, std::uint32_t *out, std::uint32_t r) {
+    std::uint32_t x[16];
+    std::memcpy(x, in + (2 * r - 1) * 16, sizeof(x));
+    for (std::uint32_t i = 0; i < 2 * r; ++i) {
+        for (int j = 0; j < 16; ++j) x[j] ^= in[i * 16 + j];
+        salsa208(x);
+        std::memcpy(out + ((i & 1) * r + i / 2) * 16, x, sizeof(x));
+    }
+}
+
+// scryptROMix：先顺序填满 N 个块的表 v，再按数据相关的下标随机访问 N 次（内存困难性的来源）
+void roMix(std::uint8_t *block, std::uint32_t r, std::uint64_t N, std::vector<std::uint32_t> &v, std::vector<std::uint32_t> &xy) {
+    const size_t words = 32 * r;
+    std::uint32_t *x = xy.data();
+    std::uint32_t *y = xy.data() + words;
+    for (size_t i = 0; i < words; ++i) {
+        const std::uint8_t *p = block + 4 * i;
+        x[i] = std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+    }
+    for (std::uint64_t i = 0; i < N; ++i) {
+        std::memcpy(&v[i * words], x, words * 4);
+        blockMix(x, y, r);
+        std::swap(x, y);
+    }
+    for (std::uint64_t i = 0; i < N; ++i) {
+        std::uint64_t j = x[(2 * r - 1) * 16] & (N - 1);
+        const std::uint32_t *vj = &v[j * words];
+        for (size_t k = 0; k < words; ++k) x[k] ^= vj[k];
+        blockMix(x, y, r);
+        std::swap(x, y);
+    }
+    for (size_t i = 0; i < words; ++i) {
+        std::uint8_t *p = block + 4 * i;
+        p[0] = static_cast<std::uint8_t>(x[i]);
+        p[1] = static_cast<std::uint8_t>(x[i] >> 8);
+        p[2] = static_cast<std::uint8_t>(x[i] >> 16);
+        p[3] = static_cast<std::uint8_t>(x[i] >> 24);
+    }
+}
+
+const char kB64Url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+int b64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '-') return 62;
+    if (c == '_') return 63;
+    return -1;
+}
+
+} // namespace
+
+Sha256Digest sha256(const void *data, size_t len) {
+    Sha256 ctx;
+    ctx.update(data, len);
+    return ctx.finish();
+}
+
+Sha256Digest hmacSha256(std::string_view key, const void *data, size_t len) {
+    std::uint8_t k[64] = {0};
+    if (key.size() > sizeof(k)) {
+        Sha256Digest kh = sha256(key.data(), key.size());
+        std::memcpy(k, kh.data(), kh.size());
+    } else {
+        std::memcpy(k, key.data(), key.size());
+    }
+    std::uint8_t ipad[64], opad[64];
+    for (int i = 0; i < 64; ++i) { ipad[i] = k[i] ^ 0x36; opad[i] = k[i] ^ 0x5c; }
+
+    Sha256 inner;
+    inner.update(ipad, sizeof(ipad));
+    inner.update(data, len);
+    Sha256Digest ih = inner.finish();
+
+    Sha256 outer;
+    outer.update(opad, sizeof(opad));
+    outer.update(ih.data(), ih.size());
+    return outer.finish();
+}
+
+void pbkdf2HmacSha256(std::string_view password, const void *salt, size_t saltLen, std::uint32_t iterations, std::uint8_t *out, size_t outLen) {
+    HmacSha256 prf(password);
+    for (std::uint32_t blockIndex = 1; outLen > 0; ++blockIndex) {
+        std::uint8_t be[4] = {static_cast<std::uint8_t>(blockIndex >> 24), static_cast<std::uint8_t>(blockIndex >> 16),
+                              static_cast<std::uint8_t>(blockIndex >> 8), static_cast<std::uint8_t>(blockIndex)};
+        Sha256Digest u = prf.mac(salt, saltLen, be, sizeof(be));
+        Sha256Digest t = u;
+        for (std::uint32_t i = 1; i < iterations; ++i) {
+            u = prf.mac(u.data(), u.size());
+            for (size_t k = 0; k < t.size(); ++k) t[k] ^= u[k];
+        }
+        size_t take = std::min(outLen, t.size());
+        std::memcpy(out, t.data(), take);
+        out += take;
+        outLen -= take;
+    }
+}
+
+bool scrypt(std::string_view password, const void *salt, size_t saltLen, std::uint64_t N, std::uint32_t r, std::uint32_t p, std::uint8_t *out, size_t outLen) {
+    if (N < 2 || (N & (N - 1)) != 0 || r == 0 || p == 0) return false;
+    if (static_cast<std::uint64_t>(r) * p >= (1u << 30) || N > (std::uint64_t(1) << 32) / r) return false;
+    const size_t blockBytes = 128 * static_cast<size_t>(r);
+    std::vector<std::uint8_t> b(blockBytes * p);
+    pbkdf2HmacSha256(password, salt, saltLen, 1, b.data(), b.size());
+    std::vector<std::uint32_t> v(static_cast<size_t>(N) * 32 * r);
+    std::vector<std::uint32_t> xy(64 * static_cast<size_t>(r));
+    for (std::uint32_t i = 0; i < p; ++i) roMix(b.data() + i * blockBytes, r, N, v, xy);
+    pbkdf2HmacSha256(password, b.data(), b.size(), 1, out, outLen);
+    return true;
+}
+
+bool constantTimeEqual(const void *a, const void *b, size_t len) {
+    const volatile std::uint8_t *x = static_cast<const volatile std::uint8_t *>(a);
+    const volatile std::uint8_t *y = static_cast<const volatile std::uint8_t *>(b);
+    std::uint8_t diff = 0;
+    for (size_t i = 0; i < len; ++i) diff |= x[i] ^ y[i];
+    return diff == 0;
+}
+
+std::string base64UrlEncode(const void *data, size_t len) {
+    const std::uint8_t *p = static_cast<const std::uint8_t *>(data);
+    std::string out;
+    out.reserve((len * 4 + 2) / 3);
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3) {
+        std::uint32_t v = (std::uint32_t(p[i]) << 16) | (std::uint32_t(p[i + 1]) << 8) | p[i + 2];
+        out.push_back(kB64Url[(v >> 18) & 63]);
+        out.push_back(kB64Url[(v >> 12) & 63]);
+        out.push_back(kB64Url[(v >> 6) & 63]);
+        out.push_back(kB64Url[v & 63]);
+    }
+    if (len - i == 1) {
+        std::uint32_t v = std::uint32_t(p[i]) << 16;
+        out.push_back(kB64Url[(v >> 18) & 63]);
+        out.push_back(kB64Url[(v >> 12) & 63]);
+    } else if (len - i == 2) {
+        std::uint32_t v = (std::uint32_t(p[i]) << 16) | (std::uint32_t(p[i + 1]) << 8);
+        out.push_back(kB64Url[(v >> 18) & 63]);
+        out.push_back(kB64Url[(v >> 12) & 63]);
+        out.push_back(kB64Url[(v >> 6) & 63]);
+    }
+    return out;
+}
+
+bool base64UrlDecode(std::string_view in, std::string &out) {
+    if (in.size() % 4 == 1) return false;
+    out.clear();
+    out.reserve(in.size() * 3 / 4);
+    std::uint32_t acc = 0;
+    int bits = 0;
+    for (char c : in) {
+        int v = b64Value(c);
+        if (v < 0) return false;
+        acc = (acc << 6) | static_cast<std::uint32_t>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+void randomBytes(void *out, size_t len) {
+    static thread_local std::random_device rd;
+    std::uint8_t *p = static_cast<std::uint8_t *>(out);
+    while (len) {
+        std::uint32_t v = rd();
+        size_t take = std::min(len, sizeof(v));
+        std::memcpy(p, &v, take);
+        p += take;
+        len -= take;
+    }
+}
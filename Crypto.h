@@ -0,0 +1,33 @@
+#pragma once
+// 自包含的密码学基础函数：SHA-256、HMAC-SHA256、PBKDF2、scrypt、常数时间比较、base64url 与随机字节。
+// 不引入 OpenSSL 等外部依赖，保持“单头文件库 + 标准库”即可构建
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using Sha256Digest = std::array<std::uint8_t, 32>;
+
+// SHA-256（FIPS 180-4）
+Sha256Digest sha256(const void *data, size_t len);
+
+// HMAC-SHA256（RFC 2104）
+Sha256Digest hmacSha256(std::string_view key, const void *data, size_t len);
+
+// PBKDF2-HMAC-SHA256（RFC 8018），输出 outLen 字节
+void pbkdf2HmacSha256(std::string_view password, const void *salt, size_t saltLen, std::uint32_t iterations, std::uint8_t *out, size_t outLen);
+
+// scrypt（RFC 7914）：内存开销约 128 * r * N 字节，N 须为 2 的幂；参数非法时返回 false
+bool scrypt(std::string_view password, const void *salt, size_t saltLen, std::uint64_t N, std::uint32_t r, std::uint32_t p, std::uint8_t *out, size_t outLen);
+
+// 常数时间比较：耗时只与长度有关，不因首个不同字节的位置而泄露信息
+bool constantTimeEqual(const void *a, const void *b, size_t len);
+
+// base64url（RFC 4648 §5，无填充）；解码遇到非法字符返回 false
+std::string base64UrlEncode(const void *data, size_t len);
+bool base64UrlDecode(std::string_view in, std::string &out);
+
+// 从系统随机源（std::random_device）读取随机字节
+void randomBytes(void *out, size_t len);
@@ -2,6 +2,7 @@
 // 设备类层次结构定义，提供多态接口与通用属性；不同设备类型通过覆写行为体现差异
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <optional>
@@ -18,7 +19,7 @@ public:
 
     // 通用属性
     int id{0};
-    std::string name;
+    std::string_view name; // 驻留于 LabManager::strings、设备目录映射或静态字面量，不单独持有存储
     int health{100}; // 健康度范围 0-100，归零视为损坏
     DeviceType type{DeviceType::Consumable};
     bool allowStudentReserve{true};
@@ -0,0 +1,173 @@
+#include "DeviceCatalog.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'L', 'A', 'B', 'C', 'A', 'T', '1', '\0'};
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kRecordSize = 16;
+
+std::uint32_t readU32(const std::uint8_t *p) {
+    return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+void putU32(std::string &out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+} // namespace
+
+DeviceCatalog::~DeviceCatalog() {
+    close();
+}
+
+bool DeviceCatalog::open(const std::string &path) {
+    close();
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    base_ = buffer_.data();
+    length_ = buffer_.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // 映射建立后即可关闭描述符
+    if (p == MAP_FAILED) return false;
+    base_ = static_cast<const std::uint8_t *>(p);
+    length_ = static_cast<size_t>(st.st_size);
+#endif
+    if (length_ < kHeaderSize || std::memcmp(base_, kMagic, sizeof(kMagic)) != 0) {
+        close();
+        return false;
+    }
+    size_t count = readU32(base_ + 8);
+    size_t strOffset = readU32(base_ + 12);
+    size_t strLen = readU32(base_ + 16);
+    if (kHeaderSize + count * kRecordSize > length_ || strOffset < kHeaderSize + count * kRecordSize || strOffset + strLen > length_) {
+        close();
+        return false;
+    }
+    count_ = count;
+    records_ = base_ + kHeaderSize;
+    strings_ = reinterpret_cast<const char *>(base_ + strOffset);
+    stringsLen_ = strLen;
+    return true;
+}
+
+void DeviceCatalog::close() {
+#ifdef _WIN32
+    buffer_.clear();
+#else
+    if (base_) munmap(const_cast<std::uint8_t *>(base_), length_);
+#endif
+    base_ = nullptr;
+    length_ = 0;
+    count_ = 0;
+    records_ = nullptr;
+    strings_ = nullptr;
+    stringsLen_ = 0;
+}
+
+int DeviceCatalog::idAt(size_t index) const {
+    return static_cast<int>(readU32(records_ + index * kRecordSize));
+}
+
+int DeviceCatalog::maxId() const {
+    return count_ ? idAt(count_ - 1) : 0;
+}
+
+DeviceCatalog::Entry DeviceCatalog::at(size_t index) const {
+    const std::uint8_t *r = records_ + index * kRecordSize;
+    Entry e;
+    e.id = static_cast<int>(readU32(r));
+    e.type = r[4] <= 2 ? static_cast<DeviceType>(r[4]) : DeviceType::Consumable;
+    e.allowStudent = r[5] != 0;
+    size_t offset = readU32(r + 8);
+    size_t len = readU32(r + 12);
+    if (offset <= stringsLen_ && len <= stringsLen_ - offset) e.name = std::string_view(strings_ + offset, len);
+    return e;
+}
+
+std::optional<size_t> DeviceCatalog::indexOf(int id) const {
+    if (count_ == 0) return std::nullopt;
+    // 常见情况：id 从首条起连续分配
+    long long guess = static_cast<long long>(id) - idAt(0);
+    if (guess >= 0 && static_cast<size_t>(guess) < count_ && idAt(static_cast<size_t>(guess)) == id) return static_cast<size_t>(guess);
+    size_t lo = 0, hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (idAt(mid) < id) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < count_ && idAt(lo) == id) return lo;
+    return std::nullopt;
+}
+
+bool DeviceCatalog::write(const std::string &path, std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.id < b.id; });
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].id == entries[i - 1].id) return false;
+    }
+
+    std::string strings;
+    std::unordered_map<std::string_view, std::uint32_t> interned;
+    interned.reserve(entries.size());
+    std::vector<std::uint32_t> offsets(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto it = interned.find(entries[i].name);
+        if (it != interned.end()) { offsets[i] = it->second; continue; }
+        offsets[i] = static_cast<std::uint32_t>(strings.size());
+        strings.append(entries[i].name);
+        interned.emplace(entries[i].name, offsets[i]);
+    }
+
+    std::string out(kMagic, sizeof(kMagic));
+    size_t strOffset = kHeaderSize + entries.size() * kRecordSize;
+    putU32(out, static_cast<std::uint32_t>(entries.size()));
+    putU32(out, static_cast<std::uint32_t>(strOffset));
+    putU32(out, static_cast<std::uint32_t>(strings.size()));
+    out.append(kHeaderSize - out.size(), '\0');
+    out.reserve(strOffset + strings.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry &e = entries[i];
+        putU32(out, static_cast<std::uint32_t>(e.id));
+        out.push_back(static_cast<char>(e.type));
+        out.push_back(static_cast<char>(e.allowStudent ? 1 : 0));
+        out.append(2, '\0');
+        putU32(out, offsets[i]);
+        putU32(out, static_cast<std::uint32_t>(e.name.size()));
+    }
+    out.append(strings);
+
+    // 先写临时文件再改名：运行中的服务器映射的旧文件不受影响
+    std::string tmp = path + ".tmp";
+    std::FILE *f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+// 只读设备目录：设备的静态元数据（ID、类型、名称、学生可否预约）保存在定长布局的二进制文件中，
+// 启动时整体 mmap，不解析、不逐条构造对象，打开耗时与目录规模无关。
+// 可变状态（健康度、磨损、预约）不在目录中：LabManager 在设备第一次被修改时才按目录条目
+// 构造 Device 对象放入 devicesById（覆盖层），之后以覆盖层为准；删除以墓碑记录。
+//
+// 文件格式（整数均为小端）：
+//   文件头 32 字节：魔数 "LABCAT1\0" | u32 条目数 | u32 字符串表偏移 | u32 字符串表字节数 | 12 字节保留
+//   条目表：每条 16 字节，按 id 升序 —— i32 id | u8 类型 | u8 学生可预约 | u16 保留 | u32 名称偏移 | u32 名称字节数
+//   字符串表：名称的 UTF-8 字节，相同名称只存一份（驻留），不以 '\0' 结尾
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Types.h"
+
+class DeviceCatalog {
+public:
+    struct Entry {
+        int id{0};
+        DeviceType type{DeviceType::Consumable};
+        bool allowStudent{true};
+        std::string_view name;
+    };
+
+    DeviceCatalog() = default;
+    ~DeviceCatalog();
+    DeviceCatalog(const DeviceCatalog &) = delete;
+    DeviceCatalog &operator=(const DeviceCatalog &) = delete;
+
+    // 映射目录文件：只校验文件头与各表边界（O(1)），条目内容在访问时校验
+    bool open(const std::string &path);
+    void close();
+
+    size_t size() const { return count_; }
+    int maxId() const;
+
+    // 第 i 条（按 id 升序）；名称越界的损坏条目返回空名称
+    Entry at(size_t index) const;
+    // 按 id 查找：id 连续时 O(1)，否则二分查找
+    std::optional<size_t> indexOf(int id) const;
+
+    // 生成目录文件：entries 的 id 须唯一，写入时按 id 排序并驻留名称
+    static bool write(const std::string &path, std::vector<Entry> entries);
+
+private:
+    const std::uint8_t *base_{nullptr};
+    size_t length_{0};
+    size_t count_{0};
+    const std::uint8_t *records_{nullptr};
+    const char *strings_{nullptr};
+    size_t stringsLen_{0};
+#ifdef _WIN32
+    std::vector<std::uint8_t> buffer_;  // Windows 下读入内存代替 mmap
+#endif
+
+    int idAt(size_t index) const;
+};
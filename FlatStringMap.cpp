@@ -0,0 +1,145 @@
+#include "FlatStringMap.h"
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAB_FLATMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 组内控制字节等于 tag 的槽位掩码（第 i 位对应第 i 个槽）
+std::uint32_t matchGroup(const std::uint8_t *group, std::uint8_t tag) {
+#ifdef LAB_FLATMAP_SSE2
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    std::uint32_t mask = 0;
+    for (size_t i = 0; i < FlatStringMap::kGroupSize; ++i) {
+        if (group[i] == tag) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// 组内空槽或墓碑（控制字节最高位为 1）的槽位掩码
+std::uint32_t matchFree(const std::uint8_t *group) {
+#ifdef LAB_FLATMAP_SSE2
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+    std::uint32_t mask = 0;
+    for (size_t i = 0; i < FlatStringMap::kGroupSize; ++i) {
+        if (group[i] & 0x80) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+int lowestBit(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+    while (!(mask & 1u)) { mask >>= 1; ++i; }
+    return i;
+#endif
+}
+
+} // namespace
+
+std::uint32_t FlatStringMap::hashOf(std::string_view key) {
+    size_t h = std::hash<std::string_view>{}(key);
+    return static_cast<std::uint32_t>(h ^ (static_cast<std::uint64_t>(h) >> 32));
+}
+
+// 哈希低 7 位作为控制字节，其余位决定起始组；按组做三角探测（组数为 2 的幂时可遍历全部组）
+const int *FlatStringMap::find(std::string_view key) const {
+    size_t slot = findSlot(key, hashOf(key));
+    return slot == npos ? nullptr : &entries_[slot].value;
+}
+
+size_t FlatStringMap::findSlot(std::string_view key, std::uint32_t h) const {
+    if (ctrl_.empty()) return npos;
+    std::uint8_t tag = static_cast<std::uint8_t>(h & 0x7F);
+    size_t group = (h >> 7) & groupMask_;
+    for (size_t step = 1;; ++step) {
+        const std::uint8_t *ctrl = ctrl_.data() + group * kGroupSize;
+        for (std::uint32_t m = matchGroup(ctrl, tag); m; m &= m - 1) {
+            size_t slot = group * kGroupSize + lowestBit(m);
+            const Entry &e = entries_[slot];
+            if (e.hash == h && e.key == key) return slot;
+        }
+        if (matchGroup(ctrl, kEmpty)) return npos;  // 该组有空槽：键不可能在更后面的组（墓碑不终止探测）
+        group = (group + step) & groupMask_;
+    }
+}
+
+bool FlatStringMap::insert(std::string_view key, int value) {
+    std::uint32_t h = hashOf(key);
+    if (findSlot(key, h) != npos) return false;
+    // 负载因子（占用 + 墓碑）上限 7/8；墓碑占多数时原尺寸重建即可
+    if ((size_ + tombstones_ + 1) * 8 > ctrl_.size() * 7) {
+        size_t groups = ctrl_.empty() ? 1 : groupMask_ + 1;
+        if ((size_ + 1) * 2 > ctrl_.size()) groups *= 2;
+        rehash(groups);
+    }
+    place(Entry{key, h, value});
+    ++size_;
+    return true;
+}
+
+// 组内有空槽时，没有任何键是越过该组探测后放下的（组满之后才会继续探测，而满组只会产生墓碑），
+// 此时直接置空不会截断其他键的探测链
+bool FlatStringMap::erase(std::string_view key) {
+    size_t slot = findSlot(key, hashOf(key));
+    if (slot == npos) return false;
+    const std::uint8_t *group = ctrl_.data() + slot / kGroupSize * kGroupSize;
+    if (matchGroup(group, kEmpty)) {
+        ctrl_[slot] = kEmpty;
+    } else {
+        ctrl_[slot] = kDeleted;
+        ++tombstones_;
+    }
+    entries_[slot] = Entry{};
+    --size_;
+    return true;
+}
+
+void FlatStringMap::reserve(size_t n) {
+    size_t groups = ctrl_.empty() ? 1 : groupMask_ + 1;
+    while (n * 8 > groups * kGroupSize * 7) groups *= 2;
+    if (groups != (ctrl_.empty() ? 0 : groupMask_ + 1)) rehash(groups);
+}
+
+// 放入探测链上第一个空槽或墓碑
+void FlatStringMap::place(const Entry &src) {
+    size_t group = (src.hash >> 7) & groupMask_;
+    for (size_t step = 1;; ++step) {
+        std::uint8_t *ctrl = ctrl_.data() + group * kGroupSize;
+        std::uint32_t free = matchFree(ctrl);
+        if (free) {
+            size_t slot = group * kGroupSize + lowestBit(free);
+            if (ctrl_[slot] == kDeleted) --tombstones_;
+            ctrl_[slot] = static_cast<std::uint8_t>(src.hash & 0x7F);
+            entries_[slot] = src;
+            return;
+        }
+        group = (group + step) & groupMask_;
+    }
+}
+
+// 扩容或回收墓碑：按预存的哈希放入新表（键只是视图，搬移不复制字符串）
+void FlatStringMap::rehash(size_t groups) {
+    std::vector<std::uint8_t> oldCtrl;
+    std::vector<Entry> oldEntries;
+    oldCtrl.swap(ctrl_);
+    oldEntries.swap(entries_);
+    ctrl_.assign(groups * kGroupSize, kEmpty);
+    entries_.assign(groups * kGroupSize, Entry{});
+    groupMask_ = groups - 1;
+    tombstones_ = 0;
+    for (size_t i = 0; i < oldCtrl.size(); ++i) {
+        if (!(oldCtrl[i] & 0x80)) place(oldEntries[i]);
+    }
+}
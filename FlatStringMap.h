@@ -0,0 +1,59 @@
+#pragma once
+// 开放寻址的扁平哈希表（string_view -> int），用于用户名索引 LabManager::usernameToId。
+// 布局参照 SwissTable：每个槽一个控制字节（空槽为 kEmpty，删除后为墓碑 kDeleted，占用时存哈希低 7 位），
+// 16 个槽为一组，查找时用 SSE2 一次比较整组控制字节，候选槽再比较预存的 32 位哈希与键内容；
+// 键与值连续存放在一个数组里，没有逐节点分配，命中通常只访问两条缓存行。
+// 键只保存视图，指向的存储须比表活得久（LabManager 中指向 strings）。
+// 负载因子（占用 + 墓碑）上限 7/8，超过时重建：存活元素不到一半容量时原尺寸重建以回收墓碑，否则加倍。
+// 无 SSE2 时退化为逐字节比较，行为相同
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class FlatStringMap {
+public:
+    FlatStringMap() = default;
+
+    // 查找：不存在时返回 nullptr（指针在下一次插入或删除前有效）
+    const int *find(std::string_view key) const;
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    // 插入：键已存在时不覆盖并返回 false
+    bool insert(std::string_view key, int value);
+
+    // 删除：键不存在时返回 false。所在组仍有空槽时直接置空（探测不会越过该组），否则留下墓碑
+    bool erase(std::string_view key);
+
+    // 预留至少 n 个元素的容量（批量导入前调用，避免逐次扩容）
+    void reserve(size_t n);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return ctrl_.size(); }
+
+    static constexpr size_t kGroupSize = 16;
+
+private:
+    struct Entry {
+        std::string_view key;
+        std::uint32_t hash{0};   // 预先算好的哈希：比较键之前先比哈希，扩容时不必重新哈希
+        int value{0};
+    };
+
+    static constexpr std::uint8_t kEmpty = 0x80;
+    static constexpr std::uint8_t kDeleted = 0xFE;   // 与 kEmpty 一样最高位为 1，占用槽的控制字节最高位为 0
+
+    std::vector<std::uint8_t> ctrl_;   // 组数 * 16，组数为 2 的幂
+    std::vector<Entry> entries_;
+    size_t size_{0};
+    size_t tombstones_{0};
+    size_t groupMask_{0};
+
+    static std::uint32_t hashOf(std::string_view key);
+    size_t findSlot(std::string_view key, std::uint32_t h) const;   // 不存在时返回 npos
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    void rehash(size_t groups);
+    void place(const Entry &e);
+};
@@ -0,0 +1,301 @@
+#include "Import.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+#include "json.hpp"     // 引入 nlohmann/json 单头文件（外部依赖）
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr size_t kMaxUsernameBytes = 64;
+constexpr size_t kMaxDeviceNameBytes = 128;
+constexpr std::string_view kHashPrefix = "$scrypt$";
+
+size_t resolveThreads(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return threads;
+}
+
+// 把 [0, n) 均分给若干线程执行 fn(begin, end, worker)；只有一段时在当前线程执行
+template <typename Fn>
+void parallelFor(size_t n, size_t threads, Fn fn) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    if (threads <= 1) {
+        fn(size_t(0), n, size_t(0));
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] { fn(n * t / threads, n * (t + 1) / threads, t); });
+    }
+    for (auto &w : workers) w.join();
+}
+
+std::string lower(std::string_view s) {
+    std::string out(s);
+    for (char &c : out) if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    return out;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+bool parseUserType(std::string_view s, UserType &out) {
+    std::string v = lower(trim(s));
+    if (v == "student" || v == "0") out = UserType::Student;
+    else if (v == "teacher" || v == "1") out = UserType::Teacher;
+    else if (v == "admin" || v == "2") out = UserType::Admin;
+    else return false;
+    return true;
+}
+
+bool parseDeviceType(std::string_view s, DeviceType &out) {
+    std::string v = lower(trim(s));
+    if (v == "consumable" || v == "0") out = DeviceType::Consumable;
+    else if (v == "precision" || v == "1") out = DeviceType::Precision;
+    else if (v == "power" || v == "2") out = DeviceType::Power;
+    else return false;
+    return true;
+}
+
+bool parseBool(std::string_view s, bool &out) {
+    std::string v = lower(trim(s));
+    if (v.empty()) out = true;  // 缺省允许学生预约，与 /api/admin/add 一致
+    else if (v == "true" || v == "1" || v == "yes" || v == "是") out = true;
+    else if (v == "false" || v == "0" || v == "no" || v == "否") out = false;
+    else return false;
+    return true;
+}
+
+bool hasControlChars(std::string_view s) {
+    return std::any_of(s.begin(), s.end(), [](char c) { return static_cast<unsigned char>(c) < 0x20; });
+}
+
+// 单个分块的解析结果（行号为块内相对行号，合并时加上前面各块的行数）
+struct ChunkResult {
+    ImportBatch batch;
+    size_t lines{0};
+};
+
+// CSV 行拆分：支持双引号包裹与 "" 转义，引号内的首尾空白原样保留；引号不闭合时返回 false
+bool splitCsv(std::string_view line, std::vector<std::string> &fields) {
+    fields.clear();
+    std::string cur;
+    bool quoted = false;
+    size_t quotedLen = std::string::npos;   // 字段以引号开头时引号内内容的长度
+    auto finish = [&] {
+        if (quotedLen == std::string::npos) fields.emplace_back(trim(cur));
+        else fields.push_back(cur.substr(0, quotedLen).append(trim(std::string_view(cur).substr(quotedLen))));
+        cur.clear();
+        quotedLen = std::string::npos;
+    };
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c != '"') cur.push_back(c);
+            else if (i + 1 < line.size() && line[i + 1] == '"') { cur.push_back('"'); ++i; }
+            else { quoted = false; quotedLen = cur.size(); }
+        } else if (c == '"' && quotedLen == std::string::npos && trim(cur).empty()) {
+            cur.clear();
+            quoted = true;
+        } else if (c == ',') {
+            finish();
+        } else {
+            cur.push_back(c);
+        }
+    }
+    if (quoted) return false;
+    finish();
+    return true;
+}
+
+// 校验并加入批次；失败时记录错误
+void addUser(ImportBatch &b, size_t line, UserType type, std::string username, std::string password) {
+    if (username.empty() || username.size() > kMaxUsernameBytes || hasControlChars(username)) {
+        b.errors.push_back({line, "用户名为空、过长或含控制字符"});
+    } else if (password.empty()) {
+        b.errors.push_back({line, "密码为空"});
+    } else if (password.compare(0, kHashPrefix.size(), kHashPrefix) == 0 && !isPasswordHash(password)) {
+        b.errors.push_back({line, "口令哈希格式无效（CSV 中须用双引号包裹）"});
+    } else {
+        b.users.push_back({type, std::move(username), std::move(password), line});
+    }
+}
+
+void addDevice(ImportBatch &b, size_t line, DeviceType type, std::string name, bool allowStudent) {
+    if (name.empty() || name.size() > kMaxDeviceNameBytes || hasControlChars(name)) {
+        b.errors.push_back({line, "设备名称为空、过长或含控制字符"});
+    } else {
+        b.devices.push_back({type, std::move(name), allowStudent, line});
+    }
+}
+
+void parseCsvLine(std::string_view line, size_t lineNo, ImportBatch &b, std::vector<std::string> &fields) {
+    if (!splitCsv(line, fields)) { b.errors.push_back({lineNo, "引号未闭合"}); return; }
+    fields.resize(std::max<size_t>(fields.size(), 5));
+    std::string kind = lower(fields[0]);
+    if (kind == "user") {
+        UserType type;
+        if (!parseUserType(fields[1], type)) { b.errors.push_back({lineNo, "用户类型无效"}); return; }
+        addUser(b, lineNo, type, std::move(fields[2]), std::move(fields[3]));
+    } else if (kind == "device") {
+        DeviceType type;
+        bool allow = true;
+        if (!parseDeviceType(fields[1], type)) { b.errors.push_back({lineNo, "设备类型无效"}); return; }
+        if (!parseBool(fields[4], allow)) { b.errors.push_back({lineNo, "allowStudent 取值无效"}); return; }
+        addDevice(b, lineNo, type, std::move(fields[2]), allow);
+    } else {
+        b.errors.push_back({lineNo, "kind 须为 user 或 device"});
+    }
+}
+
+// JSON 字段既可为字符串也可为数字（type）或布尔（allowStudent）
+std::string jsonText(const json &obj, const char *key) {
+    auto it = obj.find(key);
+    if (it == obj.end() || it->is_null()) return "";
+    if (it->is_string()) return it->get<std::string>();
+    if (it->is_boolean()) return it->get<bool>() ? "true" : "false";
+    if (it->is_number_integer()) return std::to_string(it->get<long long>());
+    return "\x01";  // 其他类型：令后续校验失败
+}
+
+void parseJsonLine(std::string_view line, size_t lineNo, ImportBatch &b) {
+    json obj = json::parse(line.begin(), line.end(), nullptr, false);
+    if (obj.is_discarded() || !obj.is_object()) { b.errors.push_back({lineNo, "JSON 格式错误"}); return; }
+    std::string kind = lower(jsonText(obj, "kind"));
+    if (kind == "user") {
+        UserType type;
+        if (!parseUserType(jsonText(obj, "type"), type)) { b.errors.push_back({lineNo, "用户类型无效"}); return; }
+        addUser(b, lineNo, type, jsonText(obj, "username"), jsonText(obj, "password"));
+    } else if (kind == "device") {
+        DeviceType type;
+        bool allow = true;
+        if (!parseDeviceType(jsonText(obj, "type"), type)) { b.errors.push_back({lineNo, "设备类型无效"}); return; }
+        if (!parseBool(jsonText(obj, "allowStudent"), allow)) { b.errors.push_back({lineNo, "allowStudent 取值无效"}); return; }
+        addDevice(b, lineNo, type, jsonText(obj, "name"), allow);
+    } else {
+        b.errors.push_back({lineNo, "kind 须为 user 或 device"});
+    }
+}
+
+void parseChunk(std::string_view chunk, bool jsonLines, bool first, ChunkResult &out) {
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos < chunk.size()) {
+        size_t end = chunk.find('\n', pos);
+        if (end == std::string_view::npos) end = chunk.size();
+        std::string_view line = trim(chunk.substr(pos, end - pos));
+        pos = end + 1;
+        size_t lineNo = ++out.lines;
+        if (line.empty() || line.front() == '#') continue;
+        if (jsonLines) {
+            parseJsonLine(line, lineNo, out.batch);
+        } else {
+            // 首行以 kind 开头视为表头
+            if (first && lineNo == 1 && lower(line.substr(0, 4)) == "kind") continue;
+            parseCsvLine(line, lineNo, out.batch, fields);
+        }
+    }
+}
+
+} // namespace
+
+ImportBatch parseImport(std::string_view data, size_t threads) {
+    if (data.substr(0, 3) == "\xEF\xBB\xBF") data.remove_prefix(3);  // UTF-8 BOM
+    size_t firstChar = data.find_first_not_of(" \t\r\n");
+    bool jsonLines = firstChar != std::string_view::npos && data[firstChar] == '{';
+
+    // 按换行切块：每块至少 64 KiB，块边界对齐到行首
+    threads = std::max<size_t>(1, std::min(resolveThreads(threads), data.size() / (64 << 10)));
+    std::vector<size_t> bounds{0};
+    for (size_t t = 1; t < threads; ++t) {
+        size_t pos = data.find('\n', std::max(bounds.back(), data.size() * t / threads));
+        if (pos == std::string_view::npos) break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(data.size());
+
+    std::vector<ChunkResult> chunks(bounds.size() - 1);
+    parallelFor(chunks.size(), chunks.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            parseChunk(data.substr(bounds[i], bounds[i + 1] - bounds[i]), jsonLines, i == 0, chunks[i]);
+        }
+    });
+
+    // 按块顺序合并（导入顺序即文件顺序，分配的ID与单线程解析一致），换算为绝对行号
+    ImportBatch out;
+    size_t users = 0, devices = 0;
+    for (const auto &c : chunks) { users += c.batch.users.size(); devices += c.batch.devices.size(); }
+    out.users.reserve(users);
+    out.devices.reserve(devices);
+    size_t lineOffset = 0;
+    for (auto &c : chunks) {
+        for (auto &u : c.batch.users) { u.line += lineOffset; out.users.push_back(std::move(u)); }
+        for (auto &d : c.batch.devices) { d.line += lineOffset; out.devices.push_back(std::move(d)); }
+        for (auto &e : c.batch.errors) { e.line += lineOffset; out.errors.push_back(std::move(e)); }
+        lineOffset += c.lines;
+    }
+
+    // 批内用户名重复：保留第一次出现
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(out.users.size());
+    for (const auto &u : out.users) {
+        if (!seen.insert(u.username).second) out.errors.push_back({u.line, "用户名在导入文件中重复：" + u.username});
+    }
+    std::stable_sort(out.errors.begin(), out.errors.end(), [](const ImportError &a, const ImportError &b) { return a.line < b.line; });
+    return out;
+}
+
+PreparedImport prepareImport(const ImportBatch &batch, StringPool &strings, const ScryptParams &params, size_t threads) {
+    PreparedImport out;
+    out.users.resize(batch.users.size());
+    parallelFor(batch.users.size(), resolveThreads(threads), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            const ImportUser &src = batch.users[i];
+            auto u = LabManager::makeUser(src.type);
+            u->username = src.username;  // 暂指向 batch，insertBulk 成功时复制进池
+            bool prehashed = std::string_view(src.password).substr(0, kHashPrefix.size()) == kHashPrefix;
+            u->passwordHash = prehashed ? src.password : hashPassword(src.password, params);
+            out.users[i] = std::move(u);
+        }
+    });
+    out.devices.reserve(batch.devices.size());
+    for (const auto &src : batch.devices) {
+        auto d = LabManager::makeDevice(src.type);
+        d->name = strings.intern(src.name);
+        d->allowStudentReserve = src.allowStudent;
+        out.devices.push_back(std::move(d));
+    }
+    return out;
+}
+
+std::string importLogPayload(const PreparedImport &prepared) {
+    // 每个字段都加引号："" 转义，名称中的逗号与首尾空白原样保留
+    auto quote = [](std::string &out, std::string_view s) {
+        out.push_back('"');
+        for (char c : s) {
+            if (c == '"') out.push_back('"');
+            out.push_back(c);
+        }
+        out.push_back('"');
+    };
+    std::string out;
+    for (const auto &u : prepared.users) {
+        out.append("user,").append(std::to_string(static_cast<int>(u->type))).push_back(',');
+        quote(out, u->username);
+        out.push_back(',');
+        quote(out, u->passwordHash);
+        out.append(",\n");
+    }
+    for (const auto &d : prepared.devices) {
+        out.append("device,").append(std::to_string(static_cast<int>(d->type))).push_back(',');
+        quote(out, d->name);
+        out.append(d->allowStudentReserve ? ",,true\n" : ",,false\n");
+    }
+    return out;
+}
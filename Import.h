@@ -0,0 +1,68 @@
+#pragma once
+// 批量导入用户与设备：用于新学期 / 新院系上线时一次性导入数万条记录。
+// 流程分三段，只有最后一段持有 LabManager::mutex：
+//   1. parseImport：按行切块，多线程并行解析与校验（CSV 或每行一个 JSON 对象的 JSON Lines）
+//   2. prepareImport：并行计算口令哈希、构造用户 / 设备对象（scrypt 开销大，务必在锁外）
+//   3. LabManager::insertBulk：在一次独占锁内预留容量并插入全部对象（用户名冲突时整体不生效）
+//
+// CSV 格式（首行可为表头；字段可用双引号包裹，"" 表示一个引号；字段内不允许换行）：
+//   kind,type,name,password,allowStudent
+//   user,student,alice,123456,
+//   device,precision,电子显微镜 B,,false
+// JSON Lines 格式（每行一个对象）：
+//   {"kind":"user","type":"teacher","username":"bob","password":"..."}
+//   {"kind":"device","type":2,"name":"离心机 Y","allowStudent":true}
+// type 可写名称（student / teacher / admin，consumable / precision / power）或数字 0-2；
+// password 以 "$scrypt$" 开头时视为已计算好的哈希直接使用（大批量导入建议离线预先计算），
+// 格式不完整的哈希报错而不是当作明文；哈希中含逗号，CSV 中须用双引号包裹；
+// allowStudent 缺省为 true。首个非空白字符为 '{' 时按 JSON Lines 解析，否则按 CSV 解析。
+// 通过 HTTP 上传时请带 Content-Type: text/csv 或 application/x-ndjson
+// （cpp-httplib 对 application/x-www-form-urlencoded 请求体限制为 8 KiB）
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LabManager.h"
+
+struct ImportUser {
+    UserType type{UserType::Student};
+    std::string username;
+    std::string password;   // 明文或 "$scrypt$" 哈希
+    size_t line{0};
+};
+
+struct ImportDevice {
+    DeviceType type{DeviceType::Consumable};
+    std::string name;
+    bool allowStudent{true};
+    size_t line{0};
+};
+
+struct ImportError {
+    size_t line{0};          // 1 起始的行号
+    std::string message;
+};
+
+struct ImportBatch {
+    std::vector<ImportUser> users;
+    std::vector<ImportDevice> devices;
+    std::vector<ImportError> errors;   // 按行号排序
+};
+
+// 解析并校验（含批内用户名重复检查）；threads 为 0 时取 CPU 核数
+ImportBatch parseImport(std::string_view data, size_t threads = 0);
+
+// 锁外准备：并行计算口令哈希、构造对象，并把设备名称驻留到 strings（传 LabManager::strings；
+// insertBulk 失败时不回收，但重复导入同一文件不会重复占用）。用户名暂指向 batch，
+// 由 insertBulk 在确认不重复后复制进池，因此 batch 须存活到 insertBulk 返回
+struct PreparedImport {
+    std::vector<std::shared_ptr<User>> users;
+    std::vector<std::shared_ptr<Device>> devices;
+};
+PreparedImport prepareImport(const ImportBatch &batch, StringPool &strings, const ScryptParams &params, size_t threads = 0);
+
+// 写入轨迹 / 复制日志 / 共识日志的负载：把准备好的对象按 CSV 重新序列化，口令为已计算的哈希。
+// 重放方 parseImport + prepareImport 得到同样的对象，但不再计算 scrypt（持锁重放时不做慢哈希），日志中也不留明文口令
+std::string importLogPayload(const PreparedImport &prepared);
@@ -0,0 +1,49 @@
+#include "JsonWriter.h"
+#include <cmath>
+
+#include "json.hpp"
+
+std::string &JsonWriter::threadBuffer() {
+    thread_local std::string buf;
+    buf.clear();
+    return buf;
+}
+
+// 浮点数：与 nlohmann 相同，非有限值输出 null，其余使用其 Grisu2 最短往返表示
+void JsonWriter::writeDouble(double v) {
+    if (!std::isfinite(v)) {
+        out_.append("null", 4);
+        return;
+    }
+    char buf[64];
+    char *end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), v);
+    out_.append(buf, static_cast<size_t>(end - buf));
+}
+
+// 字符串转义规则与 dump()（ensure_ascii = false）一致：转义引号、反斜杠与控制字符，UTF-8 原样输出
+void JsonWriter::writeString(std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out_.push_back('"');
+    size_t run = 0; // 连续无需转义的片段起点，整段追加以减少逐字节写入
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out_.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  out_.append("\\\"", 2); break;
+            case '\\': out_.append("\\\\", 2); break;
+            case '\b': out_.append("\\b", 2); break;
+            case '\t': out_.append("\\t", 2); break;
+            case '\n': out_.append("\\n", 2); break;
+            case '\f': out_.append("\\f", 2); break;
+            case '\r': out_.append("\\r", 2); break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out_.append(esc, 6);
+            }
+        }
+    }
+    out_.append(s.data() + run, s.size() - run);
+    out_.push_back('"');
+}
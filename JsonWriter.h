@@ -0,0 +1,83 @@
+#pragma once
+// 流式 JSON 写入器：直接把对象序列化到一个可复用的字符串缓冲区，不构建 nlohmann::json DOM；
+// 数字 / 字符串的输出格式与 nlohmann::json::dump() 完全一致（键顺序由调用方按字典序给出）。
+// 一致性以字符串是合法 UTF-8 为前提：写入器不校验编码，非法字节原样输出，而 dump() 对此抛出异常；
+// 写入的字符串来自已解析的请求或驻留池（均为合法 UTF-8），由调用方保证。
+// 容器嵌套不超过 kMaxDepth 层
+
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string &out) : out_(out) {}
+
+    void beginObject() { separate(); out_.push_back('{'); push(); }
+    void endObject() { pop(); out_.push_back('}'); }
+    void beginArray() { separate(); out_.push_back('['); push(); }
+    void endArray() { pop(); out_.push_back(']'); }
+
+    // 写出键名（键名必须是无需转义的 ASCII 标识符），随后紧跟一个值
+    void key(std::string_view k) {
+        separate();
+        out_.push_back('"');
+        out_.append(k.data(), k.size());
+        out_.append("\":", 2);
+        afterKey_ = true;
+    }
+
+    void value(long long v) { separate(); writeInt(v); }
+    void value(int v) { value(static_cast<long long>(v)); }
+    void value(bool v) { separate(); if (v) out_.append("true", 4); else out_.append("false", 5); }
+    void value(double v) { separate(); writeDouble(v); }
+    void value(std::string_view s) { separate(); writeString(s); }
+    void value(const char *s) { value(std::string_view(s)); }
+    void value(const std::string &s) { value(std::string_view(s)); }
+
+    // 键值对便捷写法
+    template <typename T>
+    void field(std::string_view k, const T &v) { key(k); value(v); }
+
+    // 当前线程的复用缓冲区：每次取用时清空内容但保留容量
+    static std::string &threadBuffer();
+
+private:
+    // 嵌套层数上限：超过时 push() 断言失败；不带断言的构建中 bitset 越界抛出 std::out_of_range
+    static constexpr int kMaxDepth = 32;
+
+    // 逗号分隔：同一容器内除第一个元素外都需要前置逗号；键之后的值不加逗号
+    void separate() {
+        if (afterKey_) { afterKey_ = false; return; }
+        if (depth_ > 0) {
+            if (hasItem_.test(static_cast<size_t>(depth_))) out_.push_back(',');
+            else hasItem_.set(static_cast<size_t>(depth_));
+        }
+    }
+    void push() {
+        assert(depth_ < kMaxDepth);
+        ++depth_;
+        hasItem_.reset(static_cast<size_t>(depth_));
+    }
+    void pop() { --depth_; }
+
+    // 快速整数输出：倒序写入栈上缓冲，避免 snprintf / to_string
+    void writeInt(long long v) {
+        char buf[24];
+        char *end = buf + sizeof(buf);
+        char *p = end;
+        unsigned long long u = v < 0 ? 0ULL - static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v);
+        do { *--p = static_cast<char>('0' + u % 10); u /= 10; } while (u != 0);
+        if (v < 0) *--p = '-';
+        out_.append(p, static_cast<size_t>(end - p));
+    }
+    void writeDouble(double v);
+    void writeString(std::string_view s);
+
+    std::string &out_;
+    int depth_{0};
+    std::bitset<kMaxDepth + 1> hasItem_;   // 第 d 位：第 d 层容器中是否已写出元素
+    bool afterKey_{false};
+};
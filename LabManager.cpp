@@ -1,63 +1,140 @@
 #include "LabManager.h"
 #include <algorithm>
 #include <functional>
+#include <tuple>
 
 // 演示数据初始化：创建三个角色用户与若干设备，并设置默认冲突策略
 // 这里展示了如何初始化系统的基础状态，包括用户对象和不同类型的设备对象
 void LabManager::seed() {
     // 用户初始化：创建 Student, Teacher, Admin 三种类型的用户对象
-    // 使用 std::make_shared 创建智能指针，管理用户对象的生命周期
-    {
-        auto u = std::make_shared<Student>();
-        u->id = nextUserId++;
-        u->username = "student1";
-        u->passwordHash = "123456"; // 演示用简单哈希（实际应更安全）
-        usersById[u->id] = u;
-        usernameToId[u->username] = u->id;
-    }
-    {
-        auto u = std::make_shared<Teacher>();
-        u->id = nextUserId++;
-        u->username = "teacher1";
-        u->passwordHash = "123456";
-        usersById[u->id] = u;
-        usernameToId[u->username] = u->id;
-    }
-    {
-        auto u = std::make_shared<Admin>();
-        u->id = nextUserId++;
-        u->username = "admin1";
-        u->passwordHash = "123456";
-        usersById[u->id] = u;
-        usernameToId[u->username] = u->id;
-    }
+    addUser(UserType::Student, "student1", "123456");
+    addUser(UserType::Teacher, "teacher1", "123456");
+    addUser(UserType::Admin, "admin1", "123456");
 
     // 设备初始化：根据规格创建不同类型的设备（ConsumableDevice, PrecisionDevice, PowerDevice）
     // 体现了多态性：不同类型的设备统一存储在 std::shared_ptr<Device> 容器中
-    { auto d = std::make_shared<ConsumableDevice>(); d->id = nextDeviceId++; d->name = "3D打印机 A"; d->allowStudentReserve = true; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PrecisionDevice>(); d->id = nextDeviceId++; d->name = "电子显微镜"; d->allowStudentReserve = false; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PowerDevice>(); d->id = nextDeviceId++; d->name = "离心机 X"; d->allowStudentReserve = true; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PowerDevice>(); d->id = nextDeviceId++; d->name = "GPU 集群"; d->allowStudentReserve = false; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PowerDevice>(); d->id = nextDeviceId++; d->name = "培养箱"; d->allowStudentReserve = true; devicesById[d->id] = d; }
-    { auto d = std::make_shared<ConsumableDevice>(); d->id = nextDeviceId++; d->name = "激光切割机"; d->allowStudentReserve = false; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PrecisionDevice>(); d->id = nextDeviceId++; d->name = "示波器"; d->allowStudentReserve = true; devicesById[d->id] = d; }
-    { auto d = std::make_shared<PrecisionDevice>(); d->id = nextDeviceId++; d->name = "光谱仪"; d->allowStudentReserve = false; devicesById[d->id] = d; }
-    { auto d = std::make_shared<ConsumableDevice>(); d->id = nextDeviceId++; d->name = "绘图仪"; d->allowStudentReserve = true; devicesById[d->id] = d; }
-    { auto d = std::make_shared<ConsumableDevice>(); d->id = nextDeviceId++; d->name = "化学试剂分配器"; d->allowStudentReserve = false; devicesById[d->id] = d; }
+    // 分片部署时每个分片只创建归属自己的演示设备，第 i 台设备在任何分片数下ID都是 i + 1
+    struct SeedDevice { DeviceType type; const char *name; bool allowStudent; };
+    static const SeedDevice seedDevices[] = {
+        {DeviceType::Consumable, "3D打印机 A", true},
+        {DeviceType::Precision, "电子显微镜", false},
+        {DeviceType::Power, "离心机 X", true},
+        {DeviceType::Power, "GPU 集群", false},
+        {DeviceType::Power, "培养箱", true},
+        {DeviceType::Consumable, "激光切割机", false},
+        {DeviceType::Precision, "示波器", true},
+        {DeviceType::Precision, "光谱仪", false},
+        {DeviceType::Consumable, "绘图仪", true},
+        {DeviceType::Consumable, "化学试剂分配器", false},
+    };
+    for (size_t i = 0; i < sizeof(seedDevices) / sizeof(seedDevices[0]); ++i) {
+        if (static_cast<int>(i % shardCount) != shardIndex) continue;
+        auto d = makeDevice(seedDevices[i].type);
+        d->id = nextDeviceId.fetch_add(shardCount, std::memory_order_relaxed);
+        d->name = seedDevices[i].name;
+        d->allowStudentReserve = seedDevices[i].allowStudent;
+        devicesById.insert(d->id, d);
+    }
 
     // 初始化冲突策略：使用默认策略（DefaultConflictPolicy）
     // 这里使用了策略模式，允许在未来轻松替换为其他冲突解决策略
     conflictPolicy = std::make_unique<DefaultConflictPolicy>();
 }
 
+// 分片：设备 / 申请 / 通知的首个ID为 shardIndex + 1，之后按 shardCount 跨步递增
+void LabManager::setShard(int index, int count) {
+    shardIndex = index;
+    shardCount = count;
+    nextDeviceId = index + 1;
+    nextApplicationId = index + 1;
+    nextNotificationId = index + 1;
+    nextHoldId = index + 1;
+}
+
+// 新增用户：根据类型创建具体的派生类对象（工厂模式思想），用户名需唯一
+// 使用 std::make_shared 创建智能指针，管理用户对象的生命周期
+int LabManager::addUser(UserType type, std::string_view username, const std::string &password) {
+    if (usernameToId.contains(username)) return -1;
+    std::shared_ptr<User> u = makeUser(type);
+    u->id = nextUserId.fetch_add(1, std::memory_order_relaxed);
+    u->username = strings.store(username);
+    u->passwordHash = hashPassword(password, passwordParams);
+    usersById.insert(u->id, u);
+    usernameToId.insert(u->username, u->id);
+    return u->id;
+}
+
+// 按类型构造用户对象：派生类的构造函数设置优先级与初始信用
+std::shared_ptr<User> LabManager::makeUser(UserType type) {
+    switch (type) {
+        case UserType::Student: return std::make_shared<Student>();
+        case UserType::Teacher: return std::make_shared<Teacher>();
+        case UserType::Admin:   return std::make_shared<Admin>();
+    }
+    return nullptr;
+}
+
+// 根据类型创建具体的派生类对象
+std::shared_ptr<Device> LabManager::makeDevice(DeviceType type) {
+    switch (type) {
+        case DeviceType::Consumable: return std::make_shared<ConsumableDevice>();
+        case DeviceType::Precision:  return std::make_shared<PrecisionDevice>();
+        case DeviceType::Power:      return std::make_shared<PowerDevice>();
+    }
+    return nullptr;
+}
+
+// 批量入库：先整体检查用户名冲突（全部成功或全部不变），再一次性预留容量并插入，
+// 临界区内只有ID分配与哈希表插入，对象构造与口令哈希都已在锁外完成
+bool LabManager::insertBulk(std::vector<std::shared_ptr<User>> &users, std::vector<std::shared_ptr<Device>> &devices,
+                            std::vector<std::string> *duplicates) {
+    bool ok = true;
+    for (const auto &u : users) {
+        if (!usernameToId.contains(u->username)) continue;
+        ok = false;
+        if (duplicates) duplicates->emplace_back(u->username);
+    }
+    if (!ok) return false;
+
+    // 分片部署：按位置轮流分配，本分片只保留自己的一份（各分片对同一批数据得到互补的子集）
+    if (shardCount > 1) {
+        size_t kept = 0;
+        for (size_t i = 0; i < devices.size(); ++i) {
+            if (static_cast<int>(i % shardCount) == shardIndex) devices[kept++] = std::move(devices[i]);
+        }
+        devices.resize(kept);
+    }
+
+    // 一次原子操作取走整段ID（设备ID按分片数跨步）
+    int userId = nextUserId.fetch_add(static_cast<int>(users.size()), std::memory_order_relaxed);
+    int deviceSpan = static_cast<int>(devices.size()) * shardCount;
+    int deviceId = nextDeviceId.fetch_add(deviceSpan, std::memory_order_relaxed);
+    usersById.reserve(users.size(), userId + static_cast<int>(users.size()));
+    usernameToId.reserve(usernameToId.size() + users.size());
+    devicesById.reserve(devices.size(), deviceId + deviceSpan);
+    for (auto &u : users) {
+        u->id = userId++;
+        u->username = strings.store(u->username);
+        usersById.insert(u->id, u);
+        usernameToId.insert(u->username, u->id);
+    }
+    for (auto &d : devices) {
+        d->id = deviceId;
+        deviceId += shardCount;
+        devicesById.insert(d->id, d);
+    }
+    return true;
+}
+
 // 用户认证：验证用户名和密码
 // 返回值使用 std::optional<int>，成功时返回用户ID，失败时返回 std::nullopt
-std::optional<int> LabManager::authenticate(const std::string &username, const std::string &password) {
-    auto it = usernameToId.find(username);
+std::optional<int> LabManager::authenticate(std::string_view username, const std::string &password) {
+    const int *id = usernameToId.find(username);
     // 用户名不存在
-    if (it == usernameToId.end()) return std::nullopt;
+    if (!id) return std::nullopt;
     
-    auto u = usersById[it->second];
+    // 只读查找：认证可在共享锁下并发执行
+    const User *u = usersById.get(*id);
     // 用户对象为空（异常情况）
     if (!u) return std::nullopt;
     
@@ -68,55 +145,125 @@ std::optional<int> LabManager::authenticate(const std::string &username, const s
     return std::nullopt;
 }
 
-// 获取用户对象：根据用户ID查找
-// 返回 std::shared_ptr<User>，若不存在则返回 nullptr
-std::shared_ptr<User> LabManager::getUser(int userId) {
-    auto it = usersById.find(userId);
-    if (it == usersById.end()) return nullptr;
-    return it->second;
+// 获取用户对象：根据用户ID查找，若不存在则返回 nullptr
+// 返回裸指针而非 shared_ptr 副本：预约冲突循环、归还、延长等热路径上不再有引用计数的原子增减
+User *LabManager::getUser(int userId) {
+    return usersById.get(userId);
+}
+
+const User *LabManager::getUser(int userId) const {
+    return usersById.get(userId);
+}
+
+// 按用户名查找用户对象：登录时在锁内取出，锁外校验口令（对象由 shared_ptr 保活）
+std::shared_ptr<User> LabManager::findUser(std::string_view username) const {
+    const int *id = usernameToId.find(username);
+    return id ? usersById.share(*id) : nullptr;
 }
 
 // 添加设备：根据类型参数创建特定的设备对象（工厂模式思想）
 // 参数：type-设备类型, name-设备名称, allowStudent-是否允许学生预约
-int LabManager::addDevice(DeviceType type, const std::string &name, bool allowStudent) {
-    std::shared_ptr<Device> d;
-    // 根据类型创建具体的派生类对象
-    switch (type) {
-        case DeviceType::Consumable: d = std::make_shared<ConsumableDevice>(); break;
-        case DeviceType::Precision:  d = std::make_shared<PrecisionDevice>();  break;
-        case DeviceType::Power:      d = std::make_shared<PowerDevice>();      break;
-    }
-    d->id = nextDeviceId++;
-    d->name = name;
+int LabManager::addDevice(DeviceType type, std::string_view name, bool allowStudent) {
+    std::shared_ptr<Device> d = makeDevice(type);
+    d->id = nextDeviceId.fetch_add(shardCount, std::memory_order_relaxed);
+    d->name = strings.intern(name);
     d->allowStudentReserve = allowStudent;
     // 存储基类指针：利用多态性统一管理不同类型的设备
-    devicesById[d->id] = d;
+    devicesById.insert(d->id, d);
     return d->id;
 }
 
+// 挂接只读目录：目录ID不得与已有设备重复，只能挂接一次（设备名称指向映射）；新增设备的ID从目录最大ID之后开始分配
+bool LabManager::attachCatalog(std::shared_ptr<const DeviceCatalog> c) {
+    if (!c || catalog || shardCount > 1) return false;
+    for (const auto &slot : devicesById) {
+        if (c->indexOf(slot.id)) return false;
+    }
+    catalog = std::move(c);
+    deletedCatalogIds.clear();
+    catalogMaterialized = 0;
+    nextDeviceId.store(std::max(nextDeviceId.load(), catalog->maxId() + 1));
+    return true;
+}
+
+// 原始状态的目录设备：每个线程每种类型复用一个对象，只改写元数据字段（名称直接指向目录映射）
+const Device &LabManager::pristineDevice(const DeviceCatalog::Entry &e) {
+    static thread_local std::shared_ptr<Device> prototypes[3] = {
+        makeDevice(DeviceType::Consumable), makeDevice(DeviceType::Precision), makeDevice(DeviceType::Power)};
+    Device &d = *prototypes[static_cast<int>(e.type)];
+    d.id = e.id;
+    d.name = e.name;
+    d.allowStudentReserve = e.allowStudent;
+    return d;
+}
+
+Device *LabManager::findDevice(int deviceId) {
+    if (Device *d = devicesById.get(deviceId)) return d;
+    if (!catalog || deletedCatalogIds.count(deviceId)) return nullptr;
+    auto idx = catalog->indexOf(deviceId);
+    if (!idx) return nullptr;
+    // 第一次修改：按目录条目构造对象放入覆盖层，此后以覆盖层为准
+    DeviceCatalog::Entry e = catalog->at(*idx);
+    std::shared_ptr<Device> d = makeDevice(e.type);
+    d->id = e.id;
+    d->name = e.name;
+    d->allowStudentReserve = e.allowStudent;
+    ++catalogMaterialized;
+    Device *raw = d.get();
+    devicesById.insert(deviceId, std::move(d));
+    return raw;
+}
+
+const Device *LabManager::peekDevice(int deviceId) const {
+    if (const Device *d = devicesById.get(deviceId)) return d;
+    if (!catalog || deletedCatalogIds.count(deviceId)) return nullptr;
+    auto idx = catalog->indexOf(deviceId);
+    return idx ? &pristineDevice(catalog->at(*idx)) : nullptr;
+}
+
+size_t LabManager::deviceCount() const {
+    size_t n = devicesById.size();
+    if (catalog) n += catalog->size() - catalogMaterialized - deletedCatalogIds.size();
+    return n;
+}
+
 // 删除设备：在删除前检查设备是否处于可删除状态
 // 返回 true 表示删除成功，false 表示失败（如设备正在使用中）
 bool LabManager::deleteDevice(int deviceId) {
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    std::time_t now = std::time(nullptr);
+    const Device *dev = peekDevice(deviceId);
+    if (!dev) return false;
+    std::time_t now = this->now();
     // 调用虚函数 canDelete：不同设备可能有不同的删除条件（如是否有未完成的预约）
     // 体现多态：运行时根据实际设备类型调用对应的检查逻辑
-    if (!it->second->canDelete(now)) return false;
-    return devicesById.erase(deviceId) > 0;
+    if (!dev->canDelete(now)) return false;
+    // 目录中的设备记墓碑，目录文件本身只读
+    if (catalog && catalog->indexOf(deviceId)) {
+        deletedCatalogIds.insert(deviceId);
+        if (devicesById.contains(deviceId)) --catalogMaterialized;
+    }
+    // 可删除的设备上仍可能有未开始的预约，随设备一起移出索引
+    for (const auto &r : dev->reservations) unindexReservation(r.userId, deviceId, r.startTime);
+    // 设备上的暂留一并释放（不再占用用户的暂留名额；时间轮中的到期项在到期时跳过）
+    auto held = holdsByDevice.find(deviceId);
+    if (held != holdsByDevice.end()) {
+        std::vector<int> ids = held->second;
+        for (int holdId : ids) eraseHold(holdId);
+    }
+    devicesById.erase(deviceId);
+    return true;
 }
 
 // 维护设备：对设备进行维护操作（如重置健康度、补充材料等）
 // 返回 true 表示维护成功，false 表示失败（如设备正在使用中）
 bool LabManager::maintainDevice(int deviceId) {
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    std::time_t now = std::time(nullptr);
+    Device *dev = findDevice(deviceId);
+    if (!dev) return false;
+    std::time_t now = this->now();
     // 调用虚函数 canMaintain：检查设备当前是否可维护
-    if (!it->second->canMaintain(now)) return false;
+    if (!dev->canMaintain(now)) return false;
     // 调用虚函数 maintain：执行具体的维护操作
     // 体现多态：不同设备执行不同的维护逻辑（如ConsumableDevice补充材料，PrecisionDevice校准）
-    it->second->maintain();
+    dev->maintain();
     return true;
 }
 
@@ -135,19 +282,18 @@ bool LabManager::reserve(int userId, int deviceId, std::time_t start, std::time_
 // 参数：bypassStudentRule - 是否绕过“学生不可预约特定设备”的规则（如管理员审批后的申请）
 bool LabManager::reserve(int userId, int deviceId, std::time_t start, std::time_t end, bool bypassStudentRule) {
     if (start >= end) return false;
-    std::time_t now = std::time(nullptr);
+    std::time_t now = this->now();
     // 允许开始时间略早于当前，容忍 120 秒，用于前端选择误差
     std::time_t adjStart = start;
     if (adjStart < now - 120) adjStart = now - 120;
     
     // 1. 用户检查：是否存在且有预约权限（调用虚函数 canReserve）
-    auto u = getUser(userId);
+    const User *u = getUser(userId);
     if (!u || !u->canReserve()) return false;
     
-    // 2. 设备检查：是否存在
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    auto &dev = it->second;
+    // 2. 设备检查：是否存在（只读查找，预约被拒绝时不把目录设备放入覆盖层）
+    const Device *dev = peekDevice(deviceId);
+    if (!dev) return false;
     
     // 3. 规则检查：除非显式绕过，否则检查学生是否被允许预约此设备
     if (!bypassStudentRule) {
@@ -158,6 +304,19 @@ bool LabManager::reserve(int userId, int deviceId, std::time_t start, std::time_
     if (dev->health <= 0) return false;
 
     // 5. 冲突处理：使用策略模式解决时间重叠
+    // 其他用户未到期的暂留：与既有预约同样交给冲突策略，可覆盖的在预约成功后删除
+    std::vector<int> holdsToDrop;
+    auto held = holdsByDevice.find(deviceId);
+    if (held != holdsByDevice.end()) {
+        for (int holdId : held->second) {
+            const Hold &h = holds.at(holdId);
+            if (h.userId == userId || h.expiresAt <= now || !isOverlap(adjStart, end, h.start, h.end)) continue;
+            const User *hu = getUser(h.userId);
+            ConflictDecision d = conflictPolicy && hu ? conflictPolicy->decide(u->type, hu->type, false) : ConflictDecision::RejectNew;
+            if (d == ConflictDecision::RejectNew) return false;
+            if (d == ConflictDecision::RemoveExisting) holdsToDrop.push_back(holdId);
+        }
+    }
     // 遍历设备当前的所有预约，检查是否有时间重叠
     std::vector<size_t> toRemove;
     for (size_t i = 0; i < dev->reservations.size(); ++i) {
@@ -165,7 +324,7 @@ bool LabManager::reserve(int userId, int deviceId, std::time_t start, std::time_
         // 重叠判断条件：!(新结束 <= 旧开始 || 新开始 >= 旧结束)
         bool overlap = !(end <= r.startTime || adjStart >= r.endTime);
         if (overlap) {
-            auto ru = getUser(r.userId);
+            const User *ru = getUser(r.userId);
             if (!ru) return false;
             
             // 核心逻辑：调用冲突策略对象 (IConflictPolicy) 决定如何处理
@@ -175,30 +334,38 @@ bool LabManager::reserve(int userId, int deviceId, std::time_t start, std::time_
             if (d == ConflictDecision::RejectNew) return false; // 策略决定拒绝新预约
             if (d == ConflictDecision::RemoveExisting) {
                 // 策略决定移除既有预约（例如教师优先于学生），记录并通知被移除的用户
-                notifications.push_back(Notification{ nextNotificationId++, r.userId, "您的预约已被教师优先占用，该设备对您暂不可用", std::time(nullptr) });
+                notifications.push_back(Notification{ nextNotificationId, r.userId, "您的预约已被教师优先占用，该设备对您暂不可用", now });
+                nextNotificationId += shardCount;
                 toRemove.push_back(i);
             }
         }
     }
     
+    // 确定要写入后才取可写对象：未修改的目录设备此时才放入覆盖层（其上没有预约，toRemove 为空）
+    Device *target = findDevice(deviceId);
+
     // 执行删除操作（从后向前删除，避免索引失效）
     std::sort(toRemove.begin(), toRemove.end());
     for (int i = static_cast<int>(toRemove.size()) - 1; i >= 0; --i) {
-        dev->reservations.erase(dev->reservations.begin() + toRemove[i]);
+        const auto &r = target->reservations[toRemove[i]];
+        unindexReservation(r.userId, deviceId, r.startTime);
+        target->reservations.erase(target->reservations.begin() + toRemove[i]);
     }
 
     // 6. 成功预约：添加新的预约记录
     Reservation nr; nr.userId = userId; nr.startTime = adjStart; nr.endTime = end; nr.borrowed = false; nr.actualStartTime = 0;
-    dev->reservations.push_back(nr);
+    target->reservations.push_back(nr);
+    indexReservation(userId, deviceId, adjStart);
+    scheduleReservationTimers(deviceId, nr, true);
+    for (int holdId : holdsToDrop) eraseHold(holdId);
     return true;
 }
 
 // 借用设备：用户开始使用已预约的设备
 // 作用：标记预约状态为“已借出”，并记录实际开始使用时间
 bool LabManager::borrow(int userId, int deviceId, std::time_t now) {
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    auto &dev = it->second;
+    Device *dev = findDevice(deviceId);
+    if (!dev) return false;
     if (dev->health <= 0) return false;
 
     // 查找当前时间对应的预约记录
@@ -219,9 +386,8 @@ bool LabManager::borrow(int userId, int deviceId, std::time_t now) {
 // 归还设备：用户结束使用
 // 作用：计算使用时长，应用磨损，处理逾期，并移除预约记录
 bool LabManager::returnDevice(int userId, int deviceId, std::time_t now) {
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    auto &dev = it->second;
+    Device *dev = findDevice(deviceId);
+    if (!dev) return false;
 
     // 找到当前用户的进行中预约（若无则尝试已借用但未归还的记录）
     auto idxOpt = dev->findActiveReservationIndex(now, userId);
@@ -242,13 +408,14 @@ bool LabManager::returnDevice(int userId, int deviceId, std::time_t now) {
     dev->applyWearAndTear(duration);
 
     // 2. 逾期处理：若当前时间超过预约结束时间，扣除用户信用分
-    auto u = getUser(userId);
+    User *u = getUser(userId);
     if (!u) return false;
     if (now > r.endTime) { u->deductCredit(10); }
 
     // 3. 结束流程：归还后删除该预约记录，释放时间段
     r.borrowed = false;
     r.actualStartTime = 0;
+    unindexReservation(userId, deviceId, r.startTime);
     dev->reservations.erase(dev->reservations.begin() + idx);
     return true;
 }
@@ -256,9 +423,8 @@ bool LabManager::returnDevice(int userId, int deviceId, std::time_t now) {
 // 延长预约：在设备使用过程中申请延长结束时间
 // 限制：只能延长不能缩短，且延长的时间段不能与其他人的预约冲突
 bool LabManager::extend(int userId, int deviceId, std::time_t newEnd) {
-    auto it = devicesById.find(deviceId);
-    if (it == devicesById.end()) return false;
-    auto &dev = it->second;
+    Device *dev = findDevice(deviceId);
+    if (!dev) return false;
 
     // 遍历查找该用户在此设备上的预约（假设同时最多一个）
     for (size_t i = 0; i < dev->reservations.size(); ++i) {
@@ -277,15 +443,25 @@ bool LabManager::extend(int userId, int deviceId, std::time_t newEnd) {
             }
             
             // 检查当前是否已逾期（在延长操作之前）
-            std::time_t now = std::time(nullptr);
+            std::time_t now = this->now();
+
+            // 其他用户未到期的暂留同样不能被延长覆盖
+            auto held = holdsByDevice.find(deviceId);
+            if (held != holdsByDevice.end()) {
+                for (int holdId : held->second) {
+                    const Hold &h = holds.at(holdId);
+                    if (h.userId != userId && h.expiresAt > now && isOverlap(r.startTime, newEnd, h.start, h.end)) return false;
+                }
+            }
             bool overdueBeforeExtend = now > r.endTime;
             
-            // 执行延长
+            // 执行延长：按新的结束时间重排提醒与逾期定时器（旧的到期时核对不符自动丢弃）
             r.endTime = newEnd;
+            scheduleReservationTimers(deviceId, r, false);
             
             // 如果在已逾期的情况下才延长，仍需扣除一定的信用分作为惩罚
             if (overdueBeforeExtend) {
-                auto u = getUser(userId);
+                User *u = getUser(userId);
                 if (u) { u->deductCredit(5); }
             }
             return true;
@@ -297,7 +473,8 @@ bool LabManager::extend(int userId, int deviceId, std::time_t newEnd) {
 // 提交特殊申请：当直接预约不满足条件时（如学生想预约限制设备），提交申请由管理员审批
 // 返回生成的申请ID
 int LabManager::apply(int userId, int deviceId, std::time_t start, std::time_t end, const std::string &reason) {
-    int id = nextApplicationId++;
+    int id = nextApplicationId;
+    nextApplicationId += shardCount;
     applications.push_back(Application{ id, userId, deviceId, start, end, reason });
     return id;
 }
@@ -332,3 +509,242 @@ std::vector<LabManager::Notification> LabManager::popNotifications(int userId) {
     notifications.erase(std::remove_if(notifications.begin(), notifications.end(), [&](const Notification &n){ return n.userId == userId; }), notifications.end());
     return out;
 }
+
+
+void LabManager::indexReservation(int userId, int deviceId, std::time_t start) {
+    reservationsByUser[userId].push_back(ReservationRef{ deviceId, start });
+}
+
+void LabManager::unindexReservation(int userId, int deviceId, std::time_t start) {
+    auto it = reservationsByUser.find(userId);
+    if (it == reservationsByUser.end()) return;
+    auto &refs = it->second;
+    auto pos = std::find_if(refs.begin(), refs.end(), [&](const ReservationRef &ref) { return ref.deviceId == deviceId && ref.start == start; });
+    if (pos == refs.end()) return;
+    *pos = refs.back();
+    refs.pop_back();
+    if (refs.empty()) reservationsByUser.erase(it);
+}
+
+void LabManager::rebuildReservationIndex() {
+    reservationsByUser.clear();
+    for (const auto &slot : devicesById) {
+        for (const auto &r : slot.value->reservations) indexReservation(r.userId, slot.id, r.startTime);
+    }
+}
+
+// 我的预约：逐条回到设备上取当前记录（设备按ID直接索引，每台设备只有进行中与未来的少量预约）
+std::vector<LabManager::UserReservation> LabManager::userReservations(int userId, std::time_t now) const {
+    std::vector<UserReservation> out;
+    auto it = reservationsByUser.find(userId);
+    if (it == reservationsByUser.end()) return out;
+    out.reserve(it->second.size());
+    for (const auto &ref : it->second) {
+        const Device *dev = devicesById.get(ref.deviceId);
+        if (!dev) continue;
+        auto r = std::find_if(dev->reservations.begin(), dev->reservations.end(),
+                              [&](const Reservation &x) { return x.userId == userId && x.startTime == ref.start; });
+        if (r == dev->reservations.end()) continue;
+        BookingStatus status;
+        if (r->borrowed) status = BookingStatus::Borrowed;
+        else if (r->endTime <= now) continue;
+        else status = r->startTime <= now ? BookingStatus::Current : BookingStatus::Upcoming;
+        out.push_back(UserReservation{ ref.deviceId, dev->name, *r, status });
+    }
+    std::sort(out.begin(), out.end(), [](const UserReservation &a, const UserReservation &b) {
+        return std::make_pair(a.reservation.startTime, a.deviceId) < std::make_pair(b.reservation.startTime, b.deviceId);
+    });
+    return out;
+}
+
+// 预约压缩：逐台设备把已过期的未借出预约移入归档并记爽约；其余预约保持原有顺序。
+// 扣分与通知按预约逐条进行，同一用户多次爽约分别计
+size_t LabManager::compactReservations(std::time_t before) {
+    size_t archived = 0;
+    std::time_t now = this->now();
+    for (const auto &slot : devicesById) {
+        Device &dev = *slot.value;
+        auto expired = [before](const Reservation &r) { return !r.borrowed && r.endTime < before; };
+        if (std::none_of(dev.reservations.begin(), dev.reservations.end(), expired)) continue;
+        for (const auto &r : dev.reservations) {
+            if (!expired(r)) continue;
+            reservationArchive.push_back(ArchivedReservation{ dev.id, r.userId, r.startTime, r.endTime });
+            unindexReservation(r.userId, dev.id, r.startTime);
+            if (User *u = getUser(r.userId)) {
+                u->deductCredit(kNoShowPenalty);
+                notifications.push_back(Notification{ nextNotificationId, r.userId, "您的预约已过期且未借用设备，按爽约扣除信用分 " + std::to_string(kNoShowPenalty), now });
+                nextNotificationId += shardCount;
+            }
+            ++archived;
+        }
+        dev.reservations.erase(std::remove_if(dev.reservations.begin(), dev.reservations.end(), expired), dev.reservations.end());
+    }
+    archivedTotal += archived;
+    while (reservationArchive.size() > archiveCapacity) reservationArchive.pop_front();
+    return archived;
+}
+
+// 开始提醒只按开始时间核对（end 记 0），延长不会使其重复；逾期定时器排在结束后第一个尚未经过的整周期
+void LabManager::scheduleReservationTimers(int deviceId, const Reservation &r, bool includeStart) {
+    if (includeStart) timers.schedule(r.startTime - kReminderLead, ReservationTimer{ deviceId, r.userId, r.startTime, 0, TimerKind::StartReminder });
+    timers.schedule(r.endTime - kReminderLead, ReservationTimer{ deviceId, r.userId, r.startTime, r.endTime, TimerKind::EndReminder });
+    std::time_t overdue = r.endTime + kOverdueInterval;
+    if (overdue <= timers.now()) overdue += ((timers.now() - overdue) / kOverdueInterval + 1) * kOverdueInterval;
+    timers.schedule(overdue, ReservationTimer{ deviceId, r.userId, r.startTime, r.endTime, TimerKind::Overdue });
+}
+
+void LabManager::rebuildTimers() {
+    timers.reset(timers.now());
+    holdExpiry.reset(timers.now());
+    for (const auto &slot : devicesById) {
+        for (const auto &r : slot.value->reservations) scheduleReservationTimers(slot.id, r, true);
+    }
+    for (const auto &entry : holds) holdExpiry.schedule(entry.second.expiresAt, entry.first);
+}
+
+std::time_t LabManager::nextTimerDue() const {
+    return std::min(timers.nextDue(), holdExpiry.nextDue());
+}
+
+// 处理到期定时器：同一批按（到期时刻, 设备, 用户, 开始, 结束, 类型）排序并去重，处理顺序与时间轮内部的排列无关
+// （重建过时间轮的副本与一直运行的节点生成相同的通知序列）；判断“是否已开始 / 已结束”以 to 为准
+size_t LabManager::advanceTimers(std::time_t to) {
+    // 到期的暂留直接删除（确认或放弃后已删除的跳过）
+    std::vector<TimingWheel<int>::Timer> expired;
+    holdExpiry.advance(to, expired);
+    for (const auto &t : expired) {
+        auto it = holds.find(t.value);
+        if (it != holds.end() && it->second.expiresAt <= to) eraseHold(t.value);
+    }
+
+    std::vector<TimingWheel<ReservationTimer>::Timer> fired;
+    timers.advance(to, fired);
+    if (fired.empty()) return 0;
+    auto key = [](const TimingWheel<ReservationTimer>::Timer &t) {
+        return std::make_tuple(t.due, t.value.deviceId, t.value.userId, t.value.start, t.value.end, t.value.kind);
+    };
+    std::sort(fired.begin(), fired.end(), [&](const auto &a, const auto &b) { return key(a) < key(b); });
+    fired.erase(std::unique(fired.begin(), fired.end(), [&](const auto &a, const auto &b) { return key(a) == key(b); }), fired.end());
+
+    size_t handled = 0;
+    for (const auto &t : fired) {
+        const ReservationTimer &e = t.value;
+        // 未修改的目录设备没有预约，只查覆盖层
+        const Device *dev = devicesById.get(e.deviceId);
+        if (!dev) continue;
+        auto it = std::find_if(dev->reservations.begin(), dev->reservations.end(),
+                               [&](const Reservation &r) { return r.userId == e.userId && r.startTime == e.start; });
+        if (it == dev->reservations.end()) continue;
+        const Reservation &r = *it;
+        std::string message;
+        switch (e.kind) {
+            case TimerKind::StartReminder:
+                if (r.borrowed || to >= r.startTime) continue;
+                message = "您预约的设备「" + std::string(dev->name) + "」即将开始，请按时借用";
+                break;
+            case TimerKind::EndReminder:
+                if (!r.borrowed || r.endTime != e.end || to >= r.endTime) continue;
+                message = "您借用的设备「" + std::string(dev->name) + "」即将到期，请按时归还或延长";
+                break;
+            case TimerKind::Overdue: {
+                if (!r.borrowed || r.endTime != e.end) continue;
+                if (User *u = getUser(e.userId)) u->deductCredit(kOverduePenalty);
+                message = "您借用的设备「" + std::string(dev->name) + "」已逾期未归还，扣除信用分 " + std::to_string(kOverduePenalty);
+                // 下一次：跳过推进期间已经经过的整周期（长时间未推进时不补扣）
+                std::time_t next = t.due + kOverdueInterval;
+                if (next <= to) next += ((to - next) / kOverdueInterval + 1) * kOverdueInterval;
+                timers.schedule(next, e);
+                break;
+            }
+        }
+        notifications.push_back(Notification{ nextNotificationId, e.userId, std::move(message), to });
+        nextNotificationId += shardCount;
+        ++handled;
+    }
+    return handled;
+}
+
+// 暂留：与 reserve 相同的用户 / 设备 / 健康度检查，但不修改任何预约；既有预约与其他用户的暂留
+// 只要有一个按冲突策略不可覆盖即失败
+int LabManager::hold(int userId, int deviceId, std::time_t start, std::time_t end) {
+    if (start >= end) return 0;
+    std::time_t now = this->now();
+    std::time_t adjStart = std::max(start, now - 120);
+    if (adjStart >= end) return 0;
+
+    const User *u = getUser(userId);
+    if (!u || !u->canReserve()) return 0;
+    auto mine = holdsByUser.find(userId);
+    if (mine != holdsByUser.end()) {
+        std::vector<int> ids = mine->second;
+        for (int holdId : ids) {
+            if (holds.at(holdId).expiresAt <= now) eraseHold(holdId);
+        }
+        mine = holdsByUser.find(userId);
+        if (mine != holdsByUser.end() && mine->second.size() >= static_cast<size_t>(kMaxHoldsPerUser)) return 0;
+    }
+    const Device *dev = peekDevice(deviceId);
+    if (!dev || dev->health <= 0) return 0;
+    if (u->type == UserType::Student && !dev->allowStudentReserve) return 0;
+
+    auto blocks = [&](UserType existingType, bool borrowed) {
+        return !conflictPolicy || conflictPolicy->decide(u->type, existingType, borrowed) == ConflictDecision::RejectNew;
+    };
+    for (const auto &r : dev->reservations) {
+        if (!isOverlap(adjStart, end, r.startTime, r.endTime)) continue;
+        const User *ru = getUser(r.userId);
+        if (!ru || blocks(ru->type, r.borrowed)) return 0;
+    }
+    auto held = holdsByDevice.find(deviceId);
+    if (held != holdsByDevice.end()) {
+        for (int holdId : held->second) {
+            const Hold &h = holds.at(holdId);
+            if (h.userId == userId || h.expiresAt <= now || !isOverlap(adjStart, end, h.start, h.end)) continue;
+            const User *hu = getUser(h.userId);
+            if (!hu || blocks(hu->type, false)) return 0;
+        }
+    }
+
+    Hold h{ nextHoldId, userId, deviceId, adjStart, end, now + kHoldTtl };
+    nextHoldId += shardCount;
+    insertHold(h);
+    holdExpiry.schedule(h.expiresAt, h.id);
+    return h.id;
+}
+
+LabManager::HoldOutcome LabManager::confirmHold(int userId, int holdId) {
+    auto it = holds.find(holdId);
+    if (it == holds.end() || it->second.userId != userId) return HoldOutcome::NotFound;
+    Hold h = it->second;
+    if (h.expiresAt <= now()) return HoldOutcome::Expired;
+    if (!reserve(userId, h.deviceId, h.start, h.end)) return HoldOutcome::Rejected;
+    eraseHold(holdId);
+    return HoldOutcome::Ok;
+}
+
+bool LabManager::releaseHold(int userId, int holdId) {
+    auto it = holds.find(holdId);
+    if (it == holds.end() || it->second.userId != userId) return false;
+    eraseHold(holdId);
+    return true;
+}
+
+void LabManager::insertHold(const Hold &h) {
+    holds.emplace(h.id, h);
+    holdsByDevice[h.deviceId].push_back(h.id);
+    holdsByUser[h.userId].push_back(h.id);
+}
+
+void LabManager::eraseHold(int holdId) {
+    auto it = holds.find(holdId);
+    if (it == holds.end()) return;
+    const Hold &h = it->second;
+    auto detach = [holdId](std::unordered_map<int, std::vector<int>> &index, int key) {
+        auto &ids = index[key];
+        ids.erase(std::find(ids.begin(), ids.end(), holdId));
+        if (ids.empty()) index.erase(key);
+    };
+    detach(holdsByDevice, h.deviceId);
+    detach(holdsByUser, h.userId);
+    holds.erase(it);
+}
@@ -1,39 +1,118 @@
 #pragma once
 // 系统核心控制器：封装用户、设备与预约的业务流程，提供统一的服务接口
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <vector>
 #include <string>
 #include <optional>
+#include <shared_mutex>
 #include <ctime>
 
 #include "User.h"
 #include "Device.h"
+#include "DeviceCatalog.h"
+#include "FlatStringMap.h"
 #include "ConflictPolicy.h"
+#include "Clock.h"
+#include "PasswordHash.h"
+#include "SlotMap.h"
+#include "StringPool.h"
+#include "TimingWheel.h"
 
 class LabManager {
 public:
-    // 用户与设备存储
-    std::unordered_map<int, std::shared_ptr<User>> usersById;
-    std::unordered_map<std::string, int> usernameToId;
-    std::unordered_map<int, std::shared_ptr<Device>> devicesById;
+    // 用户名与设备名称的存储：User::username、Device::name 与 usernameToId 的键都指向这里
+    // （设备名称去重驻留；用户名本身唯一，只复制一份）
+    StringPool strings;
 
-    // 自增ID计数器
-    int nextUserId{1};
-    int nextDeviceId{1};
+    // 用户与设备存储：按ID直接索引（见 SlotMap.h）
+    SlotMap<User> usersById;
+    FlatStringMap usernameToId;  // 开放寻址扁平表（见 FlatStringMap.h），以 string_view 查找
+    SlotMap<Device> devicesById;  // 挂接目录时为覆盖层：只含新增设备与被修改过的目录设备
+
+    // 只读设备目录（可选，见 DeviceCatalog.h）：未被修改过的目录设备不构造对象
+    std::shared_ptr<const DeviceCatalog> catalog;
+    std::unordered_set<int> deletedCatalogIds;  // 已删除的目录设备（墓碑）
+    size_t catalogMaterialized{0};              // 已构造进覆盖层的目录设备数
+
+    // 自增ID计数器：原子分配，取号本身不依赖 mutex（批量入库一次取走一段）
+    std::atomic<int> nextUserId{1};
+    std::atomic<int> nextDeviceId{1};
+
+    // 分片部署（见 ShardRouter.h）：设备按ID划分到 shardCount 个进程，本进程只持有
+    // (id - 1) % shardCount == shardIndex 的设备；设备、申请与通知的ID按分片数跨步分配，全局不重复，
+    // 路由进程据此由ID直接算出归属分片。用户在每个分片上完整保存一份（各分片以相同顺序导入）。
+    // 单进程部署即 0 / 1
+    int shardIndex{0};
+    int shardCount{1};
+    // 设置分片：须在 seed / 导入 / 新增设备之前调用
+    void setShard(int index, int count);
+    bool ownsDevice(int deviceId) const { return deviceId > 0 && (deviceId - 1) % shardCount == shardIndex; }
+
+    // 读写锁：LabManager 自身不做同步，并发调用方（HTTP 处理线程等）需持有该锁，
+    // 只读操作持共享锁，修改操作持独占锁
+    mutable std::shared_mutex mutex;
 
     // 初始化演示数据：创建默认用户与设备
     void seed();
 
-    // 鉴权登录：返回用户ID或空（失败）
-    std::optional<int> authenticate(const std::string &username, const std::string &password);
+    // 新增用户：返回用户ID，用户名已存在时返回 -1
+    int addUser(UserType type, std::string_view username, const std::string &password);
+
+    // 按类型构造用户 / 设备对象（不分配ID、不入库），批量导入时在锁外预先构造
+    static std::shared_ptr<User> makeUser(UserType type);
+    static std::shared_ptr<Device> makeDevice(DeviceType type);
+
+    // 批量入库：为预先构造的对象分配ID并插入各索引（调用方持独占锁）。用户名在此复制进 strings，
+    // 设备名称须已驻留（prepareImport 已处理）。分片部署时只保留第 i 个设备中 i % shardCount == shardIndex 的部分。
+    // 任一用户名与已有用户重复时不做任何修改，返回 false 并在 duplicates 中列出重复的用户名
+    bool insertBulk(std::vector<std::shared_ptr<User>> &users, std::vector<std::shared_ptr<Device>> &devices,
+                    std::vector<std::string> *duplicates = nullptr);
+
+    // 口令哈希参数：addUser 按此计算 scrypt 哈希；仿真 / 基准等批量建号的场景可调低
+    ScryptParams passwordParams;
+
+    // 鉴权登录：返回用户ID或空（失败）；同步计算 scrypt，HTTP 接口改为在锁外经 VerifyPool 校验
+    std::optional<int> authenticate(std::string_view username, const std::string &password);
+
+    // 用户查询：getUser 返回 LabManager 持有的对象的裸指针（不触碰引用计数），只在持有 mutex 期间使用；
+    // 跨锁使用请保存用户ID重新查找。findUser 返回 shared_ptr，供登录在锁外校验口令时保活
+    User *getUser(int userId);
+    const User *getUser(int userId) const;
+    std::shared_ptr<User> findUser(std::string_view username) const;
 
-    // 用户查询
-    std::shared_ptr<User> getUser(int userId);
+    // 挂接只读目录：目录ID与已有设备冲突或已挂接过目录时返回 false（设备名称指向映射，不可替换）；
+    // 目录ID连续编号，不能按分片跨步，分片部署下同样返回 false
+    bool attachCatalog(std::shared_ptr<const DeviceCatalog> c);
+
+    // 设备查找：覆盖层优先，其次按目录条目构造并放入覆盖层（会修改 devicesById，需持独占锁）。
+    // 返回的指针在 deleteDevice 之后失效；设备ID不复用，删除后按ID查找返回空，跨锁请保存设备ID
+    Device *findDevice(int deviceId);
+    // 只读查找：未修改的目录设备返回线程内复用的原始状态对象（下次调用前有效），可在共享锁下调用
+    const Device *peekDevice(int deviceId) const;
+    // 设备总数（覆盖层 + 未修改且未删除的目录设备）
+    size_t deviceCount() const;
+    // 遍历全部设备：先覆盖层，后未修改的目录设备（以原始状态对象呈现，引用只在回调内有效）
+    template <typename Fn>
+    void forEachDevice(Fn &&fn) const {
+        for (const auto &slot : devicesById) fn(static_cast<const Device &>(*slot.value));
+        if (!catalog) return;
+        bool overlaid = !devicesById.empty() || !deletedCatalogIds.empty();
+        for (size_t i = 0; i < catalog->size(); ++i) {
+            DeviceCatalog::Entry e = catalog->at(i);
+            if (overlaid && (devicesById.contains(e.id) || deletedCatalogIds.count(e.id))) continue;
+            fn(pristineDevice(e));
+        }
+    }
 
     // 设备管理
-    int addDevice(DeviceType type, const std::string &name, bool allowStudent);
+    int addDevice(DeviceType type, std::string_view name, bool allowStudent);
+    // 删除设备：借用中不可删除；设备上未开始的预约与暂留一并删除
     bool deleteDevice(int deviceId);
     bool maintainDevice(int deviceId);
 
@@ -44,6 +123,22 @@ public:
     bool returnDevice(int userId, int deviceId, std::time_t now);
     bool extend(int userId, int deviceId, std::time_t newEnd);
 
+    // 用户预约索引：用户ID -> 该用户各条预约的（设备ID, 开始时间），开始时间在预约存续期间不变，
+    // 同一用户在同一设备上的预约互不重叠，二者即可唯一确定一条预约。凡增删 Device::reservations 的业务方法
+    // （预约与抢占、归还、压缩、删除设备）同步维护，整体替换状态后由 rebuildReservationIndex 重建。
+    // 查询时按条目回到覆盖层设备核对（未修改的目录设备没有预约），借出标记与结束时间以设备上的记录为准
+    struct ReservationRef { int deviceId; std::time_t start; };
+    std::unordered_map<int, std::vector<ReservationRef>> reservationsByUser;
+    void indexReservation(int userId, int deviceId, std::time_t start);
+    void unindexReservation(int userId, int deviceId, std::time_t start);
+    void rebuildReservationIndex();
+
+    // 某用户的预约（“我的预约”）：借出中、进行中（now 落在时段内、未借出）与未开始的，按（开始时间, 设备ID）排序；
+    // 已结束且未借出、等待压缩归档的不返回。开销与该用户的预约数成正比，不遍历设备
+    enum class BookingStatus { Borrowed, Current, Upcoming };
+    struct UserReservation { int deviceId; std::string_view deviceName; Reservation reservation; BookingStatus status; };
+    std::vector<UserReservation> userReservations(int userId, std::time_t now) const;
+
     struct Application { int id; int userId; int deviceId; std::time_t start; std::time_t end; std::string reason; };
     int nextApplicationId{1};
     std::vector<Application> applications;
@@ -55,9 +150,74 @@ public:
     std::vector<Notification> notifications;
     std::vector<Notification> popNotifications(int userId);
 
+    // 归档层：结束时间已过且从未借出（爽约）的预约由 compactReservations 从设备上移到这里，
+    // 设备的预约列表只保留进行中与未来的预约，冲突检查、状态计算与设备列表不再随历史增长。
+    // 借出未还的预约留在设备上，由归还时的逾期扣分处理。归档超过 archiveCapacity 条时丢弃最早的记录
+    struct ArchivedReservation { int deviceId; int userId; std::time_t start; std::time_t end; };
+    std::deque<ArchivedReservation> reservationArchive;
+    size_t archiveCapacity{100000};
+    std::uint64_t archivedTotal{0};     // 累计归档条数（含已丢弃的）
+    static constexpr int kNoShowPenalty = 5;
+    // 压缩：把结束时间早于 before 且未借出的预约移入归档，每条扣预约人 kNoShowPenalty 信用分并通知；
+    // 返回归档条数。只遍历覆盖层中的设备（未修改的目录设备没有预约）
+    size_t compactReservations(std::time_t before);
+
+    // 预约提醒与逾期处理：reserve / extend 时为预约的开始、结束与逾期各排一个定时器（分层时间轮，见 TimingWheel.h），
+    // advanceTimers 推进到给定时刻并处理到期的定时器：
+    //   - 开始前 kReminderLead 秒：尚未借出时提醒预约人按时借用
+    //   - 结束前 kReminderLead 秒：借用中时提醒归还或延长
+    //   - 结束后每满 kOverdueInterval 秒：仍未归还时扣 kOverduePenalty 信用分并通知，随后排下一次
+    // 预约被归还、抢占、归档或延长后不取消定时器：到期时按（设备, 用户, 开始 / 结束时间）核对预约，不符的直接丢弃。
+    // 时间轮的当前时刻只由 advanceTimers 推进，到期时刻不晚于它的定时器不再加入，各副本据此得到相同的结果
+    enum class TimerKind : std::uint8_t { StartReminder, EndReminder, Overdue };
+    struct ReservationTimer { int deviceId; int userId; std::time_t start; std::time_t end; TimerKind kind; };
+    TimingWheel<ReservationTimer> timers;
+    static constexpr std::time_t kReminderLead = 600;
+    static constexpr std::time_t kOverdueInterval = 3600;
+    static constexpr int kOverduePenalty = 5;
+    // 推进到 to 并处理到期的定时器，返回产生了通知的定时器数
+    size_t advanceTimers(std::time_t to);
+    // 按现有预约重建时间轮（保持当前时刻），整体替换状态（如安装快照）之后调用
+    void rebuildTimers();
+    // 为一条预约排定时器；延长时 includeStart 为 false（开始提醒已排过）
+    void scheduleReservationTimers(int deviceId, const Reservation &r, bool includeStart);
+    // 下一个可能有定时器（预约定时器或暂留到期）到期的时刻，供调用方判断是否需要 advanceTimers
+    std::time_t nextTimerDue() const;
+
+    // 暂留（两阶段预约）：用户选定时段时先占住 kHoldTtl 秒，填完表单后确认为正式预约，或放弃 / 到期自动释放。
+    // 暂留与 Device::reservations 分开保存（不进入设备列表与预约冲突循环的热路径），未到期的暂留阻止其他用户
+    // 预约、延长或暂留重叠的时段（按冲突策略，与既有预约同样处理：教师可覆盖学生的暂留）。
+    // 到期判断以当前时间为准；到期的暂留由 advanceTimers 经 holdExpiry 时间轮清除（用户再次暂留时也先清除其到期的）。
+    // ID 与申请一样按分片数跨步
+    struct Hold { int id; int userId; int deviceId; std::time_t start; std::time_t end; std::time_t expiresAt; };
+    static constexpr std::time_t kHoldTtl = 120;
+    static constexpr int kMaxHoldsPerUser = 3;
+    int nextHoldId{1};
+    std::unordered_map<int, Hold> holds;
+    std::unordered_map<int, std::vector<int>> holdsByDevice;   // 设备ID -> 暂留ID
+    std::unordered_map<int, std::vector<int>> holdsByUser;     // 用户ID -> 暂留ID
+    TimingWheel<int> holdExpiry;                               // 到期时刻 -> 暂留ID（与 timers 一同推进）
+    // 暂留时段：检查与 reserve 相同（开始时间同样容忍 120 秒），重叠的既有预约按冲突策略须可覆盖；
+    // 成功返回暂留ID，失败返回 0
+    int hold(int userId, int deviceId, std::time_t start, std::time_t end);
+    enum class HoldOutcome { Ok, NotFound, Expired, Rejected };
+    // 确认暂留：按暂留的时段调用 reserve，成功后删除暂留；不是本人的暂留按不存在处理
+    HoldOutcome confirmHold(int userId, int holdId);
+    // 放弃暂留
+    bool releaseHold(int userId, int holdId);
+    void insertHold(const Hold &h);
+    void eraseHold(int holdId);
+
     // 面向对象：冲突策略
     std::unique_ptr<IConflictPolicy> conflictPolicy;
 
+    // 时钟：业务逻辑中的“当前时间”一律取自这里，回放 / 仿真时替换为 ManualClock
+    std::shared_ptr<IClock> clock{std::make_shared<SystemClock>()};
+    std::time_t now() const { return clock->now(); }
+
+    // 目录条目的原始状态视图（线程内复用）
+    static const Device &pristineDevice(const DeviceCatalog::Entry &e);
+
     // 工具方法：区间重叠判断
     static bool isOverlap(std::time_t s1, std::time_t e1, std::time_t s2, std::time_t e2);
 };
@@ -0,0 +1,211 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+long long wallClockMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+const char *levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info:  return "info";
+        case LogLevel::Warn:  return "warn";
+        case LogLevel::Error: return "error";
+    }
+    return "info";
+}
+
+// 定长行缓冲：写满后置 truncated 标记并忽略后续内容，保证不越界
+struct LineBuf {
+    char *p;
+    std::size_t cap;
+    std::size_t n{0};
+    bool truncated{false};
+
+    void put(char c) {
+        if (n < cap) p[n++] = c; else truncated = true;
+    }
+    void put(std::string_view s) {
+        if (n + s.size() > cap) { truncated = true; return; }
+        std::memcpy(p + n, s.data(), s.size());
+        n += s.size();
+    }
+    void putInt(long long v) {
+        char tmp[24];
+        int len = std::snprintf(tmp, sizeof(tmp), "%lld", v);
+        put(std::string_view(tmp, static_cast<std::size_t>(len)));
+    }
+    // JSON 字符串转义：引号、反斜杠与控制字符
+    void putEscaped(std::string_view s) {
+        put('"');
+        for (char ch : s) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (c == '"' || c == '\\') { put('\\'); put(ch); }
+            else if (c == '\n') put("\\n");
+            else if (c == '\r') put("\\r");
+            else if (c == '\t') put("\\t");
+            else if (c < 0x20) {
+                char tmp[8];
+                std::snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                put(std::string_view(tmp, 6));
+            } else put(ch);
+            if (truncated) return;
+        }
+        put('"');
+    }
+};
+
+} // namespace
+
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : slots_(new Slot[kCapacity]) {
+    for (std::size_t i = 0; i < kCapacity; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+LogLevel Logger::parseLevel(const char *s, LogLevel fallback) {
+    if (!s) return fallback;
+    std::string_view v(s);
+    if (v == "debug") return LogLevel::Debug;
+    if (v == "info")  return LogLevel::Info;
+    if (v == "warn")  return LogLevel::Warn;
+    if (v == "error") return LogLevel::Error;
+    return fallback;
+}
+
+void Logger::start(std::FILE *out) {
+    if (running_.exchange(true)) return;
+    out_ = out ? out : stdout;
+    writer_ = std::thread([this] { writerLoop(); });
+}
+
+void Logger::stop() {
+    if (!running_.exchange(false)) return;
+    if (writer_.joinable()) writer_.join();
+}
+
+bool Logger::isRedacted(std::string_view key) const {
+    for (const auto &k : redactedKeys_) if (key == k) return true;
+    return false;
+}
+
+// 固定一秒窗口计数限流：Error 级别不受限，保证故障信息不丢
+bool Logger::admit(LogLevel level, long long nowMs) {
+    unsigned limit = rateLimit_.load(std::memory_order_relaxed);
+    if (limit == 0 || level == LogLevel::Error) return true;
+    long long sec = nowMs / 1000;
+    long long w = windowSec_.load(std::memory_order_relaxed);
+    if (w != sec && windowSec_.compare_exchange_strong(w, sec, std::memory_order_relaxed)) {
+        windowCount_.store(0, std::memory_order_relaxed);
+    }
+    if (windowCount_.fetch_add(1, std::memory_order_relaxed) >= limit) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        suppressedTotal_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// 输出格式：{"ts":毫秒,"level":"info","event":"...",字段...}\n ；超长时截断到最后一个完整字段
+std::size_t Logger::format(char *buf, LogLevel level, long long nowMs, std::string_view event, std::initializer_list<LogField> fields) const {
+    static constexpr std::string_view kTail = ",\"truncated\":true}\n";
+    LineBuf b{buf, kLineMax - kTail.size()};
+    b.put("{\"ts\":"); b.putInt(nowMs);
+    b.put(",\"level\":\""); b.put(levelName(level)); b.put('"');
+    b.put(",\"event\":"); b.putEscaped(event);
+    std::size_t lastGood = b.n;
+    for (const auto &f : fields) {
+        b.put(','); b.putEscaped(f.key); b.put(':');
+        if (isRedacted(f.key)) b.put("\"***\"");
+        else if (f.kind == LogField::Kind::Str) b.putEscaped(f.str);
+        else if (f.kind == LogField::Kind::Bool) b.put(f.num ? "true" : "false");
+        else b.putInt(f.num);
+        if (b.truncated) break;
+        lastGood = b.n;
+    }
+    if (b.truncated) {
+        std::memcpy(buf + lastGood, kTail.data(), kTail.size());
+        return lastGood + kTail.size();
+    }
+    b.put("}\n");
+    return b.n;
+}
+
+void Logger::log(LogLevel level, std::string_view event, std::initializer_list<LogField> fields) {
+    if (!enabled(level)) return;
+    long long nowMs = wallClockMs();
+    if (!admit(level, nowMs)) return;
+
+    // Vyukov 有界 MPSC 入队：CAS 抢占槽位后直接在槽内格式化，发布时写入 seq
+    std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &slots_[pos & (kCapacity - 1)];
+        std::size_t seq = slot->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->len = static_cast<std::uint16_t>(format(slot->data, level, nowMs, event, fields));
+    slot->seq.store(pos + 1, std::memory_order_release);
+}
+
+// 单消费者出队：把当前可读的所有行追加到 batch，返回条数
+std::size_t Logger::drain(std::string &batch) {
+    std::size_t count = 0;
+    for (;;) {
+        Slot &slot = slots_[dequeuePos_ & (kCapacity - 1)];
+        std::size_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != dequeuePos_ + 1) break;
+        batch.append(slot.data, slot.len);
+        slot.seq.store(dequeuePos_ + kCapacity, std::memory_order_release);
+        ++dequeuePos_;
+        ++count;
+    }
+    return count;
+}
+
+void Logger::writerLoop() {
+    std::string batch;
+    batch.reserve(kCapacity * 128);
+    for (;;) {
+        bool stopping = !running_.load(std::memory_order_acquire);
+        batch.clear();
+        std::size_t n = drain(batch);
+
+        // 限流与丢弃的汇总信息由写线程补记，避免在调用方额外产生日志
+        std::uint64_t sup = suppressed_.exchange(0, std::memory_order_relaxed);
+        std::uint64_t drop = dropped_.load(std::memory_order_relaxed);
+        if (sup > 0 || drop != droppedReported_) {
+            char tmp[kLineMax];
+            std::size_t len = format(tmp, LogLevel::Warn, wallClockMs(), "log.loss",
+                                     {{"suppressed", sup}, {"dropped", drop - droppedReported_}});
+            batch.append(tmp, len);
+            droppedReported_ = drop;
+        }
+
+        if (!batch.empty()) {
+            std::fwrite(batch.data(), 1, batch.size(), out_);
+            std::fflush(out_);
+        }
+        if (stopping) break;
+        if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
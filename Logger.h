@@ -0,0 +1,118 @@
+#pragma once
+// 异步结构化日志：调用线程只把一条 JSON 行格式化进无锁环形缓冲区，由后台线程批量写出，
+// 避免 std::cout << std::endl 在请求路径上逐条刷新并在 stdout 锁上串行化所有工作线程
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 日志级别：低于当前级别的日志在调用方直接丢弃，不做任何格式化
+enum class LogLevel { Debug, Info, Warn, Error };
+
+// 日志字段：键 + 值（字符串 / 整数 / 布尔），只保存视图，调用方无需分配内存
+struct LogField {
+    enum class Kind { Str, Int, Bool };
+    std::string_view key;
+    Kind kind{Kind::Str};
+    std::string_view str;
+    long long num{0};
+
+    LogField(std::string_view k, std::string_view v) : key(k), kind(Kind::Str), str(v) {}
+    LogField(std::string_view k, const char *v) : key(k), kind(Kind::Str), str(v ? v : "") {}
+    LogField(std::string_view k, const std::string &v) : key(k), kind(Kind::Str), str(v) {}
+    LogField(std::string_view k, bool v) : key(k), kind(Kind::Bool), num(v ? 1 : 0) {}
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    LogField(std::string_view k, T v) : key(k), kind(Kind::Int), num(static_cast<long long>(v)) {}
+};
+
+class Logger {
+public:
+    // 进程内唯一实例：服务器各处共享同一个环形缓冲区与写线程
+    static Logger &instance();
+
+    // 启动后台写线程；out 为输出目标（默认 stdout）
+    void start(std::FILE *out = stdout);
+    // 停止写线程并写出缓冲区中剩余的日志
+    void stop();
+
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= this->level(); }
+
+    // 限流：每秒最多接受 perSecond 条非 Error 日志（0 表示不限），超出部分只计数
+    void setRateLimit(unsigned perSecond) { rateLimit_.store(perSecond, std::memory_order_relaxed); }
+
+    // 脱敏字段名：这些键的值一律输出为 "***"（需在 start 之前设置）
+    void setRedactedKeys(std::vector<std::string> keys) { redactedKeys_ = std::move(keys); }
+
+    // 记录一条日志：event 为事件名，fields 为附加字段；缓冲区满时直接丢弃并计数，绝不阻塞调用方
+    void log(LogLevel level, std::string_view event, std::initializer_list<LogField> fields = {});
+
+    std::uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    std::uint64_t suppressedCount() const { return suppressedTotal_.load(std::memory_order_relaxed); }
+
+    // 从字符串解析日志级别（debug/info/warn/error），无法识别时返回 fallback
+    static LogLevel parseLevel(const char *s, LogLevel fallback);
+
+private:
+    Logger();
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    static constexpr std::size_t kCapacity = 2048; // 必须为 2 的幂
+    static constexpr std::size_t kLineMax = 512;
+
+    // 环形缓冲区槽位：seq 为 Vyukov 有界队列的序号，data 存放已格式化好的一行
+    struct Slot {
+        std::atomic<std::size_t> seq{0};
+        std::uint16_t len{0};
+        char data[kLineMax];
+    };
+
+    bool isRedacted(std::string_view key) const;
+    bool admit(LogLevel level, long long nowMs);
+    std::size_t format(char *buf, LogLevel level, long long nowMs, std::string_view event, std::initializer_list<LogField> fields) const;
+    void writerLoop();
+    std::size_t drain(std::string &batch);
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::size_t> enqueuePos_{0};
+    alignas(64) std::size_t dequeuePos_{0};
+
+    std::atomic<LogLevel> level_{LogLevel::Info};
+    std::atomic<unsigned> rateLimit_{0};
+    std::atomic<long long> windowSec_{0};
+    std::atomic<unsigned> windowCount_{0};
+    std::atomic<std::uint64_t> suppressed_{0};
+    std::atomic<std::uint64_t> suppressedTotal_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::uint64_t droppedReported_{0};
+
+    std::vector<std::string> redactedKeys_;
+    std::FILE *out_{stdout};
+    std::atomic<bool> running_{false};
+    std::thread writer_;
+};
+
+// 便捷函数：与 Logger::instance().log(...) 等价
+inline void logDebug(std::string_view event, std::initializer_list<LogField> fields = {}) {
+    Logger &l = Logger::instance();
+    if (l.enabled(LogLevel::Debug)) l.log(LogLevel::Debug, event, fields);
+}
+inline void logInfo(std::string_view event, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Info, event, fields);
+}
+inline void logWarn(std::string_view event, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Warn, event, fields);
+}
+inline void logError(std::string_view event, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Error, event, fields);
+}
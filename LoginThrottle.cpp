@@ -0,0 +1,59 @@
+#include "LoginThrottle.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+LoginThrottle::Shard &LoginThrottle::shardFor(std::string_view username) {
+    return shards_[std::hash<std::string_view>{}(username) % kShards];
+}
+
+double LoginThrottle::refilled(const Entry &e, std::time_t now) const {
+    double elapsed = static_cast<double>(std::max<std::time_t>(0, now - e.updatedAt));
+    return std::min(config_.burst, e.tokens + elapsed / config_.refillSeconds);
+}
+
+bool LoginThrottle::acquire(std::string_view username, std::time_t now, int &retryAfter) {
+    Shard &shard = shardFor(username);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto it = shard.entries.find(std::string(username));
+    if (it == shard.entries.end()) {
+        // 分片已满时淘汰最久未更新的记录
+        size_t limit = std::max<size_t>(1, config_.maxEntries / kShards);
+        while (shard.entries.size() >= limit) {
+            shard.entries.erase(*shard.order.back());
+            shard.order.pop_back();
+        }
+        it = shard.entries.emplace(std::string(username), Entry{config_.burst - 1, now, {}}).first;
+        shard.order.push_front(&it->first);
+        it->second.order = shard.order.begin();
+        return true;
+    }
+    Entry &e = it->second;
+    e.tokens = refilled(e, now);
+    e.updatedAt = now;
+    shard.order.splice(shard.order.begin(), shard.order, e.order);
+    if (e.tokens < 1) {
+        retryAfter = std::max(1, static_cast<int>(std::ceil((1 - e.tokens) * config_.refillSeconds)));
+        return false;
+    }
+    e.tokens -= 1;
+    return true;
+}
+
+void LoginThrottle::succeeded(std::string_view username) {
+    Shard &shard = shardFor(username);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto it = shard.entries.find(std::string(username));
+    if (it == shard.entries.end()) return;
+    shard.order.erase(it->second.order);
+    shard.entries.erase(it);
+}
+
+size_t LoginThrottle::size() const {
+    size_t n = 0;
+    for (const auto &shard : shards_) {
+        std::lock_guard<std::mutex> lk(shard.mutex);
+        n += shard.entries.size();
+    }
+    return n;
+}
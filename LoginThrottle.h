@@ -0,0 +1,52 @@
+#pragma once
+// 按用户名的登录限流（令牌桶）：每次尝试消耗一个令牌，令牌按固定速率恢复，登录成功后清空记录。
+// 针对单个账号的在线猜测在连续失败几次后被拖慢到每 refillSeconds 一次，
+// 正常用户偶尔输错密码不受影响。用户名不论是否存在都计数，接口行为不泄露账号是否存在。
+// 记录条数有上限：每个分片按最近更新时间排成链表，满时淘汰最久未更新的一条（O(1)），
+// 大量随机用户名的尝试不会使内存无限增长；被淘汰的记录再次出现时按新记录处理
+
+#include <array>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct LoginThrottleConfig {
+    double burst{5};            // 连续尝试上限
+    double refillSeconds{30};   // 每恢复一次尝试机会所需秒数
+    size_t maxEntries{100000};  // 记录条数上限（按分片均分，满时淘汰最久未更新的条目）
+};
+
+class LoginThrottle {
+public:
+    explicit LoginThrottle(LoginThrottleConfig config = LoginThrottleConfig{}) : config_(config) {}
+
+    // 登录尝试前调用：允许时消耗一个令牌并返回 true；否则返回 false，retryAfter 为建议等待秒数
+    bool acquire(std::string_view username, std::time_t now, int &retryAfter);
+
+    // 登录成功：清除该用户名的记录
+    void succeeded(std::string_view username);
+
+    size_t size() const;
+
+private:
+    static constexpr size_t kShards = 16;
+    struct Entry {
+        double tokens;
+        std::time_t updatedAt;
+        std::list<const std::string *>::iterator order;   // 在 Shard::order 中的位置
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<const std::string *> order;   // 指向 entries 的键（节点地址稳定），最近更新的在前
+    };
+
+    LoginThrottleConfig config_;
+    std::array<Shard, kShards> shards_;
+
+    Shard &shardFor(std::string_view username);
+    double refilled(const Entry &e, std::time_t now) const;
+};
@@ -0,0 +1,76 @@
+#include "PasswordHash.h"
+#include <cstdlib>
+
+#include "Crypto.h"
+
+namespace {
+
+constexpr size_t kSaltLen = 16;
+constexpr size_t kHashLen = 32;
+constexpr std::string_view kPrefix = "$scrypt$";
+
+// 解析 "ln=14,r=8,p=1"；拒绝超出合理范围的参数，避免伪造的哈希串触发超大内存分配
+bool parseParams(std::string_view s, ScryptParams &out) {
+    int seen = 0;
+    while (!s.empty()) {
+        size_t comma = s.find(',');
+        std::string_view item = s.substr(0, comma);
+        s = comma == std::string_view::npos ? std::string_view() : s.substr(comma + 1);
+        size_t eq = item.find('=');
+        if (eq == std::string_view::npos) return false;
+        std::string key(item.substr(0, eq));
+        std::string value(item.substr(eq + 1));
+        char *end = nullptr;
+        long v = std::strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || v <= 0) return false;
+        if (key == "ln" && v <= 20) { out.logN = static_cast<int>(v); seen |= 1; }
+        else if (key == "r" && v <= 32) { out.r = static_cast<std::uint32_t>(v); seen |= 2; }
+        else if (key == "p" && v <= 16) { out.p = static_cast<std::uint32_t>(v); seen |= 4; }
+        else return false;
+    }
+    return seen == 7;
+}
+
+// 拆分 "$scrypt$参数$盐$哈希"；格式非法时返回 false
+bool decodeHash(std::string_view encoded, ScryptParams &params, std::string &salt, std::string &expected) {
+    if (encoded.substr(0, kPrefix.size()) != kPrefix) return false;
+    encoded.remove_prefix(kPrefix.size());
+    size_t d1 = encoded.find('$');
+    if (d1 == std::string_view::npos) return false;
+    size_t d2 = encoded.find('$', d1 + 1);
+    if (d2 == std::string_view::npos) return false;
+    if (!parseParams(encoded.substr(0, d1), params)) return false;
+    if (!base64UrlDecode(encoded.substr(d1 + 1, d2 - d1 - 1), salt) || salt.empty()) return false;
+    return base64UrlDecode(encoded.substr(d2 + 1), expected) && expected.size() == kHashLen;
+}
+
+} // namespace
+
+std::string hashPassword(std::string_view plain, const ScryptParams &params) {
+    std::uint8_t salt[kSaltLen];
+    randomBytes(salt, sizeof(salt));
+    std::uint8_t hash[kHashLen];
+    scrypt(plain, salt, sizeof(salt), std::uint64_t(1) << params.logN, params.r, params.p, hash, sizeof(hash));
+    std::string out(kPrefix);
+    out += "ln=" + std::to_string(params.logN) + ",r=" + std::to_string(params.r) + ",p=" + std::to_string(params.p);
+    out += '$';
+    out += base64UrlEncode(salt, sizeof(salt));
+    out += '$';
+    out += base64UrlEncode(hash, sizeof(hash));
+    return out;
+}
+
+bool verifyPasswordHash(std::string_view plain, std::string_view encoded) {
+    ScryptParams params;
+    std::string salt, expected;
+    if (!decodeHash(encoded, params, salt, expected)) return false;
+    std::uint8_t actual[kHashLen];
+    if (!scrypt(plain, salt.data(), salt.size(), std::uint64_t(1) << params.logN, params.r, params.p, actual, sizeof(actual))) return false;
+    return constantTimeEqual(actual, expected.data(), kHashLen);
+}
+
+bool isPasswordHash(std::string_view encoded) {
+    ScryptParams params;
+    std::string salt, expected;
+    return decodeHash(encoded, params, salt, expected);
+}
@@ -0,0 +1,24 @@
+#pragma once
+// 口令哈希：加盐的 scrypt（内存困难，抵抗 GPU / ASIC 批量猜测），编码为自描述字符串
+//   $scrypt$ln=14,r=8,p=1$<盐 base64url>$<哈希 base64url>
+// 参数随哈希一起保存，调整 ScryptParams 后旧哈希仍可校验。
+// 一次校验约占用 128 * r * 2^ln 字节内存与数十毫秒 CPU，不应在 HTTP 线程或业务锁内执行（见 VerifyPool.h）
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+struct ScryptParams {
+    int logN{14};        // N = 2^logN（默认 16384，配合 r=8 约 16 MiB）
+    std::uint32_t r{8};
+    std::uint32_t p{1};
+};
+
+// 生成随机盐并计算哈希
+std::string hashPassword(std::string_view plain, const ScryptParams &params = ScryptParams{});
+
+// 校验口令；编码格式非法时返回 false
+bool verifyPasswordHash(std::string_view plain, std::string_view encoded);
+
+// 只检查编码格式（参数范围、盐与哈希长度），不计算哈希
+bool isPasswordHash(std::string_view encoded);
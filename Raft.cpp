@@ -0,0 +1,964 @@
+// 共识复制实现：选举、日志复制与提交、落盘与恢复、快照
+#include "Raft.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <shared_mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#include <io.h>
+#endif
+
+#include "Logger.h"
+#include "Replay.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr unsigned char kNoop = 0xFE;
+constexpr std::uint64_t kMaxPayload = 256u << 20;   // 与轨迹文件相同的负载上限
+constexpr size_t kApplyBatch = 256;                  // 应用线程每取一次独占锁最多应用的条目数
+const char kSnapshotMagic[8] = {'L', 'A', 'B', 'S', 'N', 'P', '1', '\0'};
+
+long long systemMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+void putVarint(std::string &out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void putBytes(std::string &out, const std::string &s) {
+    putVarint(out, s.size());
+    out.append(s);
+}
+
+// 顺序解码；任何字段越界或格式错误后 ok 为 false，其后读取的值均无效
+struct Reader {
+    const char *p;
+    const char *end;
+    bool ok{true};
+
+    explicit Reader(const std::string &s) : p(s.data()), end(s.data() + s.size()) {}
+
+    bool atEnd() const { return p == end; }
+    std::uint64_t varint() {
+        std::uint64_t v = 0;
+        for (int shift = 0; ok && shift < 64; shift += 7) {
+            if (p == end) break;
+            unsigned char c = static_cast<unsigned char>(*p++);
+            v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    unsigned char byte() {
+        if (p == end) { ok = false; return 0; }
+        return static_cast<unsigned char>(*p++);
+    }
+    std::string bytes() {
+        std::uint64_t n = varint();
+        if (!ok || n > kMaxPayload || static_cast<std::uint64_t>(end - p) < n) { ok = false; return {}; }
+        std::string s(p, static_cast<size_t>(n));
+        p += n;
+        return s;
+    }
+    std::string rest() {
+        std::string s(p, static_cast<size_t>(end - p));
+        p = end;
+        return s;
+    }
+};
+
+// 条目编码（日志文件与 AppendEntries 共用）：varint 任期 | varint 微秒 | 1 字节路由 | varint 会话用户ID | varint 长度 | 负载
+void putEntry(std::string &out, const RaftEntry &e) {
+    putVarint(out, e.term);
+    putVarint(out, static_cast<std::uint64_t>(e.us));
+    out.push_back(static_cast<char>(e.route));
+    putVarint(out, static_cast<std::uint32_t>(e.userId));
+    putBytes(out, e.payload);
+}
+
+bool getEntry(Reader &r, RaftEntry &e) {
+    e.term = r.varint();
+    e.us = static_cast<long long>(r.varint());
+    e.route = r.byte();
+    e.userId = static_cast<int>(static_cast<std::uint32_t>(r.varint()));
+    e.payload = r.bytes();
+    if (e.route != kNoop && e.route >= kTraceRouteCount) r.ok = false;
+    return r.ok;
+}
+
+bool readFile(const std::string &path, std::string &out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// 日志与快照含导入的口令哈希：POSIX 下仅允许属主读写
+std::FILE *openPrivate(const std::string &path, bool append) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0600);
+    if (fd < 0) return nullptr;
+    std::FILE *f = ::fdopen(fd, append ? "ab" : "wb");
+    if (!f) ::close(fd);
+    return f;
+#else
+    return std::fopen(path.c_str(), append ? "ab" : "wb");
+#endif
+}
+
+void syncFile(std::FILE *f) {
+    std::fflush(f);
+#ifndef _WIN32
+    ::fsync(::fileno(f));
+#else
+    ::_commit(::_fileno(f));
+#endif
+}
+
+// 落盘线程在锁外 fsync 用的独立描述符：期间日志文件可能被 rewriteLog 关闭并替换
+int dupHandle(std::FILE *f) {
+#ifndef _WIN32
+    return ::dup(::fileno(f));
+#else
+    return ::_dup(::_fileno(f));
+#endif
+}
+
+void syncHandle(int fd) {
+#ifndef _WIN32
+    ::fsync(fd);
+    ::close(fd);
+#else
+    ::_commit(fd);
+    ::_close(fd);
+#endif
+}
+
+// 先写临时文件、fsync 后改名替换，崩溃时要么是旧文件要么是新文件
+bool writeFileAtomic(const std::string &path, const std::string &data, bool sync) {
+    const std::string tmp = path + ".tmp";
+    std::FILE *f = openPrivate(tmp, false);
+    if (!f) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (sync) syncFile(f);
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) return false;
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace
+
+const char *raftRoleName(RaftRole role) {
+    switch (role) {
+        case RaftRole::Follower:  return "follower";
+        case RaftRole::Candidate: return "candidate";
+        case RaftRole::Leader:    return "leader";
+    }
+    return "unknown";
+}
+
+RaftNode::RaftNode(LabManager &mgr, PinnableClock &clock, RaftOptions options)
+    : mgr_(mgr), clock_(clock), options_(std::move(options)), peers_(options_.peers.size()),
+      rng_(std::random_device{}() ^ static_cast<unsigned>(options_.id)) {}
+
+RaftNode::~RaftNode() {
+    stop();
+}
+
+bool RaftNode::start() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!loadState()) return false;
+        resetElectionTimer();
+    }
+    server_.set_tcp_nodelay(true);
+    server_.Post("/raft/vote", [this](const httplib::Request &req, httplib::Response &res) { handleVote(req, res); });
+    server_.Post("/raft/append", [this](const httplib::Request &req, httplib::Response &res) { handleAppend(req, res); });
+    server_.Post("/raft/snapshot", [this](const httplib::Request &req, httplib::Response &res) { handleSnapshot(req, res); });
+    const ShardEndpoint &self = options_.peers[static_cast<size_t>(options_.id)];
+    if (!server_.bind_to_port(self.host, self.port)) {
+        logError("raft.listen_failed", {{"host", self.host}, {"port", self.port}});
+        return false;
+    }
+    threads_.emplace_back([this] { server_.listen_after_bind(); });
+    server_.wait_until_ready();
+    threads_.emplace_back([this] { tickLoop(); });
+    threads_.emplace_back([this] { applyLoop(); });
+    threads_.emplace_back([this] { persistLoop(); });
+    for (size_t i = 0; i < peers_.size(); ++i) {
+        if (static_cast<int>(i) != options_.id) threads_.emplace_back([this, i] { peerLoop(i); });
+    }
+    logInfo("raft.start", {{"id", options_.id}, {"nodes", options_.peers.size()}, {"host", self.host}, {"port", self.port},
+                           {"term", term_}, {"snapshotIndex", snapIndex_}, {"lastIndex", lastIndex()}});
+    return true;
+}
+
+void RaftNode::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        failPending(0, UINT64_MAX, "服务正在停止");
+    }
+    peerCv_.notify_all();
+    applyCv_.notify_all();
+    tickCv_.notify_all();
+    persistCv_.notify_all();
+    server_.stop();
+    for (auto &t : threads_) t.join();
+    threads_.clear();
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (logFile_) {
+        std::fclose(logFile_);
+        logFile_ = nullptr;
+    }
+}
+
+bool RaftNode::isLeader() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return role_ == RaftRole::Leader;
+}
+
+std::string RaftNode::leaderApi() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return leaderApi_;
+}
+
+RaftStatus RaftNode::status() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    RaftStatus s;
+    s.role = role_;
+    s.term = term_;
+    s.leaderId = leaderId_;
+    s.leaderApi = leaderApi_;
+    s.lastIndex = lastIndex();
+    s.commitIndex = commitIndex_;
+    s.lastApplied = lastApplied_;
+    s.snapshotIndex = snapIndex_;
+    if (role_ == RaftRole::Leader) {
+        for (size_t i = 0; i < peers_.size(); ++i) {
+            s.matchIndex.push_back(static_cast<int>(i) == options_.id ? durableIndex_ : peers_[i].matchIndex);
+        }
+    }
+    return s;
+}
+
+// ---- 提交 ----
+
+void RaftNode::propose(TraceRoute route, int userId, std::string payload, Apply apply) {
+    auto pending = std::make_shared<Pending>();
+    pending->apply = std::move(apply);
+    std::future<void> done = pending->done.get_future();
+    std::uint64_t index;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopping_ || role_ != RaftRole::Leader) throw RaftUnavailable("当前节点不是主节点", leaderApi_);
+        RaftEntry e;
+        e.route = static_cast<unsigned char>(route);
+        e.userId = userId;
+        e.payload = std::move(payload);
+        index = appendLocal(std::move(e));
+        pending->term = term_;
+        pending_[index] = pending;
+    }
+    if (done.wait_for(std::chrono::milliseconds(options_.commitTimeoutMs)) == std::future_status::timeout) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        auto it = pending_.find(index);
+        // 仍在等待：撤回闭包（条目之后仍可能被提交，届时按日志重放）；已被应用线程取走时等它执行完
+        if (it != pending_.end() && it->second == pending) {
+            pending_.erase(it);
+            logWarn("raft.commit_timeout", {{"index", index}, {"commitIndex", commitIndex_}});
+            throw RaftUnavailable("提交超时，修改可能稍后生效", leaderApi_);
+        }
+    }
+    done.get();
+}
+
+std::uint64_t RaftNode::appendLocal(RaftEntry entry) {
+    // 时间单调：系统时间回拨时沿用上一条的时间
+    lastUs_ = std::max(lastUs_, systemMicros());
+    entry.us = lastUs_;
+    entry.term = term_;
+    log_.push_back(std::move(entry));
+    std::uint64_t index = lastIndex();
+    writeEntries(index);
+    if (options_.fsync) persistCv_.notify_one();
+    else durableIndex_ = index;
+    peerCv_.notify_all();
+    advanceCommit();
+    return index;
+}
+
+// 主节点：多数节点（含本节点已落盘的部分）确认的本任期条目即提交；更早任期的条目随之间接提交
+void RaftNode::advanceCommit() {
+    if (role_ != RaftRole::Leader) return;
+    for (std::uint64_t n = lastIndex(); n > commitIndex_ && n > snapIndex_; --n) {
+        if (entryAt(n).term != term_) break;
+        size_t acks = durableIndex_ >= n ? 1 : 0;
+        for (size_t i = 0; i < peers_.size(); ++i) {
+            if (static_cast<int>(i) != options_.id && peers_[i].matchIndex >= n) ++acks;
+        }
+        if (acks >= majority()) {
+            commitIndex_ = n;
+            applyCv_.notify_one();
+            // 立即把新的提交位置带给跟随者（不等下一次心跳），缩短跟随者读到新状态的延迟
+            auto now = Clock::now();
+            for (auto &p : peers_) p.nextHeartbeat = std::min(p.nextHeartbeat, now);
+            peerCv_.notify_all();
+            break;
+        }
+    }
+}
+
+void RaftNode::failPending(std::uint64_t from, std::uint64_t to, const char *message) {
+    for (auto it = pending_.lower_bound(from); it != pending_.end() && it->first <= to;) {
+        it->second->done.set_exception(std::make_exception_ptr(RaftUnavailable(message, leaderApi_)));
+        it = pending_.erase(it);
+    }
+}
+
+// ---- 角色转换 ----
+
+std::uint64_t RaftNode::termAt(std::uint64_t index) const {
+    if (index == snapIndex_) return snapTerm_;
+    if (index < snapIndex_ || index > lastIndex()) return 0;
+    return entryAt(index).term;
+}
+
+void RaftNode::resetElectionTimer() {
+    std::uniform_int_distribution<int> jitter(0, options_.electionTimeoutMs - 1);
+    electionDeadline_ = Clock::now() + std::chrono::milliseconds(options_.electionTimeoutMs + jitter(rng_));
+}
+
+void RaftNode::becomeFollower(std::uint64_t term) {
+    if (term > term_) {
+        term_ = term;
+        votedFor_ = -1;
+        leaderId_ = -1;
+        leaderApi_.clear();
+        saveMeta();
+    }
+    if (role_ != RaftRole::Follower) {
+        logInfo("raft.follower", {{"term", term_}, {"was", raftRoleName(role_)}});
+        role_ = RaftRole::Follower;
+        resetElectionTimer();
+    }
+    peerCv_.notify_all();
+}
+
+void RaftNode::startElection() {
+    ++term_;
+    votedFor_ = options_.id;
+    saveMeta();
+    role_ = RaftRole::Candidate;
+    leaderId_ = -1;
+    leaderApi_.clear();
+    votes_ = 1;
+    resetElectionTimer();
+    logInfo("raft.election", {{"term", term_}, {"lastIndex", lastIndex()}});
+    if (votes_ >= majority()) becomeLeader();
+    peerCv_.notify_all();
+}
+
+// 新任主节点先追加一条本任期的空条目：它提交时，之前任期遗留的条目随之提交
+void RaftNode::becomeLeader() {
+    role_ = RaftRole::Leader;
+    leaderId_ = options_.id;
+    leaderApi_ = options_.apiAddress;
+    auto now = Clock::now();
+    for (auto &p : peers_) {
+        p.nextIndex = lastIndex() + 1;
+        p.matchIndex = 0;
+        p.nextHeartbeat = p.retryAt = now;
+        p.lastAck = now;
+    }
+    logInfo("raft.leader", {{"term", term_}, {"lastIndex", lastIndex()}, {"commitIndex", commitIndex_}});
+    RaftEntry noop;
+    noop.route = kNoop;
+    appendLocal(std::move(noop));
+}
+
+// ---- 持久化 ----
+
+std::string RaftNode::path(const char *name) const {
+    return options_.dataDir + "/" + name;
+}
+
+bool RaftNode::saveMeta() {
+    std::string data = std::to_string(term_) + " " + std::to_string(votedFor_) + "\n";
+    if (writeFileAtomic(path("meta"), data, options_.fsync)) return true;
+    logError("raft.meta_write_failed", {{"dir", options_.dataDir}, {"term", term_}});
+    return false;
+}
+
+// 日志文件记录：varint 序号 | 条目
+void RaftNode::writeEntries(std::uint64_t from) {
+    std::string buf;
+    for (std::uint64_t i = from; i <= lastIndex(); ++i) {
+        putVarint(buf, i);
+        putEntry(buf, entryAt(i));
+    }
+    if (std::fwrite(buf.data(), 1, buf.size(), logFile_) != buf.size()) {
+        logError("raft.log_write_failed", {{"dir", options_.dataDir}, {"from", from}});
+    }
+    std::fflush(logFile_);
+}
+
+bool RaftNode::rewriteLog() {
+    std::string buf;
+    for (std::uint64_t i = snapIndex_ + 1; i <= lastIndex(); ++i) {
+        putVarint(buf, i);
+        putEntry(buf, entryAt(i));
+    }
+    if (logFile_) std::fclose(logFile_);
+    ++logGeneration_;
+    bool ok = writeFileAtomic(path("log"), buf, options_.fsync);
+    logFile_ = openPrivate(path("log"), true);
+    if (!ok || !logFile_) {
+        logError("raft.log_rewrite_failed", {{"dir", options_.dataDir}});
+        return false;
+    }
+    durableIndex_ = lastIndex();
+    return true;
+}
+
+void RaftNode::syncLog() {
+    if (options_.fsync) syncFile(logFile_);
+}
+
+bool RaftNode::writeSnapshotFile(std::uint64_t index, std::uint64_t term, const std::string &data) const {
+    std::string buf(kSnapshotMagic, sizeof(kSnapshotMagic));
+    putVarint(buf, index);
+    putVarint(buf, term);
+    buf += data;
+    return writeFileAtomic(path("snapshot"), buf, options_.fsync);
+}
+
+// 恢复顺序：任期与投票 → 快照（整体替换 LabManager 状态）→ 快照之后的日志（等提交位置确定后重新应用）。
+// 日志尾部不完整（写入时崩溃）时截去残缺部分
+bool RaftNode::loadState() {
+#ifndef _WIN32
+    ::mkdir(options_.dataDir.c_str(), 0700);
+#else
+    ::_mkdir(options_.dataDir.c_str());
+#endif
+    std::string data;
+    if (readFile(path("meta"), data)) {
+        unsigned long long term = 0;
+        int vote = -1;
+        if (std::sscanf(data.c_str(), "%llu %d", &term, &vote) != 2) {
+            logError("raft.meta_corrupt", {{"dir", options_.dataDir}});
+            return false;
+        }
+        term_ = term;
+        votedFor_ = vote;
+    }
+    if (readFile(path("snapshot"), data)) {
+        if (data.size() < sizeof(kSnapshotMagic) || std::memcmp(data.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+            logError("raft.snapshot_corrupt", {{"dir", options_.dataDir}});
+            return false;
+        }
+        Reader r(data);
+        r.p += sizeof(kSnapshotMagic);
+        std::uint64_t index = r.varint();
+        std::uint64_t term = r.varint();
+        auto state = std::make_shared<std::string>(r.rest());
+        bool loaded = false;
+        if (r.ok) {
+            std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+            loaded = loadStateSnapshot(mgr_, *state);
+        }
+        if (!loaded) {
+            logError("raft.snapshot_corrupt", {{"dir", options_.dataDir}});
+            return false;
+        }
+        snapIndex_ = commitIndex_ = lastApplied_ = snapshotTried_ = index;
+        snapTerm_ = term;
+        snapData_ = std::move(state);
+    }
+    bool torn = false;
+    if (readFile(path("log"), data)) {
+        Reader r(data);
+        while (!r.atEnd()) {
+            std::uint64_t index = r.varint();
+            RaftEntry e;
+            if (!r.ok || !getEntry(r, e)) { torn = true; break; }
+            if (index <= snapIndex_) continue;          // 生成快照后、重写日志前崩溃留下的旧条目
+            if (index != lastIndex() + 1) {
+                logError("raft.log_gap", {{"dir", options_.dataDir}, {"expected", lastIndex() + 1}, {"got", index}});
+                return false;
+            }
+            lastUs_ = std::max(lastUs_, e.us);
+            log_.push_back(std::move(e));
+        }
+    }
+    if (torn) logWarn("raft.log_torn_tail", {{"dir", options_.dataDir}, {"lastIndex", lastIndex()}});
+    if (torn) {
+        if (!rewriteLog()) return false;
+    } else {
+        logFile_ = openPrivate(path("log"), true);
+        if (!logFile_) {
+            logError("raft.log_open_failed", {{"dir", options_.dataDir}});
+            return false;
+        }
+    }
+    durableIndex_ = lastIndex();
+    return true;
+}
+
+// 主节点的成组落盘：一次 fsync 覆盖期间追加的全部条目，之后计入本节点的确认。
+// fsync 在 mutex_ 之外进行（条目已由 writeEntries 写入内核），期间仍可追加条目、收发消息；
+// 日志在此期间被 rewriteLog 替换时（其自身已落盘并更新 durableIndex_）丢弃本次结果
+void RaftNode::persistLoop() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (!stopping_) {
+        persistCv_.wait(lk, [this] { return stopping_ || durableIndex_ < lastIndex(); });
+        if (stopping_) break;
+        std::uint64_t target = lastIndex();
+        std::uint64_t generation = logGeneration_;
+        int fd = logFile_ ? dupHandle(logFile_) : -1;
+        if (fd >= 0) {
+            lk.unlock();
+            syncHandle(fd);
+            lk.lock();
+            if (generation != logGeneration_) continue;
+        } else {
+            syncLog();
+        }
+        durableIndex_ = std::max(durableIndex_, target);
+        advanceCommit();
+    }
+}
+
+// ---- 定时：选举超时与主节点的多数联系检查 ----
+
+void RaftNode::tickLoop() {
+    const auto quorumWindow = std::chrono::milliseconds(2 * options_.electionTimeoutMs);
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (!stopping_) {
+        tickCv_.wait_for(lk, std::chrono::milliseconds(10));
+        if (stopping_) break;
+        auto now = Clock::now();
+        if (role_ == RaftRole::Leader) {
+            size_t reachable = 1;
+            for (size_t i = 0; i < peers_.size(); ++i) {
+                if (static_cast<int>(i) != options_.id && now - peers_[i].lastAck < quorumWindow) ++reachable;
+            }
+            if (reachable < majority()) {
+                logWarn("raft.lost_quorum", {{"term", term_}, {"reachable", reachable}});
+                leaderId_ = -1;
+                leaderApi_.clear();
+                becomeFollower(term_);
+            }
+        } else if (now >= electionDeadline_) {
+            startElection();
+        }
+    }
+}
+
+// ---- 对端发送线程 ----
+
+void RaftNode::peerLoop(size_t i) {
+    const ShardEndpoint &ep = options_.peers[i];
+    httplib::Client cli(ep.host, ep.port);
+    cli.set_keep_alive(true);
+    cli.set_tcp_nodelay(true);
+    cli.set_connection_timeout(0, 200000);
+    cli.set_read_timeout(2);
+    cli.set_write_timeout(2);
+    const auto heartbeat = std::chrono::milliseconds(options_.heartbeatMs);
+    Peer &peer = peers_[i];
+    bool warned = false;
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (!stopping_) {
+        if (role_ == RaftRole::Candidate && peer.voteTerm != term_) {
+            std::uint64_t term = term_;
+            peer.voteTerm = term;
+            std::string body;
+            putVarint(body, term);
+            putVarint(body, static_cast<std::uint64_t>(options_.id));
+            putVarint(body, lastIndex());
+            putVarint(body, termAt(lastIndex()));
+            lk.unlock();
+            auto r = cli.Post("/raft/vote", body, "application/octet-stream");
+            lk.lock();
+            if (!r || r->status != 200) continue;
+            Reader rd(r->body);
+            std::uint64_t replyTerm = rd.varint();
+            bool granted = rd.byte() != 0;
+            if (!rd.ok) continue;
+            if (replyTerm > term_) { becomeFollower(replyTerm); continue; }
+            if (role_ == RaftRole::Candidate && term_ == term && granted && ++votes_ >= majority()) becomeLeader();
+            continue;
+        }
+        if (role_ != RaftRole::Leader) {
+            peerCv_.wait(lk);
+            continue;
+        }
+
+        auto now = Clock::now();
+        bool backlog = peer.nextIndex <= lastIndex() && now >= peer.retryAt;
+        if (!backlog && now < peer.nextHeartbeat) {
+            peerCv_.wait_until(lk, std::min(peer.nextHeartbeat, std::max(peer.retryAt, now + std::chrono::milliseconds(1))));
+            continue;
+        }
+
+        // 落后于快照的对端整体安装快照，否则发送 nextIndex 起积压的条目（上限 maxBatchBytes）
+        std::uint64_t term = term_;
+        std::uint64_t sentLast;
+        const char *target;
+        std::string body;
+        putVarint(body, term);
+        putVarint(body, static_cast<std::uint64_t>(options_.id));
+        putBytes(body, options_.apiAddress);
+        std::shared_ptr<const std::string> snapshot;
+        if (peer.nextIndex <= snapIndex_) {
+            target = "/raft/snapshot";
+            sentLast = snapIndex_;
+            putVarint(body, snapIndex_);
+            putVarint(body, snapTerm_);
+            snapshot = snapData_;
+        } else {
+            target = "/raft/append";
+            std::uint64_t prev = peer.nextIndex - 1;
+            putVarint(body, prev);
+            putVarint(body, termAt(prev));
+            putVarint(body, commitIndex_);
+            std::string entries;
+            std::uint64_t count = 0;
+            for (std::uint64_t k = peer.nextIndex; k <= lastIndex() && (count == 0 || entries.size() < options_.maxBatchBytes); ++k, ++count) {
+                putEntry(entries, entryAt(k));
+            }
+            putVarint(body, count);
+            body += entries;
+            sentLast = prev + count;
+        }
+        peer.nextHeartbeat = now + heartbeat;
+        lk.unlock();
+        if (snapshot) body += *snapshot;   // 快照可能较大，在锁外拼接
+        auto r = cli.Post(target, body, "application/octet-stream");
+        lk.lock();
+
+        if (!r || r->status != 200) {
+            peer.retryAt = Clock::now() + heartbeat;
+            if (!warned) logWarn("raft.peer_unreachable", {{"peer", i}, {"host", ep.host}, {"port", ep.port}});
+            warned = true;
+            continue;
+        }
+        if (warned) logInfo("raft.peer_reachable", {{"peer", i}});
+        warned = false;
+        Reader rd(r->body);
+        std::uint64_t replyTerm = rd.varint();
+        bool success = rd.byte() != 0;
+        std::uint64_t hint = snapshot ? 0 : rd.varint();
+        if (!rd.ok) continue;
+        if (replyTerm > term_) { becomeFollower(replyTerm); continue; }
+        if (role_ != RaftRole::Leader || term_ != term) continue;
+        peer.lastAck = Clock::now();
+        if (success) {
+            peer.matchIndex = std::max(peer.matchIndex, sentLast);
+            peer.nextIndex = peer.matchIndex + 1;
+            advanceCommit();
+        } else if (!snapshot) {
+            // 日志不一致：按对端给出的位置回退（不早于 1）
+            peer.nextIndex = std::max<std::uint64_t>(1, std::min(peer.nextIndex - 1, hint + 1));
+        } else {
+            peer.retryAt = Clock::now() + heartbeat;
+        }
+    }
+}
+
+// ---- 应用线程 ----
+
+void RaftNode::applyLoop() {
+    struct Item {
+        RaftEntry entry;
+        std::shared_ptr<Pending> pending;
+        std::exception_ptr error;
+    };
+    std::vector<Item> batch;
+    std::unique_lock<std::mutex> lk(mutex_);
+    for (;;) {
+        applyCv_.wait(lk, [this] { return stopping_ || incoming_ || lastApplied_ < commitIndex_; });
+        if (stopping_) break;
+        if (incoming_) {
+            installSnapshot(lk);
+            continue;
+        }
+        batch.clear();
+        std::uint64_t last = std::min(commitIndex_, lastApplied_ + kApplyBatch);
+        for (std::uint64_t i = lastApplied_ + 1; i <= last; ++i) {
+            Item item{entryAt(i), nullptr, nullptr};
+            auto it = pending_.find(i);
+            if (it != pending_.end()) {
+                // 同一序号上已是其他任期的条目：本节点提交的那条已被覆盖
+                if (it->second->term == item.entry.term) item.pending = std::move(it->second);
+                else it->second->done.set_exception(std::make_exception_ptr(RaftUnavailable("主节点已变更，修改未生效", leaderApi_)));
+                pending_.erase(it);
+            }
+            batch.push_back(std::move(item));
+        }
+        lk.unlock();
+        {
+            // 一批条目只取一次独占锁；时钟固定为每条的主节点时间
+            std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+            for (Item &item : batch) {
+                const RaftEntry &e = item.entry;
+                if (e.route == kNoop) continue;
+                clock_.pin(static_cast<std::time_t>(e.us / 1000000));
+                if (item.pending) {
+                    try {
+                        item.pending->apply(mgr_);
+                    } catch (...) {
+                        item.error = std::current_exception();
+                    }
+                } else {
+                    TraceRecord rec;
+                    rec.timestampUs = e.us;
+                    rec.route = static_cast<TraceRoute>(e.route);
+                    rec.userId = e.userId;
+                    rec.payload = e.payload;
+                    applyTraceRecord(mgr_, rec);
+                }
+            }
+            clock_.unpin();
+        }
+        for (Item &item : batch) {
+            if (!item.pending) continue;
+            if (item.error) item.pending->done.set_exception(item.error);
+            else item.pending->done.set_value();
+        }
+        lk.lock();
+        lastApplied_ = last;
+        if (lastApplied_ - snapIndex_ >= options_.snapshotEvery && lastApplied_ - snapshotTried_ >= options_.snapshotEvery) takeSnapshot(lk);
+    }
+    if (incoming_) {
+        incoming_->done.set_value(false);
+        incoming_.reset();
+    }
+}
+
+// 在应用线程中调用：此时 LabManager 的状态恰为 lastApplied_ 处（只有应用线程修改它），
+// 共享锁下序列化，锁外写文件，最后截断日志
+void RaftNode::takeSnapshot(std::unique_lock<std::mutex> &lk) {
+    std::uint64_t index = lastApplied_;
+    std::uint64_t term = termAt(index);
+    snapshotTried_ = index;
+    lk.unlock();
+    auto t0 = std::chrono::steady_clock::now();
+    auto data = std::make_shared<std::string>();
+    {
+        std::shared_lock<std::shared_mutex> lock(mgr_.mutex);
+        writeStateSnapshot(*data, mgr_);
+    }
+    bool ok = writeSnapshotFile(index, term, *data);
+    lk.lock();
+    if (!ok) {
+        logError("raft.snapshot_write_failed", {{"dir", options_.dataDir}, {"index", index}});
+        return;
+    }
+    if (index <= snapIndex_) return;
+    log_.erase(log_.begin(), log_.begin() + static_cast<std::ptrdiff_t>(index - snapIndex_));
+    snapIndex_ = index;
+    snapTerm_ = term;
+    snapData_ = std::move(data);
+    rewriteLog();
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+    logInfo("raft.snapshot", {{"index", index}, {"bytes", snapData_->size()}, {"remaining", log_.size()}, {"us", us}});
+}
+
+// 安装主节点发来的快照：整体替换 LabManager 状态，日志中与快照一致的后续条目保留，其余丢弃
+void RaftNode::installSnapshot(std::unique_lock<std::mutex> &lk) {
+    std::unique_ptr<IncomingSnapshot> in = std::move(incoming_);
+    if (in->index <= lastApplied_) {
+        in->done.set_value(true);
+        return;
+    }
+    lk.unlock();
+    bool ok;
+    {
+        std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+        ok = loadStateSnapshot(mgr_, in->data);
+    }
+    if (ok) ok = writeSnapshotFile(in->index, in->term, in->data);
+    lk.lock();
+    if (!ok) {
+        logError("raft.snapshot_install_failed", {{"index", in->index}, {"bytes", in->data.size()}});
+        in->done.set_value(false);
+        return;
+    }
+    if (in->index < lastIndex() && termAt(in->index) == in->term) {
+        log_.erase(log_.begin(), log_.begin() + static_cast<std::ptrdiff_t>(in->index - snapIndex_));
+    } else {
+        log_.clear();
+    }
+    failPending(0, in->index, "主节点已变更，修改结果未知");
+    snapIndex_ = lastApplied_ = snapshotTried_ = in->index;
+    snapTerm_ = in->term;
+    commitIndex_ = std::max(commitIndex_, snapIndex_);
+    logInfo("raft.snapshot_installed", {{"index", snapIndex_}, {"term", snapTerm_}, {"bytes", in->data.size()}, {"remaining", log_.size()}});
+    snapData_ = std::make_shared<const std::string>(std::move(in->data));
+    rewriteLog();
+    in->done.set_value(true);
+}
+
+// ---- 节点间 RPC ----
+
+// 主节点消息：任期不旧于本节点时承认其地位并重置选举计时
+bool RaftNode::acceptLeader(std::uint64_t term, int leaderId, std::string api) {
+    if (term < term_) return false;
+    if (term > term_ || role_ != RaftRole::Follower) becomeFollower(term);
+    if (leaderId_ != leaderId) logInfo("raft.leader_changed", {{"term", term_}, {"leader", leaderId}, {"api", api}});
+    leaderId_ = leaderId;
+    leaderApi_ = std::move(api);
+    leaderContact_ = Clock::now();
+    resetElectionTimer();
+    return true;
+}
+
+// 请求：varint 任期 | varint 候选者 | varint 最后序号 | varint 最后任期；应答：varint 任期 | 1 字节是否投票
+void RaftNode::handleVote(const httplib::Request &req, httplib::Response &res) {
+    Reader rd(req.body);
+    std::uint64_t term = rd.varint();
+    int candidate = static_cast<int>(rd.varint());
+    std::uint64_t lastIdx = rd.varint();
+    std::uint64_t lastTerm = rd.varint();
+    if (!rd.ok) { res.status = 400; return; }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    // 刚收到过主节点消息的跟随者不响应选举：避免暂时失联后恢复的节点以更高任期打断正常的主节点
+    bool leaderAlive = role_ == RaftRole::Leader ||
+                       (leaderId_ >= 0 && Clock::now() - leaderContact_ < std::chrono::milliseconds(options_.electionTimeoutMs));
+    bool granted = false;
+    if (!leaderAlive) {
+        if (term > term_) becomeFollower(term);
+        std::uint64_t myLastTerm = termAt(lastIndex());
+        bool upToDate = lastTerm > myLastTerm || (lastTerm == myLastTerm && lastIdx >= lastIndex());
+        granted = term == term_ && (votedFor_ == -1 || votedFor_ == candidate) && upToDate;
+        if (granted && votedFor_ != candidate) {
+            votedFor_ = candidate;
+            granted = saveMeta();
+        }
+        if (granted) resetElectionTimer();
+    }
+    std::string out;
+    putVarint(out, term_);
+    out.push_back(granted ? 1 : 0);
+    res.set_content(out, "application/octet-stream");
+}
+
+// 请求：varint 任期 | varint 主节点 | 主节点业务地址 | varint 前一条序号 | varint 前一条任期 | varint 提交位置 | varint 条数 | 条目…
+// 应答：varint 任期 | 1 字节是否成功 | varint 本节点最后序号（失败时为主节点回退的参考位置）
+void RaftNode::handleAppend(const httplib::Request &req, httplib::Response &res) {
+    Reader rd(req.body);
+    std::uint64_t term = rd.varint();
+    int leader = static_cast<int>(rd.varint());
+    std::string api = rd.bytes();
+    std::uint64_t prev = rd.varint();
+    std::uint64_t prevTerm = rd.varint();
+    std::uint64_t leaderCommit = rd.varint();
+    std::uint64_t count = rd.varint();
+    std::vector<RaftEntry> entries;
+    for (std::uint64_t k = 0; rd.ok && k < count; ++k) {
+        RaftEntry e;
+        if (getEntry(rd, e)) entries.push_back(std::move(e));
+    }
+    if (!rd.ok) { res.status = 400; return; }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto reply = [&](bool success, std::uint64_t hint) {
+        std::string out;
+        putVarint(out, term_);
+        out.push_back(success ? 1 : 0);
+        putVarint(out, hint);
+        res.set_content(out, "application/octet-stream");
+    };
+    if (!acceptLeader(term, leader, std::move(api))) return reply(false, lastIndex());
+    if (prev > lastIndex()) return reply(false, lastIndex());
+    if (prev >= snapIndex_ && termAt(prev) != prevTerm) return reply(false, prev - 1);
+
+    std::uint64_t index = prev;
+    std::uint64_t firstNew = 0;
+    bool truncated = false;
+    for (RaftEntry &e : entries) {
+        ++index;
+        if (index <= snapIndex_) continue;
+        if (index <= lastIndex()) {
+            if (entryAt(index).term == e.term) continue;
+            // 冲突：删除该位置及之后的全部条目（它们不可能已提交）
+            log_.resize(static_cast<size_t>(index - snapIndex_ - 1));
+            failPending(index, UINT64_MAX, "主节点已变更，修改未生效");
+            truncated = true;
+        }
+        if (!firstNew) firstNew = index;
+        lastUs_ = std::max(lastUs_, e.us);
+        log_.push_back(std::move(e));
+    }
+    if (truncated) {
+        logWarn("raft.log_truncated", {{"from", firstNew}, {"term", term_}});
+        rewriteLog();
+    } else if (firstNew) {
+        writeEntries(firstNew);
+        syncLog();
+        durableIndex_ = lastIndex();
+    }
+    std::uint64_t commit = std::min(leaderCommit, index);
+    if (commit > commitIndex_) {
+        commitIndex_ = commit;
+        applyCv_.notify_one();
+    }
+    reply(true, lastIndex());
+}
+
+// 请求：varint 任期 | varint 主节点 | 主节点业务地址 | varint 快照序号 | varint 快照任期 | 快照内容；
+// 应答：varint 任期 | 1 字节是否成功。由应用线程安装，本线程等待其完成
+void RaftNode::handleSnapshot(const httplib::Request &req, httplib::Response &res) {
+    Reader rd(req.body);
+    std::uint64_t term = rd.varint();
+    int leader = static_cast<int>(rd.varint());
+    std::string api = rd.bytes();
+    std::uint64_t index = rd.varint();
+    std::uint64_t snapTerm = rd.varint();
+    if (!rd.ok) { res.status = 400; return; }
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    bool ok = false;
+    if (acceptLeader(term, leader, std::move(api))) {
+        if (index <= lastApplied_) {
+            ok = true;
+        } else if (!incoming_ && !stopping_) {
+            incoming_ = std::make_unique<IncomingSnapshot>();
+            incoming_->index = index;
+            incoming_->term = snapTerm;
+            incoming_->data = rd.rest();
+            std::future<bool> done = incoming_->done.get_future();
+            applyCv_.notify_one();
+            lk.unlock();
+            ok = done.get();
+            lk.lock();
+        }
+    }
+    std::string out;
+    putVarint(out, term_);
+    out.push_back(ok ? 1 : 0);
+    res.set_content(out, "application/octet-stream");
+}
@@ -0,0 +1,219 @@
+#pragma once
+// 共识复制（Raft）：3 或 5 个服务器进程组成一个复制组，每个修改类请求作为一条日志由主节点（leader）
+// 追加并复制到各节点，多数节点落盘后提交，各节点按日志顺序在自己的 LabManager 上应用。
+// 任一少数节点（含主节点）宕机时其余节点选出新主节点继续服务，已提交的修改不丢失。
+//
+// 日志条目与复制日志 / 轨迹文件的记录相同（路由、会话用户ID、请求体，见 Trace.h），另带任期与主节点时间戳；
+// 应用时时钟固定为条目时间，各节点经 applyTraceRecord 做出相同的判断（与只读副本同一套语义，见 Replication.h）。
+// 主节点上由本节点提交的条目改为执行接口处理函数传入的闭包，以便生成响应；两者调用的是同一组业务方法。
+//
+// 实现要点：
+//   - 选举：跟随者在随机选举超时内未收到主节点消息即发起选举；只投票给日志不比自己旧的候选者。
+//     主节点在一个选举超时内联系不上多数节点时主动退位，使被隔离的旧主节点尽快把客户端引向新主节点
+//   - 复制：每个对端一个发送线程，每次 AppendEntries 携带自上次确认以来积压的全部条目（受字节上限约束），
+//     上一个请求在途期间新提交的修改自动并入下一批；空闲时按心跳间隔发送空请求
+//   - 落盘：任期与投票、日志、快照保存在数据目录中；主节点由落盘线程成组 fsync 后计入自己的确认，
+//     跟随者在应答前 fsync。重启后从快照与日志恢复
+//   - 快照：已应用的日志超过阈值时把 LabManager 状态序列化（见 StateSnapshot.h）并截断日志；
+//     落后过多（所需日志已被截断）的节点由主节点发送快照整体安装
+//   - 节点间通信：各节点在单独的端口上提供 POST /raft/vote、/raft/append、/raft/snapshot，消息为紧凑的二进制编码
+//
+// 各节点须以相同的初始数据启动（同样的 --import / --catalog / --shard 参数）。集群成员固定，不支持在线变更
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "httplib.h"    // 引入 cpp-httplib 单头文件库（外部依赖）
+#include "Clock.h"
+#include "LabManager.h"
+#include "ShardRouter.h"
+#include "Trace.h"
+
+struct RaftOptions {
+    int id{0};                          // 本节点序号：peers 中的下标
+    std::vector<ShardEndpoint> peers;   // 全部节点的节点间通信地址（含本节点），各节点的列表须相同
+    std::string dataDir;                // 持久化目录：任期与投票（meta）、日志（log）、快照（snapshot）
+    std::string apiAddress;             // 本节点业务接口的 host:port，跟随者据此把修改转发给主节点
+    int electionTimeoutMs{300};         // 选举超时下限，实际在 [t, 2t) 内随机
+    int heartbeatMs{60};                // 主节点心跳间隔
+    size_t maxBatchBytes{1u << 20};     // 单个 AppendEntries 携带的条目字节上限
+    std::uint64_t snapshotEvery{10000}; // 快照之后再应用这么多条日志时生成新快照
+    int commitTimeoutMs{5000};          // 提交等待上限，超时按结果未知处理
+    bool fsync{true};                   // 落盘后 fsync（测试时可关闭）
+};
+
+// 提交失败：本节点不是主节点、失去主节点地位或等待超时（此时修改可能已经或将会生效）
+class RaftUnavailable : public std::runtime_error {
+public:
+    RaftUnavailable(const char *message, std::string leaderApi) : std::runtime_error(message), leaderApi(std::move(leaderApi)) {}
+    std::string leaderApi;   // 已知的主节点业务地址（未知时为空）
+};
+
+// 日志条目
+struct RaftEntry {
+    std::uint64_t term{0};
+    long long us{0};                 // 主节点追加时的 Unix 微秒
+    unsigned char route{0};          // TraceRoute 取值；0xFE 为新任主节点的空条目
+    int userId{0};
+    std::string payload;
+};
+
+enum class RaftRole { Follower, Candidate, Leader };
+
+const char *raftRoleName(RaftRole role);
+
+struct RaftStatus {
+    RaftRole role{RaftRole::Follower};
+    std::uint64_t term{0};
+    int leaderId{-1};
+    std::string leaderApi;
+    std::uint64_t lastIndex{0};
+    std::uint64_t commitIndex{0};
+    std::uint64_t lastApplied{0};
+    std::uint64_t snapshotIndex{0};
+    std::vector<std::uint64_t> matchIndex;   // 主节点：各节点已确认的日志位置（本节点为已落盘位置）
+};
+
+class RaftNode {
+public:
+    // 应用时代替 applyTraceRecord 执行的闭包：持有 mgr.mutex 独占锁，时钟已固定为条目时间
+    using Apply = std::function<void(LabManager &)>;
+
+    // clock 须为 mgr 正在使用的时钟
+    RaftNode(LabManager &mgr, PinnableClock &clock, RaftOptions options);
+    ~RaftNode();
+
+    RaftNode(const RaftNode &) = delete;
+    RaftNode &operator=(const RaftNode &) = delete;
+
+    // 读取数据目录恢复状态并开始服务；数据目录或快照损坏、端口无法绑定时返回 false
+    bool start();
+    void stop();
+
+    // 提交一条修改并等待本节点应用：apply 在应用该条目时执行，异常原样抛给调用方。
+    // 失败时抛出 RaftUnavailable；超时时 apply 保证不会再执行
+    void propose(TraceRoute route, int userId, std::string payload, Apply apply);
+
+    bool isLeader() const;
+    std::string leaderApi() const;
+    RaftStatus status() const;
+    const RaftOptions &options() const { return options_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 本节点提交、等待应用的修改
+    struct Pending {
+        std::uint64_t term{0};
+        Apply apply;
+        std::promise<void> done;
+    };
+
+    // 由接收线程交给应用线程安装的快照
+    struct IncomingSnapshot {
+        std::uint64_t index{0};
+        std::uint64_t term{0};
+        std::string data;
+        std::promise<bool> done;
+    };
+
+    struct Peer {
+        std::uint64_t nextIndex{1};
+        std::uint64_t matchIndex{0};
+        std::uint64_t voteTerm{0};       // 已在该任期向其请求过投票
+        Clock::time_point nextHeartbeat{};
+        Clock::time_point lastAck{};
+        Clock::time_point retryAt{};     // 对端不可达时暂停发送到该时刻
+    };
+
+    LabManager &mgr_;
+    PinnableClock &clock_;
+    RaftOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable peerCv_;     // 有新条目 / 角色变化：唤醒发送线程
+    std::condition_variable applyCv_;    // 提交位置前进 / 有待安装快照：唤醒应用线程
+    std::condition_variable tickCv_;
+    std::condition_variable persistCv_;
+
+    // 持久状态
+    std::uint64_t term_{0};
+    int votedFor_{-1};
+    std::deque<RaftEntry> log_;              // 快照之后的条目：log_[i] 的序号为 snapIndex_ + 1 + i
+    std::uint64_t snapIndex_{0};
+    std::uint64_t snapTerm_{0};
+    std::shared_ptr<const std::string> snapData_;   // 最近的快照（发给落后节点）
+    std::FILE *logFile_{nullptr};
+
+    // 易失状态
+    RaftRole role_{RaftRole::Follower};
+    int leaderId_{-1};
+    std::string leaderApi_;
+    std::uint64_t commitIndex_{0};
+    std::uint64_t lastApplied_{0};
+    std::uint64_t durableIndex_{0};      // 本节点已落盘的最后序号
+    std::uint64_t logGeneration_{0};     // 日志文件被 rewriteLog 替换的次数（落盘线程据此丢弃过期的 fsync 结果）
+    long long lastUs_{0};
+    size_t votes_{0};
+    Clock::time_point leaderContact_{};  // 最近一次收到主节点消息的时刻
+    std::uint64_t snapshotTried_{0};     // 最近一次尝试生成快照时的应用位置（失败后不立即重试）
+    Clock::time_point electionDeadline_{};
+    std::vector<Peer> peers_;
+    std::map<std::uint64_t, std::shared_ptr<Pending>> pending_;
+    std::unique_ptr<IncomingSnapshot> incoming_;
+    std::mt19937 rng_;
+    bool stopping_{false};
+
+    httplib::Server server_;
+    std::vector<std::thread> threads_;
+
+    // 以下均在持有 mutex_ 时调用
+    std::uint64_t lastIndex() const { return snapIndex_ + log_.size(); }
+    std::uint64_t termAt(std::uint64_t index) const;
+    const RaftEntry &entryAt(std::uint64_t index) const { return log_[index - snapIndex_ - 1]; }
+    size_t majority() const { return options_.peers.size() / 2 + 1; }
+    void resetElectionTimer();
+    void becomeFollower(std::uint64_t term);
+    void becomeLeader();
+    void startElection();
+    std::uint64_t appendLocal(RaftEntry entry);
+    void advanceCommit();
+    void failPending(std::uint64_t from, std::uint64_t to, const char *message);
+
+    // 持久化（持有 mutex_ 时调用）
+    bool loadState();
+    bool saveMeta();
+    void writeEntries(std::uint64_t from);   // 把 from 起的条目追加到日志文件
+    bool rewriteLog();                       // 用内存中的条目重写日志文件（截断冲突或压缩之后）
+    void syncLog();
+    bool writeSnapshotFile(std::uint64_t index, std::uint64_t term, const std::string &data) const;
+    std::string path(const char *name) const;
+
+    // 线程
+    void tickLoop();
+    void peerLoop(size_t i);
+    void applyLoop();
+    void persistLoop();
+    void takeSnapshot(std::unique_lock<std::mutex> &lk);
+    void installSnapshot(std::unique_lock<std::mutex> &lk);
+
+    // 节点间 RPC 处理
+    void handleVote(const httplib::Request &req, httplib::Response &res);
+    void handleAppend(const httplib::Request &req, httplib::Response &res);
+    void handleSnapshot(const httplib::Request &req, httplib::Response &res);
+    bool acceptLeader(std::uint64_t term, int leaderId, std::string api);
+};
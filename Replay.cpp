@@ -0,0 +1,170 @@
+#include "Replay.h"
+#include <cstdlib>
+
+#include "ApiJson.h"
+#include "Import.h"
+#include "RequestDecoder.h"
+
+namespace {
+
+ReplayOutcome outcome(bool ok) {
+    return ok ? ReplayOutcome::Ok : ReplayOutcome::Rejected;
+}
+
+// 各路由在线上要求的必填字段，与 Server.cpp 保持一致；
+// 旧版轨迹（无会话用户ID）的用户类接口仍从请求体读取 userId
+FieldMask requiredFields(TraceRoute route, bool userFromBody) {
+    FieldMask user = userFromBody ? static_cast<FieldMask>(Field::UserId) : 0;
+    switch (route) {
+        case TraceRoute::Reserve:
+        case TraceRoute::Apply:
+        case TraceRoute::Hold:     return user | Field::DeviceId | Field::StartTime | Field::EndTime;
+        case TraceRoute::HoldConfirm:
+        case TraceRoute::HoldRelease: return static_cast<FieldMask>(Field::HoldId);
+        case TraceRoute::Borrow:
+        case TraceRoute::Return:   return user | Field::DeviceId;
+        case TraceRoute::Extend:   return user | Field::DeviceId | Field::EndTime;
+        case TraceRoute::AdminAdd: return Field::Type | Field::Name;
+        case TraceRoute::Approve:  return static_cast<FieldMask>(Field::AppId);
+        case TraceRoute::Delete:
+        case TraceRoute::Maintain: return static_cast<FieldMask>(Field::DeviceId);
+        default:                   return 0;
+    }
+}
+
+// 从 "userId=3" 形式的查询串中取出 key 对应的整数；缺失或非数字时返回 false
+bool parseQueryInt(const std::string &query, const std::string &key, long long &value) {
+    size_t pos = query.find(key + "=");
+    if (pos == std::string::npos || (pos > 0 && query[pos - 1] != '&')) return false;
+    const char *begin = query.c_str() + pos + key.size() + 1;
+    char *end = nullptr;
+    long long v = std::strtoll(begin, &end, 10);
+    if (end == begin) return false;
+    value = v;
+    return true;
+}
+
+// 管理员接口（线上先检查会话用户是否为管理员）
+bool requiresAdmin(TraceRoute route) {
+    switch (route) {
+        case TraceRoute::AdminAdd:
+        case TraceRoute::Applications:
+        case TraceRoute::Approve:
+        case TraceRoute::Delete:
+        case TraceRoute::Maintain:
+        case TraceRoute::Import:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+const char *replayOutcomeName(ReplayOutcome outcome) {
+    switch (outcome) {
+        case ReplayOutcome::Ok:         return "ok";
+        case ReplayOutcome::Rejected:   return "rejected";
+        case ReplayOutcome::BadRequest: return "bad_request";
+    }
+    return "unknown";
+}
+
+ReplayOutcome applyTraceRecord(LabManager &mgr, const TraceRecord &rec) {
+    std::time_t now = mgr.now();
+    std::string &buf = JsonWriter::threadBuffer();
+
+    // 记录了会话用户的管理员接口：按当时的用户类型重新检查，线上返回 403 的请求回放时同样拒绝
+    if (rec.userId != 0 && requiresAdmin(rec.route)) {
+        const User *u = mgr.getUser(rec.userId);
+        if (!u || u->type != UserType::Admin) return ReplayOutcome::Rejected;
+    }
+
+    // 无请求体的读接口
+    switch (rec.route) {
+        case TraceRoute::Devices:
+            writeDevicesResponse(buf, mgr, now);
+            return ReplayOutcome::Ok;
+        case TraceRoute::Applications:
+            writeApplicationsResponse(buf, mgr);
+            return ReplayOutcome::Ok;
+        case TraceRoute::Import: {
+            // 线上记录的负载为 importLogPayload（口令已哈希），这里只解析与插入；旧轨迹中的明文口令仍按参数哈希
+            ImportBatch batch = parseImport(rec.payload);
+            if (!batch.errors.empty()) return ReplayOutcome::BadRequest;
+            PreparedImport prepared = prepareImport(batch, mgr.strings, mgr.passwordParams);
+            return outcome(mgr.insertBulk(prepared.users, prepared.devices));
+        }
+        case TraceRoute::Notifications: {
+            long long userId = rec.userId;
+            if (userId == 0 && !parseQueryInt(rec.payload, "userId", userId)) return ReplayOutcome::BadRequest;
+            writeNotificationsResponse(buf, mgr.popNotifications(static_cast<int>(userId)));
+            return ReplayOutcome::Ok;
+        }
+        case TraceRoute::UserReservations: {
+            // 查看他人的预约须为管理员（线上返回 403）
+            long long userId = 0;
+            if (!parseQueryInt(rec.payload, "userId", userId)) return ReplayOutcome::BadRequest;
+            if (rec.userId != 0 && userId != rec.userId) {
+                const User *u = mgr.getUser(rec.userId);
+                if (!u || u->type != UserType::Admin) return ReplayOutcome::Rejected;
+            }
+            writeUserReservationsResponse(buf, mgr.userReservations(static_cast<int>(userId), now));
+            return ReplayOutcome::Ok;
+        }
+        case TraceRoute::Compact: {
+            long long before = 0;
+            if (!parseQueryInt(rec.payload, "before", before)) return ReplayOutcome::BadRequest;
+            mgr.compactReservations(static_cast<std::time_t>(before));
+            return ReplayOutcome::Ok;
+        }
+        case TraceRoute::Timers: {
+            long long until = 0;
+            if (!parseQueryInt(rec.payload, "until", until)) return ReplayOutcome::BadRequest;
+            mgr.advanceTimers(static_cast<std::time_t>(until));
+            return ReplayOutcome::Ok;
+        }
+        default:
+            break;
+    }
+
+    DecodedRequest body;
+    DecodeResult dr = decodeRequest(rec.payload, body, requiredFields(rec.route, rec.userId == 0));
+    if (!dr.ok()) return ReplayOutcome::BadRequest;
+    if (rec.route == TraceRoute::AdminAdd && (body.type < 0 || body.type > 2)) return ReplayOutcome::BadRequest;
+
+    int userId = rec.userId != 0 ? rec.userId : static_cast<int>(body.userId);
+    int deviceId = static_cast<int>(body.deviceId);
+    switch (rec.route) {
+        case TraceRoute::Login:
+            return outcome(mgr.authenticate(body.username, body.password).has_value());
+        case TraceRoute::Reserve:
+            return outcome(mgr.reserve(userId, deviceId, static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime)));
+        case TraceRoute::Borrow:
+            return outcome(mgr.borrow(userId, deviceId, now));
+        case TraceRoute::Return:
+            return outcome(mgr.returnDevice(userId, deviceId, now));
+        case TraceRoute::Extend:
+            return outcome(mgr.extend(userId, deviceId, static_cast<std::time_t>(body.endTime)));
+        case TraceRoute::AdminAdd:
+            mgr.addDevice(static_cast<DeviceType>(body.type), body.name, body.allowStudent);
+            return ReplayOutcome::Ok;
+        case TraceRoute::Apply:
+            mgr.apply(userId, deviceId, static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime), body.reason);
+            return ReplayOutcome::Ok;
+        case TraceRoute::Approve:
+            return outcome(mgr.approveApplication(static_cast<int>(body.appId)));
+        case TraceRoute::Delete:
+            return outcome(mgr.deleteDevice(deviceId));
+        case TraceRoute::Maintain:
+            return outcome(mgr.maintainDevice(deviceId));
+        case TraceRoute::Hold:
+            return outcome(mgr.hold(userId, deviceId, static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime)) != 0);
+        case TraceRoute::HoldConfirm:
+            return outcome(mgr.confirmHold(userId, static_cast<int>(body.holdId)) == LabManager::HoldOutcome::Ok);
+        case TraceRoute::HoldRelease:
+            return outcome(mgr.releaseHold(userId, static_cast<int>(body.holdId)));
+        default:
+            return ReplayOutcome::BadRequest;
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+// 轨迹回放：把一条轨迹记录作用到 LabManager 上，语义与 Server.cpp 中对应的处理函数一致
+// （同样的解码规则、同样的业务调用；读接口同样完成响应体序列化，以便计入耗时）
+
+#include "LabManager.h"
+#include "Trace.h"
+
+enum class ReplayOutcome {
+    Ok,          // 业务成功（对应响应中 ok 为 true）
+    Rejected,    // 业务拒绝（ok 为 false，如时间冲突、登录失败）
+    BadRequest   // 请求体解码失败（线上返回 400），未作用于 LabManager
+};
+
+const char *replayOutcomeName(ReplayOutcome outcome);
+
+// 回放一条记录；调用方需先把 mgr 的时钟设到记录的时间戳，并保证独占访问 mgr
+ReplayOutcome applyTraceRecord(LabManager &mgr, const TraceRecord &rec);
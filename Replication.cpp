@@ -0,0 +1,407 @@
+#include "Replication.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "Logger.h"
+#include "Replay.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr unsigned char kHeartbeat = 0xFF;
+constexpr std::uint64_t kMaxPayload = 256u << 20;   // 与轨迹文件相同的负载上限
+constexpr size_t kMaxChunk = 1u << 20;              // 每次推送最多约 1 MiB
+
+long long systemMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+void putVarint(std::string &out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+enum class Parse { Ok, Incomplete, Corrupt };
+
+Parse getVarint(const char *&p, const char *end, std::uint64_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return Parse::Incomplete;
+        unsigned char c = static_cast<unsigned char>(*p++);
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if (!(c & 0x80)) return Parse::Ok;
+    }
+    return Parse::Corrupt;
+}
+
+void putFrame(std::string &out, std::uint64_t seq, long long us, unsigned char route, int userId, const std::string &payload) {
+    putVarint(out, seq);
+    putVarint(out, static_cast<std::uint64_t>(us));
+    out.push_back(static_cast<char>(route));
+    putVarint(out, static_cast<std::uint32_t>(userId));
+    putVarint(out, payload.size());
+    out.append(payload);
+}
+
+struct Frame {
+    std::uint64_t seq{0};
+    long long us{0};
+    unsigned char route{0};
+    TraceRecord record;
+};
+
+// 解码一帧；不完整时 p 不前进
+Parse getFrame(const char *&p, const char *end, Frame &f) {
+    const char *q = p;
+    std::uint64_t seq, us, user, len;
+    Parse r;
+    if ((r = getVarint(q, end, seq)) != Parse::Ok) return r;
+    if ((r = getVarint(q, end, us)) != Parse::Ok) return r;
+    if (q == end) return Parse::Incomplete;
+    unsigned char route = static_cast<unsigned char>(*q++);
+    if (route != kHeartbeat && route >= kTraceRouteCount) return Parse::Corrupt;
+    if ((r = getVarint(q, end, user)) != Parse::Ok) return r;
+    if ((r = getVarint(q, end, len)) != Parse::Ok) return r;
+    if (len > kMaxPayload) return Parse::Corrupt;
+    if (static_cast<std::uint64_t>(end - q) < len) return Parse::Incomplete;
+    f.seq = seq;
+    f.us = static_cast<long long>(us);
+    f.route = route;
+    if (route != kHeartbeat) {
+        f.record.timestampUs = f.us;
+        f.record.route = static_cast<TraceRoute>(route);
+        f.record.userId = static_cast<int>(static_cast<std::uint32_t>(user));
+        f.record.payload.assign(q, static_cast<size_t>(len));
+    }
+    p = q + len;
+    return Parse::Ok;
+}
+
+} // namespace
+
+bool isMutationRoute(TraceRoute route) {
+    switch (route) {
+        case TraceRoute::Login:
+        case TraceRoute::Devices:
+        case TraceRoute::Applications:
+        case TraceRoute::UserReservations:
+        case TraceRoute::Count:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// ---- ReplicationLog ----
+
+ReplicationLog::~ReplicationLog() {
+    stop();
+}
+
+int ReplicationLog::start(const std::string &host, int port) {
+    server_.set_tcp_nodelay(true);
+    server_.Get("/wal", [this](const httplib::Request &req, httplib::Response &res) { serve(req, res); });
+    server_.Get("/wal/snapshot", [this](const httplib::Request &, httplib::Response &res) { serveSnapshot(res); });
+    int bound = port == 0 ? server_.bind_to_any_port(host) : (server_.bind_to_port(host, port) ? port : -1);
+    if (bound < 0) return -1;
+    port_ = bound;
+    thread_ = std::thread([this] { server_.listen_after_bind(); });
+    return bound;
+}
+
+void ReplicationLog::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+    }
+    appended_.notify_all();
+    if (server_.is_running()) server_.stop();
+    if (thread_.joinable()) thread_.join();
+}
+
+std::time_t ReplicationLog::append(TraceRoute route, int userId, const std::string &payload) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    // 时间单调：系统时间回拨时沿用上一条的时间
+    lastUs_ = std::max(lastUs_, systemMicros());
+    offsets_.push_back(log_.size());
+    putFrame(log_, base_ + offsets_.size(), lastUs_, static_cast<unsigned char>(route), userId, payload);
+    appended_.notify_all();
+    return static_cast<std::time_t>(lastUs_ / 1000000);
+}
+
+void ReplicationLog::compact(std::uint64_t seq, std::string snapshot) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (seq <= snapshotSeq_ || seq > base_ + offsets_.size()) return;
+    // 快照的时间取其覆盖的最后一帧（副本据此计算延迟）
+    if (seq > base_) {
+        const char *p = log_.data() + offsets_[seq - base_ - 1];
+        Frame f;
+        if (getFrame(p, log_.data() + log_.size(), f) == Parse::Ok) snapshotUs_ = f.us;
+    }
+    snapshot_ = std::make_shared<const std::string>(std::move(snapshot));
+    snapshotSeq_ = seq;
+    truncateLocked();
+}
+
+void ReplicationLog::truncateLocked() {
+    std::uint64_t cut = snapshotSeq_;
+    for (const auto &c : cursors_) cut = std::min(cut, c.second - 1);
+    if (cut <= base_) return;
+    size_t drop = static_cast<size_t>(cut - base_);
+    size_t bytes = drop < offsets_.size() ? offsets_[drop] : log_.size();
+    log_.erase(0, bytes);
+    offsets_.erase(offsets_.begin(), offsets_.begin() + static_cast<std::ptrdiff_t>(drop));
+    for (size_t &o : offsets_) o -= bytes;
+    base_ = cut;
+    logDebug("replication.truncate", {{"firstSeq", base_ + 1}, {"frames", offsets_.size()}, {"bytes", log_.size()}});
+}
+
+std::uint64_t ReplicationLog::lastSeq() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return base_ + offsets_.size();
+}
+
+std::uint64_t ReplicationLog::firstSeq() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return base_ + 1;
+}
+
+std::uint64_t ReplicationLog::snapshotSeq() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return snapshotSeq_;
+}
+
+void ReplicationLog::serveSnapshot(httplib::Response &res) {
+    std::shared_ptr<const std::string> data;
+    std::uint64_t seq;
+    long long us;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        data = snapshot_;
+        seq = snapshotSeq_;
+        us = snapshotUs_;
+    }
+    if (!data) {
+        res.status = 404;
+        return;
+    }
+    res.set_header("X-Snapshot-Seq", std::to_string(seq));
+    res.set_header("X-Snapshot-Us", std::to_string(us));
+    res.set_content(*data, "application/octet-stream");
+}
+
+// 推送自序号 from 起的日志：有新记录时整段复制后发送，空闲一秒发送一次心跳；
+// 副本断开或服务停止时结束。推送期间以该连接的发送位置作为截断的低水位
+void ReplicationLog::serve(const httplib::Request &req, httplib::Response &res) {
+    std::uint64_t from = req.has_param("from") ? std::strtoull(req.get_param_value("from").c_str(), nullptr, 10) : 1;
+    if (from == 0) from = 1;
+    std::uint64_t stream;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        std::uint64_t last = base_ + offsets_.size();
+        // 副本已应用的比主节点现有的还多：主节点重启过，副本状态已不可用
+        if (from > last + 1) {
+            logError("replication.follower_ahead", {{"from", from}, {"seq", last}, {"remote", req.remote_addr}});
+            res.status = 409;
+            return;
+        }
+        // 所需的帧已被快照覆盖并丢弃：副本须先安装快照
+        if (from <= base_) {
+            logInfo("replication.snapshot_required", {{"from", from}, {"firstSeq", base_ + 1}, {"remote", req.remote_addr}});
+            res.status = 410;
+            return;
+        }
+        stream = nextStream_++;
+        cursors_[stream] = from;
+    }
+    followers_.fetch_add(1, std::memory_order_relaxed);
+    logInfo("replication.follower", {{"from", from}, {"remote", req.remote_addr}});
+    res.set_chunked_content_provider(
+        "application/octet-stream",
+        [this, stream, next = from](size_t, httplib::DataSink &sink) mutable {
+            std::string chunk;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                appended_.wait_for(lk, std::chrono::seconds(1), [&] { return stopping_ || base_ + offsets_.size() >= next; });
+                if (stopping_) return false;
+                if (base_ + offsets_.size() >= next) {
+                    size_t first = static_cast<size_t>(next - base_ - 1);   // 低水位保证 next 之后的帧仍在
+                    size_t begin = offsets_[first];
+                    size_t last = first;
+                    while (last < offsets_.size() && offsets_[last] - begin < kMaxChunk) ++last;
+                    size_t end = last < offsets_.size() ? offsets_[last] : log_.size();
+                    chunk.assign(log_, begin, end - begin);
+                    next = base_ + last + 1;
+                    cursors_[stream] = next;
+                    if (snapshotSeq_ > base_) truncateLocked();
+                } else {
+                    putFrame(chunk, base_ + offsets_.size(), std::max(lastUs_, systemMicros()), kHeartbeat, 0, std::string());
+                }
+            }
+            return sink.write(chunk.data(), chunk.size());
+        },
+        [this, stream](bool) {
+            followers_.fetch_sub(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lk(mutex_);
+            cursors_.erase(stream);
+            if (snapshotSeq_ > base_) truncateLocked();
+        });
+}
+
+// ---- ReplicaFollower ----
+
+ReplicaFollower::ReplicaFollower(LabManager &mgr, PinnableClock &clock, std::string host, int port)
+    : mgr_(mgr), clock_(clock), host_(std::move(host)), port_(port) {}
+
+ReplicaFollower::~ReplicaFollower() {
+    stop();
+}
+
+void ReplicaFollower::start() {
+    thread_ = std::thread([this] { run(); });
+}
+
+void ReplicaFollower::stop() {
+    {
+        std::lock_guard<std::mutex> lk(waitMutex_);
+        stopping_.store(true);
+    }
+    waitCv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+ReplicaStatus ReplicaFollower::status() const {
+    ReplicaStatus s;
+    s.connected = connected_.load();
+    s.appliedSeq = appliedSeq_.load();
+    s.primarySeq = std::max(primarySeq_.load(), s.appliedSeq);
+    long long contact = contactUs_.load();
+    if (contact == 0) {
+        // 尚未与主节点建立过连接，延迟未知
+        s.lagMs = s.contactAgeMs = -1;
+        return s;
+    }
+    s.contactAgeMs = (systemMicros() - contact) / 1000;
+    if (s.appliedSeq < s.primarySeq) s.lagMs = std::max(0LL, primaryUs_.load() - appliedUs_.load()) / 1000;
+    // 断开期间主节点的新修改未知，延迟至少按失联时长计
+    if (!s.connected) s.lagMs = std::max(s.lagMs, s.contactAgeMs);
+    return s;
+}
+
+void ReplicaFollower::run() {
+    bool warned = false;
+    while (!stopping_.load()) {
+        httplib::Client cli(host_, port_);
+        cli.set_connection_timeout(2);
+        cli.set_read_timeout(5);   // 主节点空闲时每秒一次心跳，超时即视为断开
+        cli.set_tcp_nodelay(true);
+        std::string buf;
+        bool corrupt = false;
+        bool needSnapshot = false;
+        std::string path = "/wal?from=" + std::to_string(appliedSeq_.load() + 1);
+        cli.Get(
+            path,
+            [&](const httplib::Response &r) {
+                if (r.status == 410) {
+                    needSnapshot = true;
+                    return false;
+                }
+                if (r.status != 200) {
+                    logError("replica.rejected", {{"status", r.status}, {"from", appliedSeq_.load() + 1}});
+                    return false;
+                }
+                connected_.store(true);
+                warned = false;
+                logInfo("replica.connected", {{"host", host_}, {"port", port_}, {"from", appliedSeq_.load() + 1}});
+                return true;
+            },
+            [&](const char *data, size_t len) {
+                buf.append(data, len);
+                contactUs_.store(systemMicros());
+                size_t used = consume(buf);
+                if (used == std::string::npos) {
+                    corrupt = true;
+                    return false;
+                }
+                buf.erase(0, used);
+                return !stopping_.load();
+            });
+        connected_.store(false);
+        if (stopping_.load()) break;
+        if (needSnapshot && installSnapshot()) continue;
+        if (corrupt) logError("replica.corrupt_stream", {{"appliedSeq", appliedSeq_.load()}});
+        else if (!warned) logWarn("replica.disconnected", {{"host", host_}, {"port", port_}, {"appliedSeq", appliedSeq_.load()}});
+        warned = true;
+        std::unique_lock<std::mutex> lk(waitMutex_);
+        waitCv_.wait_for(lk, std::chrono::seconds(1), [this] { return stopping_.load(); });
+    }
+}
+
+bool ReplicaFollower::installSnapshot() {
+    httplib::Client cli(host_, port_);
+    cli.set_connection_timeout(2);
+    cli.set_read_timeout(30);
+    auto res = cli.Get("/wal/snapshot");
+    std::uint64_t seq = 0;
+    if (res && res->status == 200) seq = std::strtoull(res->get_header_value("X-Snapshot-Seq").c_str(), nullptr, 10);
+    if (seq <= appliedSeq_.load()) {
+        logError("replica.snapshot_unavailable", {{"status", res ? res->status : -1}, {"seq", seq}, {"appliedSeq", appliedSeq_.load()}});
+        return false;
+    }
+    bool ok;
+    {
+        std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+        ok = loadStateSnapshot(mgr_, res->body);
+    }
+    if (!ok) {
+        logError("replica.snapshot_install_failed", {{"seq", seq}, {"bytes", res->body.size()}});
+        return false;
+    }
+    long long us = std::strtoll(res->get_header_value("X-Snapshot-Us").c_str(), nullptr, 10);
+    appliedUs_.store(us);
+    appliedSeq_.store(seq);
+    if (seq > primarySeq_.load()) primarySeq_.store(seq);
+    logInfo("replica.snapshot_installed", {{"seq", seq}, {"bytes", res->body.size()}});
+    return true;
+}
+
+size_t ReplicaFollower::consume(const std::string &buf) {
+    const char *begin = buf.data();
+    const char *p = begin;
+    const char *end = begin + buf.size();
+    std::vector<Frame> batch;
+    for (;;) {
+        Frame f;
+        Parse r = getFrame(p, end, f);
+        if (r == Parse::Incomplete) break;
+        if (r == Parse::Corrupt) return std::string::npos;
+        primaryUs_.store(f.us);
+        if (f.seq > primarySeq_.load()) primarySeq_.store(f.seq);
+        if (f.route != kHeartbeat) batch.push_back(std::move(f));
+    }
+    if (!batch.empty()) {
+        // 一批记录只取一次独占锁；时钟固定为每条记录的时间，重放完恢复系统时间
+        std::unique_lock<std::shared_mutex> lock(mgr_.mutex);
+        std::uint64_t applied = appliedSeq_.load();
+        for (const Frame &f : batch) {
+            if (f.seq <= applied) continue;           // 重连后重复推送的部分
+            if (f.seq != applied + 1) {
+                clock_.unpin();
+                logError("replica.gap", {{"expected", applied + 1}, {"got", f.seq}});
+                return std::string::npos;
+            }
+            clock_.pin(static_cast<std::time_t>(f.us / 1000000));
+            applyTraceRecord(mgr_, f.record);
+            applied = f.seq;
+            appliedUs_.store(f.us);
+            appliedSeq_.store(applied);
+        }
+        clock_.unpin();
+    }
+    return static_cast<size_t>(p - begin);
+}
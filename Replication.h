@@ -0,0 +1,140 @@
+#pragma once
+// 主从复制（只读副本）：主节点把每个修改类请求按执行顺序追加到内存中的复制日志，
+// 副本经 TCP 连接持续拉取日志，在自己的 LabManager 上按日志时间重放（与 lab_replay 同一套语义，
+// 见 Replay.h），并以此对外提供设备列表、申请列表等读接口，读能力随副本数扩展。
+//
+// 复制日志只包含修改类路由（预约、借用、归还、延长、申请、审批、管理员增删维护、批量导入、弹出通知），
+// 记录内容与轨迹文件相同（路由、会话用户ID、请求体），另加递增序号与主节点时间戳。
+// 主节点在每次修改前把 LabManager 的时钟固定为该条日志的时间（秒），副本重放时设为同一时间，
+// 两边对同一请求做出相同判断。
+//
+// 传输：主节点在单独的端口上提供 GET /wal?from=N（与业务端口分开，不占用接口线程），
+// 以分块响应持续推送自序号 N 起的帧，空闲时每秒发送一次心跳帧（携带主节点最新序号与时间），
+// 副本据此计算复制延迟；连接断开后从已应用的下一条继续拉取。
+// 帧格式（整数为 LEB128 变长编码）：varint 序号 | varint 主节点时间（Unix 微秒） | 1 字节路由（0xFF 为心跳）|
+//   varint 会话用户ID | varint 负载长度 | 负载
+//
+// 副本须以与主节点相同的初始数据启动（同样的 --import / --catalog / --shard 参数），日志从主节点启动时开始。
+//
+// 日志压缩：主节点在最近快照之后积累一定条数时生成业务状态快照（见 StateSnapshot.h）并丢弃快照已覆盖的帧；
+// 仍连接着的副本尚未收到的帧保留到推送完为止（低水位）。请求的起点已被丢弃的副本（新启动或断开过久）
+// 收到 410，先经 GET /wal/snapshot 安装快照（响应头 X-Snapshot-Seq / X-Snapshot-Us），再从快照之后继续拉取
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "httplib.h"    // 引入 cpp-httplib 单头文件库（外部依赖）
+#include "Clock.h"
+#include "LabManager.h"
+#include "Trace.h"
+
+// 是否为修改类路由（需写入复制日志）
+bool isMutationRoute(TraceRoute route);
+
+// 主节点：复制日志与推送服务
+class ReplicationLog {
+public:
+    ReplicationLog() = default;
+    ~ReplicationLog();
+
+    ReplicationLog(const ReplicationLog &) = delete;
+    ReplicationLog &operator=(const ReplicationLog &) = delete;
+
+    // 在 host:port 上开始提供日志（port 为 0 时绑定任意空闲端口）；返回实际端口，失败返回 -1
+    int start(const std::string &host, int port);
+    void stop();
+
+    // 追加一条修改记录（调用方持有 LabManager 独占锁，追加顺序即执行顺序）；返回记录的时间（秒）
+    std::time_t append(TraceRoute route, int userId, const std::string &payload);
+
+    // 登记快照并截断日志：snapshot 为序号 seq 及之前全部修改作用后的状态
+    // （调用方在持有 LabManager 共享锁期间读取 lastSeq 并序列化，见 ApiServer::snapshotReplicationLog）
+    void compact(std::uint64_t seq, std::string snapshot);
+
+    std::uint64_t lastSeq() const;
+    std::uint64_t firstSeq() const;        // 内存中最早一帧的序号（日志为空时为 lastSeq + 1）
+    std::uint64_t snapshotSeq() const;     // 最近快照覆盖到的序号（尚无快照时为 0）
+    int port() const { return port_; }
+    size_t followers() const { return followers_.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable appended_;
+    std::string log_;                      // 内存中的帧首尾相接
+    std::vector<size_t> offsets_;          // 第 i 条（序号 base_ + i + 1）帧在 log_ 中的起始位置
+    std::uint64_t base_{0};                // 已丢弃的帧数（即被丢弃的最后一帧的序号）
+    std::shared_ptr<const std::string> snapshot_;
+    std::uint64_t snapshotSeq_{0};
+    long long snapshotUs_{0};              // 快照覆盖的最后一帧的主节点时间
+    std::map<std::uint64_t, std::uint64_t> cursors_;   // 推送中的连接 -> 下一条待发送的序号（低水位）
+    std::uint64_t nextStream_{0};
+    long long lastUs_{0};
+    bool stopping_{false};
+    int port_{-1};
+    std::atomic<size_t> followers_{0};
+    httplib::Server server_;
+    std::thread thread_;
+
+    void serve(const httplib::Request &req, httplib::Response &res);
+    void serveSnapshot(httplib::Response &res);
+    // 丢弃快照已覆盖且各连接都已发送的帧（持有 mutex_ 时调用）
+    void truncateLocked();
+};
+
+// 副本的复制状态
+struct ReplicaStatus {
+    bool connected{false};
+    std::uint64_t appliedSeq{0};       // 已应用的最后一条记录序号
+    std::uint64_t primarySeq{0};       // 已知的主节点最新序号
+    long long lagMs{0};                // 复制延迟：已追平且连接正常时为 0
+    long long contactAgeMs{0};         // 距上次收到主节点数据（含心跳）的时间
+};
+
+// 副本：后台线程拉取并重放主节点日志
+class ReplicaFollower {
+public:
+    // clock 须为 mgr 正在使用的时钟：重放每批记录时固定为记录时间，之后恢复系统时间
+    ReplicaFollower(LabManager &mgr, PinnableClock &clock, std::string host, int port);
+    ~ReplicaFollower();
+
+    ReplicaFollower(const ReplicaFollower &) = delete;
+    ReplicaFollower &operator=(const ReplicaFollower &) = delete;
+
+    void start();
+    void stop();
+
+    ReplicaStatus status() const;
+    const std::string &primaryHost() const { return host_; }
+    int primaryPort() const { return port_; }
+
+private:
+    LabManager &mgr_;
+    PinnableClock &clock_;
+    std::string host_;
+    int port_;
+
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> connected_{false};
+    std::atomic<std::uint64_t> appliedSeq_{0};
+    std::atomic<std::uint64_t> primarySeq_{0};
+    std::atomic<long long> appliedUs_{0};      // 最后应用的记录的主节点时间
+    std::atomic<long long> primaryUs_{0};      // 最近一帧携带的主节点时间
+    std::atomic<long long> contactUs_{0};      // 最近收到数据的本地时间
+    std::mutex waitMutex_;
+    std::condition_variable waitCv_;
+    std::thread thread_;
+
+    void run();
+    // 主节点已丢弃所需的帧时：下载并安装快照，成功后从快照之后继续拉取
+    bool installSnapshot();
+    // 解码并应用 buf 中的完整帧，返回消耗的字节数；遇到损坏数据时返回 npos
+    size_t consume(const std::string &buf);
+};
@@ -0,0 +1,216 @@
+#include "RequestDecoder.h"
+#include <climits>
+#include <cmath>
+
+#include "json.hpp"
+
+namespace {
+
+using json = nlohmann::json;
+
+// 字段名 -> 字段枚举：请求体只有十几个已知键，线性比较即可
+Field lookupField(const std::string &k) {
+    switch (k.size()) {
+        case 4:
+            if (k == "type") return Field::Type;
+            if (k == "name") return Field::Name;
+            break;
+        case 5:
+            if (k == "appId") return Field::AppId;
+            break;
+        case 6:
+            if (k == "userId") return Field::UserId;
+            if (k == "reason") return Field::Reason;
+            if (k == "holdId") return Field::HoldId;
+            break;
+        case 7:
+            if (k == "endTime") return Field::EndTime;
+            break;
+        case 8:
+            if (k == "deviceId") return Field::DeviceId;
+            if (k == "username") return Field::Username;
+            if (k == "password") return Field::Password;
+            break;
+        case 9:
+            if (k == "startTime") return Field::StartTime;
+            break;
+        case 12:
+            if (k == "allowStudent") return Field::AllowStudent;
+            break;
+    }
+    return Field::None;
+}
+
+// SAX 处理器：只关心深度为 1 的键值，嵌套对象 / 数组整体跳过
+class FieldExtractor {
+public:
+    explicit FieldExtractor(DecodedRequest &out) : out_(out) {}
+
+    DecodeResult result;
+
+    bool null() { return scalarMismatch(); }
+    bool boolean(bool v) {
+        if (!atField()) return true;
+        if (current_ != Field::AllowStudent) return fail(DecodeError::WrongType);
+        out_.allowStudent = v;
+        return mark();
+    }
+    bool number_integer(json::number_integer_t v) { return number(static_cast<long long>(v)); }
+    // 未识别的键与嵌套值只检查位置，不取值（也就不做可能越界的转换）
+    bool number_unsigned(json::number_unsigned_t v) {
+        if (!atField()) return number(0);
+        if (v > static_cast<json::number_unsigned_t>(LLONG_MAX)) return fail(DecodeError::WrongType);
+        return number(static_cast<long long>(v));
+    }
+    // 浮点数只接受整数值（如 1e3）：ID 与时间戳带小数部分时不截断，按类型不符拒绝
+    bool number_float(json::number_float_t v, const std::string &) {
+        if (!atField()) return number(0);
+        if (!(v > static_cast<double>(LLONG_MIN) && v < static_cast<double>(LLONG_MAX) && std::trunc(v) == v)) return fail(DecodeError::WrongType);
+        return number(static_cast<long long>(v));
+    }
+    bool string(std::string &v) {
+        if (!atField()) return true;
+        std::string *dst = stringSlot();
+        if (!dst) return fail(DecodeError::WrongType);
+        dst->swap(v);
+        return mark();
+    }
+    bool binary(json::binary_t &) { return scalarMismatch(); }
+
+    bool start_object(std::size_t) {
+        if (depth_ == 0) sawObject_ = true;
+        else if (atField()) return fail(DecodeError::WrongType);
+        ++depth_;
+        return true;
+    }
+    bool end_object() { --depth_; return true; }
+    bool start_array(std::size_t) {
+        if (depth_ == 0) return fail(DecodeError::NotObject);
+        if (atField()) return fail(DecodeError::WrongType);
+        ++depth_;
+        return true;
+    }
+    bool end_array() { --depth_; return true; }
+    bool key(std::string &k) {
+        current_ = depth_ == 1 ? lookupField(k) : Field::None;
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+        result.error = DecodeError::Malformed;
+        return false;
+    }
+
+    bool sawObject() const { return sawObject_; }
+
+private:
+    bool atField() const { return depth_ == 1 && current_ != Field::None; }
+
+    bool scalarMismatch() {
+        if (depth_ == 0) return fail(DecodeError::NotObject);
+        return atField() ? fail(DecodeError::WrongType) : true;
+    }
+
+    bool number(long long v) {
+        if (depth_ == 0) return fail(DecodeError::NotObject);
+        if (!atField()) return true;
+        long long *dst = numberSlot();
+        if (!dst) return fail(DecodeError::WrongType);
+        if (isId(current_) && (v < INT_MIN || v > INT_MAX)) return fail(DecodeError::InvalidValue);
+        *dst = v;
+        return mark();
+    }
+
+    // ID 字段在业务层是 int：超出范围的取值在这里拒绝，调用方可以直接收窄
+    static bool isId(Field f) {
+        return f == Field::UserId || f == Field::DeviceId || f == Field::AppId || f == Field::HoldId;
+    }
+
+    long long *numberSlot() {
+        switch (current_) {
+            case Field::UserId:    return &out_.userId;
+            case Field::DeviceId:  return &out_.deviceId;
+            case Field::StartTime: return &out_.startTime;
+            case Field::EndTime:   return &out_.endTime;
+            case Field::AppId:     return &out_.appId;
+            case Field::HoldId:    return &out_.holdId;
+            case Field::Type:      return &out_.type;
+            default:               return nullptr;
+        }
+    }
+
+    std::string *stringSlot() {
+        switch (current_) {
+            case Field::Name:     return &out_.name;
+            case Field::Reason:   return &out_.reason;
+            case Field::Username: return &out_.username;
+            case Field::Password: return &out_.password;
+            default:              return nullptr;
+        }
+    }
+
+    bool mark() {
+        out_.present |= static_cast<FieldMask>(current_);
+        return true;
+    }
+
+    bool fail(DecodeError e) {
+        result.error = e;
+        result.field = current_;
+        return false;
+    }
+
+    DecodedRequest &out_;
+    int depth_{0};
+    Field current_{Field::None};
+    bool sawObject_{false};
+};
+
+} // namespace
+
+DecodeResult decodeRequest(std::string_view body, DecodedRequest &out, FieldMask required) {
+    FieldExtractor sax(out);
+    bool parsed = json::sax_parse(body.data(), body.data() + body.size(), &sax);
+    if (!parsed) {
+        if (sax.result.ok()) sax.result.error = DecodeError::Malformed;
+        return sax.result;
+    }
+    if (!sax.sawObject()) return DecodeResult{DecodeError::NotObject, Field::None};
+
+    FieldMask missing = required & ~out.present;
+    if (missing != 0) {
+        FieldMask first = missing & (~missing + 1); // 取最低位的缺失字段
+        return DecodeResult{DecodeError::MissingField, static_cast<Field>(first)};
+    }
+    return DecodeResult{};
+}
+
+const char *decodeErrorName(DecodeError e) {
+    switch (e) {
+        case DecodeError::None:         return "none";
+        case DecodeError::Malformed:    return "malformed";
+        case DecodeError::NotObject:    return "not_object";
+        case DecodeError::MissingField: return "missing_field";
+        case DecodeError::WrongType:    return "wrong_type";
+        case DecodeError::InvalidValue: return "invalid_value";
+    }
+    return "unknown";
+}
+
+const char *fieldName(Field f) {
+    switch (f) {
+        case Field::None:         return "";
+        case Field::UserId:       return "userId";
+        case Field::DeviceId:     return "deviceId";
+        case Field::StartTime:    return "startTime";
+        case Field::EndTime:      return "endTime";
+        case Field::AppId:        return "appId";
+        case Field::Type:         return "type";
+        case Field::Name:         return "name";
+        case Field::AllowStudent: return "allowStudent";
+        case Field::Reason:       return "reason";
+        case Field::Username:     return "username";
+        case Field::Password:     return "password";
+        case Field::HoldId:       return "holdId";
+    }
+    return "";
+}
@@ -0,0 +1,71 @@
+#pragma once
+// 请求解码层：基于 nlohmann 的 SAX 接口直接从请求体中抽取顶层标量字段（userId、deviceId、startTime 等），
+// 不构建 JSON DOM；解析失败、缺字段或类型不符时返回结构化错误码，热路径上不抛异常
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 可识别的请求字段，按位组合成掩码用于声明必填字段
+enum class Field : std::uint32_t {
+    None         = 0,
+    UserId       = 1u << 0,
+    DeviceId     = 1u << 1,
+    StartTime    = 1u << 2,
+    EndTime      = 1u << 3,
+    AppId        = 1u << 4,
+    Type         = 1u << 5,
+    Name         = 1u << 6,
+    AllowStudent = 1u << 7,
+    Reason       = 1u << 8,
+    Username     = 1u << 9,
+    Password     = 1u << 10,
+    HoldId       = 1u << 11,
+};
+
+using FieldMask = std::uint32_t;
+constexpr FieldMask operator|(Field a, Field b) { return static_cast<FieldMask>(a) | static_cast<FieldMask>(b); }
+constexpr FieldMask operator|(FieldMask a, Field b) { return a | static_cast<FieldMask>(b); }
+
+// 解码错误码
+enum class DecodeError {
+    None,          // 成功
+    Malformed,     // 不是合法 JSON
+    NotObject,     // 顶层不是对象
+    MissingField,  // 缺少必填字段
+    WrongType,     // 字段类型不符（如 userId 为字符串）
+    InvalidValue,  // 类型正确但取值非法（ID 超出 int 范围时由解码器设置，其余由调用方校验后设置）
+};
+
+struct DecodeResult {
+    DecodeError error{DecodeError::None};
+    Field field{Field::None}; // 出错的字段（MissingField / WrongType / InvalidValue 时有效）
+    bool ok() const { return error == DecodeError::None; }
+};
+
+// 解码后的请求：数值字段统一以 long long 保存；浮点输入须为整数值（如 1e3），带小数部分的返回 WrongType；
+// userId / deviceId / appId / holdId 保证在 int 范围内，超出时返回 InvalidValue
+struct DecodedRequest {
+    FieldMask present{0};
+    long long userId{0};
+    long long deviceId{0};
+    long long startTime{0};
+    long long endTime{0};
+    long long appId{0};
+    long long holdId{0};
+    long long type{0};
+    bool allowStudent{true};
+    std::string name;
+    std::string reason;
+    std::string username;
+    std::string password;
+
+    bool has(Field f) const { return (present & static_cast<FieldMask>(f)) != 0; }
+};
+
+// 解码请求体；required 中声明的字段缺失时返回 MissingField（field 为第一个缺失字段）
+DecodeResult decodeRequest(std::string_view body, DecodedRequest &out, FieldMask required = 0);
+
+// 错误码 / 字段名的文本表示（用于响应体中的 error / field）
+const char *decodeErrorName(DecodeError e);
+const char *fieldName(Field f);
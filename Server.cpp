@@ -1,319 +1,846 @@
-// HTTP 服务器入口（替代 main.cpp）：提供设备与预约相关的 REST 接口
-#include <iostream>
+// HTTP 接口层实现：路由注册与各 REST 接口的处理函数；进程入口见 main.cpp
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <string>
 #include <ctime>
-#include <fstream>
-#include "httplib.h"    // 引入 cpp-httplib 单头文件库（外部依赖）
+#include <future>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include "json.hpp"     // 引入 nlohmann/json 单头文件（外部依赖）
 
-#include "LabManager.h"
+#include "Server.h"
+#include "ApiJson.h"
+#include "Logger.h"
+#include "StateSnapshot.h"
 
 using json = nlohmann::json;
 
-int main() {
-    LabManager mgr;
-    mgr.seed();
+// 校验队列默认不超过 HTTP 线程数的一半：即使登录请求全部在等待校验，也至少留一半线程处理其他接口
+static size_t defaultVerifyQueue() {
+    return std::max<size_t>(1, static_cast<size_t>(CPPHTTPLIB_THREAD_POOL_COUNT) / 2);
+}
 
-    httplib::Server svr;
-    svr.Get("/", [&](const httplib::Request &req, httplib::Response &res) {
-        std::ifstream f("index.html", std::ios::binary);
-        if (!f) {
-            res.status = 404;
-            res.set_content("index.html not found", "text/plain; charset=UTF-8");
-            return;
+ApiServer::ApiServer(LabManager &mgr, ServerOptions options)
+    : mgr(mgr), options(std::move(options)), sessions(this->options.sessionSecret, this->options.sessionTtl),
+      verifier(this->options.verifyThreads, this->options.verifyQueue ? this->options.verifyQueue : defaultVerifyQueue()),
+      loginThrottle(this->options.loginThrottle), dummyHash(hashPassword("", mgr.passwordParams)) {
+    // 响应头与响应体分两次写出，keep-alive 连接上 Nagle 与延迟 ACK 叠加会使每个请求多等约 40ms
+    http.set_tcp_nodelay(true);
+    // 前端静态资源：启动时读入内存并预压缩，可选监听文件变化自动重载
+    if (this->options.serveStatic) {
+        assets.add("/", "index.html", "text/html; charset=UTF-8", "no-cache");
+        assets.add("/index.html", "index.html", "text/html; charset=UTF-8", "no-cache");
+        assets.add("/app.js", "app.js", "application/javascript; charset=UTF-8", "no-cache");
+        assets.loadAll();
+        if (this->options.staticReload) assets.startWatching();
+        for (const auto &path : assets.paths()) {
+            http.Get(path, [this](const httplib::Request &req, httplib::Response &res) { assets.serve(req, res); });
+        }
+    }
+    if (!this->options.tracePath.empty()) {
+        if (trace.open(this->options.tracePath)) logInfo("trace.open", {{"path", this->options.tracePath}});
+        else logError("trace.open_failed", {{"path", this->options.tracePath}});
+    }
+    // 随机密钥只在本进程内有效：多进程部署或希望重启后令牌仍可用时需设置 LAB_SESSION_SECRET
+    if (sessions.ephemeralSecret()) logWarn("session.ephemeral_secret", {{"ttl", sessions.ttl()}});
+    logInfo("login.verify_pool", {{"threads", verifier.threads()}, {"capacity", verifier.capacity()}});
+    // 复制：主节点、副本与共识复制节点都改用可固定的时钟（见 Replication.h / Raft.h）
+    bool consensus = !this->options.raft.peers.empty();
+    if (this->options.replicationPort >= 0 || !this->options.replicaHost.empty() || consensus) {
+        auto clock = std::make_shared<PinnableClock>();
+        mgr.clock = clock;
+        pinnedClock = clock.get();
+    }
+    if (this->options.replicationPort >= 0) {
+        replicationLog = std::make_unique<ReplicationLog>();
+        int port = replicationLog->start(this->options.replicationHost, this->options.replicationPort);
+        if (port >= 0) logInfo("replication.listen", {{"host", this->options.replicationHost}, {"port", port}});
+        else logError("replication.listen_failed", {{"host", this->options.replicationHost}, {"port", this->options.replicationPort}});
+    }
+    if (!this->options.replicaHost.empty()) {
+        replica = std::make_unique<ReplicaFollower>(mgr, *pinnedClock, this->options.replicaHost, this->options.replicaPort);
+        replica->start();
+        registerReplicaGuards();
+    }
+    if (consensus) {
+        raft = std::make_unique<RaftNode>(mgr, *pinnedClock, this->options.raft);
+        if (raft->start()) registerRaftErrors();
+        else raft.reset();
+    }
+    // 共识复制模式下修改由 Raft 的应用线程串行执行，不再需要命令管线
+    if (this->options.singleWriter && !consensus) {
+        pipeline = std::make_unique<CommandPipeline>(mgr, this->options.writerBatch);
+        logInfo("server.single_writer", {{"batch", pipeline->maxBatch()}});
+    }
+    registerRoutes();
+    if ((this->options.compactInterval > 0 || this->options.timers || replicationLog) && !replica) housekeeping.thread = std::thread([this] { housekeepingLoop(); });
+}
+
+ApiServer::~ApiServer() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lk(housekeeping.mutex);
+        housekeeping.stopping = true;
+    }
+    housekeeping.cv.notify_all();
+    if (housekeeping.thread.joinable()) housekeeping.thread.join();
+    assets.stopWatching();
+    if (replica) replica->stop();
+    if (replicationLog) replicationLog->stop();
+    if (raft) raft->stop();
+    if (pipeline) logInfo("server.single_writer_stats", {{"commands", pipeline->commands()}, {"batches", pipeline->batches()}});
+    if (trace.isOpen()) {
+        logInfo("trace.close", {{"path", options.tracePath}, {"records", trace.count()}});
+        trace.close();
+    }
+}
+
+bool ApiServer::listen(const std::string &host, int port) {
+    logInfo("server.listen", {{"host", host}, {"port", port}});
+    return http.listen(host, port);
+}
+
+int ApiServer::bindToAnyPort(const std::string &host) {
+    return http.bind_to_any_port(host);
+}
+
+bool ApiServer::listenAfterBind() {
+    return http.listen_after_bind();
+}
+
+void ApiServer::stop() {
+    if (http.is_running()) http.stop();
+}
+
+void ApiServer::addCors(httplib::Response &res) const {
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    res.set_header("Access-Control-Allow-Methods", "GET,POST,OPTIONS");
+}
+
+// 列表类 JSON 响应：超过阈值且客户端支持时透明压缩（需以 LAB_WITH_ZLIB 构建）
+void ApiServer::sendJson(const httplib::Request &req, httplib::Response &res, const std::string &body) const {
+    res.set_content(body, "application/json");
+    compressResponse(req, res, options.compression);
+}
+
+// 请求解码失败：返回 400 与结构化错误码（error / field），不再依赖异常
+void ApiServer::sendBadRequest(httplib::Response &res, const DecodeResult &r) const {
+    res.status = 400;
+    res.set_content(json({{"ok", false}, {"message", "请求格式错误"}, {"error", decodeErrorName(r.error)}, {"field", fieldName(r.field)}}).dump(), "application/json");
+    addCors(res);
+}
+
+// 429 / 503：附带 Retry-After 头，客户端按建议间隔重试
+void ApiServer::sendRetryLater(httplib::Response &res, int status, const char *message, int retryAfter) const {
+    res.status = status;
+    res.set_header("Retry-After", std::to_string(retryAfter));
+    res.set_content(json({{"ok", false}, {"message", message}}).dump(), "application/json");
+    addCors(res);
+}
+
+// 会话校验：从 Authorization: Bearer 头取出令牌并校验（不访问 LabManager，在加锁之前调用）；
+// 失败时写好 401 响应并返回 false
+bool ApiServer::authorize(const httplib::Request &req, httplib::Response &res, SessionClaims &claims) const {
+    const std::string header = req.get_header_value("Authorization");
+    std::string_view token = SessionTokens::bearerToken(header);
+    TokenError err = sessions.validate(token, mgr.now(), claims);
+    if (err == TokenError::None) return true;
+    logDebug("session.rejected", {{"path", req.path}, {"error", tokenErrorName(err)}, {"remote", req.remote_addr}});
+    res.status = 401;
+    res.set_content(json({{"ok", false}, {"message", "未登录或会话已过期"}, {"error", tokenErrorName(err)}}).dump(), "application/json");
+    addCors(res);
+    return false;
+}
+
+// 管理员接口的权限检查：需在持有 mgr.mutex 时调用（读取用户类型）；非管理员返回 403
+bool ApiServer::requireAdmin(int userId, httplib::Response &res) const {
+    const User *u = mgr.getUser(userId);
+    if (u && u->type == UserType::Admin) return true;
+    res.status = 403;
+    res.set_content(json({{"ok", false}, {"message", "需要管理员权限"}}).dump(), "application/json");
+    addCors(res);
+    return false;
+}
+
+// 轨迹记录：处理函数在取得 mgr.mutex 之后调用（单写者模式下修改类请求在写线程中调用），
+// 文件中的顺序即请求作用于 LabManager 的顺序；
+// userId 为会话令牌中的用户（无需令牌的接口传 0）
+// 主节点：修改类请求同时写入复制日志，并把时钟固定为日志时间直到本次修改结束（见 mutate）
+void ApiServer::traceRequest(TraceRoute route, int userId, const httplib::Request &req, const std::string *payload) {
+    bool replicate = replicationLog && isMutationRoute(route);
+    if (!replicate && !trace.isOpen()) return;
+    std::string built;
+    if (!payload) payload = &(built = tracePayload(route, userId, req));
+    if (replicate) pinnedClock->pin(replicationLog->append(route, userId, *payload));
+    if (trace.isOpen()) trace.append(route, userId, *payload);
+}
+
+// 记录的负载：POST 为请求体，GET /api/notifications 为查询串，GET /api/users/{id}/reservations 为路径中的用户，其余 GET 为空
+std::string ApiServer::tracePayload(TraceRoute route, int userId, const httplib::Request &req) {
+    if (route == TraceRoute::Notifications) return "userId=" + std::to_string(userId);
+    if (route == TraceRoute::UserReservations) return "userId=" + req.matches[1].str();
+    return req.body;
+}
+
+// 只读副本：拒绝修改类接口（含会弹出通知的 GET /api/notifications），所有响应附带复制延迟
+void ApiServer::registerReplicaGuards() {
+    http.set_pre_routing_handler([this](const httplib::Request &req, httplib::Response &res) {
+        bool readOnly = req.method == "OPTIONS" || req.path == "/api/login" || req.path == "/api/logout" ||
+                        (req.method == "GET" && req.path != "/api/notifications");
+        if (readOnly) return httplib::Server::HandlerResponse::Unhandled;
+        res.status = 403;
+        res.set_content(json({{"ok", false}, {"message", "只读副本不接受修改，请向主节点提交"}}).dump(), "application/json");
+        addCors(res);
+        return httplib::Server::HandlerResponse::Handled;
+    });
+    http.set_post_routing_handler([this](const httplib::Request &, httplib::Response &res) {
+        ReplicaStatus s = replica->status();
+        res.set_header("X-Replica-Lag-Ms", std::to_string(s.lagMs));
+        res.set_header("X-Replica-Applied-Seq", std::to_string(s.appliedSeq));
+    });
+}
+
+// 共识复制：提交失败（RaftUnavailable）统一返回 503 与 Retry-After，已知主节点时附带 X-Raft-Leader
+void ApiServer::registerRaftErrors() {
+    http.set_exception_handler([this](const httplib::Request &req, httplib::Response &res, std::exception_ptr ep) {
+        try {
+            std::rethrow_exception(ep);
+        } catch (const RaftUnavailable &e) {
+            logWarn("raft.request_failed", {{"path", req.path}, {"reason", e.what()}, {"leader", e.leaderApi}});
+            if (!e.leaderApi.empty()) res.set_header("X-Raft-Leader", e.leaderApi);
+            sendRetryLater(res, 503, e.what(), 1);
+        } catch (const std::exception &e) {
+            logError("http.exception", {{"path", req.path}, {"what", e.what()}});
+            res.status = 500;
+            addCors(res);
         }
-        std::string content((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-        res.set_content(content, "text/html; charset=UTF-8");
     });
+}
+
+// 共识复制的跟随者：修改类接口（与只读副本拒绝的范围相同）转发给主节点，返回 true 表示已处理。
+// 在各修改类处理函数开头调用（预路由阶段请求体尚未读取，不能在那里转发）；读接口在本地处理
+bool ApiServer::forwardIfFollower(const httplib::Request &req, httplib::Response &res) {
+    if (!raft || raft->isLeader()) return false;
+    forwardToLeader(req, res);
+    return true;
+}
+
+// 把请求原样转发给主节点（方法、路径与查询串、请求体、Authorization）并转回响应。
+// 被转发的请求带 X-Raft-Forwarded 头：主节点恰好在此期间变更时不再二次转发，直接返回 503
+void ApiServer::forwardToLeader(const httplib::Request &req, httplib::Response &res) {
+    std::string leader = raft->leaderApi();
+    size_t colon = leader.rfind(':');
+    if (leader.empty() || colon == std::string::npos || req.has_header("X-Raft-Forwarded")) {
+        sendRetryLater(res, 503, "正在选举主节点，请稍后重试", 1);
+        return;
+    }
+    std::unique_ptr<httplib::Client> cli;
+    {
+        std::lock_guard<std::mutex> lk(leaderPool.mutex);
+        if (leaderPool.address != leader) {
+            leaderPool.address = leader;
+            leaderPool.idle.clear();
+        } else if (!leaderPool.idle.empty()) {
+            cli = std::move(leaderPool.idle.back());
+            leaderPool.idle.pop_back();
+        }
+    }
+    if (!cli) {
+        cli = std::make_unique<httplib::Client>(leader.substr(0, colon), std::atoi(leader.c_str() + colon + 1));
+        cli->set_keep_alive(true);
+        cli->set_tcp_nodelay(true);
+        cli->set_connection_timeout(1);
+        cli->set_read_timeout(options.raft.commitTimeoutMs / 1000 + 5);   // 主节点等待提交的上限之外再留余量
+    }
+    httplib::Headers headers{{"X-Raft-Forwarded", "1"}};
+    if (req.has_header("Authorization")) headers.emplace("Authorization", req.get_header_value("Authorization"));
+    const std::string &target = req.target.empty() ? req.path : req.target;
+    httplib::Result r = req.method == "POST"
+        ? cli->Post(target, headers, req.body, req.get_header_value("Content-Type", "application/json"))
+        : cli->Get(target, headers);
+    if (!r) {
+        logWarn("raft.forward_failed", {{"leader", leader}, {"path", req.path}, {"error", httplib::to_string(r.error())}});
+        res.set_header("X-Raft-Leader", leader);
+        sendRetryLater(res, 503, "主节点不可用，请稍后重试", 1);
+        return;
+    }
+    res.status = r->status;
+    res.set_content(r->body, r->get_header_value("Content-Type", "application/json"));
+    if (r->has_header("Retry-After")) res.set_header("Retry-After", r->get_header_value("Retry-After"));
+    res.set_header("X-Raft-Leader", leader);
+    addCors(res);
+    std::lock_guard<std::mutex> lk(leaderPool.mutex);
+    if (leaderPool.address == leader) leaderPool.idle.push_back(std::move(cli));
+}
+
+// 每秒一轮：处理到期定时器，每隔 compactInterval 秒压缩一次预约
+void ApiServer::housekeepingLoop() {
+    auto nextCompact = std::chrono::steady_clock::now() + std::chrono::seconds(options.compactInterval);
+    std::unique_lock<std::mutex> lk(housekeeping.mutex);
+    while (!housekeeping.cv.wait_for(lk, std::chrono::seconds(1), [this] { return housekeeping.stopping; })) {
+        lk.unlock();
+        if (options.timers) fireTimers();
+        if (options.compactInterval > 0 && std::chrono::steady_clock::now() >= nextCompact) {
+            compactReservations();
+            nextCompact = std::chrono::steady_clock::now() + std::chrono::seconds(options.compactInterval);
+        }
+        if (replicationLog && replicationLog->lastSeq() - replicationLog->snapshotSeq() >= options.replicationSnapshotEvery) {
+            snapshotReplicationLog();
+        }
+        lk.lock();
+    }
+}
+
+// 复制日志快照：日志在 LabManager 独占锁内追加，持共享锁时读到的序号与状态一致；序列化完即可截断（见 ReplicationLog::compact）
+void ApiServer::snapshotReplicationLog() {
+    if (!replicationLog) return;
+    auto t0 = std::chrono::steady_clock::now();
+    std::string data;
+    std::uint64_t seq;
+    {
+        std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+        seq = replicationLog->lastSeq();
+        writeStateSnapshot(data, mgr);
+    }
+    size_t bytes = data.size();
+    replicationLog->compact(seq, std::move(data));
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+    logInfo("replication.snapshot", {{"seq", seq}, {"bytes", bytes}, {"firstSeq", replicationLog->firstSeq()}, {"us", us}});
+}
 
-    auto add_cors = [&](httplib::Response &res) {
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type");
-        res.set_header("Access-Control-Allow-Methods", "GET,POST,OPTIONS");
-    };
+// 到期定时器：共享锁下先看时间轮的下一个到期时刻，没有到期的不产生修改（也不写轨迹 / 日志）；
+// 有到期的经 mutate 推进（timers 路由，负载为推进到的时刻），副本与跟随者按日志重放
+void ApiServer::fireTimers() {
+    if (raft && !raft->isLeader()) return;
+    std::time_t until = mgr.now();
+    {
+        std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+        if (mgr.nextTimerDue() > until) return;
+    }
+    httplib::Request req;
+    req.body = "until=" + std::to_string(until);
+    try {
+        size_t notified = mutate(TraceRoute::Timers, 0, req, [&](LabManager &m) { return m.advanceTimers(until); });
+        if (notified > 0) logDebug("timers.fired", {{"notified", notified}, {"until", static_cast<long long>(until)}});
+    } catch (const RaftUnavailable &e) {
+        logWarn("timers.advance_failed", {{"reason", e.what()}});
+    }
+}
+
+// 预约压缩：与接口修改一样经 mutate 执行并记入轨迹 / 复制日志（compact 路由，负载为截止时间），
+// 副本与跟随者按日志中的截止时间重放；共识复制模式下只由主节点发起
+void ApiServer::compactReservations() {
+    if (raft && !raft->isLeader()) return;
+    std::time_t before = mgr.now() - options.compactGrace;
+    httplib::Request req;
+    req.body = "before=" + std::to_string(before);
+    try {
+        size_t archived = mutate(TraceRoute::Compact, 0, req, [&](LabManager &m) { return m.compactReservations(before); });
+        if (archived > 0) logInfo("reservations.compacted", {{"archived", archived}, {"before", static_cast<long long>(before)}});
+    } catch (const RaftUnavailable &e) {
+        logWarn("reservations.compact_failed", {{"reason", e.what()}});
+    }
+}
 
+// 路由注册：LabManager 本身不是线程安全的，读接口持有 mgr.mutex 的共享锁，修改经 mutate() 执行
+void ApiServer::registerRoutes() {
     // 登录接口
-    svr.Options("/api/login", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/login", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/login", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            std::cout << "[LOGIN] body=" << req.body << std::endl;
-            auto body = json::parse(req.body);
-            std::string username = body.value("username", "");
-            std::string password = body.value("password", "");
-            auto uidOpt = mgr.authenticate(username, password);
-            if (!uidOpt.has_value()) {
-                std::cout << "[LOGIN] failed user=" << username << std::endl;
-                res.status = 401;
-                res.set_content(json({{"ok", false}, {"message", "登录失败"}}).dump(), "application/json");
-                add_cors(res);
-                return;
-            }
-            int uid = uidOpt.value();
-            auto u = mgr.getUser(uid);
-            json out{{"ok", true}, {"userId", uid}, {"username", u->username}, {"credit", u->creditScore}, {"priority", u->priority}, {"type", (int)u->type}};
-            res.set_content(out.dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            std::cout << "[LOGIN] exception while parsing body" << std::endl;
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
+    http.Post("/api/login", [this](const httplib::Request &req, httplib::Response &res) {
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body);
+        if (!dr.ok()) {
+            logWarn("login.bad_request", {{"bytes", req.body.size()}, {"error", decodeErrorName(dr.error)}, {"remote", req.remote_addr}});
+            sendBadRequest(res, dr);
+            return;
+        }
+        const std::string &username = body.username;
+        int retryAfter = 0;
+        if (!loginThrottle.acquire(username, mgr.now(), retryAfter)) {
+            logWarn("login.throttled", {{"username", username}, {"remote", req.remote_addr}, {"retryAfter", retryAfter}});
+            sendRetryLater(res, 429, "登录尝试过于频繁，请稍后再试", retryAfter);
+            return;
+        }
+
+        // 锁内只取出用户对象，scrypt 校验在锁外的校验线程池中执行
+        std::shared_ptr<User> u;
+        {
+            std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+            traceRequest(TraceRoute::Login, 0, req);
+            u = mgr.findUser(username);
+        }
+        // 用户名不存在时对占位哈希做一次同样开销的校验，响应耗时不泄露账号是否存在
+        std::future<bool> verified;
+        bool queued = verifier.trySubmit([this, u, password = std::move(body.password)] {
+            if (!u) { verifyPasswordHash(password, dummyHash); return false; }
+            return u->verifyPassword(password);
+        }, verified);
+        if (!queued) {
+            logWarn("login.busy", {{"username", username}, {"inFlight", verifier.inFlight()}});
+            sendRetryLater(res, 503, "登录繁忙，请稍后再试", 1);
+            return;
+        }
+        if (!verified.get()) {
+            logWarn("login.failed", {{"username", username}, {"remote", req.remote_addr}});
+            res.status = 401;
+            res.set_content(json({{"ok", false}, {"message", "登录失败"}}).dump(), "application/json");
+            addCors(res);
+            return;
+        }
+        loginThrottle.succeeded(username);
+
+        SessionClaims claims;
+        std::string token = sessions.issue(u->id, mgr.now(), &claims);
+        json out;
+        {
+            std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+            out = json{{"ok", true}, {"userId", u->id}, {"username", u->username}, {"credit", u->creditScore}, {"priority", u->priority}, {"type", (int)u->type},
+                       {"token", token}, {"expiresAt", claims.expiresAt}};
         }
+        logInfo("login.ok", {{"username", username}, {"userId", u->id}});
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
+    });
+
+    // 登出：吊销当前会话令牌
+    http.Options("/api/logout", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
+        res.status = 200;
+    });
+    http.Post("/api/logout", [this](const httplib::Request &req, httplib::Response &res) {
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        sessions.revoke(session, mgr.now());
+        logInfo("logout", {{"userId", session.userId}});
+        res.set_content(json({{"ok", true}}).dump(), "application/json");
+        addCors(res);
     });
 
     // 设备列表（含动态状态）
-    svr.Options("/api/devices", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/devices", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Get("/api/devices", [&](const httplib::Request &req, httplib::Response &res) {
-        std::time_t now = std::time(nullptr);
-        json arr = json::array();
-        for (const auto &kv : mgr.devicesById) {
-            const auto &d = kv.second;
-            json dev{{"id", d->id}, {"name", d->name}, {"type", (int)d->type}, {"health", d->health}, {"status", (int)d->getDynamicStatus(now)}, {"allowStudent", d->allowStudentReserve}};
-            // 附加派生设备状态
-            if (d->type == DeviceType::Consumable) {
-                dev["materialLevel"] = static_cast<ConsumableDevice*>(d.get())->materialLevel;
-            } else if (d->type == DeviceType::Precision) {
-                dev["calibration"] = static_cast<PrecisionDevice*>(d.get())->calibration;
-            } else if (d->type == DeviceType::Power) {
-                dev["temperature"] = static_cast<PowerDevice*>(d.get())->temperature;
+    http.Get("/api/devices", [this](const httplib::Request &req, httplib::Response &res) {
+        if (pipeline) {
+            // 单写者模式：状态版本与当前秒都未变化时直接返回已发布的快照
+            auto snap = std::atomic_load(&devicesSnapshot);
+            if (snap && snap->version == pipeline->version() && snap->now == mgr.now()) {
+                traceRequest(TraceRoute::Devices, 0, req);
+                sendJson(req, res, snap->body);
+                addCors(res);
+                return;
             }
-            // 预约概览
-            json rs = json::array();
-            for (const auto &r : d->reservations) {
-                rs.push_back({{"userId", r.userId}, {"startTime", (long long)r.startTime}, {"endTime", (long long)r.endTime}, {"borrowed", r.borrowed}});
+            auto fresh = std::make_shared<DevicesSnapshot>();
+            {
+                std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+                traceRequest(TraceRoute::Devices, 0, req);
+                fresh->version = pipeline->version();  // 写线程在独占锁内更新版本，此处读到的与状态一致
+                fresh->now = mgr.now();
+                writeDevicesResponse(fresh->body, mgr, fresh->now);
             }
-            dev["reservations"] = rs;
-            arr.push_back(dev);
+            std::atomic_store(&devicesSnapshot, std::shared_ptr<const DevicesSnapshot>(fresh));
+            sendJson(req, res, fresh->body);
+            addCors(res);
+            return;
         }
-        res.set_content(json({{"ok", true}, {"devices", arr}}).dump(), "application/json");
-        add_cors(res);
+        std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+        traceRequest(TraceRoute::Devices, 0, req);
+        std::time_t now = mgr.now();
+        std::string &buf = JsonWriter::threadBuffer();
+        writeDevicesResponse(buf, mgr, now);
+        lock.unlock(); // 序列化完成即释放锁，压缩不占用临界区
+        sendJson(req, res, buf);
+        addCors(res);
     });
 
     // 预约
-    svr.Options("/api/reserve", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/reserve", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/reserve", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int userId = body.at("userId").get<int>();
-            int deviceId = body.at("deviceId").get<int>();
-            long long start = body.at("startTime").get<long long>();
-            long long end = body.at("endTime").get<long long>();
+    http.Post("/api/reserve", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, Field::DeviceId | Field::StartTime | Field::EndTime);
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        json out = mutate(TraceRoute::Reserve, session.userId, req, [&](LabManager &m) {
+            int userId = session.userId;
+            int deviceId = static_cast<int>(body.deviceId);
             // 后端允许开始时间略早于当前（在 LabManager 中处理）
-            bool ok = mgr.reserve(userId, deviceId, static_cast<std::time_t>(start), static_cast<std::time_t>(end));
+            bool ok = m.reserve(userId, deviceId, static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime));
             std::string message = "";
-            auto it = mgr.devicesById.find(deviceId);
-            if (!ok && it != mgr.devicesById.end()) {
-                // 借用中提示更明确
-                if (it->second->getDynamicStatus(std::time(nullptr)) == DeviceStatus::IN_USE) message = "设备正在使用，无法预约";
-            }
-            res.set_content(json({{"ok", ok}, {"message", message}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+            const Device *dev = ok ? nullptr : m.peekDevice(deviceId);
+            // 借用中提示更明确
+            if (dev && dev->getDynamicStatus(m.now()) == DeviceStatus::IN_USE) message = "设备正在使用，无法预约";
+            return json{{"ok", ok}, {"message", message}};
+        });
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
     });
 
     // 借用
-    svr.Options("/api/borrow", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/borrow", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/borrow", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int userId = body.at("userId").get<int>();
-            int deviceId = body.at("deviceId").get<int>();
-            std::time_t now = std::time(nullptr);
-            bool ok = mgr.borrow(userId, deviceId, now);
-            res.set_content(json({{"ok", ok}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+    http.Post("/api/borrow", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::DeviceId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        bool ok = mutate(TraceRoute::Borrow, session.userId, req, [&](LabManager &m) {
+            return m.borrow(session.userId, static_cast<int>(body.deviceId), m.now());
+        });
+        res.set_content(json({{"ok", ok}}).dump(), "application/json");
+        addCors(res);
     });
 
     // 归还
-    svr.Options("/api/return", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/return", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/return", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int userId = body.at("userId").get<int>();
-            int deviceId = body.at("deviceId").get<int>();
-            std::time_t now = std::time(nullptr);
-            bool ok = mgr.returnDevice(userId, deviceId, now);
-            auto u = mgr.getUser(userId);
+    http.Post("/api/return", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::DeviceId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        json out = mutate(TraceRoute::Return, session.userId, req, [&](LabManager &m) {
+            int userId = session.userId;
+            bool ok = m.returnDevice(userId, static_cast<int>(body.deviceId), m.now());
+            const User *u = m.getUser(userId);
             int credit = u ? u->creditScore : 0;
-            res.set_content(json({{"ok", ok}, {"credit", credit}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+            return json{{"ok", ok}, {"credit", credit}};
+        });
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
     });
 
     // 延长
-    svr.Options("/api/extend", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/extend", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/extend", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int userId = body.at("userId").get<int>();
-            int deviceId = body.at("deviceId").get<int>();
-            std::time_t newEnd = body.at("endTime").get<long long>();
-            bool ok = mgr.extend(userId, deviceId, newEnd);
-            auto u = mgr.getUser(userId);
+    http.Post("/api/extend", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, Field::DeviceId | Field::EndTime);
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        json out = mutate(TraceRoute::Extend, session.userId, req, [&](LabManager &m) {
+            int userId = session.userId;
+            bool ok = m.extend(userId, static_cast<int>(body.deviceId), static_cast<std::time_t>(body.endTime));
+            const User *u = m.getUser(userId);
             int credit = u ? u->creditScore : 0;
-            res.set_content(json({{"ok", ok}, {"credit", credit}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
+            return json{{"ok", ok}, {"credit", credit}};
+        });
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
+    });
+
+    // 两阶段预约：暂留时段（返回暂留ID与到期时刻），随后确认或放弃
+    http.Options("/api/hold", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Options("/api/hold/confirm", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Options("/api/hold/release", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Post("/api/hold", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, Field::DeviceId | Field::StartTime | Field::EndTime);
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        json out = mutate(TraceRoute::Hold, session.userId, req, [&](LabManager &m) {
+            int holdId = m.hold(session.userId, static_cast<int>(body.deviceId), static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime));
+            if (holdId == 0) return json{{"ok", false}, {"message", "该时段已被占用或无法预约"}};
+            return json{{"ok", true}, {"holdId", holdId}, {"expiresAt", m.holds.at(holdId).expiresAt}};
+        });
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
+    });
+    http.Post("/api/hold/confirm", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::HoldId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        LabManager::HoldOutcome outcome = mutate(TraceRoute::HoldConfirm, session.userId, req, [&](LabManager &m) {
+            return m.confirmHold(session.userId, static_cast<int>(body.holdId));
+        });
+        const char *message = "";
+        switch (outcome) {
+            case LabManager::HoldOutcome::Ok:       break;
+            case LabManager::HoldOutcome::NotFound: message = "暂留不存在"; break;
+            case LabManager::HoldOutcome::Expired:  message = "暂留已过期，请重新选择时段"; break;
+            case LabManager::HoldOutcome::Rejected: message = "预约失败（信用不足或设备不可用）"; break;
         }
+        res.set_content(json({{"ok", outcome == LabManager::HoldOutcome::Ok}, {"message", message}}).dump(), "application/json");
+        addCors(res);
+    });
+    http.Post("/api/hold/release", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::HoldId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        bool ok = mutate(TraceRoute::HoldRelease, session.userId, req, [&](LabManager &m) {
+            return m.releaseHold(session.userId, static_cast<int>(body.holdId));
+        });
+        res.set_content(json({{"ok", ok}}).dump(), "application/json");
+        addCors(res);
     });
 
     // 管理员接口——新增设备
-    svr.Options("/api/admin/add", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/admin/add", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/admin/add", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int type = body.at("type").get<int>();
-            std::string name = body.at("name").get<std::string>();
-            bool allowStudent = body.value("allowStudent", true);
-            int id = mgr.addDevice(static_cast<DeviceType>(type), name, allowStudent);
-            res.set_content(json({{"ok", true}, {"deviceId", id}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+    http.Post("/api/admin/add", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, Field::Type | Field::Name);
+        // 设备类型只允许 0-2，越界值会导致无法构造设备对象
+        if (dr.ok() && (body.type < 0 || body.type > 2)) dr = DecodeResult{DecodeError::InvalidValue, Field::Type};
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        // 非管理员时 requireAdmin 已写好 403 响应，命令返回 0
+        int id = mutate(TraceRoute::AdminAdd, session.userId, req, [&](LabManager &m) {
+            if (!requireAdmin(session.userId, res)) return 0;
+            return m.addDevice(static_cast<DeviceType>(body.type), body.name, body.allowStudent);
+        });
+        if (id == 0) return;
+        res.set_content(json({{"ok", true}, {"deviceId", id}}).dump(), "application/json");
+        addCors(res);
     });
 
-    svr.Options("/api/apply", [&](const httplib::Request &req, httplib::Response &res) { add_cors(res); res.status = 200; });
-    svr.Post("/api/apply", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int userId = body.at("userId").get<int>();
-            int deviceId = body.at("deviceId").get<int>();
-            long long start = body.at("startTime").get<long long>();
-            long long end   = body.at("endTime").get<long long>();
-            std::string reason = body.value("reason", "");
-            int appId = mgr.apply(userId, deviceId, static_cast<std::time_t>(start), static_cast<std::time_t>(end), reason);
-            res.set_content(json({{"ok", true}, {"applicationId", appId}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+    http.Options("/api/apply", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Post("/api/apply", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, Field::DeviceId | Field::StartTime | Field::EndTime);
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        int appId = mutate(TraceRoute::Apply, session.userId, req, [&](LabManager &m) {
+            return m.apply(session.userId, static_cast<int>(body.deviceId), static_cast<std::time_t>(body.startTime), static_cast<std::time_t>(body.endTime), body.reason);
+        });
+        res.set_content(json({{"ok", true}, {"applicationId", appId}}).dump(), "application/json");
+        addCors(res);
     });
 
-    svr.Options("/api/admin/applications", [&](const httplib::Request &req, httplib::Response &res) { add_cors(res); res.status = 200; });
-    svr.Get("/api/admin/applications", [&](const httplib::Request &req, httplib::Response &res) {
-        json arr = json::array();
-        for (const auto &a : mgr.applications) {
-            arr.push_back({{"id", a.id}, {"userId", a.userId}, {"deviceId", a.deviceId}, {"startTime", (long long)a.start}, {"endTime", (long long)a.end}, {"reason", a.reason}});
-        }
-        res.set_content(json({{"ok", true}, {"applications", arr}}).dump(), "application/json");
-        add_cors(res);
+    http.Options("/api/admin/applications", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Get("/api/admin/applications", [this](const httplib::Request &req, httplib::Response &res) {
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+        if (!requireAdmin(session.userId, res)) return;
+        traceRequest(TraceRoute::Applications, session.userId, req);
+        std::string &buf = JsonWriter::threadBuffer();
+        writeApplicationsResponse(buf, mgr);
+        lock.unlock();
+        sendJson(req, res, buf);
+        addCors(res);
     });
 
-    svr.Options("/api/admin/applications/approve", [&](const httplib::Request &req, httplib::Response &res) { add_cors(res); res.status = 200; });
-    svr.Post("/api/admin/applications/approve", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int appId = body.at("appId").get<int>();
-            bool ok = mgr.approveApplication(appId);
-            res.set_content(json({{"ok", ok}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+    http.Options("/api/admin/applications/approve", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Post("/api/admin/applications/approve", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::AppId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        std::optional<bool> ok = mutate(TraceRoute::Approve, session.userId, req, [&](LabManager &m) -> std::optional<bool> {
+            if (!requireAdmin(session.userId, res)) return std::nullopt;
+            return m.approveApplication(static_cast<int>(body.appId));
+        });
+        if (!ok) return;
+        res.set_content(json({{"ok", *ok}}).dump(), "application/json");
+        addCors(res);
     });
 
     // 管理员接口——删除设备
-    svr.Options("/api/admin/delete", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/admin/delete", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/admin/delete", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int deviceId = body.at("deviceId").get<int>();
-            bool ok = mgr.deleteDevice(deviceId);
-            res.set_content(json({{"ok", ok}, {"message", ok?"":"设备正在借用，无法删除"}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
-        }
+    http.Post("/api/admin/delete", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::DeviceId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        std::optional<bool> ok = mutate(TraceRoute::Delete, session.userId, req, [&](LabManager &m) -> std::optional<bool> {
+            if (!requireAdmin(session.userId, res)) return std::nullopt;
+            return m.deleteDevice(static_cast<int>(body.deviceId));
+        });
+        if (!ok) return;
+        res.set_content(json({{"ok", *ok}, {"message", *ok?"":"设备正在借用，无法删除"}}).dump(), "application/json");
+        addCors(res);
     });
 
     // 管理员接口——维护设备
-    svr.Options("/api/admin/maintain", [&](const httplib::Request &req, httplib::Response &res) {
-        add_cors(res);
+    http.Options("/api/admin/maintain", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
         res.status = 200;
     });
-    svr.Post("/api/admin/maintain", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto body = json::parse(req.body);
-            int deviceId = body.at("deviceId").get<int>();
-            bool ok = mgr.maintainDevice(deviceId);
-            res.set_content(json({{"ok", ok}, {"message", ok?"":"设备正在借用，无法维护"}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
+    http.Post("/api/admin/maintain", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::DeviceId));
+        if (!dr.ok()) { sendBadRequest(res, dr); return; }
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        std::optional<bool> ok = mutate(TraceRoute::Maintain, session.userId, req, [&](LabManager &m) -> std::optional<bool> {
+            if (!requireAdmin(session.userId, res)) return std::nullopt;
+            return m.maintainDevice(static_cast<int>(body.deviceId));
+        });
+        if (!ok) return;
+        res.set_content(json({{"ok", *ok}, {"message", *ok?"":"设备正在借用，无法维护"}}).dump(), "application/json");
+        addCors(res);
+    });
+
+    // 管理员接口——批量导入用户与设备（CSV / JSON Lines，格式见 Import.h）：
+    // 解析、校验与口令哈希都在锁外完成，独占锁内只做一次批量插入；任一行有误或用户名冲突时整体不生效
+    http.Options("/api/admin/import", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Post("/api/admin/import", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        {
+            std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+            if (!requireAdmin(session.userId, res)) return;
+        }
+        ImportBatch batch = parseImport(req.body);
+        if (!batch.errors.empty()) {
+            json errors = json::array();
+            for (size_t i = 0; i < batch.errors.size() && i < 20; ++i) errors.push_back({{"line", batch.errors[i].line}, {"message", batch.errors[i].message}});
+            logWarn("import.invalid", {{"userId", session.userId}, {"errors", batch.errors.size()}});
             res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
+            res.set_content(json({{"ok", false}, {"message", "导入数据有误"}, {"errorCount", batch.errors.size()}, {"errors", errors}}).dump(), "application/json");
+            addCors(res);
+            return;
+        }
+        PreparedImport prepared = prepareImport(batch, mgr.strings, mgr.passwordParams);
+        std::string logged = importLogPayload(prepared);
+        // 分片部署时 insertBulk 只保留本分片的设备，响应中按整批计数（与单进程一致）
+        size_t userCount = prepared.users.size(), deviceCount = prepared.devices.size();
+
+        std::vector<std::string> duplicates;
+        long long lockUs = 0;
+        bool ok = mutate(TraceRoute::Import, session.userId, req, [&](LabManager &m) {
+            auto t0 = std::chrono::steady_clock::now();
+            bool inserted = m.insertBulk(prepared.users, prepared.devices, &duplicates);
+            lockUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+            return inserted;
+        }, &logged);
+        if (!ok) {
+            if (duplicates.size() > 20) duplicates.resize(20);
+            res.status = 409;
+            res.set_content(json({{"ok", false}, {"message", "用户名已存在"}, {"duplicates", duplicates}}).dump(), "application/json");
+            addCors(res);
+            return;
         }
+        logInfo("import.ok", {{"userId", session.userId}, {"users", userCount}, {"devices", deviceCount}, {"lockUs", lockUs}});
+        res.set_content(json({{"ok", true}, {"users", userCount}, {"devices", deviceCount}}).dump(), "application/json");
+        addCors(res);
     });
 
-    // 学生通知：弹出并清除
-    svr.Get("/api/notifications", [&](const httplib::Request &req, httplib::Response &res) {
-        try {
-            auto q = req.params.find("userId");
-            if (q == req.params.end()) {
-                res.set_content(json({{"ok", false}, {"message", "缺少userId"}}).dump(), "application/json"); add_cors(res); return; }
-            int userId = std::stoi(q->second);
-            auto list = mgr.popNotifications(userId);
-            json arr = json::array();
-            for (const auto &n : list) arr.push_back({{"id", n.id}, {"message", n.message}, {"createdAt", (long long)n.createdAt}});
-            res.set_content(json({{"ok", true}, {"notifications", arr}}).dump(), "application/json");
-            add_cors(res);
-        } catch (...) {
-            res.status = 400;
-            res.set_content(json({{"ok", false}, {"message", "请求格式错误"}}).dump(), "application/json");
-            add_cors(res);
+    // 学生通知：弹出并清除（用户取自会话令牌，查询串中的 userId 不再使用）
+    http.Options("/api/notifications", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Get("/api/notifications", [this](const httplib::Request &req, httplib::Response &res) {
+        if (forwardIfFollower(req, res)) return;
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        auto list = mutate(TraceRoute::Notifications, session.userId, req, [&](LabManager &m) {
+            return m.popNotifications(session.userId);
+        });
+        std::string &buf = JsonWriter::threadBuffer();
+        writeNotificationsResponse(buf, list);
+        sendJson(req, res, buf);
+        addCors(res);
+    });
+
+    // 我的预约：借出中、进行中与未开始的预约（见 LabManager::userReservations）；只能查看自己的，管理员可查看任意用户。
+    // 只读，各模式下都在本节点读取（共识复制的跟随者与只读副本可能略旧）
+    http.Options(R"(/api/users/(\d+)/reservations)", [this](const httplib::Request &, httplib::Response &res) { addCors(res); res.status = 200; });
+    http.Get(R"(/api/users/(\d+)/reservations)", [this](const httplib::Request &req, httplib::Response &res) {
+        SessionClaims session;
+        if (!authorize(req, res, session)) return;
+        long long target = std::strtoll(req.matches[1].str().c_str(), nullptr, 10);
+        std::shared_lock<std::shared_mutex> lock(mgr.mutex);
+        if (target != session.userId && !requireAdmin(session.userId, res)) return;
+        if (target > std::numeric_limits<int>::max() || !mgr.getUser(static_cast<int>(target))) {
+            res.status = 404;
+            res.set_content(json({{"ok", false}, {"message", "用户不存在"}}).dump(), "application/json");
+            addCors(res);
+            return;
         }
+        traceRequest(TraceRoute::UserReservations, session.userId, req);
+        std::string &buf = JsonWriter::threadBuffer();
+        writeUserReservationsResponse(buf, mgr.userReservations(static_cast<int>(target), mgr.now()));
+        lock.unlock();
+        sendJson(req, res, buf);
+        addCors(res);
     });
 
-    std::cout << "Server listening on http://localhost:8080" << std::endl;
-    svr.listen("0.0.0.0", 8080);
-    return 0;
+    // 复制状态：角色、日志序号与（副本的）复制延迟；共识复制模式下为节点状态与各位置
+    http.Get("/api/replication", [this](const httplib::Request &, httplib::Response &res) {
+        json out{{"ok", true}};
+        if (replica) {
+            ReplicaStatus s = replica->status();
+            out["role"] = "replica";
+            out["primary"] = replica->primaryHost() + ":" + std::to_string(replica->primaryPort());
+            out["connected"] = s.connected;
+            out["appliedSeq"] = s.appliedSeq;
+            out["primarySeq"] = s.primarySeq;
+            out["lagRecords"] = s.primarySeq - s.appliedSeq;
+            out["lagMs"] = s.lagMs;
+            out["contactAgeMs"] = s.contactAgeMs;
+        } else if (replicationLog) {
+            out["role"] = "primary";
+            out["seq"] = replicationLog->lastSeq();
+            out["followers"] = replicationLog->followers();
+        } else if (raft) {
+            RaftStatus s = raft->status();
+            out["role"] = "raft";
+            out["state"] = raftRoleName(s.role);
+            out["node"] = raft->options().id;
+            out["term"] = s.term;
+            out["leaderId"] = s.leaderId;
+            out["leader"] = s.leaderApi;
+            out["lastIndex"] = s.lastIndex;
+            out["commitIndex"] = s.commitIndex;
+            out["lastApplied"] = s.lastApplied;
+            out["snapshotIndex"] = s.snapshotIndex;
+            if (!s.matchIndex.empty()) out["matchIndex"] = s.matchIndex;
+        } else {
+            out["role"] = "standalone";
+        }
+        res.set_content(out.dump(), "application/json");
+        addCors(res);
+    });
+
+    // 访问日志：仅在 debug 级别输出，关闭时只有一次级别判断的开销
+    http.set_logger([](const httplib::Request &req, const httplib::Response &res) {
+        logDebug("http.access", {{"method", req.method}, {"path", req.path}, {"status", res.status}, {"bytes", res.body.size()}});
+    });
 }
@@ -0,0 +1,160 @@
+#pragma once
+// HTTP 接口层：把 LabManager 的业务操作暴露为 REST 接口；
+// 既由 main.cpp 作为独立服务器启动，也可嵌入其他程序（如基准程序在进程内启动服务器）
+
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "httplib.h"    // 引入 cpp-httplib 单头文件库（外部依赖）
+#include "CommandPipeline.h"
+#include "Compression.h"
+#include "Import.h"
+#include "LabManager.h"
+#include "LoginThrottle.h"
+#include "Raft.h"
+#include "Replication.h"
+#include "RequestDecoder.h"
+#include "Session.h"
+#include "StaticAssets.h"
+#include "Trace.h"
+#include "VerifyPool.h"
+
+// 服务器选项
+struct ServerOptions {
+    CompressionConfig compression;  // JSON 响应压缩配置
+    bool serveStatic{true};         // 是否挂载前端静态资源（index.html / app.js）
+    bool staticReload{false};       // 是否监听静态资源变化并自动重载
+    std::string tracePath;          // 非空时把每个 API 请求记录到该轨迹文件（见 Trace.h）
+    std::string sessionSecret;      // 会话令牌签名密钥；为空时随机生成（仅本进程有效）
+    std::time_t sessionTtl{8 * 3600};  // 会话令牌有效期（秒）
+    size_t verifyThreads{0};        // 口令校验线程数（0：CPU 核数的一半，至少 1）
+    size_t verifyQueue{0};          // 口令校验排队上限（0：HTTP 线程数的一半），超出时登录返回 503
+    LoginThrottleConfig loginThrottle;  // 按用户名的登录限流
+    bool singleWriter{false};       // 修改类接口经单写者命令管线执行（见 CommandPipeline.h），否则各自加独占锁
+    size_t writerBatch{64};         // 单写者模式下每批最多执行的命令数
+    int replicationPort{-1};        // >= 0 时作为主节点在该端口提供复制日志（0：任意空闲端口），见 Replication.h
+    std::string replicationHost{"127.0.0.1"};  // 复制日志的监听地址（日志含导入的口令哈希，默认只对本机开放）
+    std::uint64_t replicationSnapshotEvery{10000};  // 复制日志在最近快照之后超过这么多条时生成快照并截断
+    std::string replicaHost;        // 非空时作为只读副本，从 replicaHost:replicaPort 拉取主节点日志
+    int replicaPort{0};
+    RaftOptions raft;               // peers 非空时以共识复制模式运行（见 Raft.h），不能与主从复制同用
+    int compactInterval{60};        // 预约压缩的间隔（秒），<= 0 时不运行（见 LabManager::compactReservations）
+    std::time_t compactGrace{300};  // 预约结束超过该秒数仍未借出才按爽约归档
+    bool timers{true};              // 每秒处理到期的预约提醒与逾期定时器（见 LabManager::advanceTimers）
+};
+
+class ApiServer {
+public:
+    ApiServer(LabManager &mgr, ServerOptions options);
+    ~ApiServer();
+
+    // 阻塞监听指定地址，直到 stop() 被调用
+    bool listen(const std::string &host, int port);
+    // 绑定任意空闲端口并返回端口号（失败返回 -1），随后调用 listenAfterBind() 开始服务
+    int bindToAnyPort(const std::string &host);
+    bool listenAfterBind();
+    // 停止监听（可在其他线程调用）
+    void stop();
+    // 主节点：生成业务状态快照并截断复制日志（后台维护线程按 replicationSnapshotEvery 调用）
+    void snapshotReplicationLog();
+
+    LabManager &mgr;
+    ServerOptions options;
+    std::unique_ptr<CommandPipeline> pipeline;  // 单写者模式下的写线程；须晚于 http 析构
+    std::unique_ptr<ReplicationLog> replicationLog;   // 主节点的复制日志（未启用时为空）
+    std::unique_ptr<ReplicaFollower> replica;         // 副本的日志拉取线程（未启用时为空）
+    std::unique_ptr<RaftNode> raft;                   // 共识复制节点（未启用或启动失败时为空）
+    PinnableClock *pinnedClock{nullptr};              // 启用复制时 mgr 使用的时钟
+    httplib::Server http;
+    StaticAssets assets;
+    TraceWriter trace;
+    SessionTokens sessions;
+    VerifyPool verifier;
+    LoginThrottle loginThrottle;
+    std::string dummyHash;          // 占位哈希：用户名不存在时也做一次同等开销的校验
+
+private:
+    void registerRoutes();
+    void addCors(httplib::Response &res) const;
+    void sendJson(const httplib::Request &req, httplib::Response &res, const std::string &body) const;
+    void sendBadRequest(httplib::Response &res, const DecodeResult &r) const;
+    void sendRetryLater(httplib::Response &res, int status, const char *message, int retryAfter) const;
+    bool authorize(const httplib::Request &req, httplib::Response &res, SessionClaims &claims) const;
+    bool requireAdmin(int userId, httplib::Response &res) const;
+    void traceRequest(TraceRoute route, int userId, const httplib::Request &req, const std::string *payload = nullptr);
+    static std::string tracePayload(TraceRoute route, int userId, const httplib::Request &req);
+    void registerReplicaGuards();
+    void registerRaftErrors();
+    bool forwardIfFollower(const httplib::Request &req, httplib::Response &res);
+    void forwardToLeader(const httplib::Request &req, httplib::Response &res);
+    void housekeepingLoop();
+    void compactReservations();
+    void fireTimers();
+
+    // 后台维护线程（到期定时器、预约压缩、复制日志快照）：只在可接受修改的节点上运行，副本与跟随者由日志重放得到相同结果
+    struct Housekeeping {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping{false};
+        std::thread thread;
+    };
+    Housekeeping housekeeping;
+
+    // 跟随者转发修改请求用的到主节点的连接池：主节点变更时整体丢弃
+    struct LeaderPool {
+        std::mutex mutex;
+        std::string address;
+        std::vector<std::unique_ptr<httplib::Client>> idle;
+    };
+    LeaderPool leaderPool;
+
+    // 修改结束后解除时钟固定（见 traceRequest）
+    struct ClockPinGuard {
+        PinnableClock *clock;
+        ~ClockPinGuard() { if (clock) clock->unpin(); }
+    };
+
+    // 执行一次修改：先按 route / userId / 请求体记录轨迹（及复制日志），再执行 fn。
+    // 单写者模式下提交到命令管线并等待结果，否则在当前线程持独占锁执行；
+    // 共识复制模式下作为日志条目提交，多数节点确认后在应用线程中执行（失败时抛出 RaftUnavailable）。
+    // fn(LabManager &) 内可调用 requireAdmin（各模式下都持有 mgr.mutex 独占锁）。
+    // payload 非空时代替 tracePayload 记入轨迹、复制日志与共识日志（批量导入记录已哈希口令的负载，见 importLogPayload）
+    template <typename Fn>
+    auto mutate(TraceRoute route, int userId, const httplib::Request &req, Fn fn, const std::string *payload = nullptr)
+        -> std::invoke_result_t<Fn &, LabManager &> {
+        using R = std::invoke_result_t<Fn &, LabManager &>;
+        if (raft) {
+            std::optional<R> result;
+            raft->propose(route, userId, payload ? *payload : tracePayload(route, userId, req), [&](LabManager &m) {
+                traceRequest(route, userId, req, payload);
+                result.emplace(fn(m));
+            });
+            return std::move(*result);
+        }
+        auto run = [&](LabManager &m) -> R {
+            ClockPinGuard guard{pinnedClock};
+            traceRequest(route, userId, req, payload);
+            return fn(m);
+        };
+        if (pipeline) return pipeline->submit(run).get();
+        std::unique_lock<std::shared_mutex> lock(mgr.mutex);
+        return run(mgr);
+    }
+
+    // 设备列表快照（单写者模式）：按状态版本与秒级时间缓存已序列化的响应体，
+    // 两者都未变化时读请求不取锁、不重新序列化；发布方式同 StaticAssets
+    struct DevicesSnapshot {
+        std::uint64_t version{0};
+        std::time_t now{0};
+        std::string body;
+    };
+    std::shared_ptr<const DevicesSnapshot> devicesSnapshot;
+};
@@ -0,0 +1,121 @@
+#include "Session.h"
+#include <algorithm>
+#include <cstring>
+
+#include "Crypto.h"
+
+namespace {
+
+constexpr std::uint8_t kTokenVersion = 1;
+constexpr size_t kClaimsLen = 1 + 4 + 8 + 8;
+constexpr size_t kTokenLen = kClaimsLen + 32;
+
+void putLE(std::uint8_t *p, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+std::uint64_t getLE(const std::uint8_t *p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+const char *tokenErrorName(TokenError e) {
+    switch (e) {
+        case TokenError::None:         return "none";
+        case TokenError::Missing:      return "missing_token";
+        case TokenError::Malformed:    return "malformed_token";
+        case TokenError::BadSignature: return "bad_signature";
+        case TokenError::Expired:      return "expired";
+        case TokenError::Revoked:      return "revoked";
+    }
+    return "unknown";
+}
+
+SessionTokens::SessionTokens(std::string secret, std::time_t ttlSeconds) : secret_(std::move(secret)), ttl_(ttlSeconds) {
+    if (secret_.empty()) {
+        secret_.resize(32);
+        randomBytes(&secret_[0], secret_.size());
+        ephemeral_ = true;
+    }
+    // 会话ID起点随机：多进程、重启前后签发的会话ID互不冲突
+    std::uint64_t start = 0;
+    randomBytes(&start, sizeof(start));
+    nextSessionId_.store(start, std::memory_order_relaxed);
+}
+
+std::string SessionTokens::issue(int userId, std::time_t now, SessionClaims *claims) {
+    SessionClaims c{userId, now + ttl_, nextSessionId_.fetch_add(1, std::memory_order_relaxed)};
+    std::uint8_t raw[kTokenLen];
+    raw[0] = kTokenVersion;
+    putLE(raw + 1, static_cast<std::uint32_t>(c.userId), 4);
+    putLE(raw + 5, static_cast<std::uint64_t>(c.expiresAt), 8);
+    putLE(raw + 13, c.sessionId, 8);
+    Sha256Digest mac = hmacSha256(secret_, raw, kClaimsLen);
+    std::memcpy(raw + kClaimsLen, mac.data(), mac.size());
+    if (claims) *claims = c;
+    return base64UrlEncode(raw, sizeof(raw));
+}
+
+TokenError SessionTokens::validate(std::string_view token, std::time_t now, SessionClaims &claims) const {
+    if (token.empty()) return TokenError::Missing;
+    std::string raw;
+    if (token.size() != (kTokenLen * 4 + 2) / 3 || !base64UrlDecode(token, raw) || raw.size() != kTokenLen) return TokenError::Malformed;
+    const std::uint8_t *p = reinterpret_cast<const std::uint8_t *>(raw.data());
+    if (p[0] != kTokenVersion) return TokenError::Malformed;
+
+    Sha256Digest mac = hmacSha256(secret_, p, kClaimsLen);
+    if (!constantTimeEqual(mac.data(), p + kClaimsLen, mac.size())) return TokenError::BadSignature;
+
+    SessionClaims c;
+    c.userId = static_cast<int>(static_cast<std::uint32_t>(getLE(p + 1, 4)));
+    c.expiresAt = static_cast<std::time_t>(getLE(p + 5, 8));
+    c.sessionId = getLE(p + 13, 8);
+    if (now >= c.expiresAt) return TokenError::Expired;
+
+    const Shard &shard = shardFor(c.sessionId);
+    {
+        std::shared_lock<std::shared_mutex> lk(shard.mutex);
+        if (shard.revoked.count(c.sessionId)) return TokenError::Revoked;
+    }
+    claims = c;
+    return TokenError::None;
+}
+
+std::string_view SessionTokens::bearerToken(std::string_view header) {
+    constexpr std::string_view scheme = "bearer ";
+    if (header.size() <= scheme.size()) return {};
+    for (size_t i = 0; i < scheme.size(); ++i) {
+        char c = header[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != scheme[i]) return {};
+    }
+    std::string_view token = header.substr(scheme.size());
+    while (!token.empty() && token.front() == ' ') token.remove_prefix(1);
+    while (!token.empty() && token.back() == ' ') token.remove_suffix(1);
+    return token;
+}
+
+void SessionTokens::revoke(const SessionClaims &claims, std::time_t now) {
+    Shard &shard = shardFor(claims.sessionId);
+    std::unique_lock<std::shared_mutex> lk(shard.mutex);
+    shard.revoked[claims.sessionId] = claims.expiresAt;
+    // 清理已过期的条目（过期令牌本就无法通过校验）；阈值随存活条目数翻倍，均摊 O(1)
+    if (shard.revoked.size() < shard.pruneAt) return;
+    for (auto it = shard.revoked.begin(); it != shard.revoked.end();) {
+        if (it->second <= now) it = shard.revoked.erase(it);
+        else ++it;
+    }
+    shard.pruneAt = std::max<size_t>(64, shard.revoked.size() * 2);
+}
+
+size_t SessionTokens::revokedCount() const {
+    size_t n = 0;
+    for (const auto &shard : shards_) {
+        std::shared_lock<std::shared_mutex> lk(shard.mutex);
+        n += shard.revoked.size();
+    }
+    return n;
+}
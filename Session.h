@@ -0,0 +1,67 @@
+#pragma once
+// 会话令牌：登录成功后签发定长令牌（HMAC-SHA256 签名的 userId / 过期时间 / 会话ID），
+// 之后的请求在 Authorization: Bearer 头中携带，服务端以常数时间校验签名即可确认身份，
+// 不再信任请求体中的 userId，也不需要共享的会话存储：持有同一密钥（LAB_SESSION_SECRET）的
+// 多个工作进程都能校验同一令牌。服务端状态只有一张分片的吊销表（登出时写入，过期后清理）
+//
+// 令牌格式（base64url 编码，固定 71 个字符）：
+//   版本(1) | userId(4, 小端) | 过期时间(8, 小端 Unix 秒) | 会话ID(8) | HMAC-SHA256(32，覆盖前 21 字节)
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct SessionClaims {
+    int userId{0};
+    std::time_t expiresAt{0};
+    std::uint64_t sessionId{0};
+};
+
+enum class TokenError { None, Missing, Malformed, BadSignature, Expired, Revoked };
+
+const char *tokenErrorName(TokenError e);
+
+class SessionTokens {
+public:
+    // secret 为空时随机生成（仅本进程有效，重启后旧令牌全部失效）
+    explicit SessionTokens(std::string secret = "", std::time_t ttlSeconds = 8 * 3600);
+
+    // 签发令牌
+    std::string issue(int userId, std::time_t now, SessionClaims *claims = nullptr);
+
+    // 校验令牌：签名、过期时间、吊销表；成功时填充 claims
+    TokenError validate(std::string_view token, std::time_t now, SessionClaims &claims) const;
+
+    // 从 "Bearer <token>" 形式的 Authorization 头取出令牌（不区分 scheme 大小写），失败返回空
+    static std::string_view bearerToken(std::string_view header);
+
+    // 吊销（登出）：记录会话ID直到其过期时间
+    void revoke(const SessionClaims &claims, std::time_t now);
+
+    std::time_t ttl() const { return ttl_; }
+    bool ephemeralSecret() const { return ephemeral_; }
+    size_t revokedCount() const;
+
+private:
+    static constexpr size_t kShards = 16;
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::uint64_t, std::time_t> revoked;  // 会话ID -> 过期时间
+        size_t pruneAt{64};                                      // 条目数达到该值时清理过期条目
+    };
+
+    std::string secret_;
+    std::time_t ttl_;
+    bool ephemeral_{false};
+    std::atomic<std::uint64_t> nextSessionId_{0};
+    std::array<Shard, kShards> shards_;
+
+    Shard &shardFor(std::uint64_t sessionId) { return shards_[sessionId % kShards]; }
+    const Shard &shardFor(std::uint64_t sessionId) const { return shards_[sessionId % kShards]; }
+};
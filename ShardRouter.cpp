@@ -0,0 +1,316 @@
+// 分片路由实现：请求转发、分发汇总与分片连接池
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <string_view>
+#include <utility>
+#include "json.hpp"     // 引入 nlohmann/json 单头文件（外部依赖）
+
+#include "ShardRouter.h"
+#include "Logger.h"
+#include "RequestDecoder.h"
+
+using json = nlohmann::json;
+
+bool parseShardList(const std::string &spec, std::vector<ShardEndpoint> &out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        std::string item = spec.substr(pos, comma - pos);
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == item.size()) return false;
+        ShardEndpoint e;
+        e.host = item.substr(0, colon);
+        char *end = nullptr;
+        long port = std::strtol(item.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || port <= 0 || port > 65535) return false;
+        e.port = static_cast<int>(port);
+        out.push_back(std::move(e));
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+ShardRouter::ShardRouter(std::vector<ShardEndpoint> shards, RouterOptions options) : options_(std::move(options)) {
+    for (auto &e : shards) {
+        auto up = std::make_unique<Upstream>();
+        up->endpoint = std::move(e);
+        upstreams_.push_back(std::move(up));
+    }
+    http.set_tcp_nodelay(true);
+    registerRoutes();
+    for (size_t i = 0; i < upstreams_.size(); ++i) {
+        logInfo("router.shard", {{"index", i}, {"host", upstreams_[i]->endpoint.host}, {"port", upstreams_[i]->endpoint.port}});
+    }
+}
+
+ShardRouter::~ShardRouter() {
+    stop();
+}
+
+bool ShardRouter::listen(const std::string &host, int port) {
+    logInfo("router.listen", {{"host", host}, {"port", port}, {"shards", upstreams_.size()}});
+    return http.listen(host, port);
+}
+
+int ShardRouter::bindToAnyPort(const std::string &host) {
+    return http.bind_to_any_port(host);
+}
+
+bool ShardRouter::listenAfterBind() {
+    return http.listen_after_bind();
+}
+
+void ShardRouter::stop() {
+    if (http.is_running()) http.stop();
+}
+
+size_t ShardRouter::shardOf(long long id) const {
+    if (id <= 0) return 0;
+    return static_cast<size_t>((id - 1) % static_cast<long long>(upstreams_.size()));
+}
+
+void ShardRouter::addCors(httplib::Response &res) const {
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    res.set_header("Access-Control-Allow-Methods", "GET,POST,OPTIONS");
+}
+
+// 把请求原样发给指定分片（方法、路径与查询串、请求体、Authorization），连接从池中取用
+ShardRouter::Reply ShardRouter::call(size_t shard, const httplib::Request &req) {
+    Upstream &up = *upstreams_[shard];
+    std::unique_ptr<httplib::Client> cli;
+    {
+        std::lock_guard<std::mutex> lk(up.mutex);
+        if (!up.idle.empty()) {
+            cli = std::move(up.idle.back());
+            up.idle.pop_back();
+        }
+    }
+    if (!cli) {
+        cli = std::make_unique<httplib::Client>(up.endpoint.host, up.endpoint.port);
+        cli->set_keep_alive(true);
+        cli->set_tcp_nodelay(true);
+        cli->set_connection_timeout(2);
+    }
+
+    httplib::Headers headers;
+    if (req.has_header("Authorization")) headers.emplace("Authorization", req.get_header_value("Authorization"));
+    const std::string &target = req.target.empty() ? req.path : req.target;
+    httplib::Result r = req.method == "POST"
+        ? cli->Post(target, headers, req.body, req.get_header_value("Content-Type", "application/json"))
+        : cli->Get(target, headers);
+
+    Reply reply;
+    if (!r) {
+        logWarn("router.shard_unreachable", {{"shard", shard}, {"path", req.path}, {"error", httplib::to_string(r.error())}});
+        return reply;
+    }
+    reply.status = r->status;
+    reply.body = std::move(r->body);
+    reply.contentType = r->get_header_value("Content-Type");
+    reply.retryAfter = r->get_header_value("Retry-After");
+    std::lock_guard<std::mutex> lk(up.mutex);
+    up.idle.push_back(std::move(cli));
+    return reply;
+}
+
+// 向全部分片并发发送同一请求：1..N-1 号分片在异步任务中调用，0 号分片在当前线程调用
+std::vector<ShardRouter::Reply> ShardRouter::scatter(const httplib::Request &req) {
+    std::vector<std::future<Reply>> pending;
+    pending.reserve(upstreams_.size());
+    for (size_t i = 1; i < upstreams_.size(); ++i) {
+        pending.push_back(std::async(std::launch::async, [this, i, &req] { return call(i, req); }));
+    }
+    std::vector<Reply> replies;
+    replies.reserve(upstreams_.size());
+    replies.push_back(call(0, req));
+    for (auto &f : pending) replies.push_back(f.get());
+    return replies;
+}
+
+void ShardRouter::relay(const Reply &reply, httplib::Response &res) const {
+    if (reply.status == 0) {
+        res.status = 502;
+        res.set_content(json({{"ok", false}, {"message", "分片不可用"}}).dump(), "application/json");
+    } else {
+        res.status = reply.status;
+        res.set_content(reply.body, reply.contentType.empty() ? "application/json" : reply.contentType);
+        if (!reply.retryAfter.empty()) res.set_header("Retry-After", reply.retryAfter);
+    }
+    addCors(res);
+}
+
+void ShardRouter::forward(size_t shard, const httplib::Request &req, httplib::Response &res) {
+    relay(call(shard, req), res);
+}
+
+namespace {
+
+// 列表响应的外框：键按字典序输出（见 ApiJson.h），列表键排在 "ok" 之前时为 {"<key>":[...],"ok":true}，
+// 之后时为 {"ok":true,"<key>":[...]}。head 为数组之前的部分（含 '['），tail 为之后的部分（含 ']'）；
+// 不是这两种形式时返回 false
+bool splitListBody(std::string_view body, std::string_view &head, std::string_view &items, std::string_view &tail) {
+    constexpr std::string_view okFirst = "{\"ok\":true,\"", keyFirst = "{\"";
+    constexpr std::string_view okTail = "],\"ok\":true}", plainTail = "]}";
+    bool leadingOk = body.substr(0, okFirst.size()) == okFirst;
+    if (!leadingOk && body.substr(0, keyFirst.size()) != keyFirst) return false;
+    size_t keyEnd = body.find('"', leadingOk ? okFirst.size() : keyFirst.size());
+    if (keyEnd == std::string_view::npos || body.substr(keyEnd, 3) != "\":[") return false;
+    size_t open = keyEnd + 3;
+    std::string_view end = leadingOk ? plainTail : okTail;
+    if (body.size() < open + end.size() || body.substr(body.size() - end.size()) != end) return false;
+    head = body.substr(0, open);
+    items = body.substr(open, body.size() - end.size() - open);
+    tail = body.substr(body.size() - end.size());
+    return true;
+}
+
+// 按（开始时间, 设备ID）重排合并后的数组元素；元素不是合法 JSON 时返回 false
+bool sortByStartTime(std::string &items) {
+    json arr = json::parse("[" + items + "]", nullptr, false);
+    if (arr.is_discarded() || !arr.is_array()) return false;
+    auto key = [](const json &b) { return std::make_pair(b.value("startTime", 0LL), b.value("deviceId", 0)); };
+    std::stable_sort(arr.begin(), arr.end(), [&](const json &a, const json &b) { return key(a) < key(b); });
+    items.clear();
+    for (const auto &b : arr) {
+        if (!items.empty()) items += ',';
+        items += b.dump();
+    }
+    return true;
+}
+
+} // namespace
+
+// 汇总列表响应：列表键与外框取自分片的响应（各分片须一致），按分片顺序拼接数组；
+// byStartTime 为假时不解析元素，为真时（用户预约）按（开始时间, 设备ID）合并各分片的有序列表。
+// 任一分片返回非 200（如 401 / 403）时原样转发该响应；分片不可达时返回 502，
+// keepPartial 为真时（通知弹出后即从分片删除，不能丢弃）改为返回其余分片的结果（全部不可达时仍返回 502）
+void ShardRouter::gather(const httplib::Request &req, httplib::Response &res, bool keepPartial, bool byStartTime) {
+    std::vector<Reply> replies = scatter(req);
+    std::string_view head, tail;
+    std::string items;
+    bool answered = false;
+    for (size_t i = 0; i < replies.size(); ++i) {
+        const Reply &r = replies[i];
+        if (r.status == 0 && keepPartial) continue;
+        if (r.status != 200) { relay(r, res); return; }
+        std::string_view h, part, t;
+        if (!splitListBody(r.body, h, part, t) || (answered && (h != head || t != tail))) {
+            logError("router.bad_shard_response", {{"shard", i}, {"path", req.path}, {"bytes", r.body.size()}});
+            relay(Reply{}, res);
+            return;
+        }
+        head = h;
+        tail = t;
+        answered = true;
+        if (part.empty()) continue;
+        if (!items.empty()) items += ',';
+        items.append(part.data(), part.size());
+    }
+    if (!answered || (byStartTime && !sortByStartTime(items))) {
+        if (answered) logError("router.bad_shard_response", {{"path", req.path}, {"bytes", items.size()}});
+        relay(Reply{}, res);
+        return;
+    }
+    std::string out;
+    out.reserve(head.size() + items.size() + tail.size());
+    out.append(head.data(), head.size());
+    out += items;
+    out.append(tail.data(), tail.size());
+    res.set_content(out, "application/json");
+    compressResponse(req, res, options_.compression);
+    addCors(res);
+}
+
+void ShardRouter::registerRoutes() {
+    http.Options(R"(/api/.*)", [this](const httplib::Request &, httplib::Response &res) {
+        addCors(res);
+        res.status = 200;
+    });
+
+    // 登录：按用户名散列到固定分片；请求体无法解码时交给 0 号分片返回标准错误
+    http.Post("/api/login", [this](const httplib::Request &req, httplib::Response &res) {
+        DecodedRequest body;
+        size_t shard = 0;
+        if (decodeRequest(req.body, body, static_cast<FieldMask>(Field::Username)).ok()) {
+            shard = std::hash<std::string>{}(body.username) % upstreams_.size();
+        }
+        forward(shard, req, res);
+    });
+
+    // 登出：各分片分别维护吊销表，须全部通知
+    http.Post("/api/logout", [this](const httplib::Request &req, httplib::Response &res) {
+        std::vector<Reply> replies = scatter(req);
+        for (const auto &r : replies) {
+            if (r.status != 200) { relay(r, res); return; }
+        }
+        relay(replies.front(), res);
+    });
+
+    http.Get("/api/devices", [this](const httplib::Request &req, httplib::Response &res) { gather(req, res, false); });
+    http.Get("/api/admin/applications", [this](const httplib::Request &req, httplib::Response &res) { gather(req, res, false); });
+    http.Get("/api/notifications", [this](const httplib::Request &req, httplib::Response &res) { gather(req, res, true); });
+    // 用户的预约按设备分布在各分片上：各分片内按开始时间排序，汇总时按（开始时间, 设备ID）合并
+    http.Get(R"(/api/users/\d+/reservations)", [this](const httplib::Request &req, httplib::Response &res) { gather(req, res, false, true); });
+
+    // 按 deviceId 转发的接口
+    for (const char *path : {"/api/reserve", "/api/borrow", "/api/return", "/api/extend", "/api/apply", "/api/hold", "/api/admin/delete", "/api/admin/maintain"}) {
+        http.Post(path, [this](const httplib::Request &req, httplib::Response &res) {
+            DecodedRequest body;
+            DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::DeviceId));
+            forward(dr.ok() ? shardOf(body.deviceId) : 0, req, res);
+        });
+    }
+
+    http.Post("/api/admin/applications/approve", [this](const httplib::Request &req, httplib::Response &res) {
+        DecodedRequest body;
+        DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::AppId));
+        forward(dr.ok() ? shardOf(body.appId) : 0, req, res);
+    });
+
+    // 暂留的确认 / 放弃：按暂留ID转发（与申请ID同样按分片数跨步）
+    for (const char *path : {"/api/hold/confirm", "/api/hold/release"}) {
+        http.Post(path, [this](const httplib::Request &req, httplib::Response &res) {
+            DecodedRequest body;
+            DecodeResult dr = decodeRequest(req.body, body, static_cast<FieldMask>(Field::HoldId));
+            forward(dr.ok() ? shardOf(body.holdId) : 0, req, res);
+        });
+    }
+
+    // 新增设备：轮流分配，设备ID由接收的分片按其跨步序列分配
+    http.Post("/api/admin/add", [this](const httplib::Request &req, httplib::Response &res) {
+        forward(nextAddShard_.fetch_add(1, std::memory_order_relaxed) % upstreams_.size(), req, res);
+    });
+
+    // 批量导入：串行广播，每个分片导入全部用户与属于自己的那部分设备（见 LabManager::insertBulk）。
+    // 各分片的用户表相同，校验结果一致：0 号分片拒绝时不再发给其他分片
+    http.Post("/api/admin/import", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lk(importMutex_);
+        Reply first = call(0, req);
+        if (first.status != 200) { relay(first, res); return; }
+        for (size_t i = 1; i < upstreams_.size(); ++i) {
+            Reply r = call(i, req);
+            if (r.status != 200) {
+                logError("router.import_diverged", {{"shard", i}, {"status", r.status}});
+                relay(r, res);
+                return;
+            }
+        }
+        relay(first, res);
+    });
+
+    // 前端静态资源取自 0 号分片
+    if (options_.serveStatic) {
+        for (const char *path : {"/", "/index.html", "/app.js"}) {
+            http.Get(path, [this](const httplib::Request &req, httplib::Response &res) { forward(0, req, res); });
+        }
+    }
+
+    http.set_logger([](const httplib::Request &req, const httplib::Response &res) {
+        logDebug("http.access", {{"method", req.method}, {"path", req.path}, {"status", res.status}, {"bytes", res.body.size()}});
+    });
+}
@@ -0,0 +1,81 @@
+#pragma once
+// 分片路由：设备按ID划分到多个服务器进程（分片，见 LabManager::setShard），路由进程本身不持有业务状态，
+// 只按请求中的ID把调用转发给归属分片，或向全部分片分发后汇总结果：
+//   - 设备相关接口（reserve / borrow / return / extend / apply / hold / admin delete / maintain）：按 deviceId 转发
+//   - 审批：按申请ID转发（申请ID与设备ID一样按分片数跨步分配）；暂留的确认 / 放弃同样按暂留ID转发
+//   - 新增设备：轮流交给各分片
+//   - 设备列表、申请列表、通知：向全部分片分发，拼接各分片返回的数组；用户预约按（开始时间, 设备ID）合并
+//   - 登录：用户在每个分片上都有完整副本，按用户名散列到固定分片（分摊口令校验，限流状态不分散）
+//   - 登出、批量导入：广播到全部分片（令牌吊销表与用户表在各分片分别维护）
+// 各分片须使用相同的 LAB_SESSION_SECRET，令牌由路由原样转发、由分片校验。
+// 用户的信用分等状态由各分片分别维护：归还 / 延长的扣分只记在设备所在的分片上
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "httplib.h"    // 引入 cpp-httplib 单头文件库（外部依赖）
+#include "Compression.h"
+
+// 分片地址
+struct ShardEndpoint {
+    std::string host;
+    int port{0};
+};
+
+// 解析 "host:port,host:port,..."，列表顺序即分片序号；格式错误时返回 false
+bool parseShardList(const std::string &spec, std::vector<ShardEndpoint> &out);
+
+struct RouterOptions {
+    CompressionConfig compression;  // 汇总后的列表响应按同样的规则压缩
+    bool serveStatic{true};         // 是否转发前端静态资源（取自 0 号分片）
+};
+
+class ShardRouter {
+public:
+    ShardRouter(std::vector<ShardEndpoint> shards, RouterOptions options);
+    ~ShardRouter();
+
+    // 与 ApiServer 相同的监听接口
+    bool listen(const std::string &host, int port);
+    int bindToAnyPort(const std::string &host);
+    bool listenAfterBind();
+    void stop();
+
+    size_t shardCount() const { return upstreams_.size(); }
+    // ID 的归属分片：(id - 1) % 分片数；非法ID归 0 号分片（由其返回与单进程一致的错误）
+    size_t shardOf(long long id) const;
+
+    httplib::Server http;
+
+private:
+    // 到单个分片的连接池：空闲连接保持 keep-alive 复用，出错的连接直接丢弃
+    struct Upstream {
+        ShardEndpoint endpoint;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<httplib::Client>> idle;
+    };
+
+    // 分片的响应；status 为 0 表示分片不可达
+    struct Reply {
+        int status{0};
+        std::string body;
+        std::string contentType;
+        std::string retryAfter;
+    };
+
+    RouterOptions options_;
+    std::vector<std::unique_ptr<Upstream>> upstreams_;
+    std::atomic<unsigned> nextAddShard_{0};
+    std::mutex importMutex_;   // 批量导入逐个串行广播，各分片的用户ID分配顺序一致
+
+    Reply call(size_t shard, const httplib::Request &req);
+    std::vector<Reply> scatter(const httplib::Request &req);
+    void relay(const Reply &reply, httplib::Response &res) const;
+    void forward(size_t shard, const httplib::Request &req, httplib::Response &res);
+    void gather(const httplib::Request &req, httplib::Response &res, bool keepPartial, bool byStartTime = false);
+    void addCors(httplib::Response &res) const;
+    void registerRoutes();
+};
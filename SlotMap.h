@@ -0,0 +1,103 @@
+#pragma once
+// 按ID直接索引的槽映射：替代 unordered_map<int, shared_ptr<T>> 存放用户与设备。
+//   index_：ID -> 槽号 + 1（0 表示不存在），查找只有两次数组访问、不做哈希
+//   slots_：对象连续存放，遍历时顺序扫描；删除的槽记入空闲链表，下次插入优先复用
+// index_ 按出现过的最大ID开辟、删除后不收缩：代价是每个已分配过的ID 4 字节（一百万个ID约 4 MB）。
+// 这依赖ID由 LabManager 的计数器从小到大连续分配（分片时按分片数跨步）；外部来源的ID
+// （如状态快照）须先校验不超过对应计数器，不能把任意大的ID直接插入。
+// 与所在容器相同，不做内部同步（由 LabManager::mutex 保护）
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+template <typename T>
+class SlotMap {
+public:
+    struct Slot {
+        int id{0};   // 0 表示空闲槽
+        std::shared_ptr<T> value;
+    };
+
+    // 只遍历占用中的槽（按槽号顺序，删除较少时近似按插入顺序）
+    class const_iterator {
+    public:
+        const_iterator(const Slot *p, const Slot *end) : p_(p), end_(end) { skip(); }
+        const Slot &operator*() const { return *p_; }
+        const Slot *operator->() const { return p_; }
+        const_iterator &operator++() { ++p_; skip(); return *this; }
+        bool operator!=(const const_iterator &o) const { return p_ != o.p_; }
+        bool operator==(const const_iterator &o) const { return p_ == o.p_; }
+
+    private:
+        const Slot *p_;
+        const Slot *end_;
+        void skip() { while (p_ != end_ && p_->id == 0) ++p_; }
+    };
+
+    const_iterator begin() const { return const_iterator(slots_.data(), slots_.data() + slots_.size()); }
+    const_iterator end() const { return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool contains(int id) const { return slotOf(id) != 0; }
+
+    // 查找：不存在时返回 nullptr
+    T *get(int id) const {
+        std::uint32_t s = slotOf(id);
+        return s ? slots_[s - 1].value.get() : nullptr;
+    }
+    // 需要共享所有权时（如锁外使用）才复制 shared_ptr
+    std::shared_ptr<T> share(int id) const {
+        std::uint32_t s = slotOf(id);
+        return s ? slots_[s - 1].value : nullptr;
+    }
+
+    // 插入或替换；id 须为正数
+    void insert(int id, std::shared_ptr<T> value) {
+        if (static_cast<size_t>(id) >= index_.size()) index_.resize(static_cast<size_t>(id) + 1, 0);
+        std::uint32_t &s = index_[static_cast<size_t>(id)];
+        if (s) { slots_[s - 1].value = std::move(value); return; }
+        std::uint32_t slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        slots_[slot].id = id;
+        slots_[slot].value = std::move(value);
+        s = slot + 1;
+        ++size_;
+    }
+
+    bool erase(int id) {
+        std::uint32_t s = slotOf(id);
+        if (!s) return false;
+        Slot &slot = slots_[s - 1];
+        slot.id = 0;
+        slot.value.reset();
+        free_.push_back(s - 1);
+        index_[static_cast<size_t>(id)] = 0;
+        --size_;
+        return true;
+    }
+
+    // 批量插入前预留：count 个新对象，ID 不超过 maxId
+    void reserve(size_t count, int maxId) {
+        if (count > free_.size()) slots_.reserve(slots_.size() + count - free_.size());
+        if (maxId > 0 && static_cast<size_t>(maxId) >= index_.size()) index_.reserve(static_cast<size_t>(maxId) + 1);
+    }
+
+private:
+    std::vector<std::uint32_t> index_;
+    std::vector<Slot> slots_;
+    std::vector<std::uint32_t> free_;
+    size_t size_{0};
+
+    std::uint32_t slotOf(int id) const {
+        return static_cast<size_t>(id) < index_.size() ? index_[static_cast<size_t>(id)] : 0;
+    }
+};
@@ -0,0 +1,254 @@
+// 业务状态快照：JsonWriter 流式写出，nlohmann::json 解析后先构造全新的索引，全部成功才替换
+#include "StateSnapshot.h"
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+#include "json.hpp"     // 引入 nlohmann/json 单头文件（外部依赖）
+
+#include "JsonWriter.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr int kSnapshotVersion = 4;   // 2：预约归档；3：时间轮当前时刻；4：暂留（读取时兼容旧版本）
+
+// 设备的类型特有状态（材料余量 / 校准度 / 温度）
+double deviceMetric(const Device &d) {
+    switch (d.type) {
+        case DeviceType::Consumable: return static_cast<const ConsumableDevice &>(d).materialLevel;
+        case DeviceType::Precision:  return static_cast<const PrecisionDevice &>(d).calibration;
+        case DeviceType::Power:      return static_cast<const PowerDevice &>(d).temperature;
+    }
+    return 0;
+}
+
+void setDeviceMetric(Device &d, double v) {
+    switch (d.type) {
+        case DeviceType::Consumable: static_cast<ConsumableDevice &>(d).materialLevel = v; break;
+        case DeviceType::Precision:  static_cast<PrecisionDevice &>(d).calibration = v; break;
+        case DeviceType::Power:      static_cast<PowerDevice &>(d).temperature = v; break;
+    }
+}
+
+} // namespace
+
+// 结构（为减小体积，记录均为定长数组）：
+//   users:         [id, type, username, passwordHash, creditScore, priority]
+//   devices:       [id, type, name, allowStudent, health, metric, [[start, end, userId, borrowed, actualStart], ...]]
+//   applications:  [id, userId, deviceId, start, end, reason]
+//   archive:       [deviceId, userId, start, end]
+//   notifications: [id, userId, message, createdAt]
+//   holds:         [id, userId, deviceId, start, end, expiresAt]（按ID排序）
+void writeStateSnapshot(std::string &out, const LabManager &mgr) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("applications");
+    w.beginArray();
+    for (const auto &a : mgr.applications) {
+        w.beginArray();
+        w.value(a.id); w.value(a.userId); w.value(a.deviceId);
+        w.value(static_cast<long long>(a.start)); w.value(static_cast<long long>(a.end));
+        w.value(a.reason);
+        w.endArray();
+    }
+    w.endArray();
+    w.key("archive");
+    w.beginArray();
+    for (const auto &a : mgr.reservationArchive) {
+        w.beginArray();
+        w.value(a.deviceId); w.value(a.userId);
+        w.value(static_cast<long long>(a.start)); w.value(static_cast<long long>(a.end));
+        w.endArray();
+    }
+    w.endArray();
+    w.field("archivedTotal", static_cast<long long>(mgr.archivedTotal));
+    w.field("catalogMaterialized", static_cast<long long>(mgr.catalogMaterialized));
+    w.field("catalogSize", static_cast<long long>(mgr.catalog ? mgr.catalog->size() : 0));
+    w.key("deletedCatalogIds");
+    w.beginArray();
+    for (int id : mgr.deletedCatalogIds) w.value(id);
+    w.endArray();
+    w.key("devices");
+    w.beginArray();
+    for (const auto &slot : mgr.devicesById) {
+        const Device &d = *slot.value;
+        w.beginArray();
+        w.value(d.id); w.value(static_cast<int>(d.type)); w.value(d.name); w.value(d.allowStudentReserve);
+        w.value(d.health); w.value(deviceMetric(d));
+        w.beginArray();
+        for (const auto &r : d.reservations) {
+            w.beginArray();
+            w.value(static_cast<long long>(r.startTime)); w.value(static_cast<long long>(r.endTime));
+            w.value(r.userId); w.value(r.borrowed); w.value(static_cast<long long>(r.actualStartTime));
+            w.endArray();
+        }
+        w.endArray();
+        w.endArray();
+    }
+    w.endArray();
+    w.key("holds");
+    w.beginArray();
+    std::vector<int> holdIds;
+    holdIds.reserve(mgr.holds.size());
+    for (const auto &entry : mgr.holds) holdIds.push_back(entry.first);
+    std::sort(holdIds.begin(), holdIds.end());
+    for (int id : holdIds) {
+        const LabManager::Hold &h = mgr.holds.at(id);
+        w.beginArray();
+        w.value(h.id); w.value(h.userId); w.value(h.deviceId);
+        w.value(static_cast<long long>(h.start)); w.value(static_cast<long long>(h.end)); w.value(static_cast<long long>(h.expiresAt));
+        w.endArray();
+    }
+    w.endArray();
+    w.field("nextApplicationId", mgr.nextApplicationId);
+    w.field("nextDeviceId", mgr.nextDeviceId.load());
+    w.field("nextHoldId", mgr.nextHoldId);
+    w.field("nextNotificationId", mgr.nextNotificationId);
+    w.field("nextUserId", mgr.nextUserId.load());
+    w.key("notifications");
+    w.beginArray();
+    for (const auto &n : mgr.notifications) {
+        w.beginArray();
+        w.value(n.id); w.value(n.userId); w.value(n.message); w.value(static_cast<long long>(n.createdAt));
+        w.endArray();
+    }
+    w.endArray();
+    w.field("shardCount", mgr.shardCount);
+    w.field("shardIndex", mgr.shardIndex);
+    w.field("timerClock", static_cast<long long>(mgr.timers.now()));
+    w.key("users");
+    w.beginArray();
+    for (const auto &slot : mgr.usersById) {
+        const User &u = *slot.value;
+        w.beginArray();
+        w.value(u.id); w.value(static_cast<int>(u.type)); w.value(u.username); w.value(u.passwordHash);
+        w.value(u.creditScore); w.value(u.priority);
+        w.endArray();
+    }
+    w.endArray();
+    w.field("version", kSnapshotVersion);
+    w.endObject();
+}
+
+bool loadStateSnapshot(LabManager &mgr, const std::string &data) {
+    json doc = json::parse(data, nullptr, false);
+    int version = doc.is_object() ? doc.value("version", 0) : 0;
+    if (version < 1 || version > kSnapshotVersion) return false;
+    size_t catalogSize = mgr.catalog ? mgr.catalog->size() : 0;
+    try {
+        if (doc.at("catalogSize").get<size_t>() != catalogSize) return false;
+        if (doc.at("shardIndex").get<int>() != mgr.shardIndex || doc.at("shardCount").get<int>() != mgr.shardCount) return false;
+
+        // ID 必须小于快照中的计数器：SlotMap 按最大ID开辟索引，不能让任意大的ID撑大内存
+        int nextUserId = doc.at("nextUserId").get<int>();
+        int nextDeviceId = doc.at("nextDeviceId").get<int>();
+
+        SlotMap<User> users;
+        FlatStringMap usernames;
+        for (const auto &row : doc.at("users")) {
+            int type = row.at(1).get<int>();
+            if (type < 0 || type > 2) return false;
+            std::shared_ptr<User> u = LabManager::makeUser(static_cast<UserType>(type));
+            u->id = row.at(0).get<int>();
+            u->passwordHash = row.at(3).get<std::string>();
+            u->creditScore = row.at(4).get<int>();
+            u->priority = row.at(5).get<int>();
+            if (u->id <= 0 || u->id >= nextUserId || users.contains(u->id)) return false;
+            // 驻留而不是 store：池只追加不释放，反复安装快照的副本不能每次都再复制一遍用户表
+            u->username = mgr.strings.intern(row.at(2).get_ref<const std::string &>());
+            if (!usernames.insert(u->username, u->id)) return false;
+            int id = u->id;
+            users.insert(id, std::move(u));
+        }
+
+        SlotMap<Device> devices;
+        for (const auto &row : doc.at("devices")) {
+            int type = row.at(1).get<int>();
+            if (type < 0 || type > 2) return false;
+            std::shared_ptr<Device> d = LabManager::makeDevice(static_cast<DeviceType>(type));
+            d->id = row.at(0).get<int>();
+            if (d->id <= 0 || d->id >= nextDeviceId || devices.contains(d->id)) return false;
+            d->name = mgr.strings.intern(row.at(2).get_ref<const std::string &>());
+            d->allowStudentReserve = row.at(3).get<bool>();
+            d->health = row.at(4).get<int>();
+            setDeviceMetric(*d, row.at(5).get<double>());
+            for (const auto &r : row.at(6)) {
+                Reservation res;
+                res.startTime = r.at(0).get<std::time_t>();
+                res.endTime = r.at(1).get<std::time_t>();
+                res.userId = r.at(2).get<int>();
+                res.borrowed = r.at(3).get<bool>();
+                res.actualStartTime = r.at(4).get<std::time_t>();
+                d->reservations.push_back(res);
+            }
+            int id = d->id;
+            devices.insert(id, std::move(d));
+        }
+
+        std::unordered_set<int> deleted;
+        for (const auto &id : doc.at("deletedCatalogIds")) deleted.insert(id.get<int>());
+
+        std::vector<LabManager::Application> applications;
+        for (const auto &row : doc.at("applications")) {
+            applications.push_back({row.at(0).get<int>(), row.at(1).get<int>(), row.at(2).get<int>(),
+                                    row.at(3).get<std::time_t>(), row.at(4).get<std::time_t>(), row.at(5).get<std::string>()});
+        }
+        std::vector<LabManager::Notification> notifications;
+        for (const auto &row : doc.at("notifications")) {
+            notifications.push_back({row.at(0).get<int>(), row.at(1).get<int>(), row.at(2).get<std::string>(), row.at(3).get<std::time_t>()});
+        }
+
+        std::deque<LabManager::ArchivedReservation> archive;
+        std::uint64_t archivedTotal = 0;
+        if (version >= 2) {
+            for (const auto &row : doc.at("archive")) {
+                archive.push_back({row.at(0).get<int>(), row.at(1).get<int>(), row.at(2).get<std::time_t>(), row.at(3).get<std::time_t>()});
+            }
+            archivedTotal = doc.at("archivedTotal").get<std::uint64_t>();
+        }
+
+        std::time_t timerClock = version >= 3 ? doc.at("timerClock").get<std::time_t>() : 0;
+        std::vector<LabManager::Hold> holds;
+        int nextHoldId = mgr.shardIndex + 1;
+        if (version >= 4) {
+            for (const auto &row : doc.at("holds")) {
+                holds.push_back({row.at(0).get<int>(), row.at(1).get<int>(), row.at(2).get<int>(),
+                                 row.at(3).get<std::time_t>(), row.at(4).get<std::time_t>(), row.at(5).get<std::time_t>()});
+            }
+            nextHoldId = doc.at("nextHoldId").get<int>();
+        }
+
+        int nextApplicationId = doc.at("nextApplicationId").get<int>();
+        int nextNotificationId = doc.at("nextNotificationId").get<int>();
+        size_t materialized = doc.at("catalogMaterialized").get<size_t>();
+
+        // 全部解析成功后一次性替换
+        mgr.usersById = std::move(users);
+        mgr.usernameToId = std::move(usernames);
+        mgr.devicesById = std::move(devices);
+        mgr.rebuildReservationIndex();
+        mgr.deletedCatalogIds = std::move(deleted);
+        mgr.catalogMaterialized = materialized;
+        mgr.applications = std::move(applications);
+        mgr.notifications = std::move(notifications);
+        mgr.reservationArchive = std::move(archive);
+        mgr.archivedTotal = archivedTotal;
+        mgr.nextUserId.store(nextUserId);
+        mgr.nextDeviceId.store(nextDeviceId);
+        mgr.nextApplicationId = nextApplicationId;
+        mgr.nextNotificationId = nextNotificationId;
+        mgr.nextHoldId = nextHoldId;
+        mgr.holds.clear();
+        mgr.holdsByDevice.clear();
+        mgr.holdsByUser.clear();
+        for (const auto &h : holds) mgr.insertHold(h);
+        // 定时器不序列化：按恢复的预约与时间轮时刻重建，未来的提醒与逾期处理与原节点一致
+        mgr.timers.reset(timerClock);
+        mgr.rebuildTimers();
+    } catch (const json::exception &) {
+        return false;
+    }
+    return true;
+}
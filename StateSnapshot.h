@@ -0,0 +1,17 @@
+#pragma once
+// LabManager 业务状态快照：把用户、设备（含预约）、申请、通知、暂留、预约归档与各ID计数器序列化为一个 JSON 文档，
+// 并能在另一个以相同参数启动的 LabManager 上整体替换回来。
+// 用于共识复制（见 Raft.h）的日志压缩与向落后节点安装快照。
+//
+// 挂接了只读目录时只保存覆盖层（新增设备、被修改过的目录设备）与墓碑，未修改的目录设备由各节点
+// 自己映射的同一目录提供；恢复时目录条目数不一致视为格式错误。提醒与逾期定时器、用户预约索引不保存，恢复后按预约重建。口令哈希原样保存，快照按敏感数据保管
+
+#include <string>
+
+#include "LabManager.h"
+
+// 序列化全部业务状态（调用方至少持有 mgr.mutex 共享锁）
+void writeStateSnapshot(std::string &out, const LabManager &mgr);
+
+// 用快照替换 mgr 的业务状态（调用方持有独占锁）；格式错误时不做任何修改并返回 false
+bool loadStateSnapshot(LabManager &mgr, const std::string &data);
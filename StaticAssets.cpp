@@ -0,0 +1,201 @@
+#include "StaticAssets.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#ifdef LAB_WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "Compression.h"
+#include "Logger.h"
+
+namespace {
+
+// 强 ETag：内容的 64 位 FNV-1a 摘要 + 长度，不同压缩版本加后缀区分
+std::string makeETag(const std::string &content, const char *suffix) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (unsigned char c : content) { h ^= c; h *= 1099511628211ULL; }
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "\"%016llx-%zx%s\"", h, content.size(), suffix);
+    return buf;
+}
+
+bool brotliCompress(const std::string &in, std::string &out) {
+#ifdef LAB_WITH_BROTLI
+    size_t size = BrotliEncoderMaxCompressedSize(in.size());
+    if (size == 0) return false;
+    out.resize(size);
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, in.size(),
+                               reinterpret_cast<const uint8_t *>(in.data()), &size, reinterpret_cast<uint8_t *>(&out[0]))) {
+        return false;
+    }
+    out.resize(size);
+    return true;
+#else
+    (void)in; (void)out;
+    return false;
+#endif
+}
+
+// If-None-Match 采用弱比较：忽略 W/ 前缀，任意一个标签匹配即视为命中
+bool etagMatches(const std::string &header, const std::string &etag) {
+    if (header.empty() || etag.empty()) return false;
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = header.find(',', pos);
+        if (end == std::string::npos) end = header.size();
+        std::string tag = header.substr(pos, end - pos);
+        pos = end + 1;
+        tag.erase(0, tag.find_first_not_of(" \t"));
+        tag.erase(tag.find_last_not_of(" \t") + 1);
+        if (tag == "*") return true;
+        if (tag.compare(0, 2, "W/") == 0) tag.erase(0, 2);
+        if (tag == etag) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+StaticAssets::~StaticAssets() {
+    stopWatching();
+}
+
+void StaticAssets::add(const std::string &urlPath, const std::string &filePath, const std::string &mime, const std::string &cacheControl) {
+    Entry &e = entries_[urlPath];
+    e.filePath = filePath;
+    e.mime = mime;
+    e.cacheControl = cacheControl;
+}
+
+size_t StaticAssets::loadAll() {
+    size_t loaded = 0;
+    for (auto &kv : entries_) {
+        if (reload(kv.second)) ++loaded;
+    }
+    return loaded;
+}
+
+std::vector<std::string> StaticAssets::paths() const {
+    std::vector<std::string> out;
+    for (const auto &kv : entries_) out.push_back(kv.first);
+    return out;
+}
+
+// 读取文件并构造新快照；失败时保留旧快照（重载过程中文件可能暂时不完整）
+bool StaticAssets::reload(Entry &e) {
+    std::ifstream f(e.filePath, std::ios::binary);
+    if (!f) {
+        logWarn("static.load_failed", {{"file", e.filePath}});
+        return false;
+    }
+    auto snap = std::make_shared<Snapshot>();
+    snap->identity.body.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    snap->identity.etag = makeETag(snap->identity.body, "");
+
+    // 只保留确实更小的压缩版本
+    std::string packed;
+    if (gzipOnce(snap->identity.body, packed, 9) && packed.size() < snap->identity.body.size()) {
+        snap->gzip.body.swap(packed);
+        snap->gzip.etag = makeETag(snap->identity.body, "-gz");
+    }
+    if (brotliCompress(snap->identity.body, packed) && packed.size() < snap->identity.body.size()) {
+        snap->brotli.body.swap(packed);
+        snap->brotli.etag = makeETag(snap->identity.body, "-br");
+    }
+
+    logInfo("static.loaded", {{"file", e.filePath}, {"bytes", snap->identity.body.size()},
+                              {"gzip", snap->gzip.body.size()}, {"br", snap->brotli.body.size()}});
+    std::atomic_store(&e.current, std::shared_ptr<const Snapshot>(std::move(snap)));
+    return true;
+}
+
+void StaticAssets::serve(const httplib::Request &req, httplib::Response &res) const {
+    auto it = entries_.find(req.path);
+    std::shared_ptr<const Snapshot> snap;
+    if (it != entries_.end()) snap = std::atomic_load(&it->second.current);
+    if (!snap) {
+        res.status = 404;
+        res.set_content(it != entries_.end() ? it->second.filePath + " not found" : "not found", "text/plain; charset=UTF-8");
+        return;
+    }
+    const Entry &e = it->second;
+
+    // 选择编码：brotli 优先于 gzip，客户端均不支持时返回原文
+    const std::string &accept = req.get_header_value("Accept-Encoding");
+    const Variant *v = &snap->identity;
+    const char *encoding = nullptr;
+    if (!snap->brotli.body.empty() && acceptsEncoding(accept, "br")) { v = &snap->brotli; encoding = "br"; }
+    else if (!snap->gzip.body.empty() && acceptsEncoding(accept, "gzip")) { v = &snap->gzip; encoding = "gzip"; }
+
+    res.set_header("ETag", v->etag);
+    res.set_header("Cache-Control", e.cacheControl);
+    res.set_header("Vary", "Accept-Encoding");
+
+    if (etagMatches(req.get_header_value("If-None-Match"), v->etag)) {
+        res.status = 304;
+        return;
+    }
+    if (encoding) res.set_header("Content-Encoding", encoding);
+    res.set_content(v->body, e.mime);
+}
+
+bool StaticAssets::startWatching() {
+#ifdef __linux__
+    if (watching_.exchange(true)) return true;
+    watcher_ = std::thread([this] { watchLoop(); });
+    return true;
+#else
+    return false;
+#endif
+}
+
+void StaticAssets::stopWatching() {
+    if (!watching_.exchange(false)) return;
+    if (watcher_.joinable()) watcher_.join();
+}
+
+// 监听各文件所在目录（编辑器常以“写临时文件再改名”的方式保存），命中已注册文件名时重载。
+// 只关心写完关闭（IN_CLOSE_WRITE）与改名到位（IN_MOVED_TO）：IN_CREATE 在内容写入之前触发，
+// 此时重载会读到空文件或写了一半的文件，新建的文件写完后同样会收到 IN_CLOSE_WRITE
+void StaticAssets::watchLoop() {
+#ifdef __linux__
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        logWarn("static.watch_failed", {{"reason", "inotify_init1"}});
+        return;
+    }
+    std::map<int, std::string> dirByWd;
+    for (const auto &kv : entries_) {
+        const std::string &path = kv.second.filePath;
+        size_t slash = path.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) dirByWd[wd] = dir;
+    }
+
+    alignas(inotify_event) char buf[4096];
+    while (watching_.load(std::memory_order_acquire)) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        ssize_t n = read(fd, buf, sizeof(buf));
+        for (ssize_t off = 0; off < n;) {
+            auto *ev = reinterpret_cast<const inotify_event *>(buf + off);
+            off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+            if (ev->len == 0 || !dirByWd.count(ev->wd)) continue;
+            std::string changed = dirByWd[ev->wd] == "." ? std::string(ev->name) : dirByWd[ev->wd] + "/" + ev->name;
+            for (auto &kv : entries_) {
+                const std::string &p = kv.second.filePath;
+                if (p == changed || (dirByWd[ev->wd] == "." && p == "./" + changed)) reload(kv.second);
+            }
+        }
+    }
+    close(fd);
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+// 静态资源子系统：前端文件（index.html / app.js）启动时一次性读入内存，
+// 预先计算强 ETag 与 gzip / brotli 压缩版本，按 Accept-Encoding 选择返回；
+// 支持 If-None-Match 协商缓存（304），Linux 下可选用 inotify 监听文件变化自动重载
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "httplib.h"
+
+class StaticAssets {
+public:
+    StaticAssets() = default;
+    ~StaticAssets();
+    StaticAssets(const StaticAssets &) = delete;
+    StaticAssets &operator=(const StaticAssets &) = delete;
+
+    // 注册静态资源：urlPath 为请求路径，filePath 为磁盘文件，cacheControl 为 Cache-Control 头
+    void add(const std::string &urlPath, const std::string &filePath, const std::string &mime, const std::string &cacheControl);
+
+    // 读取全部已注册文件并生成压缩版本；返回成功加载的文件数
+    size_t loadAll();
+
+    // 已注册的请求路径（用于在服务器上挂载路由）
+    std::vector<std::string> paths() const;
+
+    // 处理请求：写入 200 / 304 / 404 响应
+    void serve(const httplib::Request &req, httplib::Response &res) const;
+
+    // 启动 / 停止文件变化监听（仅 Linux inotify 生效，其他平台返回 false）
+    bool startWatching();
+    void stopWatching();
+
+private:
+    // 某一时刻文件内容的完整快照：原文与各压缩版本均预先计算好，请求处理时只读
+    struct Variant {
+        std::string body;
+        std::string etag;
+    };
+    struct Snapshot {
+        Variant identity;
+        Variant gzip;   // 为空表示不可用（未启用或压缩无收益）
+        Variant brotli;
+    };
+    struct Entry {
+        std::string filePath;
+        std::string mime;
+        std::string cacheControl;
+        std::shared_ptr<const Snapshot> current; // 通过 std::atomic_load/store 原子替换
+    };
+
+    bool reload(Entry &e);
+    void watchLoop();
+
+    std::map<std::string, Entry> entries_;
+    std::atomic<bool> watching_{false};
+    std::thread watcher_;
+};
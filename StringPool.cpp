@@ -0,0 +1,51 @@
+#include "StringPool.h"
+#include <cstring>
+
+std::string_view StringPool::intern(std::string_view s) {
+    if (s.empty()) return {};
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = set_.find(s);
+    if (it != set_.end()) return *it;
+    char *p = allocate(s.size());
+    std::memcpy(p, s.data(), s.size());
+    std::string_view stored(p, s.size());
+    set_.insert(stored);
+    return stored;
+}
+
+std::string_view StringPool::store(std::string_view s) {
+    if (s.empty()) return {};
+    std::lock_guard<std::mutex> lk(mutex_);
+    char *p = allocate(s.size());
+    std::memcpy(p, s.data(), s.size());
+    return std::string_view(p, s.size());
+}
+
+// 从当前块切出 n 字节；超过块大小四分之一的长串单独分配，避免浪费当前块的剩余空间
+char *StringPool::allocate(size_t n) {
+    if (n > chunkBytes_ / 4) {
+        chunks_.emplace_back(new char[n]);
+        bytes_ += n;
+        return chunks_.back().get();
+    }
+    if (n > left_) {
+        chunks_.emplace_back(new char[chunkBytes_]);
+        bytes_ += chunkBytes_;
+        cursor_ = chunks_.back().get();
+        left_ = chunkBytes_;
+    }
+    char *p = cursor_;
+    cursor_ += n;
+    left_ -= n;
+    return p;
+}
+
+size_t StringPool::size() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return set_.size();
+}
+
+size_t StringPool::bytes() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return bytes_;
+}
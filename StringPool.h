@@ -0,0 +1,40 @@
+#pragma once
+// 字符串驻留池：intern 使相同内容只保存一份，store 只复制进池不去重；两者都返回指向池内存储的 string_view。
+// 池只追加不释放，返回的视图在池的生命周期内一直有效（地址稳定，可直接作为哈希表键）；
+// 设备名称、用户名等大量重复或需要多处索引的短字符串由 LabManager::strings 统一驻留。
+// 代价是被删除对象的名称不回收：相同内容不重复占用，池的大小只随出现过的不同字符串增长。
+// intern 内部加锁，可在不持有 LabManager::mutex 时并发调用（批量导入在锁外预先驻留）
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+class StringPool {
+public:
+    explicit StringPool(size_t chunkBytes = 64 << 10) : chunkBytes_(chunkBytes) {}
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    // 返回与 s 内容相同的池内视图；首次出现时复制进池
+    std::string_view intern(std::string_view s);
+    // 只复制不去重：调用方已保证唯一的字符串（如用户名，由 usernameToId 判重）省去去重表的开销
+    std::string_view store(std::string_view s);
+
+    // 去重表中的字符串个数 / 已分配的存储字节数
+    size_t size() const;
+    size_t bytes() const;
+
+private:
+    size_t chunkBytes_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char *cursor_{nullptr};   // 当前块的空闲起点
+    size_t left_{0};          // 当前块剩余字节数
+    size_t bytes_{0};
+    std::unordered_set<std::string_view> set_;
+
+    char *allocate(size_t n);
+};
@@ -0,0 +1,138 @@
+#pragma once
+// 分层时间轮：以秒为刻度的定时器容器，加入 O(1)，推进时间时取出到期的定时器，不随定时器总数扫描。
+//   4 层 × 64 槽：第 l 层每槽跨 64^l 秒，整轮约 194 天；更远的定时器放在溢出表中，每转过一整轮重新分配一次
+//   每层维护非空槽位图：O(层数) 给出下一个可能到期的时刻，推进时直接跳到该时刻，长时间未推进后
+//   一次推进的开销只与途经的非空槽数有关；较高层的槽到达时整体下移到较低层（级联）
+// 不支持按句柄取消：调用方在到期时校验定时器是否仍然有效（惰性取消），失效的定时器到期时丢弃即可。
+// 同一秒到期的定时器之间的顺序不作保证。不做内部同步（由所在容器的锁保护）
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class TimingWheel {
+public:
+    struct Timer {
+        std::time_t due;
+        T value;
+    };
+
+    explicit TimingWheel(std::time_t now = 0) : now_(now) {}
+
+    // 当前时刻：不晚于它的定时器都已取出
+    std::time_t now() const { return now_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // 清空并把当前时刻设为 now
+    void reset(std::time_t now) {
+        for (auto &level : slots_) for (auto &slot : level) slot.clear();
+        occupied_.fill(0);
+        overflow_.clear();
+        size_ = 0;
+        now_ = now;
+    }
+
+    // 加入定时器；到期时刻不晚于当前时刻时不加入并返回 false
+    bool schedule(std::time_t due, T value) {
+        if (due <= now_) return false;
+        place(Timer{due, std::move(value)});
+        return true;
+    }
+
+    // 下一个可能有定时器到期的时刻（较高层的槽按槽起点计，是下界）；为空时返回 time_t 最大值
+    std::time_t nextDue() const {
+        std::time_t best = std::numeric_limits<std::time_t>::max();
+        if (size_ == 0) return best;
+        for (int l = 0; l < kLevels; ++l) {
+            int cur = static_cast<int>((now_ >> (kBits * l)) & kMask);
+            std::uint64_t mask = cur == kSlots - 1 ? 0 : occupied_[l] & (~0ull << (cur + 1));
+            if (!mask) continue;
+            std::time_t base = (now_ >> (kBits * (l + 1))) << (kBits * (l + 1));
+            std::time_t start = base + (static_cast<std::time_t>(lowestBit(mask)) << (kBits * l));
+            if (start < best) best = start;
+        }
+        if (!overflow_.empty()) {
+            std::time_t wrap = ((now_ >> (kBits * kLevels)) + 1) << (kBits * kLevels);
+            if (wrap < best) best = wrap;
+        }
+        return best;
+    }
+
+    // 把当前时刻推进到 to，(now, to] 内到期的定时器按到期时刻先后追加到 fired
+    void advance(std::time_t to, std::vector<Timer> &fired) {
+        while (now_ < to) {
+            std::time_t next = nextDue();
+            if (next > to) {
+                now_ = to;
+                return;
+            }
+            now_ = next;
+            // 跨过的各层槽边界：从高层到低层把当前槽下移
+            if ((now_ & ((std::time_t{1} << (kBits * kLevels)) - 1)) == 0 && !overflow_.empty()) {
+                std::vector<Timer> moving;
+                moving.swap(overflow_);
+                size_ -= moving.size();
+                for (auto &t : moving) place(std::move(t));
+            }
+            for (int l = kLevels - 1; l >= 1; --l) {
+                if ((now_ & ((std::time_t{1} << (kBits * l)) - 1)) != 0) continue;
+                int idx = static_cast<int>((now_ >> (kBits * l)) & kMask);
+                if (!(occupied_[l] & (1ull << idx))) continue;
+                std::vector<Timer> moving;
+                moving.swap(slots_[l][idx]);
+                occupied_[l] &= ~(1ull << idx);
+                size_ -= moving.size();
+                for (auto &t : moving) place(std::move(t));
+            }
+            int idx = static_cast<int>(now_ & kMask);
+            if (occupied_[0] & (1ull << idx)) {
+                auto &slot = slots_[0][idx];
+                size_ -= slot.size();
+                for (auto &t : slot) fired.push_back(std::move(t));
+                slot.clear();
+                occupied_[0] &= ~(1ull << idx);
+            }
+        }
+    }
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kBits = 6;
+    static constexpr int kSlots = 1 << kBits;
+    static constexpr std::time_t kMask = kSlots - 1;
+
+    std::array<std::array<std::vector<Timer>, kSlots>, kLevels> slots_;
+    std::array<std::uint64_t, kLevels> occupied_{};
+    std::vector<Timer> overflow_;   // 超出整轮范围的定时器
+    std::time_t now_;
+    size_t size_{0};
+
+    static int lowestBit(std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(mask);
+#else
+        int i = 0;
+        while (!(mask & 1u)) { mask >>= 1; ++i; }
+        return i;
+#endif
+    }
+
+    // 放入与当前时刻同属一个上层槽的最低一层（due >= now_；级联时 due == now_ 的落在第 0 层的当前槽）
+    void place(Timer &&t) {
+        ++size_;
+        for (int l = 0; l < kLevels; ++l) {
+            int up = kBits * (l + 1);
+            if ((t.due >> up) != (now_ >> up)) continue;
+            int idx = static_cast<int>((t.due >> (kBits * l)) & kMask);
+            slots_[l][idx].push_back(std::move(t));
+            occupied_[l] |= 1ull << idx;
+            return;
+        }
+        overflow_.push_back(std::move(t));
+    }
+};
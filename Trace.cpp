@@ -0,0 +1,167 @@
+#include "Trace.h"
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'L', 'A', 'B', 'T', 'R', 'C', '2', '\0'};
+const char kMagicV1[8] = {'L', 'A', 'B', 'T', 'R', 'C', '1', '\0'};
+const char *kRouteNames[kTraceRouteCount] = {
+    "login", "devices", "reserve", "borrow", "return", "extend",
+    "admin_add", "apply", "applications", "approve", "delete", "maintain", "notifications",
+    "import", "compact", "timers",
+    "hold", "hold_confirm", "hold_release",
+    "user_reservations",
+};
+
+// 负载上限：防止损坏文件中的超大长度导致一次性分配过多内存
+constexpr std::uint64_t kMaxPayload = 256u << 20;  // 批量导入的请求体可达数十 MiB
+
+long long systemMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+void putVarint(std::string &out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool getVarint(std::FILE *f, std::uint64_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(f);
+        if (c == EOF) return false;
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+void putFixed64(std::string &out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+} // namespace
+
+const char *traceRouteName(TraceRoute route) {
+    size_t i = static_cast<size_t>(route);
+    return i < kTraceRouteCount ? kRouteNames[i] : "unknown";
+}
+
+// ---- TraceWriter ----
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string &path) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (file_) return false;
+#ifndef _WIN32
+    // 登录请求体含明文密码：轨迹文件仅允许属主读写
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return false;
+    file_ = ::fdopen(fd, "wb");
+    if (!file_) { ::close(fd); return false; }
+#else
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+#endif
+    lastUs_ = lastFlushUs_ = systemMicros();
+    buf_.assign(kMagic, sizeof(kMagic));
+    putFixed64(buf_, static_cast<std::uint64_t>(lastUs_));
+    std::fwrite(buf_.data(), 1, buf_.size(), file_);
+    std::fflush(file_);
+    return true;
+}
+
+void TraceWriter::close() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!file_) return;
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void TraceWriter::append(TraceRoute route, int userId, const std::string &payload) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!file_) return;
+    long long now = systemMicros();
+    // 系统时间回拨时按 0 间隔记录，保证时间戳单调
+    long long delta = now > lastUs_ ? now - lastUs_ : 0;
+    lastUs_ += delta;
+    buf_.clear();
+    putVarint(buf_, static_cast<std::uint64_t>(delta));
+    buf_.push_back(static_cast<char>(route));
+    putVarint(buf_, static_cast<std::uint32_t>(userId));
+    putVarint(buf_, payload.size());
+    buf_.append(payload);
+    std::fwrite(buf_.data(), 1, buf_.size(), file_);
+    ++count_;
+    if (lastUs_ - lastFlushUs_ >= 1000000) {
+        std::fflush(file_);
+        lastFlushUs_ = lastUs_;
+    }
+}
+
+std::uint64_t TraceWriter::count() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return count_;
+}
+
+// ---- TraceReader ----
+
+TraceReader::~TraceReader() {
+    if (file_) std::fclose(file_);
+}
+
+bool TraceReader::open(const std::string &path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return false;
+    unsigned char header[16];
+    if (std::fread(header, 1, sizeof(header), file_) != sizeof(header)) {
+        corrupt_ = true;
+        return false;
+    }
+    if (std::memcmp(header, kMagic, sizeof(kMagic)) == 0) version_ = 2;
+    else if (std::memcmp(header, kMagicV1, sizeof(kMagicV1)) == 0) version_ = 1;
+    else {
+        corrupt_ = true;
+        return false;
+    }
+    std::uint64_t start = 0;
+    for (int i = 0; i < 8; ++i) start |= static_cast<std::uint64_t>(header[8 + i]) << (8 * i);
+    startUs_ = lastUs_ = static_cast<long long>(start);
+    return true;
+}
+
+bool TraceReader::next(TraceRecord &out) {
+    if (!file_ || corrupt_) return false;
+    std::uint64_t delta = 0;
+    if (!getVarint(file_, delta)) return false; // 正常结束（或写入方被中断时的残缺尾部）
+    int route = std::fgetc(file_);
+    std::uint64_t user = 0;
+    std::uint64_t len = 0;
+    if (route == EOF || route >= static_cast<int>(kTraceRouteCount) || (version_ >= 2 && !getVarint(file_, user)) || !getVarint(file_, len) || len > kMaxPayload) {
+        corrupt_ = true;
+        return false;
+    }
+    out.payload.resize(len);
+    if (len && std::fread(&out.payload[0], 1, len, file_) != len) {
+        corrupt_ = true;
+        return false;
+    }
+    lastUs_ += static_cast<long long>(delta);
+    out.timestampUs = lastUs_;
+    out.route = static_cast<TraceRoute>(route);
+    out.userId = static_cast<int>(static_cast<std::uint32_t>(user));
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+// 请求轨迹（trace）：服务器按实际作用于 LabManager 的顺序记录每个 API 请求（路由、请求体、时间戳），
+// 写入紧凑的二进制文件，供 lab_replay 在全新的 LabManager 上以虚拟时钟确定性地回放。
+//
+// 文件格式（整数均为小端 / LEB128 变长编码）：
+//   文件头：8 字节魔数 "LABTRC2\0" + 8 字节起始时间（Unix 微秒）
+//   每条记录：varint 距上一条的微秒数 | 1 字节路由 | varint 会话用户ID | varint 负载长度 | 负载
+// 会话用户ID 为令牌中的 userId（登录等无需令牌的接口为 0）；旧版 "LABTRC1" 文件没有该字段，按 0 读取
+// 负载为 POST 请求体；GET /api/notifications 记录查询串（如 "userId=3"），GET /api/users/{id}/reservations
+// 记录路径中的用户（同样为 "userId=3"），其余 GET 负载为空。
+// 后台的预约压缩记为 compact，负载为截止时间（如 "before=1700000000"）；到期定时器的处理记为 timers，
+// 负载为推进到的时刻（如 "until=1700000000"）；两者的会话用户ID 为 0。
+// 时间戳在取得锁后记录，处理函数随后才读取时钟：两者相差微秒级，恰好跨秒的请求回放时可能早一秒。
+// 登录请求体含明文密码，轨迹文件应按敏感数据保管（POSIX 下以 0600 权限创建）
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+// 可记录的 API 路由（取值写入文件，只能追加不能重排）
+enum class TraceRoute : std::uint8_t {
+    Login, Devices, Reserve, Borrow, Return, Extend,
+    AdminAdd, Apply, Applications, Approve, Delete, Maintain, Notifications,
+    Import,
+    Compact,
+    Timers,
+    Hold, HoldConfirm, HoldRelease,
+    UserReservations,
+    Count
+};
+
+constexpr size_t kTraceRouteCount = static_cast<size_t>(TraceRoute::Count);
+
+const char *traceRouteName(TraceRoute route);
+
+struct TraceRecord {
+    long long timestampUs{0};   // Unix 微秒
+    TraceRoute route{TraceRoute::Login};
+    int userId{0};              // 会话令牌对应的用户（0 表示无需令牌）
+    std::string payload;
+};
+
+// 轨迹写入：线程安全；处理函数在持有 LabManager 锁之后调用 append，文件中的顺序即实际执行顺序
+class TraceWriter {
+public:
+    ~TraceWriter();
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+
+    // 追加一条记录，时间戳取调用时刻的系统时间；约每秒刷新一次到磁盘
+    void append(TraceRoute route, int userId, const std::string &payload);
+
+    std::uint64_t count() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::FILE *file_{nullptr};
+    long long lastUs_{0};
+    long long lastFlushUs_{0};
+    std::uint64_t count_{0};
+    std::string buf_;
+};
+
+// 轨迹读取：顺序解码记录
+class TraceReader {
+public:
+    ~TraceReader();
+
+    // 打开并校验文件头
+    bool open(const std::string &path);
+    // 读取下一条记录；到达文件末尾或遇到损坏数据时返回 false（可用 corrupt() 区分）
+    bool next(TraceRecord &out);
+    bool corrupt() const { return corrupt_; }
+    long long startUs() const { return startUs_; }
+
+private:
+    std::FILE *file_{nullptr};
+    long long startUs_{0};
+    long long lastUs_{0};
+    int version_{0};
+    bool corrupt_{false};
+};
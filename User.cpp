@@ -1,5 +1,5 @@
 #include "User.h"
-#include <functional>
+#include "PasswordHash.h"
 
 // 基础行为实现
 bool User::canReserve() const {
@@ -21,9 +21,7 @@ void User::restoreCredit() {
 }
 
 bool User::verifyPassword(const std::string &plain) const {
-    // 演示用简单哈希对比（不安全，仅示例）
-    std::hash<std::string> h;
-    return h(plain) == h(passwordHash);
+    return verifyPasswordHash(plain, passwordHash);
 }
 
 // 派生类构造：设置优先级与初始信用
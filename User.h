@@ -2,6 +2,7 @@
 // 用户类层次结构定义：基础用户行为接口，学生/教师/管理员通过派生类区分
 
 #include <string>
+#include <string_view>
 #include "Types.h"
 
 class User {
@@ -11,8 +12,8 @@ public:
 
     // 基础属性
     int id{0};
-    std::string username;
-    std::string passwordHash; // 演示用哈希（非生产安全方案）
+    std::string_view username; // 指向 LabManager::strings 中的驻留副本
+    std::string passwordHash; // scrypt 哈希（格式见 PasswordHash.h）
     int creditScore{0};
     int priority{0};
     UserType type{UserType::Student};
@@ -28,7 +29,7 @@ public:
     // 恢复信用分至初始值，虚函数
     virtual void restoreCredit();
 
-    // 验证登录密码，虚函数
+    // 验证登录密码，虚函数；耗时数十毫秒，不要在持有 LabManager::mutex 时调用
     virtual bool verifyPassword(const std::string &plain) const;
 };
 
@@ -0,0 +1,59 @@
+#include "VerifyPool.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+VerifyPool::VerifyPool(size_t threads, size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) workers_.emplace_back([this] { run(); });
+}
+
+VerifyPool::~VerifyPool() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &w : workers_) w.join();
+}
+
+bool VerifyPool::trySubmit(std::function<bool()> job, std::future<bool> &result) {
+    std::packaged_task<bool()> task(std::move(job));
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopping_ || inFlight_.load(std::memory_order_relaxed) >= capacity_) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        result = task.get_future();
+        queue_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void VerifyPool::run() {
+#ifdef __linux__
+    // 降低校验线程的调度优先级（Linux 下 nice 值按线程生效）：CPU 紧张时优先运行处理其他接口的 HTTP 线程
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+    for (;;) {
+        std::packaged_task<bool()> task;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this] { return stopping_ || !queue_.empty(); });
+            // 停止时仍执行完已入队的任务，等待中的 HTTP 线程都能拿到结果
+            if (queue_.empty()) return;
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
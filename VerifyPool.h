@@ -0,0 +1,44 @@
+#pragma once
+// 口令校验线程池：scrypt 校验放到固定数量的专用线程上执行，HTTP 线程只提交并等待结果。
+// 队列有上限——上课前的集中登录超出容量时立即拒绝（接口返回 503），
+// 而不是让所有 HTTP 线程都阻塞在口令计算上，从而保证预约、借还等请求仍有线程与 CPU 可用
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class VerifyPool {
+public:
+    // threads 为 0 时取 CPU 核数的一半（至少 1）；capacity 为排队 + 执行中的任务上限
+    VerifyPool(size_t threads, size_t capacity);
+    ~VerifyPool();
+
+    VerifyPool(const VerifyPool &) = delete;
+    VerifyPool &operator=(const VerifyPool &) = delete;
+
+    // 提交校验任务；已满时返回 false，result 不变
+    bool trySubmit(std::function<bool()> job, std::future<bool> &result);
+
+    size_t threads() const { return workers_.size(); }
+    size_t capacity() const { return capacity_; }
+    size_t inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+    std::uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::packaged_task<bool()>> queue_;
+    bool stopping_{false};
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::vector<std::thread> workers_;
+};
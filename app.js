@@ -25,15 +25,16 @@ async function confirmExtend(){ const endVal=document.getElementById('extend-end
 async function confirmReserve(){ const startVal=document.getElementById('reserve-start').value; const endVal=document.getElementById('reserve-end').value; let start=Math.floor(new Date(startVal).getTime()/1000); let end=Math.floor(new Date(endVal).getTime()/1000); if(!start||Number.isNaN(start)||!end||Number.isNaN(end)){ const nowSec=Math.floor(Date.now()/1000); start=nowSec; end=nowSec+3600; } if(start>=end){ alert('结束时间必须晚于开始时间'); return; } const dev=reserveTarget; let r; if(isStudent() && dataLastDeviceMap[dev.id] && dataLastDeviceMap[dev.id].allowStudent===false){ const reason=(document.getElementById('reserve-reason')?.value||'').trim(); r=await api('/api/apply','POST',{ userId: currentUser.userId, deviceId: dev.id, startTime: start, endTime: end, reason }); alert(r.ok?'申请已提交，等待管理员审核':'申请失败'); } else { r=await api('/api/reserve','POST',{ userId: currentUser.userId, deviceId: dev.id, startTime: start, endTime: end }); alert(r.ok?'预约成功':'预约失败（时间冲突或信用不足）'); } document.getElementById('reserveModal').style.display='none'; await refreshAll(); }
 
 const BASE='http://localhost:8080';
-async function api(path,method='GET',data=null){ const opts={ method, headers:{'Content-Type':'application/json'} }; if(data) opts.body=JSON.stringify(data); try{ const r=await fetch(BASE+path,opts); const text=await r.text(); try{ return JSON.parse(text); } catch{ return { ok:false, message:'响应非JSON', raw:text }; } } catch(e){ return { ok:false, message:e&&e.message?e.message:'网络错误' }; } }
+async function api(path,method='GET',data=null){ const opts={ method, headers:{'Content-Type':'application/json'} }; if(currentUser && currentUser.token) opts.headers['Authorization']='Bearer '+currentUser.token; if(data) opts.body=JSON.stringify(data); try{ const r=await fetch(BASE+path,opts); const text=await r.text(); try{ return JSON.parse(text); } catch{ return { ok:false, message:'响应非JSON', raw:text }; } } catch(e){ return { ok:false, message:e&&e.message?e.message:'网络错误' }; } }
 
 function typeName(t){ return ['耗材','精密','动力'][t]||'未知'; }
 function statusName(s){ return ['空闲','已预约','使用中','损坏'][s]||'未知'; }
 
 let dataLastDeviceMap={};
-async function loadDevices(){ const data=await api('/api/devices'); const wrap=document.getElementById('devices'); wrap.innerHTML=''; if(!data.ok) return; dataLastDeviceMap={}; data.devices.forEach(dev=>{ dataLastDeviceMap[dev.id]=dev; const card=document.createElement('div'); card.className='card'; const tags=[]; tags.push(`<span class="tag">类型：${typeName(dev.type)}</span>`); tags.push(`<span class="tag">健康：${dev.health}</span>`); tags.push(`<span class="tag">状态：${statusName(dev.status)}</span>`); tags.push(`<span class="tag">学生可预约：${dev.allowStudent ? '是' : '否'}</span>`); if(dev.materialLevel!=null) tags.push(`<span class="tag">材料：${dev.materialLevel.toFixed(1)}%</span>`); if(dev.calibration!=null) tags.push(`<span class="tag">校准：${dev.calibration.toFixed(1)}%</span>`); if(dev.temperature!=null) tags.push(`<span class="tag">温度：${dev.temperature.toFixed(1)}℃</span>`); card.innerHTML=`<div class="name">${dev.name} (#${dev.id})</div>${tags.join(' ')}`;
-  const now=Math.floor(Date.now()/1000); const activeList=dev.reservations.filter(r=>now>=r.startTime && now<=r.endTime); if(activeList.length && dev.status!==0){ const info=document.createElement('div'); info.style.marginTop='6px'; if(isAdmin()){ info.innerHTML=activeList.map(r=>`<span class="tag">#${r.userId}：${fmtHM(r.startTime)} - ${fmtHM(r.endTime)}</span>`).join(' '); } else { const mine=activeList.find(r=>r.userId===getCurrentUserId()); if(mine) info.innerHTML=`<span class="tag">时间：${fmtHM(mine.startTime)} - ${fmtHM(mine.endTime)}</span>`; } if(info.innerHTML) card.appendChild(info); }
-  const btns=document.createElement('div'); btns.className='row'; const hasMyActive=dev.reservations.some(r=>r.userId===getCurrentUserId() && now>=r.startTime && now<=r.endTime); const myRes=dev.reservations.find(r=>r.userId===getCurrentUserId());
+async function loadMyReservations(){ const byDevice={}; if(!isLoggedIn()) return byDevice; const data=await api(`/api/users/${getCurrentUserId()}/reservations`); if(data.ok) data.reservations.forEach(r=>{ (byDevice[r.deviceId]=byDevice[r.deviceId]||[]).push(r); }); return byDevice; }
+async function loadDevices(){ const [data,myByDevice]=await Promise.all([api('/api/devices'),loadMyReservations()]); const wrap=document.getElementById('devices'); wrap.innerHTML=''; if(!data.ok) return; dataLastDeviceMap={}; data.devices.forEach(dev=>{ dataLastDeviceMap[dev.id]=dev; const card=document.createElement('div'); card.className='card'; const tags=[]; tags.push(`<span class="tag">类型：${typeName(dev.type)}</span>`); tags.push(`<span class="tag">健康：${dev.health}</span>`); tags.push(`<span class="tag">状态：${statusName(dev.status)}</span>`); tags.push(`<span class="tag">学生可预约：${dev.allowStudent ? '是' : '否'}</span>`); if(dev.materialLevel!=null) tags.push(`<span class="tag">材料：${dev.materialLevel.toFixed(1)}%</span>`); if(dev.calibration!=null) tags.push(`<span class="tag">校准：${dev.calibration.toFixed(1)}%</span>`); if(dev.temperature!=null) tags.push(`<span class="tag">温度：${dev.temperature.toFixed(1)}℃</span>`); card.innerHTML=`<div class="name">${dev.name} (#${dev.id})</div>${tags.join(' ')}`;
+  const now=Math.floor(Date.now()/1000); const myList=myByDevice[dev.id]||[]; const activeList=dev.reservations.filter(r=>now>=r.startTime && now<=r.endTime); if(activeList.length && dev.status!==0){ const info=document.createElement('div'); info.style.marginTop='6px'; if(isAdmin()){ info.innerHTML=activeList.map(r=>`<span class="tag">#${r.userId}：${fmtHM(r.startTime)} - ${fmtHM(r.endTime)}</span>`).join(' '); } else { const mine=myList.find(r=>now>=r.startTime && now<=r.endTime); if(mine) info.innerHTML=`<span class="tag">时间：${fmtHM(mine.startTime)} - ${fmtHM(mine.endTime)}</span>`; } if(info.innerHTML) card.appendChild(info); }
+  const btns=document.createElement('div'); btns.className='row'; const hasMyActive=myList.some(r=>now>=r.startTime && now<=r.endTime); const myRes=myList[0];
   if(isStudent() && !dev.allowStudent){ const btnApply=document.createElement('button'); btnApply.className='btn btn-primary'; btnApply.textContent='申请'; btnApply.onclick=()=>openReserve(dev.id,dev.name); btns.appendChild(btnApply); } else { const btnReserve=document.createElement('button'); btnReserve.className='btn btn-primary'; btnReserve.textContent='预约'; btnReserve.onclick=()=>openReserve(dev.id,dev.name); btns.appendChild(btnReserve); }
   if(hasMyActive && dev.status===1){ const btnBorrow=document.createElement('button'); btnBorrow.className='btn btn-secondary'; btnBorrow.textContent='借用'; btnBorrow.onclick=async()=>{ const r=await api('/api/borrow','POST',{ userId: currentUser.userId, deviceId: dev.id }); alert(r.ok?'借用成功':'借用失败'); await refreshAll(); }; btns.appendChild(btnBorrow); }
   if(hasMyActive && dev.status===2){ const btnReturn=document.createElement('button'); btnReturn.className='btn btn-danger'; btnReturn.textContent='归还'; btnReturn.onclick=async()=>{ const r=await api('/api/return','POST',{ userId: currentUser.userId, deviceId: dev.id }); if(r.credit!=null){ currentUser.credit=r.credit; const el=document.getElementById('credit'); if(el) el.textContent=`信用分：${currentUser.credit}`; } alert(r.ok?'归还成功（可能因逾期扣分）':'归还失败'); await refreshAll(); }; btns.appendChild(btnReturn); }
@@ -45,10 +46,10 @@ async function loadDevices(){ const data=await api('/api/devices'); const wrap=d
 async function refreshAll(){ await loadDevices(); if(currentUser){ const el=document.getElementById('credit'); if(el) el.textContent=`信用分：${currentUser.credit}`; } }
 
 document.getElementById('refresh').onclick=refreshAll;
-document.getElementById('logout').onclick=()=>{ currentUser=null; document.getElementById('loginModal').style.display='flex'; const el=document.getElementById('credit'); if(el) el.textContent='信用分：-'; document.getElementById('addDevice').style.display='none'; };
+document.getElementById('logout').onclick=async()=>{ if(currentUser && currentUser.token) await api('/api/logout','POST'); currentUser=null; document.getElementById('loginModal').style.display='flex'; const el=document.getElementById('credit'); if(el) el.textContent='信用分：-'; document.getElementById('addDevice').style.display='none'; };
 document.getElementById('addDevice').onclick=async()=>{ const name=prompt('设备名称：'); if(!name) return; const typeStr=prompt('设备类型(0=耗材,1=精密,2=动力)：'); const type=Number(typeStr); if(![0,1,2].includes(type)){ alert('类型输入无效'); return; } const allowStr=prompt('学生可预约？(是/否)：'); const allowStudent=(allowStr||'是').trim()==='是'; const r=await api('/api/admin/add','POST',{ name, type, allowStudent }); alert(r.ok?`已新增设备 #${r.deviceId}`:'新增失败'); await refreshAll(); };
 
-document.getElementById('login').onclick=async()=>{ try{ const username=document.getElementById('username').value.trim(); const password=document.getElementById('password').value.trim(); const r=await api('/api/login','POST',{ username,password }); if(!r || !r.ok){ alert('登录失败'); return; } currentUser={ userId:r.userId, username:r.username, credit:r.credit, priority:r.priority, type:r.type }; document.getElementById('loginModal').style.display='none'; document.getElementById('logout').style.display='inline-block'; if(currentUser.type===2){ document.getElementById('addDevice').style.display='inline-block'; const aBtn=document.getElementById('btnApps'); if(aBtn) aBtn.style.display='inline-block'; } setDefaultToolbarTimes(); await refreshAll(); } catch(e){ alert('登录请求失败，请检查后端是否运行'); } };
+document.getElementById('login').onclick=async()=>{ try{ const username=document.getElementById('username').value.trim(); const password=document.getElementById('password').value.trim(); const r=await api('/api/login','POST',{ username,password }); if(!r || !r.ok){ alert('登录失败'); return; } currentUser={ userId:r.userId, username:r.username, credit:r.credit, priority:r.priority, type:r.type, token:r.token }; document.getElementById('loginModal').style.display='none'; document.getElementById('logout').style.display='inline-block'; if(currentUser.type===2){ document.getElementById('addDevice').style.display='inline-block'; const aBtn=document.getElementById('btnApps'); if(aBtn) aBtn.style.display='inline-block'; } setDefaultToolbarTimes(); await refreshAll(); } catch(e){ alert('登录请求失败，请检查后端是否运行'); } };
 
 document.getElementById('reserveCancel').onclick=()=>{ document.getElementById('reserveModal').style.display='none'; };
 document.getElementById('reserveConfirm').onclick=async()=>{ await confirmReserve(); };
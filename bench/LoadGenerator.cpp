@@ -0,0 +1,289 @@
+#include "LoadGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "httplib.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const char *kOpNames[kLoadOpCount] = {"login", "devices", "reserve", "borrow", "return", "extend", "apply", "approve"};
+
+struct Account {
+    std::string username;
+    std::string password;
+    int userId{0};
+    int type{0};
+    std::string token;   // 登录返回的会话令牌，后续请求放在 Authorization 头中
+};
+
+// 单次请求的结果样本
+struct Sample {
+    std::uint32_t latencyUs;   // 自计划发送时刻起的延迟
+    std::uint8_t op;
+    bool ok;                   // 业务成功（HTTP 200 且 ok 为 true）
+    bool transportError;       // 连接失败 / 非 2xx
+};
+
+struct SharedState {
+    std::vector<Account> accounts;
+    Account admin;
+    std::vector<int> deviceIds;
+    std::mutex appMutex;
+    std::vector<int> pendingApps; // apply 产生、尚未审批的申请ID，供 approve 使用
+};
+
+httplib::Headers authHeaders(const std::string &token) {
+    if (token.empty()) return {};
+    return {{"Authorization", "Bearer " + token}};
+}
+
+bool postJson(httplib::Client &cli, const char *path, const json &body, const std::string &token, json *out, bool &transportError) {
+    auto res = cli.Post(path, authHeaders(token), body.dump(), "application/json");
+    if (!res || res->status >= 500 || res->status == 0) { transportError = true; return false; }
+    transportError = false;
+    if (res->status != 200) return false;
+    json parsed = json::parse(res->body, nullptr, false);
+    if (parsed.is_discarded()) return false;
+    if (out) *out = parsed;
+    return parsed.value("ok", false);
+}
+
+bool login(httplib::Client &cli, Account &acc) {
+    bool transportError = false;
+    json out;
+    if (!postJson(cli, "/api/login", {{"username", acc.username}, {"password", acc.password}}, "", &out, transportError)) return false;
+    acc.userId = out.value("userId", 0);
+    acc.type = out.value("type", 0);
+    acc.token = out.value("token", "");
+    return true;
+}
+
+// 执行一次操作；rng 决定账号、设备与时间段的选择
+bool execute(LoadOp op, httplib::Client &cli, SharedState &st, std::mt19937_64 &rng, bool &transportError) {
+    const Account &acc = st.accounts[rng() % st.accounts.size()];
+    int deviceId = st.deviceIds.empty() ? 1 : st.deviceIds[rng() % st.deviceIds.size()];
+    long long now = static_cast<long long>(std::time(nullptr));
+    transportError = false;
+
+    switch (op) {
+        case LoadOp::Login: {
+            auto res = cli.Post("/api/login", json({{"username", acc.username}, {"password", acc.password}}).dump(), "application/json");
+            if (!res || res->status >= 500) { transportError = true; return false; }
+            return res->status == 200;
+        }
+        case LoadOp::Devices: {
+            auto res = cli.Get("/api/devices");
+            if (!res || res->status != 200) { transportError = true; return false; }
+            return res->body.compare(0, 11, "{\"devices\":") == 0;
+        }
+        case LoadOp::Reserve: {
+            // 约 40% 的预约从当前时刻开始（供 borrow / return 命中），其余分布在未来一周内
+            long long start = (rng() % 10 < 4) ? now : now + static_cast<long long>(1 + rng() % 168) * 3600;
+            return postJson(cli, "/api/reserve", {{"deviceId", deviceId}, {"startTime", start}, {"endTime", start + 3600}}, acc.token, nullptr, transportError);
+        }
+        case LoadOp::Borrow:
+            return postJson(cli, "/api/borrow", {{"deviceId", deviceId}}, acc.token, nullptr, transportError);
+        case LoadOp::Return:
+            return postJson(cli, "/api/return", {{"deviceId", deviceId}}, acc.token, nullptr, transportError);
+        case LoadOp::Extend: {
+            long long newEnd = now + static_cast<long long>(1 + rng() % 3) * 3600;
+            return postJson(cli, "/api/extend", {{"deviceId", deviceId}, {"endTime", newEnd}}, acc.token, nullptr, transportError);
+        }
+        case LoadOp::Apply: {
+            long long start = now + static_cast<long long>(1 + rng() % 168) * 3600;
+            json out;
+            bool ok = postJson(cli, "/api/apply", {{"deviceId", deviceId}, {"startTime", start}, {"endTime", start + 3600}, {"reason", "load test"}}, acc.token, &out, transportError);
+            if (ok) {
+                std::lock_guard<std::mutex> lk(st.appMutex);
+                st.pendingApps.push_back(out.value("applicationId", 0));
+            }
+            return ok;
+        }
+        case LoadOp::Approve: {
+            int appId = 0;
+            {
+                std::lock_guard<std::mutex> lk(st.appMutex);
+                if (!st.pendingApps.empty()) { appId = st.pendingApps.back(); st.pendingApps.pop_back(); }
+            }
+            return postJson(cli, "/api/admin/applications/approve", {{"appId", appId}}, st.admin.token, nullptr, transportError);
+        }
+        case LoadOp::Count:
+            break;
+    }
+    return false;
+}
+
+json latencySummary(std::vector<std::uint32_t> &v) {
+    if (v.empty()) return json::object();
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))]; };
+    double sum = 0;
+    for (auto x : v) sum += x;
+    return {{"p50", pct(0.50)}, {"p99", pct(0.99)}, {"p999", pct(0.999)}, {"max", v.back()}, {"mean", sum / v.size()}};
+}
+
+} // namespace
+
+const char *loadOpName(LoadOp op) {
+    size_t i = static_cast<size_t>(op);
+    return i < kLoadOpCount ? kOpNames[i] : "unknown";
+}
+
+bool parseLoadMix(const std::string &spec, LoadConfig &cfg) {
+    std::array<int, kLoadOpCount> weights{};
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string name = item.substr(0, eq);
+        size_t idx = 0;
+        while (idx < kLoadOpCount && name != kOpNames[idx]) ++idx;
+        if (idx == kLoadOpCount) return false;
+        weights[idx] = std::atoi(item.c_str() + eq + 1);
+    }
+    int total = 0;
+    for (int w : weights) total += std::max(0, w);
+    if (total == 0) return false;
+    cfg.weights = weights;
+    return true;
+}
+
+bool parseLoadFlag(int argc, char **argv, int &i, LoadConfig &cfg) {
+    if (i + 1 >= argc) return false;
+    const char *flag = argv[i];
+    const char *value = argv[i + 1];
+    if (std::strcmp(flag, "--qps") == 0) cfg.qps = std::atof(value);
+    else if (std::strcmp(flag, "--duration") == 0) cfg.durationSec = std::atof(value);
+    else if (std::strcmp(flag, "--warmup") == 0) cfg.warmupSec = std::atof(value);
+    else if (std::strcmp(flag, "--connections") == 0) cfg.connections = std::max(1, std::atoi(value));
+    else if (std::strcmp(flag, "--seed") == 0) cfg.seed = std::strtoull(value, nullptr, 10);
+    else if (std::strcmp(flag, "--mix") == 0) { if (!parseLoadMix(value, cfg)) return false; }
+    else return false;
+    ++i;
+    return true;
+}
+
+const char *loadFlagsUsage() {
+    return "  --qps N           目标请求速率（默认 200）\n"
+           "  --duration S      统计时长，秒（默认 10）\n"
+           "  --warmup S        预热时长，秒（默认 1）\n"
+           "  --connections N   并发连接数（默认 8）\n"
+           "  --seed N          随机种子（默认 42）\n"
+           "  --mix SPEC        操作权重，如 login=5,devices=50,reserve=15,borrow=10,return=8,extend=5,apply=4,approve=3\n";
+}
+
+std::string runLoad(const LoadConfig &cfg) {
+    SharedState st;
+
+    // 准备阶段：登录全部账号（含管理员）取得 userId 与会话令牌，获取设备ID列表
+    {
+        httplib::Client cli(cfg.host, cfg.port);
+        cli.set_keep_alive(true);
+        cli.set_tcp_nodelay(true);
+        for (const auto &a : cfg.accounts) {
+            Account acc{a.first, a.second, 0, 0, {}};
+            if (login(cli, acc)) st.accounts.push_back(acc);
+        }
+        st.admin = Account{cfg.admin.first, cfg.admin.second, 0, 0, {}};
+        if (!st.admin.username.empty()) login(cli, st.admin);
+        if (st.accounts.empty()) return "";
+        auto res = cli.Get("/api/devices");
+        if (!res || res->status != 200) return "";
+        json devices = json::parse(res->body, nullptr, false);
+        if (devices.is_discarded()) return "";
+        for (const auto &d : devices["devices"]) st.deviceIds.push_back(d.value("id", 0));
+    }
+
+    // 操作选择表：按权重展开，按序号确定性地选择操作
+    std::vector<LoadOp> table;
+    for (size_t i = 0; i < kLoadOpCount; ++i) {
+        for (int k = 0; k < cfg.weights[i]; ++k) table.push_back(static_cast<LoadOp>(i));
+    }
+
+    const auto interval = std::chrono::duration<double>(1.0 / std::max(cfg.qps, 0.001));
+    const auto start = Clock::now() + std::chrono::milliseconds(50);
+    const auto measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.warmupSec));
+    const auto stopAt = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.durationSec));
+
+    std::atomic<std::uint64_t> nextSeq{0};
+    std::vector<std::vector<Sample>> perThread(static_cast<size_t>(cfg.connections));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < cfg.connections; ++t) {
+        workers.emplace_back([&, t] {
+            httplib::Client cli(cfg.host, cfg.port);
+            cli.set_keep_alive(true);
+            cli.set_tcp_nodelay(true);
+            auto &samples = perThread[static_cast<size_t>(t)];
+            for (;;) {
+                std::uint64_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+                auto intended = start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(seq));
+                if (intended >= stopAt) break;
+                std::this_thread::sleep_until(intended);
+
+                std::mt19937_64 rng(cfg.seed ^ (seq * 0x9E3779B97F4A7C15ULL));
+                LoadOp op = table[rng() % table.size()];
+                bool transportError = false;
+                bool ok = execute(op, cli, st, rng, transportError);
+                auto done = Clock::now();
+                if (intended < measureFrom) continue;
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(done - intended).count();
+                samples.push_back(Sample{static_cast<std::uint32_t>(std::min<long long>(us, UINT32_MAX)), static_cast<std::uint8_t>(op), ok, transportError});
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    double elapsed = std::chrono::duration<double>(std::max(Clock::now(), stopAt) - measureFrom).count();
+
+    // 汇总：总体与分操作的延迟分布、成功 / 失败 / 传输错误计数
+    std::vector<std::uint32_t> all;
+    std::array<std::vector<std::uint32_t>, kLoadOpCount> byOp;
+    std::array<std::uint64_t, kLoadOpCount> okCount{}, failCount{}, errCount{};
+    std::uint64_t errors = 0;
+    for (const auto &samples : perThread) {
+        for (const auto &s : samples) {
+            all.push_back(s.latencyUs);
+            byOp[s.op].push_back(s.latencyUs);
+            if (s.transportError) { ++errCount[s.op]; ++errors; }
+            else if (s.ok) ++okCount[s.op];
+            else ++failCount[s.op];
+        }
+    }
+
+    json ops = json::object();
+    for (size_t i = 0; i < kLoadOpCount; ++i) {
+        if (byOp[i].empty()) continue;
+        json o = latencySummary(byOp[i]);
+        o["count"] = byOp[i].size();
+        o["ok"] = okCount[i];
+        o["rejected"] = failCount[i];
+        o["errors"] = errCount[i];
+        ops[kOpNames[i]] = o;
+    }
+    json mix = json::object();
+    for (size_t i = 0; i < kLoadOpCount; ++i) mix[kOpNames[i]] = cfg.weights[i];
+
+    json report{
+        {"target", cfg.host + ":" + std::to_string(cfg.port)},
+        {"config", {{"qps", cfg.qps}, {"duration_s", cfg.durationSec}, {"warmup_s", cfg.warmupSec}, {"connections", cfg.connections}, {"seed", cfg.seed}, {"mix", mix}}},
+        {"requests", all.size()},
+        {"errors", errors},
+        {"throughput_rps", elapsed > 0 ? all.size() / elapsed : 0.0},
+        {"latency_us", latencySummary(all)},
+        {"ops", ops},
+    };
+    return report.dump(2);
+}
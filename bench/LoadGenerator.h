@@ -0,0 +1,45 @@
+#pragma once
+// HTTP 负载生成器：按固定 QPS（开环）向服务器回放可配置的操作组合，
+// 统计吞吐与 p50 / p99 / p999 延迟并以 JSON 输出，便于跨版本跟踪性能回归。
+// 延迟以“计划发送时刻”为起点计算，避免协调遗漏（coordinated omission）掩盖排队延迟
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 可回放的操作类型
+enum class LoadOp { Login, Devices, Reserve, Borrow, Return, Extend, Apply, Approve, Count };
+
+constexpr size_t kLoadOpCount = static_cast<size_t>(LoadOp::Count);
+
+const char *loadOpName(LoadOp op);
+
+struct LoadConfig {
+    std::string host{"127.0.0.1"};
+    int port{8080};
+    double qps{200.0};          // 目标请求速率（每秒）
+    double durationSec{10.0};   // 计入统计的压测时长
+    double warmupSec{1.0};      // 预热时长（不计入统计）
+    int connections{8};         // 并发连接（工作线程）数
+    std::uint64_t seed{42};     // 随机种子：相同配置与种子产生相同的操作序列
+    // 各操作的权重，默认以读为主
+    std::array<int, kLoadOpCount> weights{{5, 50, 15, 10, 8, 5, 4, 3}};
+    // 压测使用的账号（用户名, 密码）；管理员账号用于审批申请
+    std::vector<std::pair<std::string, std::string>> accounts{{"student1", "123456"}, {"teacher1", "123456"}};
+    std::pair<std::string, std::string> admin{"admin1", "123456"};
+};
+
+// 解析形如 "login=5,devices=50,reserve=15" 的操作权重；未出现的操作权重置 0
+bool parseLoadMix(const std::string &spec, LoadConfig &cfg);
+
+// 解析通用命令行参数（--qps / --duration / --warmup / --connections / --mix / --seed）；
+// 识别并消费了 argv[i]（及其取值）时返回 true
+bool parseLoadFlag(int argc, char **argv, int &i, LoadConfig &cfg);
+
+// 通用参数的帮助文本
+const char *loadFlagsUsage();
+
+// 执行压测并返回 JSON 格式的报告；准备阶段（登录、获取设备列表）失败时返回空字符串
+std::string runLoad(const LoadConfig &cfg);
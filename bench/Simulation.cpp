@@ -0,0 +1,344 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "ApiJson.h"
+#include "Clock.h"
+#include "LabManager.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr std::time_t kHour = 3600;
+constexpr std::time_t kDay = 24 * kHour;
+// 仿真起点：2024-09-02 00:00 UTC（周一），固定起点保证结果可重复
+constexpr std::time_t kSemesterStart = 1725235200;
+
+// 计入统计的业务操作
+enum class SimOp { Browse, Reserve, Apply, Approve, Borrow, Extend, Return, Maintain, Poll, Count };
+constexpr size_t kSimOpCount = static_cast<size_t>(SimOp::Count);
+const char *kOpNames[kSimOpCount] = {"browse", "reserve", "apply", "approve", "borrow", "extend", "return", "maintain", "poll"};
+
+enum class EventType { Arrival, Borrow, Extend, Return, Poll, DailyAdmin };
+
+struct Event {
+    std::time_t at;
+    std::uint64_t seq;   // 同一时刻的事件按产生顺序执行
+    EventType type;
+    int user;            // users_ 下标
+    int deviceId;
+    std::time_t start;
+    std::time_t end;
+
+    bool operator>(const Event &o) const { return at != o.at ? at > o.at : seq > o.seq; }
+};
+
+struct OpStats {
+    std::vector<std::uint32_t> ns;
+    std::uint64_t ok{0};
+};
+
+class Simulator {
+public:
+    explicit Simulator(const SimConfig &cfg) : cfg_(cfg), rng_(cfg.seed), clock_(std::make_shared<ManualClock>(kSemesterStart)) {
+        mgr_.clock = clock_;
+        // 仿真不走登录流程，口令哈希取最低开销，数千个账号的建号时间可以忽略
+        mgr_.passwordParams = ScryptParams{1, 1, 1};
+        mgr_.seed();
+        static const DeviceType types[] = {DeviceType::Consumable, DeviceType::Precision, DeviceType::Power};
+        for (int i = 0; i < cfg_.devices; ++i) {
+            mgr_.addDevice(types[i % 3], "sim-device-" + std::to_string(i), i % 4 != 0);
+        }
+        for (int i = 0; i < cfg_.students + cfg_.teachers; ++i) {
+            bool teacher = i >= cfg_.students;
+            int id = mgr_.addUser(teacher ? UserType::Teacher : UserType::Student, "sim-user-" + std::to_string(i), "123456");
+            if (id > 0) { users_.push_back(id); isTeacher_.push_back(teacher); }
+        }
+        for (const auto &slot : mgr_.devicesById) devices_.push_back(slot.id);
+        std::sort(devices_.begin(), devices_.end());
+        endAt_ = kSemesterStart + cfg_.days * kDay;
+        hourly_.assign(static_cast<size_t>(cfg_.days) * 24, 0);
+    }
+
+    std::string run() {
+        openSecondsPerWeek_ = 7.0 * (cfg_.closeHour - cfg_.openHour) * kHour;
+        for (size_t u = 0; u < users_.size(); ++u) {
+            schedule(EventType::Arrival, nextArrival(kSemesterStart), static_cast<int>(u));
+            if (cfg_.pollsPerUserDay > 0) schedule(EventType::Poll, nextPoll(kSemesterStart), static_cast<int>(u));
+        }
+        for (int d = 0; d < cfg_.days; ++d) schedule(EventType::DailyAdmin, kSemesterStart + d * kDay + 7 * kHour, -1);
+
+        auto wallStart = std::chrono::steady_clock::now();
+        std::uint64_t events = 0;
+        while (!queue_.empty()) {
+            Event e = queue_.top();
+            queue_.pop();
+            if (e.at >= endAt_) continue;
+            clock_->set(e.at);
+            ++events;
+            dispatch(e);
+        }
+        double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        return report(events, wallSec);
+    }
+
+private:
+    const SimConfig &cfg_;
+    LabManager mgr_;
+    std::mt19937_64 rng_;
+    std::shared_ptr<ManualClock> clock_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue_;
+    std::uint64_t seq_{0};
+    std::time_t endAt_{0};
+    double openSecondsPerWeek_{0};
+    std::vector<int> users_;
+    std::vector<bool> isTeacher_;
+    std::vector<int> devices_;
+    std::array<OpStats, kSimOpCount> stats_;
+    std::vector<std::uint32_t> hourly_;   // 每个仿真小时内执行的操作数
+
+    void schedule(EventType type, std::time_t at, int user, int deviceId = 0, std::time_t start = 0, std::time_t end = 0) {
+        if (at >= endAt_) return;
+        queue_.push(Event{at, seq_++, type, user, deviceId, start, end});
+    }
+
+    // 计时执行一次业务操作，同时计入所在仿真小时的操作量
+    bool timed(SimOp op, const std::function<bool()> &fn) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = fn();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        OpStats &s = stats_[static_cast<size_t>(op)];
+        s.ns.push_back(static_cast<std::uint32_t>(std::min<long long>(ns, UINT32_MAX)));
+        if (ok) ++s.ok;
+        size_t hour = static_cast<size_t>((clock_->now() - kSemesterStart) / kHour);
+        if (hour < hourly_.size()) ++hourly_[hour];
+        return ok;
+    }
+
+    bool chance(double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < p; }
+    int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng_); }
+
+    // 在开放时段内累加 seconds 秒，闭馆时段不计
+    std::time_t addOpenSeconds(std::time_t t, double seconds) const {
+        for (;;) {
+            std::time_t day = t - (t - kSemesterStart) % kDay;
+            std::time_t open = day + cfg_.openHour * kHour;
+            std::time_t close = day + cfg_.closeHour * kHour;
+            if (t < open) t = open;
+            if (t >= close) { t = open + kDay; continue; }
+            double remain = static_cast<double>(close - t);
+            if (seconds < remain) return t + static_cast<std::time_t>(seconds);
+            seconds -= remain;
+            t = open + kDay;
+        }
+    }
+
+    std::time_t nextArrival(std::time_t from) {
+        double rate = cfg_.reservationsPerUserWeek / openSecondsPerWeek_;
+        if (rate <= 0) return endAt_;
+        return addOpenSeconds(from, std::exponential_distribution<double>(rate)(rng_)) + 1;
+    }
+
+    std::time_t nextPoll(std::time_t from) {
+        double rate = cfg_.pollsPerUserDay / ((cfg_.closeHour - cfg_.openHour) * kHour);
+        return addOpenSeconds(from, std::exponential_distribution<double>(rate)(rng_)) + 1;
+    }
+
+    // 选择预约时段：三成为“马上用”（下一个整点开始），其余提前 1-7 天；时长 1-4 小时，落在开放时段内
+    void pickSlot(std::time_t now, std::time_t &start, std::time_t &end) {
+        std::time_t hours = uniform(1, 4);
+        std::time_t day = now - (now - kSemesterStart) % kDay;
+        if (chance(0.3)) {
+            start = now - (now - kSemesterStart) % kHour + kHour;
+            if (start + hours * kHour > day + cfg_.closeHour * kHour) start = day + kDay + cfg_.openHour * kHour;
+        } else {
+            int latest = std::max(cfg_.openHour, cfg_.closeHour - static_cast<int>(hours));
+            start = day + uniform(1, 7) * kDay + uniform(cfg_.openHour, latest) * kHour;
+        }
+        end = start + hours * kHour;
+    }
+
+    void dispatch(const Event &e) {
+        switch (e.type) {
+            case EventType::Arrival:    onArrival(e); break;
+            case EventType::Borrow:     onBorrow(e); break;
+            case EventType::Extend:     onExtend(e); break;
+            case EventType::Return:     timed(SimOp::Return, [&] { return mgr_.returnDevice(users_[static_cast<size_t>(e.user)], e.deviceId, e.at); }); break;
+            case EventType::Poll:       onPoll(e); break;
+            case EventType::DailyAdmin: onDailyAdmin(e); break;
+        }
+    }
+
+    // 用户发起一次预约：先浏览若干次设备列表，再选设备与时段；学生遇到受限设备时按比例改为提交申请
+    void onArrival(const Event &e) {
+        size_t u = static_cast<size_t>(e.user);
+        int userId = users_[u];
+        int browses = std::poisson_distribution<int>(cfg_.browsePerReservation)(rng_);
+        for (int i = 0; i < browses; ++i) {
+            timed(SimOp::Browse, [&] {
+                std::string &buf = JsonWriter::threadBuffer();
+                writeDevicesResponse(buf, mgr_, e.at);
+                return true;
+            });
+        }
+        int deviceId = devices_[static_cast<size_t>(uniform(0, static_cast<int>(devices_.size()) - 1))];
+        std::time_t start, end;
+        pickSlot(e.at, start, end);
+        const Device *dev = mgr_.devicesById.get(deviceId);
+        if (!isTeacher_[u] && !dev->allowStudentReserve) {
+            if (chance(cfg_.applyRate)) {
+                timed(SimOp::Apply, [&] { return mgr_.apply(userId, deviceId, start, end, "课程实验") > 0; });
+            }
+        } else if (timed(SimOp::Reserve, [&] { return mgr_.reserve(userId, deviceId, start, end); })) {
+            if (chance(cfg_.showUpRate)) schedule(EventType::Borrow, start, e.user, deviceId, start, end);
+        }
+        schedule(EventType::Arrival, nextArrival(e.at), e.user);
+    }
+
+    void onBorrow(const Event &e) {
+        int userId = users_[static_cast<size_t>(e.user)];
+        if (!timed(SimOp::Borrow, [&] { return mgr_.borrow(userId, e.deviceId, e.at); })) return;
+        if (chance(cfg_.extendRate)) {
+            schedule(EventType::Extend, e.end - 10 * 60, e.user, e.deviceId, e.start, e.end);
+        } else {
+            scheduleReturn(e.user, e.deviceId, e.start, e.end);
+        }
+    }
+
+    void onExtend(const Event &e) {
+        int userId = users_[static_cast<size_t>(e.user)];
+        std::time_t newEnd = e.end + kHour;
+        bool ok = timed(SimOp::Extend, [&] { return mgr_.extend(userId, e.deviceId, newEnd); });
+        scheduleReturn(e.user, e.deviceId, e.start, ok ? newEnd : e.end);
+    }
+
+    void scheduleReturn(int user, int deviceId, std::time_t start, std::time_t end) {
+        std::time_t at = chance(cfg_.lateReturnRate) ? end + uniform(10, 180) * 60 : end - uniform(0, 15) * 60;
+        schedule(EventType::Return, std::max(at, start + 60), user, deviceId, start, end);
+    }
+
+    void onPoll(const Event &e) {
+        int userId = users_[static_cast<size_t>(e.user)];
+        timed(SimOp::Poll, [&] { return !mgr_.popNotifications(userId).empty(); });
+        schedule(EventType::Poll, nextPoll(e.at), e.user);
+    }
+
+    // 每日 07:00：管理员审批全部待审申请（成功的申请与普通预约一样安排借用），并维护健康度过低的设备
+    void onDailyAdmin(const Event &e) {
+        std::vector<LabManager::Application> pending = mgr_.applications;
+        for (const auto &a : pending) {
+            if (!timed(SimOp::Approve, [&] { return mgr_.approveApplication(a.id); })) continue;
+            auto it = std::find(users_.begin(), users_.end(), a.userId);
+            if (it != users_.end() && chance(cfg_.showUpRate)) {
+                schedule(EventType::Borrow, std::max(a.start, e.at), static_cast<int>(it - users_.begin()), a.deviceId, a.start, a.end);
+            }
+        }
+        for (int id : devices_) {
+            const Device *dev = mgr_.devicesById.get(id);
+            if (!dev || dev->health >= 30) continue;
+            timed(SimOp::Maintain, [&] { return mgr_.maintainDevice(id); });
+        }
+    }
+
+    static json summary(std::vector<std::uint32_t> &v) {
+        if (v.empty()) return json::object();
+        std::sort(v.begin(), v.end());
+        auto pct = [&](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))]; };
+        double sum = 0;
+        for (auto x : v) sum += x;
+        return {{"p50_ns", pct(0.50)}, {"p99_ns", pct(0.99)}, {"max_ns", v.back()}, {"mean_ns", sum / v.size()}};
+    }
+
+    std::string report(std::uint64_t events, double wallSec) {
+        json ops = json::object();
+        double busyNs = 0;
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < kSimOpCount; ++i) {
+            OpStats &s = stats_[i];
+            if (s.ns.empty()) continue;
+            for (auto x : s.ns) busyNs += x;
+            total += s.ns.size();
+            json o = summary(s.ns);
+            o["count"] = s.ns.size();
+            o["ok"] = s.ok;
+            ops[kOpNames[i]] = o;
+        }
+
+        // 峰值小时：仿真时间内操作最多的一小时；余量 = 单线程实测吞吐 / 峰值小时的平均每秒操作数
+        size_t peak = static_cast<size_t>(std::max_element(hourly_.begin(), hourly_.end()) - hourly_.begin());
+        double peakRate = hourly_.empty() ? 0.0 : hourly_[peak] / 3600.0;
+        double throughput = busyNs > 0 ? total / (busyNs / 1e9) : 0.0;
+
+        size_t reservations = 0, maxPerDevice = 0, broken = 0;
+        for (const auto &slot : mgr_.devicesById) {
+            reservations += slot.value->reservations.size();
+            maxPerDevice = std::max(maxPerDevice, slot.value->reservations.size());
+            if (slot.value->health <= 0) ++broken;
+        }
+        double creditSum = 0;
+        for (const auto &slot : mgr_.usersById) creditSum += slot.value->creditScore;
+
+        json out{
+            {"config", {{"students", cfg_.students}, {"teachers", cfg_.teachers}, {"devices", cfg_.devices}, {"days", cfg_.days},
+                        {"reservations_per_user_week", cfg_.reservationsPerUserWeek}, {"browse_per_reservation", cfg_.browsePerReservation}, {"seed", cfg_.seed}}},
+            {"events", events},
+            {"operations", total},
+            {"wall_s", wallSec},
+            {"simulated_s", static_cast<long long>(cfg_.days) * kDay},
+            {"speedup", wallSec > 0 ? cfg_.days * kDay / wallSec : 0.0},
+            {"busy_s", busyNs / 1e9},
+            {"throughput_ops_per_s", throughput},
+            {"peak_hour", {{"day", peak / 24}, {"hour", peak % 24}, {"ops", hourly_.empty() ? 0 : hourly_[peak]}, {"ops_per_s", peakRate}}},
+            {"headroom", peakRate > 0 ? throughput / peakRate : 0.0},
+            {"ops", ops},
+            {"final_state", {{"reservations", reservations}, {"max_reservations_per_device", maxPerDevice}, {"pending_applications", mgr_.applications.size()},
+                             {"pending_notifications", mgr_.notifications.size()}, {"broken_devices", broken},
+                             {"mean_credit", mgr_.usersById.empty() ? 0.0 : creditSum / mgr_.usersById.size()}}},
+        };
+        return out.dump(2);
+    }
+};
+
+} // namespace
+
+bool parseSimFlag(int argc, char **argv, int &i, SimConfig &cfg) {
+    if (i + 1 >= argc) return false;
+    const char *flag = argv[i];
+    const char *value = argv[i + 1];
+    if (std::strcmp(flag, "--students") == 0) cfg.students = std::max(0, std::atoi(value));
+    else if (std::strcmp(flag, "--teachers") == 0) cfg.teachers = std::max(0, std::atoi(value));
+    else if (std::strcmp(flag, "--devices") == 0) cfg.devices = std::max(0, std::atoi(value));
+    else if (std::strcmp(flag, "--days") == 0) cfg.days = std::max(1, std::atoi(value));
+    else if (std::strcmp(flag, "--rate") == 0) cfg.reservationsPerUserWeek = std::atof(value);
+    else if (std::strcmp(flag, "--browse") == 0) cfg.browsePerReservation = std::atof(value);
+    else if (std::strcmp(flag, "--polls") == 0) cfg.pollsPerUserDay = std::atof(value);
+    else if (std::strcmp(flag, "--seed") == 0) cfg.seed = std::strtoull(value, nullptr, 10);
+    else return false;
+    ++i;
+    return true;
+}
+
+const char *simFlagsUsage() {
+    return "  --students N   学生数（默认 2000）\n"
+           "  --teachers N   教师数（默认 200）\n"
+           "  --devices N    设备数（默认 300，另含 10 台演示设备）\n"
+           "  --days N       仿真天数（默认 112，即一学期）\n"
+           "  --rate X       每个用户每周发起预约的平均次数（默认 2）\n"
+           "  --browse X     每次预约前浏览设备列表的平均次数（默认 1）\n"
+           "  --polls X      每个用户每天拉取通知的平均次数（默认 1）\n"
+           "  --seed N       随机种子（默认 42）\n";
+}
+
+std::string runSimulation(const SimConfig &cfg) {
+    Simulator sim(cfg);
+    return sim.run();
+}
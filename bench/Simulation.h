@@ -0,0 +1,36 @@
+#pragma once
+// 离散事件仿真：用 ManualClock 替换 LabManager 的时钟，按仿真时间顺序生成并执行合成负载
+// （浏览设备列表、预约、借用、延长、归还、申请与审批、维护、拉取通知），
+// 在几秒的墙钟时间内跑完一整个学期，用于容量规划：
+// 报告业务层每类操作的耗时分布、峰值小时的操作量，以及按实测吞吐折算的峰值负载余量。
+// 相同配置与种子产生完全相同的事件序列与最终状态
+
+#include <cstdint>
+#include <string>
+
+struct SimConfig {
+    int students{2000};
+    int teachers{200};
+    int devices{300};
+    int days{112};                       // 仿真天数（默认一学期 16 周）
+    double reservationsPerUserWeek{2.0}; // 每个用户每周发起预约的平均次数（泊松到达）
+    double browsePerReservation{1.0};    // 每次预约前浏览设备列表的平均次数
+    double showUpRate{0.85};             // 按时借用的比例，其余为爽约（预约记录遗留）
+    double lateReturnRate{0.1};          // 逾期归还的比例
+    double extendRate{0.1};              // 使用中申请延长的比例
+    double applyRate{0.3};               // 学生遇到受限设备时改为提交申请的比例
+    double pollsPerUserDay{1.0};         // 每个用户每天拉取通知的平均次数
+    int openHour{8};                     // 开放时段（UTC 小时），预约请求只在此时段内到达
+    int closeHour{22};
+    std::uint64_t seed{42};
+};
+
+// 解析命令行参数（--students / --teachers / --devices / --days / --rate / --browse / --seed）；
+// 识别并消费了 argv[i]（及其取值）时返回 true
+bool parseSimFlag(int argc, char **argv, int &i, SimConfig &cfg);
+
+// 参数帮助文本
+const char *simFlagsUsage();
+
+// 执行仿真并返回 JSON 格式的报告
+std::string runSimulation(const SimConfig &cfg);
@@ -0,0 +1,82 @@
+// 响应压缩基准：不同设备规模下 /api/devices 与 /api/admin/applications 响应体的
+// 压缩前后字节数与每次压缩的 CPU 耗时，用于选择压缩阈值与级别
+//
+// 构建：cmake -S . -B build && cmake --build build --target bench_compression（找到 zlib 时才有该目标）
+// 运行：./build/bench_compression
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "ApiJson.h"
+#include "Compression.h"
+#include "LabManager.h"
+
+namespace {
+
+// 构造规模为 devices 的设备目录，每台设备带 perDevice 条预约，外加同等数量的待审批申请
+void populate(LabManager &mgr, int devices, int perDevice, std::time_t now) {
+    static const char *names[] = {"3D打印机", "电子显微镜", "离心机", "GPU 集群", "示波器", "光谱仪"};
+    for (int i = 0; i < devices; ++i) {
+        std::string name = std::string(names[i % 6]) + " " + std::to_string(i);
+        int id = mgr.addDevice(static_cast<DeviceType>(i % 3), name, i % 2 == 0);
+        Device *dev = mgr.devicesById.get(id);
+        for (int k = 0; k < perDevice; ++k) {
+            Reservation r;
+            r.userId = 1 + (i + k) % 3;
+            r.startTime = now + k * 3600;
+            r.endTime = r.startTime + 1800;
+            r.borrowed = k == 0 && i % 4 == 0;
+            dev->reservations.push_back(r);
+        }
+        mgr.apply(1, id, now, now + 3600, "课程实验需要");
+    }
+}
+
+struct Result {
+    size_t raw{0};
+    size_t packed{0};
+    double usPerOp{0};
+};
+
+Result measure(const std::string &body, ContentCoding coding, int level) {
+    Result r;
+    r.raw = body.size();
+    std::string out;
+    compressWithThreadState(coding, level, body.data(), body.size(), out); // 预热线程状态
+    r.packed = out.size();
+    int iters = body.size() > (1u << 20) ? 20 : 200;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) compressWithThreadState(coding, level, body.data(), body.size(), out);
+    auto t1 = std::chrono::steady_clock::now();
+    r.usPerOp = std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+    return r;
+}
+
+} // namespace
+
+int main() {
+    if (!compressionAvailable()) {
+        std::fprintf(stderr, "built without LAB_WITH_ZLIB, nothing to measure\n");
+        return 1;
+    }
+    std::time_t now = std::time(nullptr);
+    const int sizes[] = {10, 100, 1000, 10000};
+    const int levels[] = {1, 6, 9};
+
+    std::printf("%-14s %8s %6s %12s %12s %8s %10s %10s\n", "payload", "devices", "level", "raw_bytes", "wire_bytes", "ratio", "us/op", "MB/s");
+    for (int n : sizes) {
+        LabManager mgr;
+        populate(mgr, n, 4, now);
+        std::string devices = nlohmann::json({{"ok", true}, {"devices", devicesJson(mgr, now)}}).dump();
+        std::string apps = nlohmann::json({{"ok", true}, {"applications", applicationsJson(mgr)}}).dump();
+        for (const auto &payload : {std::make_pair("devices", &devices), std::make_pair("applications", &apps)}) {
+            for (int level : levels) {
+                Result r = measure(*payload.second, ContentCoding::Gzip, level);
+                double mbps = r.raw / r.usPerOp; // 字节/微秒 == MB/s
+                std::printf("%-14s %8d %6d %12zu %12zu %7.1f%% %10.1f %10.1f\n", payload.first, n, level, r.raw, r.packed,
+                            100.0 * r.packed / r.raw, r.usPerOp, mbps);
+            }
+        }
+    }
+    return 0;
+}
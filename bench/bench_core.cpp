@@ -0,0 +1,373 @@
+// LabManager 核心操作的微基准（Google Benchmark）：预约、归还、延长、通知弹出、申请审批、
+// 设备状态计算与设备列表序列化。不启动服务器，直接调用业务层，用于评估数据结构改动前后的差异
+//
+// 构建：cmake -S . -B build && cmake --build build --target bench_core（需安装 Google Benchmark）
+// 运行：./build/bench_core --benchmark_filter=Reserve
+//
+// 夹具经 reserve / borrow 等业务接口建立（预约表、用户预约索引与定时器一致）。各基准在计时循环内把状态恢复原样：
+// 预约表、用户预约索引与通知逐次恢复（如弹出 reserve 刚追加的预约及其索引条目），reserve / extend 排下的定时器
+// 每批清空一次（基准不推进时间轮）。恢复操作均为 O(1)、均摊 O(1) 或与被测操作同阶，
+// 避免 PauseTiming 本身的开销淹没亚微秒级的被测操作
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "ApiJson.h"
+#include "LabManager.h"
+
+namespace {
+
+constexpr std::time_t kHour = 3600;
+
+// 基准夹具：seed 后的管理器 + 一台学生可预约的设备，设备上有 n 条互不重叠的一小时预约
+// （从明天开始，每隔两小时一条），预约者为 student1。建立夹具时排下的定时器清空，计时循环只看到自己排下的
+struct Fixture {
+    LabManager mgr;
+    int studentId{0};
+    int teacherId{0};
+    int deviceId{0};
+    std::time_t base{0};
+
+    explicit Fixture(int reservations) {
+        mgr.seed();
+        studentId = *mgr.authenticate("student1", "123456");
+        teacherId = *mgr.authenticate("teacher1", "123456");
+        deviceId = mgr.addDevice(DeviceType::Precision, "bench", true);
+        base = std::time(nullptr) + 24 * kHour;
+        device().reservations.reserve(static_cast<size_t>(reservations) + 1);
+        for (int i = 0; i < reservations; ++i) {
+            std::time_t start = base + 2 * kHour * i;
+            if (!mgr.reserve(studentId, deviceId, start, start + kHour)) std::abort();
+        }
+        resetTimers();
+    }
+
+    Device &device() { return *mgr.devicesById.get(deviceId); }
+    // 撤销 userId 刚成功的 reserve（未抢占他人）：预约与用户索引条目都追加在末尾，原样弹出
+    void undoReserve(int userId) {
+        device().reservations.pop_back();
+        auto it = mgr.reservationsByUser.find(userId);
+        it->second.pop_back();
+        if (it->second.empty()) mgr.reservationsByUser.erase(it);
+    }
+    // 清空 reserve / extend 排下的预约定时器
+    void resetTimers() { mgr.timers.reset(mgr.timers.now()); }
+    // 第 i 条既有预约之后的空闲时段起点
+    std::time_t gapAfter(int i) const { return base + 2 * kHour * i + kHour; }
+};
+
+// reserve：参数为 (每台设备的既有预约数, 冲突比例%)。
+// 请求轮流落在既有预约上（被拒绝）或其后的空闲时段（成功，随后移除），冲突比例决定两者之比
+void BM_Reserve(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    const int overlapPct = static_cast<int>(state.range(1));
+    Fixture f(n);
+
+    // 预先生成 100 个请求时段，分散在整个预约表中
+    struct Probe { std::time_t start; bool overlaps; };
+    std::vector<Probe> probes;
+    for (int k = 0; k < 100; ++k) {
+        int slot = n > 0 ? (k * 37) % n : 0;
+        bool overlaps = n > 0 && k < overlapPct;
+        std::time_t start = overlaps ? f.base + 2 * kHour * slot + kHour / 2 : (n > 0 ? f.gapAfter(slot) : f.base);
+        probes.push_back(Probe{start, overlaps});
+    }
+
+    size_t k = 0;
+    for (auto _ : state) {
+        const Probe &p = probes[k];
+        bool ok = f.mgr.reserve(f.studentId, f.deviceId, p.start, p.start + kHour / 2);
+        benchmark::DoNotOptimize(ok);
+        if (ok) f.undoReserve(f.studentId);
+        if (++k == probes.size()) {
+            k = 0;
+            f.resetTimers();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Reserve)->ArgsProduct({{1, 16, 256, 4096}, {0, 50, 100}});
+
+// reserve（教师抢占）：新预约覆盖 m 条学生预约，策略移除全部冲突并逐一发送通知；
+// 计时包含把被移除的预约、用户预约索引与产生的通知恢复原样（与被测操作同为 O(n)）
+void BM_ReservePreempt(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    const int m = static_cast<int>(state.range(1));
+    Fixture f(n);
+    auto &list = f.device().reservations;
+    const std::vector<Reservation> original = list;
+    const auto originalIndex = f.mgr.reservationsByUser;
+    std::time_t start = f.base + 2 * kHour * (n / 2 - m / 2);
+    std::time_t end = start + 2 * kHour * m - kHour;
+
+    for (auto _ : state) {
+        bool ok = f.mgr.reserve(f.teacherId, f.deviceId, start, end);
+        benchmark::DoNotOptimize(ok);
+        list = original;
+        f.mgr.reservationsByUser = originalIndex;
+        f.mgr.notifications.clear();
+        f.resetTimers();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReservePreempt)->ArgsProduct({{256, 4096}, {1, 16}});
+
+// returnDevice：n 条预约中最后一条处于借用状态（最坏的查找位置），归还后重新放回
+void BM_ReturnDevice(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    Fixture f(n);
+    auto &dev = f.device();
+    std::time_t now = std::time(nullptr);
+    if (!f.mgr.reserve(f.teacherId, f.deviceId, now, now + kHour) || !f.mgr.borrow(f.teacherId, f.deviceId, now)) std::abort();
+    f.resetTimers();
+    const Reservation borrowed = dev.reservations.back();
+
+    for (auto _ : state) {
+        bool ok = f.mgr.returnDevice(f.teacherId, f.deviceId, now + 60);
+        benchmark::DoNotOptimize(ok);
+        dev.reservations.push_back(borrowed);
+        f.mgr.indexReservation(f.teacherId, f.deviceId, borrowed.startTime);
+        dev.health = 100;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReturnDevice)->RangeMultiplier(8)->Range(1, 4096);
+
+// extend：教师的预约位于表尾（最晚），每次延长一分钟，需要与其余 n 条逐一做冲突检查
+void BM_Extend(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    Fixture f(n);
+    auto &dev = f.device();
+    std::time_t start = f.base + 2 * kHour * n;
+    if (!f.mgr.reserve(f.teacherId, f.deviceId, start, start + kHour)) std::abort();
+    f.resetTimers();
+    Reservation &r = dev.reservations.back();
+
+    unsigned batch = 0;
+    for (auto _ : state) {
+        bool ok = f.mgr.extend(f.teacherId, f.deviceId, r.endTime + 60);
+        benchmark::DoNotOptimize(ok);
+        if (++batch % 1024 == 0) f.resetTimers();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Extend)->RangeMultiplier(8)->Range(1, 4096);
+
+// popNotifications：积压 backlog 条通知，平均分布在 64 个用户上；弹出一个用户的通知后原样补回
+void BM_PopNotifications(benchmark::State &state) {
+    const int backlog = static_cast<int>(state.range(0));
+    constexpr int kUsers = 64;
+    LabManager mgr;
+    mgr.notifications.reserve(static_cast<size_t>(backlog));
+    for (int i = 0; i < backlog; ++i) {
+        mgr.notifications.push_back(LabManager::Notification{mgr.nextNotificationId++, 1 + i % kUsers, "您的预约已被教师优先占用，该设备对您暂不可用", 0});
+    }
+
+    int user = 1;
+    for (auto _ : state) {
+        auto out = mgr.popNotifications(user);
+        benchmark::DoNotOptimize(out.data());
+        mgr.notifications.insert(mgr.notifications.end(), out.begin(), out.end());
+        user = user % kUsers + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PopNotifications)->RangeMultiplier(10)->Range(10, 1000000);
+
+// approveApplication：队列中有 queue 条待审批申请，审批最新提交的一条（线性查找的最坏位置），
+// 随后撤销生成的预约并重新提交同一申请，保持队列长度不变
+void BM_ApproveApplication(benchmark::State &state) {
+    const int queue = static_cast<int>(state.range(0));
+    Fixture f(0);
+    for (int i = 0; i < queue; ++i) {
+        f.mgr.apply(f.studentId, f.deviceId, f.base + i * kHour, f.base + i * kHour + 60, "bench");
+    }
+
+    unsigned batch = 0;
+    for (auto _ : state) {
+        const auto a = f.mgr.applications.back();
+        bool ok = f.mgr.approveApplication(a.id);
+        benchmark::DoNotOptimize(ok);
+        f.undoReserve(a.userId);
+        f.mgr.apply(a.userId, a.deviceId, a.start, a.end, a.reason);
+        if (++batch % 1024 == 0) f.resetTimers();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ApproveApplication)->RangeMultiplier(10)->Range(10, 100000);
+
+// Device::getDynamicStatus：设备上 n 条预约，查询时刻不落在任何预约内（需扫描全表）
+void BM_GetDynamicStatus(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    Fixture f(n);
+    const Device &dev = f.device();
+    std::time_t now = std::time(nullptr);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dev.getDynamicStatus(now));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetDynamicStatus)->RangeMultiplier(8)->Range(1, 4096);
+
+// 共享锁下的用户查找：模拟多个处理线程持 mgr.mutex 共享锁做权限检查（requireAdmin 读取用户类型），
+// 所有线程访问同一用户对象（getUser 返回裸指针，查找本身不写共享内存，只剩共享锁的原子操作）
+void BM_GetUserShared(benchmark::State &state) {
+    static LabManager *mgr = [] {
+        auto *m = new LabManager;
+        m->passwordParams = ScryptParams{1, 1, 1};
+        m->seed();
+        return m;
+    }();
+    const int adminId = mgr->findUser("admin1")->id;
+    for (auto _ : state) {
+        std::shared_lock<std::shared_mutex> lk(mgr->mutex);
+        const User *u = mgr->getUser(adminId);
+        benchmark::DoNotOptimize(u->type == UserType::Admin);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetUserShared)->ThreadRange(1, 8)->UseRealTime();
+
+// n 个用户、n 台设备直接批量入库（不计算口令哈希）；删除约八分之一的设备，模拟有空洞的ID空间
+void populateBulk(LabManager &mgr, int n) {
+    std::vector<std::shared_ptr<User>> users;
+    std::vector<std::shared_ptr<Device>> devices;
+    for (int i = 0; i < n; ++i) {
+        auto u = LabManager::makeUser(UserType::Student);
+        u->username = mgr.strings.store("bulk-" + std::to_string(i));
+        users.push_back(u);
+        devices.push_back(LabManager::makeDevice(static_cast<DeviceType>(i % 3)));
+    }
+    mgr.insertBulk(users, devices);
+    for (int id = 1; id <= n; id += 8) mgr.deleteDevice(id);
+}
+
+// 按ID查找：请求中的ID以大步长跳跃，避免连续访问掩盖查找结构的缓存行为
+void BM_UserLookup(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    LabManager mgr;
+    populateBulk(mgr, n);
+    int id = 1;
+    for (auto _ : state) {
+        const User *u = mgr.getUser(id);
+        benchmark::DoNotOptimize(u ? u->creditScore : 0);
+        id += 7919;
+        if (id > n) id -= n;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UserLookup)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+void BM_DeviceLookup(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    LabManager mgr;
+    populateBulk(mgr, n);
+    int id = 1;
+    for (auto _ : state) {
+        const Device *d = mgr.peekDevice(id);
+        benchmark::DoNotOptimize(d ? d->health : 0);
+        id += 7919;
+        if (id > n) id -= n;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeviceLookup)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+// 全量遍历（设备列表、仿真统计等）：累加全部设备的健康度
+void BM_DeviceIterate(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    LabManager mgr;
+    populateBulk(mgr, n);
+    for (auto _ : state) {
+        long sum = 0;
+        mgr.forEachDevice([&](const Device &d) { sum += d.health; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(mgr.deviceCount()));
+}
+BENCHMARK(BM_DeviceIterate)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+// 登录风暴中持锁的部分：按用户名查找用户（Server 的登录处理在共享锁内只做这一步，口令校验在锁外）。
+// n 个账号，用户名形如学号；每四次查找有一次是不存在的用户名
+void BM_LoginLookup(benchmark::State &state) {
+    const int n = static_cast<int>(state.range(0));
+    LabManager mgr;
+    std::vector<std::shared_ptr<User>> users;
+    std::vector<std::shared_ptr<Device>> devices;
+    std::vector<std::string> names;
+    for (int i = 0; i < n; ++i) {
+        names.push_back("2026" + std::to_string(1000000 + i));
+        auto u = LabManager::makeUser(UserType::Student);
+        u->username = mgr.strings.store(names.back());
+        users.push_back(u);
+    }
+    mgr.insertBulk(users, devices);
+    std::vector<std::string> probes;
+    for (int i = 0; i < 4096; ++i) {
+        probes.push_back(i % 4 == 3 ? "2025" + std::to_string(1000000 + i) : names[(static_cast<size_t>(i) * 7919) % names.size()]);
+    }
+    size_t k = 0, hits = 0;
+    for (auto _ : state) {
+        hits += mgr.findUser(probes[k]) != nullptr;
+        if (++k == probes.size()) k = 0;
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoginLookup)->Arg(1000)->Arg(50000)->Arg(1000000);
+
+// 设备目录：devices 台设备，约四分之一带有一条教师的预约
+void populateDevices(LabManager &mgr, int devices) {
+    static const DeviceType types[] = {DeviceType::Consumable, DeviceType::Precision, DeviceType::Power};
+    std::vector<std::shared_ptr<User>> users{LabManager::makeUser(UserType::Teacher)};
+    std::vector<std::shared_ptr<Device>> none;
+    users[0]->username = mgr.strings.store("bench-teacher");
+    mgr.insertBulk(users, none);
+    const int teacherId = users[0]->id;
+    std::time_t base = std::time(nullptr) + 24 * kHour;
+    for (int i = 0; i < devices; ++i) {
+        int id = mgr.addDevice(types[i % 3], "设备 " + std::to_string(i), i % 2 == 0);
+        if (i % 4 == 0 && !mgr.reserve(teacherId, id, base + i, base + i + kHour)) std::abort();
+    }
+}
+
+// GET /api/devices 响应体序列化：服务器使用的流式路径
+void BM_DevicesJsonStream(benchmark::State &state) {
+    LabManager mgr;
+    populateDevices(mgr, static_cast<int>(state.range(0)));
+    std::time_t now = std::time(nullptr);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        writeDevicesResponse(out, mgr, now);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+}
+BENCHMARK(BM_DevicesJsonStream)->Arg(10)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// 同一响应体的 nlohmann DOM 参考实现，作为对照
+void BM_DevicesJsonDom(benchmark::State &state) {
+    LabManager mgr;
+    populateDevices(mgr, static_cast<int>(state.range(0)));
+    std::time_t now = std::time(nullptr);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::string out = nlohmann::json({{"ok", true}, {"devices", devicesJson(mgr, now)}}).dump();
+        bytes = out.size();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_DevicesJsonDom)->Arg(10)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
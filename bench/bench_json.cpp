@@ -0,0 +1,90 @@
+// JSON 序列化基准：对比 nlohmann::json DOM + dump() 与 JsonWriter 流式快速路径，
+// 先逐字节校验两者输出一致（不一致时返回非零），再报告各规模下的单次序列化耗时
+//
+// 构建：cmake -S . -B build && cmake --build build --target bench_json
+// 运行：./build/bench_json
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include "ApiJson.h"
+#include "LabManager.h"
+
+namespace {
+
+// 构造带磨损（产生非整数浮点）、特殊字符名称与多条预约的设备目录
+void populate(LabManager &mgr, int devices, std::time_t now) {
+    static const char *names[] = {"3D打印机", "电子显微镜", "离心机 \"X\"", "路径\\C:\\lab", "换行\n制表\t", "控制\x01\x1f字符", "emoji 🧪"};
+    for (int i = 0; i < devices; ++i) {
+        std::string name = std::string(names[i % 7]) + " " + std::to_string(i);
+        int id = mgr.addDevice(static_cast<DeviceType>(i % 3), name, i % 2 == 0);
+        Device *dev = mgr.devicesById.get(id);
+        dev->applyWearAndTear((i * 977) % 20000);
+        for (int k = 0; k < i % 5; ++k) {
+            Reservation r;
+            r.userId = 1 + (i + k) % 3;
+            r.startTime = now - 600 + k * 3600;
+            r.endTime = r.startTime + 1800;
+            r.borrowed = k == 0 && i % 4 == 0;
+            dev->reservations.push_back(r);
+        }
+        mgr.apply(1 + i % 3, id, now, now + 3600, i % 2 ? "课程\"实验\"" : "毕业设计\n急需");
+        mgr.notifications.push_back(LabManager::Notification{mgr.nextNotificationId++, 1, "您的预约已被教师优先占用", now});
+    }
+}
+
+double usPerOp(int iters, const std::function<void()> &fn) {
+    fn();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+}
+
+bool check(const char *what, int n, const std::string &dom, const std::string &fast) {
+    if (dom == fast) return true;
+    size_t i = 0;
+    while (i < dom.size() && i < fast.size() && dom[i] == fast[i]) ++i;
+    std::fprintf(stderr, "MISMATCH %s n=%d at byte %zu\n  dom : %.80s\n  fast: %.80s\n", what, n, i,
+                 dom.c_str() + (i > 20 ? i - 20 : 0), fast.c_str() + (i > 20 ? i - 20 : 0));
+    return false;
+}
+
+} // namespace
+
+int main() {
+    using nlohmann::json;
+    std::time_t now = std::time(nullptr);
+    bool ok = true;
+
+    std::printf("%-14s %8s %12s %12s %12s %8s\n", "payload", "devices", "bytes", "dom_us", "stream_us", "speedup");
+    for (int n : {10, 1000, 100000}) {
+        LabManager mgr;
+        populate(mgr, n, now);
+        int iters = n >= 100000 ? 5 : (n >= 1000 ? 200 : 20000);
+
+        std::string dom = json({{"ok", true}, {"devices", devicesJson(mgr, now)}}).dump();
+        std::string fast;
+        writeDevicesResponse(fast, mgr, now);
+        ok = check("devices", n, dom, fast) && ok;
+        double tDom = usPerOp(iters, [&] { dom = json({{"ok", true}, {"devices", devicesJson(mgr, now)}}).dump(); });
+        double tFast = usPerOp(iters, [&] { std::string &b = JsonWriter::threadBuffer(); writeDevicesResponse(b, mgr, now); });
+        std::printf("%-14s %8d %12zu %12.1f %12.1f %7.1fx\n", "devices", n, fast.size(), tDom, tFast, tDom / tFast);
+
+        dom = json({{"ok", true}, {"applications", applicationsJson(mgr)}}).dump();
+        fast.clear();
+        writeApplicationsResponse(fast, mgr);
+        ok = check("applications", n, dom, fast) && ok;
+        tDom = usPerOp(iters, [&] { dom = json({{"ok", true}, {"applications", applicationsJson(mgr)}}).dump(); });
+        tFast = usPerOp(iters, [&] { std::string &b = JsonWriter::threadBuffer(); writeApplicationsResponse(b, mgr); });
+        std::printf("%-14s %8d %12zu %12.1f %12.1f %7.1fx\n", "applications", n, fast.size(), tDom, tFast, tDom / tFast);
+
+        dom = json({{"ok", true}, {"notifications", notificationsJson(mgr.notifications)}}).dump();
+        fast.clear();
+        writeNotificationsResponse(fast, mgr.notifications);
+        ok = check("notifications", n, dom, fast) && ok;
+    }
+    std::printf(ok ? "output: byte-identical\n" : "output: MISMATCH\n");
+    return ok ? 0 : 1;
+}
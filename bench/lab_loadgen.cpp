@@ -0,0 +1,72 @@
+// 独立负载生成器：向已运行的服务器（本机或远端）施加开环负载并输出 JSON 报告
+//
+// 构建：cmake -S . -B build && cmake --build build --target lab_loadgen
+// 运行：./build/lab_loadgen --host 127.0.0.1 --port 8080 --qps 300 --duration 30
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "LoadGenerator.h"
+
+namespace {
+
+void printUsage(const char *prog) {
+    std::fprintf(stderr,
+                 "用法: %s [选项]\n"
+                 "  --host 地址       目标服务器地址（默认 127.0.0.1）\n"
+                 "  --port 端口       目标服务器端口（默认 8080）\n"
+                 "  --accounts LIST   压测账号，如 student1:123456,teacher1:123456\n"
+                 "  --admin U:P       审批申请所用的管理员账号（默认 admin1:123456）\n"
+                 "  --out FILE        报告写入文件（默认输出到 stdout）\n"
+                 "%s",
+                 prog, loadFlagsUsage());
+}
+
+// 解析 "user:pass,user:pass"
+bool parseAccounts(const std::string &spec, std::vector<std::pair<std::string, std::string>> &out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        size_t colon = item.find(':');
+        if (colon == std::string::npos || colon == 0) return false;
+        out.emplace_back(item.substr(0, colon), item.substr(colon + 1));
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    LoadConfig cfg;
+    std::string outPath;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue) cfg.host = argv[++i];
+        else if (std::strcmp(argv[i], "--port") == 0 && hasValue) cfg.port = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--accounts") == 0 && hasValue) {
+            if (!parseAccounts(argv[++i], cfg.accounts)) { printUsage(argv[0]); return 2; }
+        } else if (std::strcmp(argv[i], "--admin") == 0 && hasValue) {
+            std::vector<std::pair<std::string, std::string>> admin;
+            if (!parseAccounts(argv[++i], admin) || admin.size() != 1) { printUsage(argv[0]); return 2; }
+            cfg.admin = admin.front();
+        } else if (!parseLoadFlag(argc, argv, i, cfg)) { printUsage(argv[0]); return 2; }
+    }
+
+    std::string report = runLoad(cfg);
+    if (report.empty()) {
+        std::fprintf(stderr, "压测准备阶段失败（无法连接 %s:%d，或登录 / 获取设备列表失败）\n", cfg.host.c_str(), cfg.port);
+        return 1;
+    }
+    if (outPath.empty()) {
+        std::printf("%s\n", report.c_str());
+    } else {
+        std::ofstream(outPath) << report << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// 轨迹回放：把服务器以 --trace 记录的请求轨迹作用到全新的 LabManager（seed 后的初始状态，
+// 与线上进程启动时一致）上，时钟替换为按记录时间戳推进的 ManualClock，结果与线上逐请求一致。
+// 可按原始速度、加速或不限速回放，输出 JSON 报告：分路由的调用数、业务结果与耗时分布，
+// 以及回放结束时的状态摘要（相同轨迹多次回放的摘要应相同，可用于验证确定性）
+//
+// 构建：cmake -S . -B build && cmake --build build --target lab_replay
+// 运行：./build/lab_replay trace.bin --speed 0
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "ApiJson.h"
+#include "LabManager.h"
+#include "Replay.h"
+#include "Trace.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+using SteadyClock = std::chrono::steady_clock;
+
+namespace {
+
+void printUsage(const char *prog) {
+    std::fprintf(stderr,
+                 "用法: %s 轨迹文件 [--speed X] [--out FILE]\n"
+                 "  --speed X   回放速度倍数：1 为原始速度，10 为十倍速，0 为不限速（默认 0）\n"
+                 "  --out FILE  报告写入文件（默认输出到 stdout）\n",
+                 prog);
+}
+
+struct RouteStats {
+    std::vector<std::uint32_t> latencyNs;
+    std::array<std::uint64_t, 3> outcomes{};
+};
+
+// FNV-1a：回放结束时状态的摘要
+std::uint64_t fnv1a(std::uint64_t h, const std::string &s) {
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ULL; }
+    return h;
+}
+
+// 状态摘要：设备（含预约与磨损）、待审批申请、各用户信用分与待取通知
+std::string stateDigest(const LabManager &mgr) {
+    std::uint64_t h = 1469598103934665603ULL;
+    std::string buf;
+    writeDevicesResponse(buf, mgr, mgr.now());
+    writeApplicationsResponse(buf, mgr);
+    writeNotificationsResponse(buf, mgr.notifications);
+    std::vector<int> ids;
+    for (const auto &slot : mgr.usersById) ids.push_back(slot.id);
+    std::sort(ids.begin(), ids.end());
+    for (int id : ids) buf += std::to_string(id) + ":" + std::to_string(mgr.usersById.get(id)->creditScore) + ";";
+    h = fnv1a(h, buf);
+    char out[17];
+    std::snprintf(out, sizeof(out), "%016llx", static_cast<unsigned long long>(h));
+    return out;
+}
+
+json latencySummary(std::vector<std::uint32_t> &v) {
+    if (v.empty()) return json::object();
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))]; };
+    double sum = 0;
+    for (auto x : v) sum += x;
+    return {{"p50_ns", pct(0.50)}, {"p99_ns", pct(0.99)}, {"max_ns", v.back()}, {"total_ms", sum / 1e6}};
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string tracePath;
+    std::string outPath;
+    double speed = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--speed") == 0 && hasValue) speed = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (argv[i][0] != '-' && tracePath.empty()) tracePath = argv[i];
+        else { printUsage(argv[0]); return 2; }
+    }
+    if (tracePath.empty()) { printUsage(argv[0]); return 2; }
+
+    TraceReader reader;
+    if (!reader.open(tracePath)) {
+        std::fprintf(stderr, "无法打开轨迹文件或文件头无效: %s\n", tracePath.c_str());
+        return 1;
+    }
+
+    LabManager mgr;
+    auto clock = std::make_shared<ManualClock>(static_cast<std::time_t>(reader.startUs() / 1000000));
+    mgr.clock = clock;
+    mgr.seed();
+
+    std::array<RouteStats, kTraceRouteCount> stats;
+    TraceRecord rec;
+    std::uint64_t records = 0;
+    long long firstUs = -1;
+    long long lastUs = 0;
+    const auto wallStart = SteadyClock::now();
+    while (reader.next(rec)) {
+        if (firstUs < 0) firstUs = rec.timestampUs;
+        lastUs = rec.timestampUs;
+        if (speed > 0) {
+            auto offset = std::chrono::duration<double, std::micro>((rec.timestampUs - firstUs) / speed);
+            std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<SteadyClock::duration>(offset));
+        }
+        clock->set(static_cast<std::time_t>(rec.timestampUs / 1000000));
+
+        auto t0 = SteadyClock::now();
+        ReplayOutcome outcome = applyTraceRecord(mgr, rec);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - t0).count();
+
+        RouteStats &s = stats[static_cast<size_t>(rec.route)];
+        s.latencyNs.push_back(static_cast<std::uint32_t>(std::min<long long>(ns, UINT32_MAX)));
+        ++s.outcomes[static_cast<size_t>(outcome)];
+        ++records;
+    }
+    double wallSec = std::chrono::duration<double>(SteadyClock::now() - wallStart).count();
+
+    json routes = json::object();
+    for (size_t i = 0; i < kTraceRouteCount; ++i) {
+        RouteStats &s = stats[i];
+        if (s.latencyNs.empty()) continue;
+        json r = latencySummary(s.latencyNs);
+        r["count"] = s.latencyNs.size();
+        for (size_t k = 0; k < s.outcomes.size(); ++k) r[replayOutcomeName(static_cast<ReplayOutcome>(k))] = s.outcomes[k];
+        routes[traceRouteName(static_cast<TraceRoute>(i))] = r;
+    }
+    double tracedSec = records ? (lastUs - firstUs) / 1e6 : 0.0;
+    json report{
+        {"trace", tracePath},
+        {"records", records},
+        {"truncated", reader.corrupt()},
+        {"speed", speed},
+        {"traced_duration_s", tracedSec},
+        {"replay_duration_s", wallSec},
+        {"routes", routes},
+        {"state_digest", stateDigest(mgr)},
+    };
+
+    std::string text = report.dump(2);
+    if (outPath.empty()) std::printf("%s\n", text.c_str());
+    else std::ofstream(outPath) << text << '\n';
+    return reader.corrupt() ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+// 服务器进程入口：读取命令行与环境变量配置，初始化演示数据并启动 HTTP 服务
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Import.h"
+#include "LabManager.h"
+#include "Logger.h"
+#include "Server.h"
+#include "ShardRouter.h"
+
+namespace {
+
+ApiServer *runningServer = nullptr;
+ShardRouter *runningRouter = nullptr;
+
+// SIGINT / SIGTERM：停止监听并正常退出，使日志与轨迹文件完整落盘
+void handleSignal(int) {
+    if (runningServer) runningServer->stop();
+    if (runningRouter) runningRouter->stop();
+}
+
+void printUsage(const char *prog) {
+    std::fprintf(stderr,
+                 "用法: %s [--host 地址] [--port 端口] [--trace 文件] [--import 文件] [--catalog 文件] [--shard K/N]\n"
+                 "         [--repl-port 端口 | --replica-of 地址:端口 | --raft K --raft-peers 节点列表 --raft-dir 目录]\n"
+                 "      %s --route 分片列表 [--host 地址] [--port 端口]\n"
+                 "      %s --build-catalog 设备列表 目录文件\n"
+                 "  --host    监听地址（默认 0.0.0.0）\n"
+                 "  --port    监听端口（默认 8080）\n"
+                 "  --trace   把每个 API 请求记录到二进制轨迹文件，供 lab_replay 回放\n"
+                 "  --import  启动前批量导入用户与设备（CSV / JSON Lines，格式见 Import.h），可重复指定\n"
+                 "  --catalog 映射只读设备目录（见 DeviceCatalog.h），启动耗时与目录规模无关\n"
+                 "  --shard   以 N 个分片中的第 K 个（从 0 起）启动，只持有归属本分片的设备（不能与 --catalog 同用）\n"
+                 "  --repl-port   作为主节点在该端口提供复制日志（监听地址见 LAB_REPL_HOST，默认 127.0.0.1）\n"
+                 "  --replica-of  作为只读副本启动，持续拉取并重放主节点的复制日志（须与主节点以相同的初始数据启动）\n"
+                 "  --raft    作为共识复制组的第 K 个节点（从 0 起）启动，修改经多数节点确认后生效（见 Raft.h）\n"
+                 "  --raft-peers  全部节点的节点间通信地址 host:port,host:port,...（3 或 5 个，各节点的列表须相同）\n"
+                 "  --raft-dir    保存任期、日志与快照的数据目录（默认 raft-K）\n"
+                 "  --route   作为分片路由启动，按设备ID转发到各分片（host:port,host:port,...，顺序即分片序号）\n"
+                 "  --build-catalog  把设备列表（与 --import 同格式，只取设备行）编译为目录文件后退出\n",
+                 prog, prog, prog);
+}
+
+// 编译设备目录：按文件顺序从 1 开始分配设备ID
+int buildCatalog(const char *input, const char *output) {
+    std::ifstream in(input, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "无法读取 %s\n", input);
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ImportBatch batch = parseImport(data);
+    for (size_t i = 0; i < batch.errors.size() && i < 20; ++i) {
+        std::fprintf(stderr, "第 %zu 行：%s\n", batch.errors[i].line, batch.errors[i].message.c_str());
+    }
+    if (!batch.errors.empty()) return 1;
+    std::vector<DeviceCatalog::Entry> entries;
+    entries.reserve(batch.devices.size());
+    for (const auto &d : batch.devices) {
+        entries.push_back({static_cast<int>(entries.size()) + 1, d.type, d.allowStudent, d.name});
+    }
+    if (!DeviceCatalog::write(output, std::move(entries))) {
+        std::fprintf(stderr, "无法写入 %s\n", output);
+        return 1;
+    }
+    std::printf("%zu 台设备已写入 %s\n", batch.devices.size(), output);
+    return 0;
+}
+
+// 启动前导入：任一文件有误时整体退出，不带着半套数据启动
+bool importFile(LabManager &mgr, const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        logError("import.open_failed", {{"path", path}});
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ImportBatch batch = parseImport(data);
+    for (size_t i = 0; i < batch.errors.size() && i < 20; ++i) {
+        logError("import.invalid_line", {{"path", path}, {"line", batch.errors[i].line}, {"message", batch.errors[i].message}});
+    }
+    if (!batch.errors.empty()) return false;
+    PreparedImport prepared = prepareImport(batch, mgr.strings, mgr.passwordParams);
+    std::vector<std::string> duplicates;
+    if (!mgr.insertBulk(prepared.users, prepared.devices, &duplicates)) {
+        logError("import.duplicates", {{"path", path}, {"count", duplicates.size()}, {"first", duplicates.front()}});
+        return false;
+    }
+    logInfo("import.ok", {{"path", path}, {"users", prepared.users.size()}, {"devices", prepared.devices.size()}});
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string host = "0.0.0.0";
+    int port = 8080;
+    ServerOptions options;
+    std::vector<std::string> importPaths;
+    std::string catalogPath;
+    int shardIndex = 0, shardCount = 1;
+    std::string routeSpec;
+    int raftId = -1;
+    std::string raftPeers;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--host") == 0 && hasValue) host = argv[++i];
+        else if (std::strcmp(arg, "--port") == 0 && hasValue) port = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--trace") == 0 && hasValue) options.tracePath = argv[++i];
+        else if (std::strcmp(arg, "--import") == 0 && hasValue) importPaths.push_back(argv[++i]);
+        else if (std::strcmp(arg, "--catalog") == 0 && hasValue) catalogPath = argv[++i];
+        else if (std::strcmp(arg, "--shard") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%d/%d", &shardIndex, &shardCount) != 2 || shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if (std::strcmp(arg, "--route") == 0 && hasValue) routeSpec = argv[++i];
+        else if (std::strcmp(arg, "--repl-port") == 0 && hasValue) options.replicationPort = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--replica-of") == 0 && hasValue) {
+            std::string spec = argv[++i];
+            size_t colon = spec.rfind(':');
+            if (colon == std::string::npos || colon == 0 || std::atoi(spec.c_str() + colon + 1) <= 0) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            options.replicaHost = spec.substr(0, colon);
+            options.replicaPort = std::atoi(spec.c_str() + colon + 1);
+        }
+        else if (std::strcmp(arg, "--raft") == 0 && hasValue) raftId = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--raft-peers") == 0 && hasValue) raftPeers = argv[++i];
+        else if (std::strcmp(arg, "--raft-dir") == 0 && hasValue) options.raft.dataDir = argv[++i];
+        else if (std::strcmp(arg, "--build-catalog") == 0 && i + 2 < argc) return buildCatalog(argv[i + 1], argv[i + 2]);
+        else { printUsage(argv[0]); return 2; }
+    }
+
+    // 日志配置：级别与限流可通过环境变量调整，敏感字段统一脱敏
+    Logger &logger = Logger::instance();
+    logger.setLevel(Logger::parseLevel(std::getenv("LAB_LOG_LEVEL"), LogLevel::Info));
+    if (const char *rate = std::getenv("LAB_LOG_RATE")) logger.setRateLimit(static_cast<unsigned>(std::atoi(rate)));
+    logger.setRedactedKeys({"password", "passwordHash", "token", "sessionSecret"});
+    logger.start();
+
+    if (const char *v = std::getenv("LAB_COMPRESS_MIN_BYTES")) options.compression.threshold = static_cast<size_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_COMPRESS_LEVEL")) options.compression.level = std::atoi(v);
+    if (const char *v = std::getenv("LAB_COMPRESS")) options.compression.enabled = std::string(v) != "0";
+    if (const char *v = std::getenv("LAB_STATIC_RELOAD")) options.staticReload = std::string(v) == "1";
+    // 会话密钥：多个工作进程共用同一密钥时，任一进程签发的令牌都能在其他进程通过校验
+    if (const char *v = std::getenv("LAB_SESSION_SECRET")) options.sessionSecret = v;
+    if (const char *v = std::getenv("LAB_SESSION_TTL")) options.sessionTtl = static_cast<std::time_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_VERIFY_THREADS")) options.verifyThreads = static_cast<size_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_VERIFY_QUEUE")) options.verifyQueue = static_cast<size_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_SINGLE_WRITER")) options.singleWriter = std::string(v) == "1";
+    if (const char *v = std::getenv("LAB_REPL_HOST")) options.replicationHost = v;
+    if (const char *v = std::getenv("LAB_REPL_SNAPSHOT_EVERY")) options.replicationSnapshotEvery = std::strtoull(v, nullptr, 10);
+    if (const char *v = std::getenv("LAB_WRITER_BATCH")) options.writerBatch = static_cast<size_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_COMPACT_INTERVAL")) options.compactInterval = std::atoi(v);
+    if (const char *v = std::getenv("LAB_TIMERS")) options.timers = std::string(v) != "0";
+    if (const char *v = std::getenv("LAB_COMPACT_GRACE")) options.compactGrace = static_cast<std::time_t>(std::atol(v));
+    if (const char *v = std::getenv("LAB_RAFT_FSYNC")) options.raft.fsync = std::string(v) != "0";
+    if (const char *v = std::getenv("LAB_RAFT_SNAPSHOT_EVERY")) options.raft.snapshotEvery = std::strtoull(v, nullptr, 10);
+
+    // 共识复制：节点列表须含本节点；转发给主节点的业务地址取监听地址（0.0.0.0 时按本机）
+    if (raftId >= 0 || !raftPeers.empty()) {
+        if (!parseShardList(raftPeers, options.raft.peers) || raftId < 0 || raftId >= static_cast<int>(options.raft.peers.size()) ||
+            options.replicationPort >= 0 || !options.replicaHost.empty()) {
+            logError("raft.bad_config", {{"id", raftId}, {"peers", raftPeers}});
+            logger.stop();
+            return 2;
+        }
+        if (options.raft.peers.size() % 2 == 0) logWarn("raft.even_cluster", {{"nodes", options.raft.peers.size()}});
+        options.raft.id = raftId;
+        if (options.raft.dataDir.empty()) options.raft.dataDir = "raft-" + std::to_string(raftId);
+        options.raft.apiAddress = (host == "0.0.0.0" ? std::string("127.0.0.1") : host) + ":" + std::to_string(port);
+    }
+
+    // 路由模式：不持有业务数据，只转发到各分片
+    if (!routeSpec.empty()) {
+        std::vector<ShardEndpoint> shards;
+        if (!parseShardList(routeSpec, shards)) {
+            logError("router.bad_shard_list", {{"spec", routeSpec}});
+            logger.stop();
+            return 2;
+        }
+        RouterOptions routerOptions;
+        routerOptions.compression = options.compression;
+        {
+            ShardRouter router(std::move(shards), routerOptions);
+            runningRouter = &router;
+            std::signal(SIGINT, handleSignal);
+            std::signal(SIGTERM, handleSignal);
+            router.listen(host, port);
+            runningRouter = nullptr;
+        }
+        logger.stop();
+        return 0;
+    }
+
+    LabManager mgr;
+    // 分片须在创建任何设备之前设定（决定设备ID的分配序列）
+    if (shardCount > 1) {
+        if (!catalogPath.empty()) {
+            logError("shard.catalog_unsupported", {{"path", catalogPath}});
+            logger.stop();
+            return 2;
+        }
+        mgr.setShard(shardIndex, shardCount);
+        logInfo("shard.config", {{"index", shardIndex}, {"count", shardCount}});
+    }
+    // 目录先于演示数据挂接：演示设备的ID分配在目录之后
+    if (!catalogPath.empty()) {
+        auto catalog = std::make_shared<DeviceCatalog>();
+        if (!catalog->open(catalogPath) || !mgr.attachCatalog(catalog)) {
+            logError("catalog.open_failed", {{"path", catalogPath}});
+            logger.stop();
+            return 1;
+        }
+        logInfo("catalog.open", {{"path", catalogPath}, {"devices", catalog->size()}});
+    }
+    mgr.seed();
+    for (const auto &path : importPaths) {
+        if (!importFile(mgr, path)) {
+            logger.stop();
+            return 1;
+        }
+    }
+
+    {
+        ApiServer server(mgr, options);
+        if (!options.raft.peers.empty() && !server.raft) {
+            logger.stop();
+            return 1;
+        }
+        runningServer = &server;
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+        server.listen(host, port);
+        runningServer = nullptr;
+    }
+    logger.stop();
+    return 0;
+}
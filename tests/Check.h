@@ -0,0 +1,82 @@
+#pragma once
+// 测试程序共用的最小断言与用例注册：每个 tests/test_*.cpp 编译为一个可执行文件并注册为一个 ctest 用例。
+// 断言失败时打印位置与两侧取值后继续执行（REQUIRE 失败时结束当前用例），进程以是否有失败作为退出码
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace labtest {
+
+struct Case {
+    const char *name;
+    void (*fn)();
+};
+
+inline std::vector<Case> &cases() {
+    static std::vector<Case> all;
+    return all;
+}
+
+inline int &failures() {
+    static int n = 0;
+    return n;
+}
+
+struct Register {
+    Register(const char *name, void (*fn)()) { cases().push_back(Case{name, fn}); }
+};
+
+template <typename T, typename = void>
+struct Printable : std::false_type {};
+template <typename T>
+struct Printable<T, std::void_t<decltype(std::declval<std::ostream &>() << std::declval<const T &>())>> : std::true_type {};
+
+template <typename T>
+std::string show(const T &v) {
+    if constexpr (std::is_enum_v<T>) {
+        return std::to_string(static_cast<long long>(v));
+    } else if constexpr (Printable<T>::value) {
+        std::ostringstream os;
+        os << v;
+        return os.str();
+    } else {
+        return "?";
+    }
+}
+
+inline bool fail(const char *file, int line, const std::string &what) {
+    ++failures();
+    std::fprintf(stderr, "%s:%d: 失败: %s\n", file, line, what.c_str());
+    return false;
+}
+
+template <typename A, typename B>
+bool checkEq(const A &a, const B &b, const char *ea, const char *eb, const char *file, int line) {
+    if (a == b) return true;
+    return fail(file, line, std::string(ea) + " == " + eb + "（" + show(a) + " 对 " + show(b) + "）");
+}
+
+// 依次运行全部用例，返回进程退出码
+inline int runAll() {
+    for (const auto &c : cases()) {
+        int before = failures();
+        c.fn();
+        std::printf("[%s] %s\n", failures() == before ? " ok " : "FAIL", c.name);
+    }
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace labtest
+
+#define TEST_CASE(name)                                             \
+    static void name();                                             \
+    static labtest::Register name##_registered(#name, &name);       \
+    static void name()
+
+#define CHECK(cond) ((cond) ? true : labtest::fail(__FILE__, __LINE__, #cond))
+#define CHECK_EQ(a, b) labtest::checkEq((a), (b), #a, #b, __FILE__, __LINE__)
+#define REQUIRE(cond) do { if (!CHECK(cond)) return; } while (0)
@@ -0,0 +1,325 @@
+// 登录相关：scrypt 口令哈希、按用户名的登录限流、口令校验线程池满时拒绝（接口返回 503），
+// 会话令牌的签发与校验（篡改、过期、吊销、Authorization 头格式）及其在接口上的效果
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string_view>
+#include <thread>
+
+#include "Check.h"
+#include "Crypto.h"
+#include "PasswordHash.h"
+#include "Server.h"
+#include "Session.h"
+#include "json.hpp"
+
+namespace {
+
+const ScryptParams kFast{4, 1, 1};
+const std::string kSecret = "test-session-secret-0123456789abcdef";
+constexpr std::time_t T0 = 1700000000;
+
+// 把 base64url 令牌的第 i 个字符换成另一个合法字符
+std::string flipChar(std::string token, size_t i) {
+    token[i] = token[i] == 'A' ? 'B' : 'A';
+    return token;
+}
+
+} // namespace
+
+TEST_CASE(scryptKnownAnswer) {
+    // RFC 7914 第 12 节的第一组测试向量
+    const std::uint8_t expected[64] = {
+        0x77, 0xd6, 0x57, 0x62, 0x38, 0x65, 0x7b, 0x20, 0x3b, 0x19, 0xca, 0x42, 0xc1, 0x8a, 0x04, 0x97,
+        0xf1, 0x6b, 0x48, 0x44, 0xe3, 0x07, 0x4a, 0xe8, 0xdf, 0xdf, 0xfa, 0x3f, 0xed, 0xe2, 0x14, 0x42,
+        0xfc, 0xd0, 0x06, 0x9d, 0xed, 0x09, 0x48, 0xf8, 0x32, 0x6a, 0x75, 0x3a, 0x0f, 0xc8, 0x1f, 0x17,
+        0xe8, 0xd3, 0xe0, 0xfb, 0x2e, 0x0d, 0x36, 0x28, 0xcf, 0x35, 0xe2, 0x0c, 0x38, 0xd1, 0x89, 0x06,
+    };
+    std::uint8_t out[64];
+    REQUIRE(scrypt("", "", 0, 16, 1, 1, out, sizeof(out)));
+    CHECK(std::equal(out, out + 64, expected));
+    CHECK(!scrypt("", "", 0, 15, 1, 1, out, sizeof(out)));   // N 不是 2 的幂
+}
+
+TEST_CASE(hashRoundTrip) {
+    std::string h = hashPassword("correct horse", kFast);
+    CHECK_EQ(h.rfind("$scrypt$ln=4,r=1,p=1$", 0), size_t{0});
+    CHECK(isPasswordHash(h));
+    CHECK(verifyPasswordHash("correct horse", h));
+    CHECK(!verifyPasswordHash("correct horsE", h));
+    CHECK(!verifyPasswordHash("", h));
+    // 每次生成新的盐
+    std::string again = hashPassword("correct horse", kFast);
+    CHECK(again != h);
+    CHECK(verifyPasswordHash("correct horse", again));
+}
+
+TEST_CASE(hashParseRejection) {
+    std::string h = hashPassword("pw", kFast);
+    size_t saltAt = h.find('$', 8) + 1;
+    size_t hashAt = h.find('$', saltAt) + 1;
+    std::string salt = h.substr(saltAt, hashAt - saltAt - 1);
+    std::string digest = h.substr(hashAt);
+    const std::string bad[] = {
+        "",
+        "123456",
+        "$scrypt$",
+        "$scrypt$ln=4",                                            // CSV 中未加引号、在逗号处被截断
+        "$scrypt$ln=4,r=1,p=1$" + salt,                            // 缺少哈希
+        "$bcrypt$ln=4,r=1,p=1$" + salt + "$" + digest,             // 前缀不符
+        "$scrypt$ln=4,r=1$" + salt + "$" + digest,                 // 缺少参数 p
+        "$scrypt$ln=4,r=1,p=1,x=2$" + salt + "$" + digest,         // 未知参数
+        "$scrypt$ln=21,r=1,p=1$" + salt + "$" + digest,            // 超出范围：防止伪造哈希触发超大内存分配
+        "$scrypt$ln=0,r=1,p=1$" + salt + "$" + digest,
+        "$scrypt$ln=4,r=33,p=1$" + salt + "$" + digest,
+        "$scrypt$ln=4,r=1,p=x$" + salt + "$" + digest,
+        "$scrypt$ln=4,r=1,p=1$$" + digest,                         // 空盐
+        "$scrypt$ln=4,r=1,p=1$" + salt + "$" + digest.substr(4),   // 哈希长度不符
+        "$scrypt$ln=4,r=1,p=1$" + salt + "$" + digest + "!",       // 非 base64url 字符
+    };
+    for (const auto &s : bad) {
+        if (!CHECK(!isPasswordHash(s))) std::fprintf(stderr, "  编码: %s\n", s.c_str());
+        CHECK(!verifyPasswordHash("pw", s));
+    }
+}
+
+TEST_CASE(throttleBurstAndRefill) {
+    LoginThrottle t(LoginThrottleConfig{3, 10, 1000});
+    int retry = 0;
+    for (int i = 0; i < 3; ++i) CHECK(t.acquire("alice", 100, retry));
+    CHECK(!t.acquire("alice", 100, retry));
+    CHECK_EQ(retry, 10);
+    CHECK(!t.acquire("alice", 105, retry));   // 恢复了半个令牌
+    CHECK_EQ(retry, 5);
+    CHECK(t.acquire("alice", 110, retry));
+    CHECK(!t.acquire("alice", 110, retry));
+    // 其他用户名互不影响；成功后清空记录
+    CHECK(t.acquire("bob", 110, retry));
+    t.succeeded("alice");
+    for (int i = 0; i < 3; ++i) CHECK(t.acquire("alice", 110, retry));
+    CHECK_EQ(t.size(), size_t{2});
+    t.succeeded("nobody");
+    CHECK_EQ(t.size(), size_t{2});
+}
+
+TEST_CASE(throttleBoundedUnderSpray) {
+    // 16 个分片，每片最多 4 条
+    LoginThrottle t(LoginThrottleConfig{5, 30, 64});
+    int retry = 0;
+    for (int i = 0; i < 5; ++i) t.acquire("victim", 1000, retry);
+    CHECK(!t.acquire("victim", 1000, retry));
+    // 大量随机用户名各留下一个未恢复满的记录：条数不超过上限
+    for (int i = 0; i < 20000; ++i) {
+        CHECK(t.acquire("spray-" + std::to_string(i), 1000, retry));
+        if (t.size() > 64) { CHECK(t.size() <= 64); break; }
+    }
+    CHECK(t.size() <= 64);
+    // 分片满时淘汰最久未更新的记录：取三个落在同一分片（按用户名散列，16 个分片）的用户名，每片最多 2 条
+    std::vector<std::string> same;
+    size_t shard = std::hash<std::string_view>{}("x0") % 16;
+    for (int i = 0; same.size() < 3; ++i) {
+        std::string name = "x" + std::to_string(i);
+        if (std::hash<std::string_view>{}(name) % 16 == shard) same.push_back(name);
+    }
+    LoginThrottle u(LoginThrottleConfig{2, 30, 32});
+    u.acquire(same[0], 1, retry);
+    u.acquire(same[1], 2, retry);
+    CHECK(u.acquire(same[0], 3, retry));    // 用完 same[0] 的令牌，同时更新其位置
+    CHECK(u.acquire(same[2], 4, retry));    // 淘汰 same[1]
+    CHECK_EQ(u.size(), size_t{2});
+    CHECK(!u.acquire(same[0], 4, retry));   // same[0] 的记录仍在
+}
+
+TEST_CASE(verifyPoolRejectsAtCapacity) {
+    VerifyPool pool(1, 2);
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::future<bool> a, b, c;
+    CHECK(pool.trySubmit([open] { open.wait(); return true; }, a));
+    CHECK(pool.trySubmit([open] { open.wait(); return false; }, b));
+    CHECK(!pool.trySubmit([] { return true; }, c));
+    CHECK(!c.valid());
+    CHECK_EQ(pool.rejected(), std::uint64_t{1});
+    CHECK_EQ(pool.inFlight(), size_t{2});
+    gate.set_value();
+    CHECK(a.get());
+    CHECK(!b.get());
+    // 执行完后恢复可用
+    while (pool.inFlight() != 0) std::this_thread::yield();
+    CHECK(pool.trySubmit([] { return true; }, c));
+    CHECK(c.get());
+}
+
+TEST_CASE(loginReturns503WhenVerifierFull) {
+    LabManager mgr;
+    mgr.passwordParams = kFast;
+    mgr.seed();
+    ServerOptions options;
+    options.serveStatic = false;
+    options.verifyThreads = 1;
+    options.verifyQueue = 1;
+    options.compactInterval = 0;
+    options.timers = false;
+    ApiServer server(mgr, options);
+    int port = server.bindToAnyPort("127.0.0.1");
+    REQUIRE(port > 0);
+    std::thread serving([&] { server.listenAfterBind(); });
+    while (!server.http.is_running()) std::this_thread::yield();
+
+    httplib::Client cli("127.0.0.1", port);
+    const std::string body = R"({"username":"student1","password":"123456"})";
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::future<bool> blocker;
+    CHECK(server.verifier.trySubmit([open] { open.wait(); return false; }, blocker));
+    auto busy = cli.Post("/api/login", body, "application/json");
+    if (CHECK(busy != nullptr)) {
+        CHECK_EQ(busy->status, 503);
+        CHECK_EQ(busy->get_header_value("Retry-After"), std::string("1"));
+    }
+    gate.set_value();
+    blocker.get();
+    while (server.verifier.inFlight() != 0) std::this_thread::yield();
+    auto ok = cli.Post("/api/login", body, "application/json");
+    if (CHECK(ok != nullptr)) CHECK_EQ(ok->status, 200);
+
+    server.stop();
+    serving.join();
+}
+
+TEST_CASE(sessionRoundTrip) {
+    SessionTokens tokens(kSecret, 3600);
+    CHECK(!tokens.ephemeralSecret());
+    SessionClaims issued;
+    std::string token = tokens.issue(42, T0, &issued);
+    CHECK_EQ(token.size(), size_t{71});
+    CHECK_EQ(issued.userId, 42);
+    CHECK_EQ(issued.expiresAt, T0 + 3600);
+
+    SessionClaims claims;
+    REQUIRE(tokens.validate(token, T0 + 10, claims) == TokenError::None);
+    CHECK_EQ(claims.userId, 42);
+    CHECK_EQ(claims.expiresAt, issued.expiresAt);
+    CHECK_EQ(claims.sessionId, issued.sessionId);
+
+    // 同一密钥的另一实例（另一个工作进程 / 分片）同样接受；不同密钥拒绝
+    SessionTokens peer(kSecret, 3600);
+    CHECK(peer.validate(token, T0 + 10, claims) == TokenError::None);
+    SessionTokens other("another-secret-0123456789abcdef0123", 3600);
+    CHECK(other.validate(token, T0 + 10, claims) == TokenError::BadSignature);
+    SessionTokens ephemeral;
+    CHECK(ephemeral.ephemeralSecret());
+    CHECK(ephemeral.validate(token, T0 + 10, claims) == TokenError::BadSignature);
+
+    // 连续签发的会话ID不同
+    SessionClaims second;
+    tokens.issue(42, T0, &second);
+    CHECK(second.sessionId != issued.sessionId);
+}
+
+TEST_CASE(sessionTamperedAndMalformed) {
+    SessionTokens tokens(kSecret, 3600);
+    std::string token = tokens.issue(7, T0);
+    SessionClaims claims;
+    claims.userId = -1;
+    // 前 28 个字符编码版本 / userId / 过期时间 / 会话ID，之后是签名
+    CHECK(tokens.validate(flipChar(token, 3), T0, claims) == TokenError::BadSignature);    // userId
+    CHECK(tokens.validate(flipChar(token, 10), T0, claims) == TokenError::BadSignature);   // 过期时间
+    CHECK(tokens.validate(flipChar(token, 40), T0, claims) == TokenError::BadSignature);   // 签名
+    CHECK(tokens.validate(flipChar(token, 0), T0, claims) == TokenError::Malformed);       // 版本
+    CHECK(tokens.validate("", T0, claims) == TokenError::Missing);
+    CHECK(tokens.validate(token.substr(0, 70), T0, claims) == TokenError::Malformed);
+    CHECK(tokens.validate(token + "A", T0, claims) == TokenError::Malformed);
+    std::string bad = token;
+    bad[20] = '*';
+    CHECK(tokens.validate(bad, T0, claims) == TokenError::Malformed);
+    CHECK_EQ(claims.userId, -1);   // 失败时不填充
+    CHECK_EQ(std::string(tokenErrorName(TokenError::BadSignature)), std::string("bad_signature"));
+}
+
+TEST_CASE(sessionExpiry) {
+    SessionTokens tokens(kSecret, 100);
+    std::string token = tokens.issue(1, T0);
+    SessionClaims claims;
+    CHECK(tokens.validate(token, T0 + 99, claims) == TokenError::None);
+    CHECK(tokens.validate(token, T0 + 100, claims) == TokenError::Expired);
+    CHECK(tokens.validate(token, T0 + 100000, claims) == TokenError::Expired);
+}
+
+TEST_CASE(sessionRevoke) {
+    SessionTokens tokens(kSecret, 100);
+    SessionClaims first, second, claims;
+    std::string a = tokens.issue(1, T0, &first);
+    std::string b = tokens.issue(1, T0, &second);
+    tokens.revoke(first, T0 + 1);
+    CHECK(tokens.validate(a, T0 + 2, claims) == TokenError::Revoked);
+    CHECK(tokens.validate(b, T0 + 2, claims) == TokenError::None);   // 只吊销这一个会话
+    CHECK_EQ(tokens.revokedCount(), size_t{1});
+
+    // 已过期的吊销条目在表增长时清理：每个分片的条目数不超过清理阈值 64
+    for (int i = 0; i < 3000; ++i) {
+        SessionClaims c;
+        tokens.issue(2, T0, &c);
+        tokens.revoke(c, T0 + 1000);
+    }
+    CHECK(tokens.revokedCount() < size_t{16 * 64});
+}
+
+TEST_CASE(bearerHeader) {
+    CHECK_EQ(SessionTokens::bearerToken("Bearer abc"), std::string_view("abc"));
+    CHECK_EQ(SessionTokens::bearerToken("bEaReR   abc  "), std::string_view("abc"));
+    for (std::string_view header : {"", "Bearer", "Bearer ", "Bearer    ", "Bearerabc", "Basic abc", "abc", " Bearer abc"}) {
+        if (!CHECK(SessionTokens::bearerToken(header).empty())) std::fprintf(stderr, "  头: '%.*s'\n", static_cast<int>(header.size()), header.data());
+    }
+}
+
+// 接口上的效果：缺少 / 格式错误 / 篡改的令牌返回 401，登出后同一令牌被拒绝
+TEST_CASE(logoutRevokesOverHttp) {
+    LabManager mgr;
+    mgr.passwordParams = kFast;
+    mgr.seed();
+    ServerOptions options;
+    options.serveStatic = false;
+    options.compactInterval = 0;
+    options.timers = false;
+    options.verifyThreads = 1;
+    options.sessionSecret = kSecret;
+    ApiServer server(mgr, options);
+    int port = server.bindToAnyPort("127.0.0.1");
+    REQUIRE(port > 0);
+    std::thread serving([&] { server.listenAfterBind(); });
+    while (!server.http.is_running()) std::this_thread::yield();
+
+    httplib::Client cli("127.0.0.1", port);
+    auto login = cli.Post("/api/login", R"({"username":"student1","password":"123456"})", "application/json");
+    REQUIRE(login && login->status == 200);
+    std::string token = nlohmann::json::parse(login->body).value("token", std::string());
+    REQUIRE(!token.empty());
+
+    auto status = [&](const std::string &header, std::string *error = nullptr) {
+        httplib::Headers headers;
+        if (!header.empty()) headers.emplace("Authorization", header);
+        auto res = cli.Get("/api/notifications", headers);
+        if (!res) return -1;
+        if (error) *error = nlohmann::json::parse(res->body).value("error", std::string());
+        return res->status;
+    };
+    std::string error;
+    CHECK_EQ(status("Bearer " + token), 200);
+    CHECK_EQ(status(""), 401);
+    CHECK_EQ(status("Token " + token), 401);
+    CHECK_EQ(status("Bearer " + flipChar(token, 3), &error), 401);
+    CHECK_EQ(error, std::string("bad_signature"));
+    CHECK_EQ(status("Bearer " + token.substr(1), &error), 401);
+    CHECK_EQ(error, std::string("malformed_token"));
+
+    auto logout = cli.Post("/api/logout", {{"Authorization", "Bearer " + token}}, "", "application/json");
+    CHECK(logout && logout->status == 200);
+    CHECK_EQ(status("Bearer " + token, &error), 401);
+    CHECK_EQ(error, std::string("revoked"));
+
+    server.stop();
+    serving.join();
+}
+
+int main() { return labtest::runAll(); }
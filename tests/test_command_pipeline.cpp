@@ -0,0 +1,102 @@
+// 单写者命令管线：多生产者并发提交时每条命令恰好执行一次、每个 future 恰好完成一次，
+// 同一生产者的命令按提交顺序执行，析构时执行完已入队的命令
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "CommandPipeline.h"
+
+namespace {
+
+constexpr int kProducers = 8;
+constexpr int kPerProducer = 5000;
+
+} // namespace
+
+TEST_CASE(multiProducerStress) {
+    LabManager mgr;
+    std::vector<std::atomic<int>> runs(kProducers * kPerProducer);
+    std::vector<int> lastSeen(kProducers, -1);   // 只在写线程上读写
+    std::atomic<int> outOfOrder{0};
+    std::vector<std::vector<std::future<int>>> futures(kProducers);
+    {
+        CommandPipeline pipeline(mgr, 16);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&, p] {
+                futures[p].reserve(kPerProducer);
+                for (int i = 0; i < kPerProducer; ++i) {
+                    int id = p * kPerProducer + i;
+                    futures[p].push_back(pipeline.submit([&, p, i, id](LabManager &) {
+                        runs[id].fetch_add(1);
+                        if (lastSeen[p] != i - 1) outOfOrder.fetch_add(1);
+                        lastSeen[p] = i;
+                        return id;
+                    }));
+                    if (i % 512 == 0) std::this_thread::yield();   // 让写线程时而休眠、时而被唤醒
+                }
+            });
+        }
+        for (auto &t : producers) t.join();
+        // 一半的 future 在管线存续期间取结果
+        for (int p = 0; p < kProducers / 2; ++p) {
+            for (int i = 0; i < kPerProducer; ++i) CHECK_EQ(futures[p][i].get(), p * kPerProducer + i);
+        }
+        CHECK(pipeline.version() > 0);
+        CHECK(pipeline.batches() <= pipeline.commands());
+    }
+    // 其余的在析构（排空队列）之后取
+    for (int p = kProducers / 2; p < kProducers; ++p) {
+        for (int i = 0; i < kPerProducer; ++i) {
+            REQUIRE(futures[p][i].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+            CHECK_EQ(futures[p][i].get(), p * kPerProducer + i);
+        }
+    }
+    int wrongCount = 0;
+    for (auto &r : runs) wrongCount += r.load() != 1;
+    CHECK_EQ(wrongCount, 0);
+    CHECK_EQ(outOfOrder.load(), 0);
+}
+
+TEST_CASE(destructorDrainsQueue) {
+    LabManager mgr;
+    std::atomic<int> executed{0};
+    std::vector<std::future<void>> futures;
+    // 第一条命令阻塞写线程，其余命令在析构开始时仍在队列中
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::thread release;
+    {
+        CommandPipeline pipeline(mgr, 4);
+        futures.push_back(pipeline.submit([open, &executed](LabManager &) { open.wait(); executed.fetch_add(1); }));
+        for (int i = 0; i < 1000; ++i) futures.push_back(pipeline.submit([&executed](LabManager &) { executed.fetch_add(1); }));
+        release = std::thread([&gate] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.set_value();
+        });
+    }
+    release.join();
+    CHECK_EQ(executed.load(), 1001);
+    for (auto &f : futures) {
+        REQUIRE(f.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        f.get();
+    }
+}
+
+TEST_CASE(exceptionsReachSubmitter) {
+    LabManager mgr;
+    CommandPipeline pipeline(mgr);
+    auto bad = pipeline.submit([](LabManager &) -> int { throw std::runtime_error("boom"); });
+    auto good = pipeline.submit([](LabManager &m) { return m.addDevice(DeviceType::Power, "炉", true); });
+    bool threw = false;
+    try { bad.get(); } catch (const std::runtime_error &e) { threw = std::string(e.what()) == "boom"; }
+    CHECK(threw);
+    CHECK(good.get() > 0);
+}
+
+int main() { return labtest::runAll(); }
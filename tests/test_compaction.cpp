@@ -0,0 +1,103 @@
+// 预约压缩（手动时钟）：爽约的预约移入归档并扣分、通知，借出中与未结束的预约保留，归档容量与累计计数
+#include <memory>
+
+#include "Check.h"
+#include "LabManager.h"
+
+namespace {
+
+constexpr std::time_t T0 = 1700000000;
+constexpr int kStudent = 1, kTeacher = 2;
+constexpr int kPrinter = 1, kCentrifuge = 3, kIncubator = 5;   // seed 中允许学生预约的设备
+
+struct Fixture {
+    LabManager mgr;
+    std::shared_ptr<ManualClock> clock = std::make_shared<ManualClock>(T0);
+
+    Fixture() {
+        mgr.clock = clock;
+        mgr.passwordParams = ScryptParams{4, 1, 1};
+        mgr.seed();
+    }
+    int credit(int userId) { return mgr.getUser(userId)->creditScore; }
+    size_t onDevice(int deviceId) { return mgr.findDevice(deviceId)->reservations.size(); }
+};
+
+} // namespace
+
+TEST_CASE(noShowArchivedWithPenalty) {
+    Fixture f;
+    REQUIRE(f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));        // 爽约
+    REQUIRE(f.mgr.reserve(kStudent, kCentrifuge, T0 + 3600, T0 + 5400));     // 借出后逾期未还
+    REQUIRE(f.mgr.reserve(kTeacher, kPrinter, T0 + 10000, T0 + 12000));      // 未来的预约
+    f.clock->set(T0 + 3700);
+    REQUIRE(f.mgr.borrow(kStudent, kCentrifuge, f.clock->now()));
+
+    // 截止时间早于结束时间：不归档
+    f.clock->set(T0 + 7000);
+    CHECK_EQ(f.mgr.compactReservations(T0 + 7000), size_t{0});
+    CHECK_EQ(f.onDevice(kPrinter), size_t{2});
+
+    f.clock->set(T0 + 7300);
+    CHECK_EQ(f.mgr.compactReservations(T0 + 7201), size_t{1});
+    CHECK_EQ(f.credit(kStudent), 100 - LabManager::kNoShowPenalty);
+    CHECK_EQ(f.credit(kTeacher), 200);
+    REQUIRE(f.mgr.reservationArchive.size() == 1);
+    const auto &a = f.mgr.reservationArchive.front();
+    CHECK_EQ(a.deviceId, kPrinter);
+    CHECK_EQ(a.userId, kStudent);
+    CHECK_EQ(a.start, T0 + 3600);
+    CHECK_EQ(a.end, T0 + 7200);
+    CHECK_EQ(f.mgr.archivedTotal, std::uint64_t{1});
+
+    // 设备上只留下教师未来的预约；借出中的预约即使已过结束时间也保留
+    CHECK_EQ(f.onDevice(kPrinter), size_t{1});
+    CHECK_EQ(f.mgr.findDevice(kPrinter)->reservations[0].userId, kTeacher);
+    CHECK_EQ(f.onDevice(kCentrifuge), size_t{1});
+
+    // 通知预约人，时间取当前时刻；“我的预约”中不再出现已归档的预约
+    std::vector<LabManager::Notification> notes = f.mgr.popNotifications(kStudent);
+    REQUIRE(notes.size() == 1);
+    CHECK(notes[0].message.find("爽约") != std::string::npos);
+    CHECK_EQ(notes[0].createdAt, T0 + 7300);
+    auto mine = f.mgr.userReservations(kStudent, f.clock->now());
+    REQUIRE(mine.size() == 1);
+    CHECK_EQ(mine[0].deviceId, kCentrifuge);
+    CHECK(mine[0].status == LabManager::BookingStatus::Borrowed);
+
+    // 再次压缩不重复扣分
+    CHECK_EQ(f.mgr.compactReservations(T0 + 7300), size_t{0});
+    CHECK_EQ(f.credit(kStudent), 100 - LabManager::kNoShowPenalty);
+    CHECK(f.mgr.popNotifications(kStudent).empty());
+}
+
+TEST_CASE(penaltiesAccumulateAndBlockReserving) {
+    Fixture f;
+    f.mgr.getUser(kStudent)->creditScore = 2 * LabManager::kNoShowPenalty;
+    REQUIRE(f.mgr.reserve(kStudent, kPrinter, T0 + 600, T0 + 1200));
+    REQUIRE(f.mgr.reserve(kStudent, kIncubator, T0 + 600, T0 + 1800));
+    f.clock->set(T0 + 2000);
+    CHECK_EQ(f.mgr.compactReservations(T0 + 2000), size_t{2});
+    CHECK_EQ(f.credit(kStudent), 0);
+    CHECK_EQ(f.mgr.popNotifications(kStudent).size(), size_t{2});
+    // 信用分耗尽后不能再预约
+    CHECK(!f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));
+}
+
+TEST_CASE(archiveCapacityDropsOldest) {
+    Fixture f;
+    f.mgr.archiveCapacity = 2;
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(f.mgr.reserve(kTeacher, kPrinter, T0 + 600 + i * 1000, T0 + 1200 + i * 1000));
+    }
+    f.clock->set(T0 + 5000);
+    CHECK_EQ(f.mgr.compactReservations(T0 + 5000), size_t{3});
+    CHECK_EQ(f.mgr.archivedTotal, std::uint64_t{3});
+    REQUIRE(f.mgr.reservationArchive.size() == 2);
+    CHECK_EQ(f.mgr.reservationArchive.front().start, T0 + 1600);
+    CHECK_EQ(f.mgr.reservationArchive.back().start, T0 + 2600);
+    CHECK_EQ(f.credit(kTeacher), 200 - 3 * LabManager::kNoShowPenalty);
+    CHECK_EQ(f.onDevice(kPrinter), size_t{0});
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,109 @@
+// 响应压缩：Accept-Encoding 的解析（q 值、空白、通配符，明确列出的编码优先于 *）与编码协商，
+// 以及 compressResponse 按阈值、内容类型与已有编码决定是否压缩
+#include <cstdio>
+#include <string>
+
+#include "Check.h"
+#include "Compression.h"
+
+namespace {
+
+struct AcceptCase {
+    const char *header;
+    bool gzip;
+    bool deflate;
+    ContentCoding chosen;
+};
+
+const AcceptCase kAcceptCases[] = {
+    {"", false, false, ContentCoding::Identity},
+    {"gzip", true, false, ContentCoding::Gzip},
+    {"deflate", false, true, ContentCoding::Deflate},
+    {"deflate, gzip", true, true, ContentCoding::Gzip},
+    {"gzip;q=0", false, false, ContentCoding::Identity},
+    {"gzip;q=0, deflate;q=0.5", false, true, ContentCoding::Deflate},
+    {" gzip ; q=0.000 ,deflate", false, true, ContentCoding::Deflate},
+    {"identity", false, false, ContentCoding::Identity},
+    {"gzipx, xdeflate", false, false, ContentCoding::Identity},
+    {"*", true, true, ContentCoding::Gzip},
+    {"*;q=0", false, false, ContentCoding::Identity},
+    // 明确列出的编码优先于通配符，与两者的先后顺序无关
+    {"*;q=0, gzip", true, false, ContentCoding::Gzip},
+    {"gzip, *;q=0", true, false, ContentCoding::Gzip},
+    {"gzip;q=0, *", false, true, ContentCoding::Deflate},
+    {"*, gzip;q=0", false, true, ContentCoding::Deflate},
+    {"br;q=1.0, deflate;q=0.8, *;q=0", false, true, ContentCoding::Deflate},
+};
+
+std::string jsonBody(size_t bytes) {
+    std::string body = "{\"ok\":true,\"devices\":[";
+    while (body.size() < bytes) body += "{\"id\":1,\"name\":\"3D打印机 A\",\"status\":\"空闲\"},";
+    body.back() = ']';
+    return body + "}";
+}
+
+} // namespace
+
+TEST_CASE(acceptEncodingParsing) {
+    for (const AcceptCase &c : kAcceptCases) {
+        std::string header = c.header;
+        if (!CHECK_EQ(acceptsEncoding(header, "gzip"), c.gzip)) std::printf("  header: \"%s\"\n", c.header);
+        if (!CHECK_EQ(acceptsEncoding(header, "deflate"), c.deflate)) std::printf("  header: \"%s\"\n", c.header);
+        if (!CHECK(negotiateCoding(header) == c.chosen)) std::printf("  header: \"%s\"\n", c.header);
+    }
+    // 静态资源按同样的规则判断 br
+    CHECK(acceptsEncoding("*;q=0, br", "br"));
+    CHECK(!acceptsEncoding("br;q=0, *", "br"));
+}
+
+TEST_CASE(compressResponseConditions) {
+    CompressionConfig cfg;
+    httplib::Request req;
+    req.set_header("Accept-Encoding", "*;q=0, gzip");
+
+    httplib::Response res;
+    res.set_header("Content-Type", "application/json; charset=utf-8");
+    res.body = jsonBody(cfg.threshold * 8);
+    const std::string original = res.body;
+    bool compressed = compressResponse(req, res, cfg);
+    CHECK_EQ(compressed, compressionAvailable());
+    if (compressed) {
+        CHECK_EQ(res.get_header_value("Content-Encoding"), std::string("gzip"));
+        CHECK_EQ(res.get_header_value("Vary"), std::string("Accept-Encoding"));
+        CHECK(res.body.size() < original.size());
+        CHECK(res.body.compare(0, 2, "\x1f\x8b") == 0);   // gzip 魔数
+    }
+
+    // 阈值以下、非 JSON、已有编码、客户端不接受、关闭压缩：原样返回
+    auto untouched = [&](httplib::Response r, const httplib::Request &q, const CompressionConfig &c) {
+        std::string body = r.body;
+        return !compressResponse(q, r, c) && r.body == body && !r.has_header("Vary");
+    };
+    httplib::Response small;
+    small.set_header("Content-Type", "application/json");
+    small.body = jsonBody(cfg.threshold / 2);
+    CHECK(untouched(small, req, cfg));
+
+    httplib::Response html;
+    html.set_header("Content-Type", "text/html");
+    html.body = original;
+    CHECK(untouched(html, req, cfg));
+
+    httplib::Response encoded;
+    encoded.set_header("Content-Type", "application/json");
+    encoded.set_header("Content-Encoding", "br");
+    encoded.body = original;
+    CHECK(untouched(encoded, req, cfg));
+
+    httplib::Response json;
+    json.set_header("Content-Type", "application/json");
+    json.body = original;
+    httplib::Request refuses;
+    refuses.set_header("Accept-Encoding", "gzip;q=0, *;q=0");
+    CHECK(untouched(json, refuses, cfg));
+    CompressionConfig off;
+    off.enabled = false;
+    CHECK(untouched(json, req, off));
+}
+
+int main() { return labtest::runAll(); }
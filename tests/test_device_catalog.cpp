@@ -0,0 +1,242 @@
+// 只读设备目录：生成后映射回来逐条一致（名称驻留、ID 连续与不连续时的查找），损坏文件拒绝打开；
+// 挂接到 LabManager 后只读查找与被拒绝的预约不构造覆盖层对象，预约成功时才构造且只构造一次，
+// 删除目录设备记墓碑，新增设备的ID从目录最大ID之后开始
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#include "Check.h"
+#include "DeviceCatalog.h"
+#include "LabManager.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::time_t T0 = 1700000000;
+
+// 测试结束时删除的临时目录文件
+struct TempFile {
+    fs::path path;
+    explicit TempFile(const char *name)
+        : path(fs::temp_directory_path() / ("lab_catalog_" + std::to_string(getpid()) + "_" + name)) {
+        fs::remove(path);
+    }
+    ~TempFile() { fs::remove(path); }
+    std::string str() const { return path.string(); }
+};
+
+// 1..5 连续，8 与 20 不连续（查找退化为二分）；示波器与万用表的名称各出现两次
+std::vector<DeviceCatalog::Entry> sampleEntries() {
+    return {
+        {20, DeviceType::Power, true, "万用表"},
+        {3, DeviceType::Precision, false, "示波器"},
+        {1, DeviceType::Consumable, true, "焊台"},
+        {5, DeviceType::Precision, true, "示波器"},
+        {2, DeviceType::Power, true, "电源"},
+        {8, DeviceType::Consumable, false, "万用表"},
+        {4, DeviceType::Consumable, true, "烙铁"},
+    };
+}
+
+std::shared_ptr<DeviceCatalog> openSample(const TempFile &file) {
+    if (!DeviceCatalog::write(file.str(), sampleEntries())) return nullptr;
+    auto catalog = std::make_shared<DeviceCatalog>();
+    return catalog->open(file.str()) ? catalog : nullptr;
+}
+
+struct Fixture {
+    TempFile file{"overlay"};
+    LabManager mgr;
+    int student = 0, teacher = 0;
+
+    Fixture() {
+        mgr.clock = std::make_shared<ManualClock>(T0);
+        mgr.passwordParams = ScryptParams{4, 1, 1};
+        student = mgr.addUser(UserType::Student, "student1", "123456");
+        teacher = mgr.addUser(UserType::Teacher, "teacher1", "123456");
+    }
+    size_t listed() {
+        size_t n = 0;
+        mgr.forEachDevice([&](const Device &) { ++n; });
+        return n;
+    }
+};
+
+} // namespace
+
+TEST_CASE(writeAndMapBack) {
+    TempFile file("roundtrip");
+    std::shared_ptr<DeviceCatalog> catalog = openSample(file);
+    REQUIRE(catalog != nullptr);
+    CHECK_EQ(catalog->size(), size_t{7});
+    CHECK_EQ(catalog->maxId(), 20);
+
+    // 按 id 升序，元数据逐条保留
+    const int ids[] = {1, 2, 3, 4, 5, 8, 20};
+    for (size_t i = 0; i < 7; ++i) CHECK_EQ(catalog->at(i).id, ids[i]);
+    DeviceCatalog::Entry scope = catalog->at(2);
+    CHECK(scope.name == "示波器");
+    CHECK(scope.type == DeviceType::Precision);
+    CHECK(!scope.allowStudent);
+    CHECK(catalog->at(6).type == DeviceType::Power);
+    CHECK(catalog->at(6).allowStudent);
+    // 相同名称在字符串表中只存一份
+    CHECK(catalog->at(4).name.data() == scope.name.data());
+    CHECK(catalog->at(5).name.data() == catalog->at(6).name.data());
+
+    for (size_t i = 0; i < 7; ++i) {
+        auto idx = catalog->indexOf(ids[i]);
+        REQUIRE(idx.has_value());
+        CHECK_EQ(*idx, i);
+    }
+    for (int missing : {0, -1, 6, 7, 19, 21}) CHECK(!catalog->indexOf(missing).has_value());
+
+    // ID 重复时不生成文件；已映射的目录不受后来的改写影响
+    std::vector<DeviceCatalog::Entry> dup = sampleEntries();
+    dup.push_back({3, DeviceType::Power, true, "重复"});
+    CHECK(!DeviceCatalog::write(file.str() + ".dup", dup));
+    CHECK(!fs::exists(file.str() + ".dup"));
+    REQUIRE(DeviceCatalog::write(file.str(), {{1, DeviceType::Power, true, "新目录"}}));
+    CHECK_EQ(catalog->size(), size_t{7});
+    CHECK(catalog->at(0).name == "焊台");
+
+    DeviceCatalog empty;
+    REQUIRE(DeviceCatalog::write(file.str(), {}));
+    REQUIRE(empty.open(file.str()));
+    CHECK_EQ(empty.size(), size_t{0});
+    CHECK_EQ(empty.maxId(), 0);
+    CHECK(!empty.indexOf(1).has_value());
+}
+
+TEST_CASE(rejectsDamagedFiles) {
+    TempFile file("damaged");
+    DeviceCatalog catalog;
+    CHECK(!catalog.open(file.str()));   // 文件不存在
+
+    REQUIRE(DeviceCatalog::write(file.str(), sampleEntries()));
+    std::string bytes;
+    {
+        std::ifstream in(file.str(), std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto rewrite = [&](const std::string &content) {
+        std::ofstream out(file.str(), std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    };
+
+    std::string badMagic = bytes;
+    badMagic[3] = 'X';
+    rewrite(badMagic);
+    CHECK(!catalog.open(file.str()));
+
+    rewrite(bytes.substr(0, 20));   // 文件头不完整
+    CHECK(!catalog.open(file.str()));
+
+    rewrite(bytes.substr(0, bytes.size() - 1));   // 字符串表越过文件末尾
+    CHECK(!catalog.open(file.str()));
+
+    std::string tooMany = bytes;
+    tooMany[8] = static_cast<char>(100);   // 条目数超出文件长度
+    rewrite(tooMany);
+    CHECK(!catalog.open(file.str()));
+    CHECK_EQ(catalog.size(), size_t{0});
+
+    rewrite(bytes);
+    CHECK(catalog.open(file.str()));
+    CHECK_EQ(catalog.size(), size_t{7});
+}
+
+TEST_CASE(overlayMaterialisesOnWriteOnly) {
+    Fixture f;
+    std::shared_ptr<DeviceCatalog> catalog = openSample(f.file);
+    REQUIRE(catalog != nullptr);
+    REQUIRE(f.mgr.attachCatalog(catalog));
+    CHECK(!f.mgr.attachCatalog(catalog));   // 只能挂接一次
+    CHECK_EQ(f.mgr.deviceCount(), size_t{7});
+    CHECK_EQ(f.listed(), size_t{7});
+
+    // 只读查找：原始状态对象，不进入覆盖层
+    const Device *scope = f.mgr.peekDevice(3);
+    REQUIRE(scope != nullptr);
+    CHECK(scope->name == "示波器");
+    CHECK(!scope->allowStudentReserve);
+    CHECK(f.mgr.peekDevice(6) == nullptr);
+    CHECK(f.mgr.devicesById.empty());
+
+    // 被拒绝的预约（学生不可预约的设备、时间段无效、不存在的设备）不构造覆盖层对象
+    CHECK(!f.mgr.reserve(f.student, 3, T0 + 3600, T0 + 7200));
+    CHECK(!f.mgr.reserve(f.student, 8, T0 + 3600, T0 + 7200));
+    CHECK(!f.mgr.reserve(f.teacher, 1, T0 + 7200, T0 + 3600));
+    CHECK(!f.mgr.reserve(f.teacher, 6, T0 + 3600, T0 + 7200));
+    CHECK(f.mgr.devicesById.empty());
+    CHECK_EQ(f.mgr.catalogMaterialized, size_t{0});
+
+    // 预约成功时构造，之后以覆盖层为准，再次预约不重复构造
+    REQUIRE(f.mgr.reserve(f.teacher, 3, T0 + 3600, T0 + 7200));
+    CHECK_EQ(f.mgr.catalogMaterialized, size_t{1});
+    CHECK(f.mgr.devicesById.contains(3));
+    CHECK(f.mgr.peekDevice(3) == f.mgr.findDevice(3));
+    CHECK_EQ(f.mgr.peekDevice(3)->reservations.size(), size_t{1});
+    CHECK(f.mgr.peekDevice(3)->name.data() == catalog->at(2).name.data());   // 名称仍指向映射
+    CHECK(!f.mgr.reserve(f.teacher, 3, T0 + 5400, T0 + 9000));   // 冲突：覆盖层对象已存在，不受影响
+    REQUIRE(f.mgr.reserve(f.teacher, 3, T0 + 7200, T0 + 9000));
+    CHECK_EQ(f.mgr.catalogMaterialized, size_t{1});
+    CHECK_EQ(f.mgr.deviceCount(), size_t{7});
+    CHECK_EQ(f.listed(), size_t{7});
+}
+
+TEST_CASE(deleteLeavesTombstone) {
+    Fixture f;
+    std::shared_ptr<DeviceCatalog> catalog = openSample(f.file);
+    REQUIRE(catalog != nullptr);
+    REQUIRE(f.mgr.attachCatalog(catalog));
+
+    // 未修改的目录设备：只记墓碑
+    REQUIRE(f.mgr.deleteDevice(2));
+    CHECK(!f.mgr.deleteDevice(2));
+    CHECK(f.mgr.deletedCatalogIds.count(2) == 1);
+    CHECK(f.mgr.peekDevice(2) == nullptr);
+    CHECK(f.mgr.findDevice(2) == nullptr);
+    CHECK(!f.mgr.reserve(f.teacher, 2, T0 + 3600, T0 + 7200));
+    CHECK(f.mgr.devicesById.empty());
+    CHECK_EQ(f.mgr.deviceCount(), size_t{6});
+    CHECK_EQ(f.listed(), size_t{6});
+
+    // 已构造的目录设备：移出覆盖层并记墓碑，未开始的预约一并移出
+    REQUIRE(f.mgr.reserve(f.student, 5, T0 + 3600, T0 + 7200));
+    CHECK_EQ(f.mgr.catalogMaterialized, size_t{1});
+    REQUIRE(f.mgr.deleteDevice(5));
+    CHECK_EQ(f.mgr.catalogMaterialized, size_t{0});
+    CHECK(f.mgr.devicesById.empty());
+    CHECK(f.mgr.userReservations(f.student, T0).empty());
+    CHECK_EQ(f.mgr.deviceCount(), size_t{5});
+    CHECK_EQ(f.listed(), size_t{5});
+
+    // 新增设备接在目录最大ID之后，与目录设备一同列出
+    int added = f.mgr.addDevice(DeviceType::Power, "新电源", true);
+    CHECK_EQ(added, 21);
+    CHECK_EQ(f.mgr.deviceCount(), size_t{6});
+    CHECK_EQ(f.listed(), size_t{6});
+}
+
+TEST_CASE(attachRejectsIdCollision) {
+    TempFile file("collision");
+    std::shared_ptr<DeviceCatalog> catalog = openSample(file);
+    REQUIRE(catalog != nullptr);
+    LabManager mgr;
+    mgr.clock = std::make_shared<ManualClock>(T0);
+    mgr.passwordParams = ScryptParams{4, 1, 1};
+    mgr.seed();   // seed 的设备ID 1..10 与目录重叠
+    CHECK(!mgr.attachCatalog(catalog));
+    CHECK(mgr.catalog == nullptr);
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,155 @@
+// 用户名扁平哈希表：插入 / 查找 / 删除，在墓碑上重新插入，多次扩容后键值不变，
+// 以及随机键上的插入删除序列与 std::unordered_map 逐步对照
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "Check.h"
+#include "FlatStringMap.h"
+
+namespace {
+
+// 表只保存键的视图：键字符串放在 deque 里，追加时不搬移已有元素
+struct Keys {
+    std::deque<std::string> store;
+    std::string_view add(std::string s) { return store.emplace_back(std::move(s)); }
+};
+
+} // namespace
+
+TEST_CASE(insertFindErase) {
+    Keys keys;
+    FlatStringMap map;
+    CHECK(map.empty());
+    CHECK(map.find("alice") == nullptr);
+    CHECK(!map.erase("alice"));
+
+    REQUIRE(map.insert(keys.add("alice"), 1));
+    REQUIRE(map.insert(keys.add("bob"), 2));
+    CHECK(!map.insert(keys.add("alice"), 3));   // 已存在：不覆盖
+    CHECK_EQ(map.size(), size_t{2});
+    REQUIRE(map.find("alice") != nullptr);
+    CHECK_EQ(*map.find("alice"), 1);
+    CHECK_EQ(*map.find(std::string("bob")), 2);   // 按内容查找，与键的存储位置无关
+    CHECK(!map.contains("carol"));
+    CHECK(!map.contains(""));
+
+    CHECK(map.erase("alice"));
+    CHECK(!map.erase("alice"));
+    CHECK(!map.contains("alice"));
+    CHECK_EQ(*map.find("bob"), 2);
+    CHECK_EQ(map.size(), size_t{1});
+    REQUIRE(map.insert(keys.add("alice"), 4));
+    CHECK_EQ(*map.find("alice"), 4);
+}
+
+// 接近负载上限时删除一半：满组里留下的墓碑不截断其他键的探测链，插回时复用空位；
+// 反复删除插入时墓碑由原尺寸重建回收，容量至多加倍一次而不随轮数增长
+TEST_CASE(reinsertOverTombstones) {
+    Keys keys;
+    FlatStringMap map;
+    map.reserve(1000);
+    const size_t capacity = map.capacity();
+    const int n = static_cast<int>(capacity * 7 / 8);
+    for (int i = 0; i < n; ++i) REQUIRE(map.insert(keys.add("user" + std::to_string(i)), i));
+    CHECK_EQ(map.capacity(), capacity);
+
+    // 删掉偶数键：奇数键仍全部可查
+    for (int i = 0; i < n; i += 2) REQUIRE(map.erase("user" + std::to_string(i)));
+    for (int i = 0; i < n; ++i) {
+        const int *v = map.find("user" + std::to_string(i));
+        if (i % 2) {
+            REQUIRE(v != nullptr);
+            CHECK_EQ(*v, i);
+        } else {
+            CHECK(v == nullptr);
+        }
+    }
+
+    for (int i = 0; i < n; i += 2) REQUIRE(map.insert(keys.add("user" + std::to_string(i)), -i));
+    CHECK(map.capacity() <= 2 * capacity);
+    CHECK_EQ(map.size(), static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) CHECK_EQ(*map.find("user" + std::to_string(i)), i % 2 ? i : -i);
+
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < n; i += 2) REQUIRE(map.erase("user" + std::to_string(i)));
+        for (int i = 0; i < n; i += 2) REQUIRE(map.insert(keys.add("r" + std::to_string(round) + "/" + std::to_string(i)), i));
+        for (int i = 0; i < n; i += 2) REQUIRE(map.erase("r" + std::to_string(round) + "/" + std::to_string(i)));
+        for (int i = 0; i < n; i += 2) REQUIRE(map.insert(keys.add("user" + std::to_string(i)), i));
+    }
+    CHECK(map.capacity() <= 2 * capacity);
+    CHECK_EQ(map.size(), static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) CHECK_EQ(*map.find("user" + std::to_string(i)), i);
+}
+
+TEST_CASE(growthAcrossResizes) {
+    Keys keys;
+    FlatStringMap map;
+    const int n = 100000;
+    size_t resizes = 0, capacity = map.capacity();
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(map.insert(keys.add("student" + std::to_string(i)), i));
+        if (map.capacity() != capacity) {
+            ++resizes;
+            capacity = map.capacity();
+            CHECK_EQ(capacity % FlatStringMap::kGroupSize, size_t{0});
+            CHECK((capacity & (capacity - 1)) == 0);   // 组数为 2 的幂
+        }
+    }
+    CHECK(resizes >= 10);
+    CHECK(map.size() * 8 <= map.capacity() * 7);
+    CHECK_EQ(map.size(), static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        const int *v = map.find("student" + std::to_string(i));
+        REQUIRE(v != nullptr);
+        CHECK_EQ(*v, i);
+    }
+    CHECK(!map.contains("student" + std::to_string(n)));
+
+    // 预留已足够时 reserve 不重建
+    map.reserve(n);
+    CHECK_EQ(map.capacity(), capacity);
+}
+
+// 随机长度与字符的键（含大量重复与空串）上随机插入 / 删除 / 查找，每步结果与 std::unordered_map 一致
+TEST_CASE(matchesUnorderedMap) {
+    Keys keys;
+    FlatStringMap map;
+    std::unordered_map<std::string, int> ref;
+    std::mt19937 rng(20240601);
+    std::vector<std::string_view> pool;
+    for (int i = 0; i < 4000; ++i) {
+        std::string s(rng() % 12, '\0');
+        for (char &c : s) c = static_cast<char>('a' + rng() % 6);
+        pool.push_back(keys.add(std::move(s)));
+    }
+    for (int step = 0; step < 200000; ++step) {
+        std::string_view key = pool[rng() % pool.size()];
+        switch (rng() % 3) {
+            case 0: {
+                int value = static_cast<int>(rng() % 1000);
+                bool inserted = ref.emplace(std::string(key), value).second;
+                if (!CHECK_EQ(map.insert(key, value), inserted)) return;
+                break;
+            }
+            case 1:
+                if (!CHECK_EQ(map.erase(key), ref.erase(std::string(key)) == 1)) return;
+                break;
+            default: {
+                auto it = ref.find(std::string(key));
+                const int *v = map.find(key);
+                if (!CHECK_EQ(v != nullptr, it != ref.end())) return;
+                if (v && !CHECK_EQ(*v, it->second)) return;
+            }
+        }
+        if (!CHECK_EQ(map.size(), ref.size())) return;
+    }
+    for (const auto &entry : ref) {
+        const int *v = map.find(entry.first);
+        REQUIRE(v != nullptr);
+        CHECK_EQ(*v, entry.second);
+    }
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,147 @@
+// 暂留（手动时钟）：到期后由 advanceTimers 清除、到期后确认失败、与其他用户的暂留冲突、
+// 删除设备时释放其上的暂留，以及经状态快照恢复后暂留与到期定时器保持不变
+#include <memory>
+
+#include "Check.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr std::time_t T0 = 1700000000;
+constexpr int kStudent = 1, kTeacher = 2;
+constexpr int kPrinter = 1, kCentrifuge = 3;
+
+struct Fixture {
+    LabManager mgr;
+    std::shared_ptr<ManualClock> clock = std::make_shared<ManualClock>(T0);
+
+    Fixture() {
+        mgr.clock = clock;
+        mgr.passwordParams = ScryptParams{4, 1, 1};
+        mgr.seed();
+        mgr.advanceTimers(T0);
+    }
+    size_t reservationsOn(int deviceId) { return mgr.findDevice(deviceId)->reservations.size(); }
+};
+
+} // namespace
+
+TEST_CASE(expiredHoldsClearedByTimers) {
+    Fixture f;
+    int id = f.mgr.hold(kStudent, kPrinter, T0 + 3600, T0 + 7200);
+    REQUIRE(id > 0);
+    const LabManager::Hold &h = f.mgr.holds.at(id);
+    CHECK_EQ(h.expiresAt, T0 + LabManager::kHoldTtl);
+    CHECK(f.mgr.nextTimerDue() <= h.expiresAt);
+
+    f.clock->set(T0 + LabManager::kHoldTtl - 1);
+    f.mgr.advanceTimers(f.clock->now());
+    CHECK_EQ(f.mgr.holds.size(), size_t{1});
+
+    f.clock->set(T0 + LabManager::kHoldTtl);
+    f.mgr.advanceTimers(f.clock->now());
+    CHECK(f.mgr.holds.empty());
+    CHECK(f.mgr.holdsByDevice.empty());
+    CHECK(f.mgr.holdsByUser.empty());
+    CHECK(f.mgr.confirmHold(kStudent, id) == LabManager::HoldOutcome::NotFound);
+}
+
+TEST_CASE(confirmBeforeAndAfterExpiry) {
+    Fixture f;
+    int late = f.mgr.hold(kStudent, kPrinter, T0 + 3600, T0 + 7200);
+    REQUIRE(late > 0);
+    // 到期但时间轮尚未推进：按当前时间判断为已到期，不生成预约
+    f.clock->set(T0 + LabManager::kHoldTtl + 1);
+    CHECK(f.mgr.confirmHold(kStudent, late) == LabManager::HoldOutcome::Expired);
+    CHECK_EQ(f.reservationsOn(kPrinter), size_t{0});
+
+    int id = f.mgr.hold(kStudent, kCentrifuge, T0 + 3600, T0 + 7200);
+    REQUIRE(id > 0);
+    CHECK(f.mgr.confirmHold(kTeacher, id) == LabManager::HoldOutcome::NotFound);   // 不是本人的暂留
+    f.clock->set(f.clock->now() + LabManager::kHoldTtl - 1);
+    CHECK(f.mgr.confirmHold(kStudent, id) == LabManager::HoldOutcome::Ok);
+    CHECK_EQ(f.reservationsOn(kCentrifuge), size_t{1});
+    CHECK(f.mgr.holds.find(id) == f.mgr.holds.end());
+    CHECK(f.mgr.confirmHold(kStudent, id) == LabManager::HoldOutcome::NotFound);
+}
+
+TEST_CASE(conflictsWithOtherUsersHold) {
+    Fixture f;
+    int teacherHold = f.mgr.hold(kTeacher, kPrinter, T0 + 3600, T0 + 7200);
+    REQUIRE(teacherHold > 0);
+    // 学生不能覆盖教师的暂留：重叠的暂留、预约都失败，不重叠的时段不受影响
+    CHECK_EQ(f.mgr.hold(kStudent, kPrinter, T0 + 5400, T0 + 9000), 0);
+    CHECK(!f.mgr.reserve(kStudent, kPrinter, T0 + 5400, T0 + 9000));
+    CHECK(f.mgr.hold(kStudent, kPrinter, T0 + 7200, T0 + 9000) > 0);
+    CHECK(!f.mgr.releaseHold(kStudent, teacherHold));
+
+    // 教师放弃后学生可以预约；教师的暂留到期后同样不再阻挡
+    CHECK(f.mgr.releaseHold(kTeacher, teacherHold));
+    CHECK(f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 5400));
+    REQUIRE(f.mgr.hold(kTeacher, kCentrifuge, T0 + 3600, T0 + 7200) > 0);
+    f.clock->set(T0 + LabManager::kHoldTtl);
+    CHECK(f.mgr.reserve(kStudent, kCentrifuge, T0 + 3600, T0 + 7200));
+
+    // 每人同时最多 kMaxHoldsPerUser 个暂留
+    f.clock->set(T0 + 1000);
+    for (int i = 0; i < LabManager::kMaxHoldsPerUser; ++i) {
+        CHECK(f.mgr.hold(kTeacher, kPrinter, T0 + 20000 + i * 1000, T0 + 20500 + i * 1000) > 0);
+    }
+    CHECK_EQ(f.mgr.hold(kTeacher, kPrinter, T0 + 30000, T0 + 30500), 0);
+}
+
+TEST_CASE(deleteDeviceReleasesHolds) {
+    Fixture f;
+    for (int i = 0; i < LabManager::kMaxHoldsPerUser; ++i) {
+        REQUIRE(f.mgr.hold(kStudent, kPrinter, T0 + 3600 + i * 1000, T0 + 4000 + i * 1000) > 0);
+    }
+    int other = f.mgr.hold(kTeacher, kCentrifuge, T0 + 3600, T0 + 7200);
+    REQUIRE(other > 0);
+    REQUIRE(f.mgr.deleteDevice(kPrinter));
+    CHECK_EQ(f.mgr.holds.size(), size_t{1});
+    CHECK(f.mgr.holdsByDevice.count(kPrinter) == 0);
+    CHECK(f.mgr.holdsByUser.count(kStudent) == 0);
+    CHECK(f.mgr.holds.count(other) == 1);
+    // 名额已释放；已删除设备的暂留到期时跳过
+    CHECK(f.mgr.hold(kStudent, kCentrifuge, T0 + 9000, T0 + 9600) > 0);
+    f.clock->set(T0 + LabManager::kHoldTtl);
+    f.mgr.advanceTimers(f.clock->now());
+    CHECK(f.mgr.holds.empty());
+}
+
+TEST_CASE(snapshotRoundTrip) {
+    Fixture f;
+    int a = f.mgr.hold(kStudent, kPrinter, T0 + 3600, T0 + 7200);
+    f.clock->set(T0 + 60);
+    int b = f.mgr.hold(kTeacher, kCentrifuge, T0 + 3600, T0 + 7200);
+    REQUIRE(a > 0 && b > 0);
+    std::string snapshot;
+    writeStateSnapshot(snapshot, f.mgr);
+
+    LabManager copy;
+    copy.clock = f.clock;
+    copy.passwordParams = f.mgr.passwordParams;
+    REQUIRE(loadStateSnapshot(copy, snapshot));
+    REQUIRE(copy.holds.size() == 2);
+    for (int id : {a, b}) {
+        const LabManager::Hold &x = f.mgr.holds.at(id), &y = copy.holds.at(id);
+        CHECK_EQ(y.userId, x.userId);
+        CHECK_EQ(y.deviceId, x.deviceId);
+        CHECK_EQ(y.start, x.start);
+        CHECK_EQ(y.end, x.end);
+        CHECK_EQ(y.expiresAt, x.expiresAt);
+    }
+    CHECK_EQ(copy.nextHoldId, f.mgr.nextHoldId);
+    CHECK_EQ(copy.holdsByUser.at(kStudent).size(), size_t{1});
+
+    // 恢复后暂留照常阻挡冲突、按原到期时刻清除，未到期的仍可确认
+    CHECK(!copy.reserve(kStudent, kCentrifuge, T0 + 3600, T0 + 7200));
+    f.clock->set(T0 + LabManager::kHoldTtl);
+    copy.advanceTimers(f.clock->now());
+    CHECK(copy.holds.count(a) == 0);
+    CHECK(copy.confirmHold(kTeacher, b) == LabManager::HoldOutcome::Ok);
+    CHECK(copy.holds.empty());
+    CHECK_EQ(copy.findDevice(kCentrifuge)->reservations.size(), size_t{1});
+}
+
+int main() { return labtest::runAll(); }
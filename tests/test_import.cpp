@@ -0,0 +1,163 @@
+// 批量导入：CSV 中的预计算哈希（带 / 不带引号）、用户名重复、并行分块后的绝对行号与入库
+#include "Check.h"
+#include "Import.h"
+
+namespace {
+
+const ScryptParams kFast{4, 1, 1};
+
+bool hasError(const ImportBatch &b, size_t line, const std::string &fragment) {
+    for (const auto &e : b.errors) {
+        if (e.line == line && e.message.find(fragment) != std::string::npos) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE(csvPrehashedPasswords) {
+    std::string hash = hashPassword("s3cret", kFast);
+    std::string csv = "kind,type,name,password,allowStudent\n"
+                      "user,student,quoted,\"" + hash + "\",\n"
+                      "user,teacher,unquoted," + hash + ",\n"
+                      "user,admin,plain,123456,\n"
+                      "user,student,broken,$scrypt$ln=4,\n";
+    ImportBatch b = parseImport(csv, 1);
+    REQUIRE(b.users.size() == 2);
+    CHECK_EQ(b.users[0].username, std::string("quoted"));
+    CHECK_EQ(b.users[0].password, hash);
+    CHECK_EQ(b.users[0].line, size_t{2});
+    CHECK_EQ(b.users[1].username, std::string("plain"));
+    // 未加引号的哈希在逗号处被拆开：报告所在行而不是把截断的前缀当作哈希
+    CHECK_EQ(b.errors.size(), size_t{2});
+    CHECK(hasError(b, 3, "口令哈希格式无效"));
+    CHECK(hasError(b, 5, "口令哈希格式无效"));
+
+    // 预计算的哈希原样入库，明文按参数哈希
+    LabManager mgr;
+    mgr.passwordParams = kFast;
+    PreparedImport p = prepareImport(b, mgr.strings, mgr.passwordParams, 1);
+    CHECK_EQ(p.users[0]->passwordHash, hash);
+    CHECK(p.users[1]->passwordHash != "123456");
+    REQUIRE(mgr.insertBulk(p.users, p.devices));
+    CHECK(mgr.authenticate("quoted", "s3cret").has_value());
+    CHECK(mgr.authenticate("plain", "123456").has_value());
+    CHECK(!mgr.authenticate("unquoted", "s3cret").has_value());
+}
+
+TEST_CASE(jsonLinesPrehashed) {
+    std::string hash = hashPassword("pw", kFast);
+    std::string data = "{\"kind\":\"user\",\"type\":\"student\",\"username\":\"j1\",\"password\":\"" + hash + "\"}\n"
+                       "{\"kind\":\"user\",\"type\":0,\"username\":\"j2\",\"password\":\"$scrypt$bad\"}\n"
+                       "{\"kind\":\"device\",\"type\":2,\"name\":\"离心机 Y\",\"allowStudent\":false}\n";
+    ImportBatch b = parseImport(data, 1);
+    REQUIRE(b.users.size() == 1);
+    CHECK_EQ(b.users[0].password, hash);
+    CHECK(hasError(b, 2, "口令哈希格式无效"));
+    REQUIRE(b.devices.size() == 1);
+    CHECK_EQ(b.devices[0].allowStudent, false);
+    CHECK_EQ(b.devices[0].type, DeviceType::Power);
+}
+
+TEST_CASE(duplicateUsernames) {
+    std::string csv = "user,student,dup,1,\n"
+                      "device,power,炉,,\n"
+                      "user,teacher,dup,2,\n"
+                      "user,student,student1,3,\n";
+    ImportBatch b = parseImport(csv, 1);
+    // 批内重复：保留第一次出现，重复的行报错
+    CHECK_EQ(b.errors.size(), size_t{1});
+    CHECK(hasError(b, 3, "用户名在导入文件中重复：dup"));
+
+    // 与已有用户重复：整体不生效并列出重复的用户名
+    LabManager mgr;
+    mgr.passwordParams = kFast;
+    mgr.seed();
+    size_t usersBefore = mgr.usersById.size();
+    size_t devicesBefore = mgr.deviceCount();
+    ImportBatch ok = parseImport("user,student,fresh,1,\nuser,student,student1,3,\ndevice,power,炉,,\n", 1);
+    REQUIRE(ok.errors.empty());
+    PreparedImport p = prepareImport(ok, mgr.strings, mgr.passwordParams, 1);
+    std::vector<std::string> duplicates;
+    CHECK(!mgr.insertBulk(p.users, p.devices, &duplicates));
+    CHECK_EQ(duplicates.size(), size_t{1});
+    if (!duplicates.empty()) CHECK_EQ(duplicates[0], std::string("student1"));
+    CHECK_EQ(mgr.usersById.size(), usersBefore);
+    CHECK_EQ(mgr.deviceCount(), devicesBefore);
+    CHECK(!mgr.findUser("fresh"));
+}
+
+TEST_CASE(chunkBoundaryLineNumbers) {
+    // 约 1 MiB：按 4 线程切成多个分块，错误与记录的行号须为整个文件中的绝对行号，且与单线程解析一致
+    std::string csv = "kind,type,name,password,allowStudent\n";
+    std::vector<size_t> badLines;
+    size_t line = 1;
+    for (int i = 0; i < 20000; ++i) {
+        ++line;
+        if (i % 997 == 0) {
+            csv += "user,nobody,bad" + std::to_string(i) + ",x,\n";
+            badLines.push_back(line);
+        } else if (i % 5 == 0) {
+            csv += "device,precision,显微镜 " + std::to_string(i) + ",,false\n";
+        } else {
+            csv += "user,student,user" + std::to_string(i) + ",p" + std::string(30, 'x') + ",\n";
+        }
+        if (i % 4000 == 1999) { csv += "\n"; ++line; }   // 空行同样计入行号
+    }
+    ++line;
+    csv += "user,student,user1,again,\n";   // 与第 3 行重复
+    REQUIRE(csv.size() > 4 * (64u << 10));
+
+    ImportBatch serial = parseImport(csv, 1);
+    ImportBatch parallel = parseImport(csv, 4);
+    CHECK_EQ(parallel.errors.size(), badLines.size() + 1);
+    for (size_t i = 0; i < badLines.size() && i < parallel.errors.size(); ++i) {
+        CHECK_EQ(parallel.errors[i].line, badLines[i]);
+        CHECK_EQ(parallel.errors[i].message, std::string("用户类型无效"));
+    }
+    CHECK(hasError(parallel, line, "用户名在导入文件中重复：user1"));
+    REQUIRE(serial.users.size() == parallel.users.size());
+    REQUIRE(serial.devices.size() == parallel.devices.size());
+    REQUIRE(serial.errors.size() == parallel.errors.size());
+    bool same = true;
+    for (size_t i = 0; i < serial.users.size(); ++i) {
+        same = same && serial.users[i].line == parallel.users[i].line && serial.users[i].username == parallel.users[i].username;
+    }
+    for (size_t i = 0; i < serial.devices.size(); ++i) same = same && serial.devices[i].line == parallel.devices[i].line;
+    for (size_t i = 0; i < serial.errors.size(); ++i) same = same && serial.errors[i].line == parallel.errors[i].line;
+    CHECK(same);
+    // 第 3 行即 i = 1 的用户
+    CHECK_EQ(parallel.users.front().line, size_t{3});
+    CHECK_EQ(parallel.users.front().username, std::string("user1"));
+}
+
+TEST_CASE(logPayloadCarriesHashes) {
+    // 写入日志的负载：口令为已计算的哈希，名称中的逗号、引号与首尾空白原样往返
+    std::string data = "{\"kind\":\"user\",\"type\":\"teacher\",\"username\":\" bob\",\"password\":\"plain-secret\"}\n"
+                       "{\"kind\":\"device\",\"type\":\"power\",\"name\":\"炉, \\\"B\\\" \",\"allowStudent\":false}\n"
+                       "{\"kind\":\"user\",\"type\":0,\"username\":\"amy\",\"password\":\"123456\"}\n";
+    ImportBatch b = parseImport(data, 1);
+    REQUIRE(b.errors.empty());
+    StringPool strings;
+    PreparedImport p = prepareImport(b, strings, kFast, 1);
+    std::string payload = importLogPayload(p);
+    CHECK_EQ(payload.find("plain-secret"), std::string::npos);
+
+    ImportBatch again = parseImport(payload, 1);
+    REQUIRE(again.errors.empty());
+    REQUIRE(again.users.size() == 2);
+    REQUIRE(again.devices.size() == 1);
+    PreparedImport q = prepareImport(again, strings, ScryptParams{5, 2, 1}, 1);   // 与参数无关：不再计算哈希
+    for (size_t i = 0; i < q.users.size(); ++i) {
+        CHECK_EQ(std::string(q.users[i]->username), std::string(p.users[i]->username));
+        CHECK_EQ(q.users[i]->passwordHash, p.users[i]->passwordHash);
+        CHECK_EQ(q.users[i]->type, p.users[i]->type);
+    }
+    CHECK_EQ(std::string(q.users[0]->username), std::string(" bob"));
+    CHECK(verifyPasswordHash("plain-secret", q.users[0]->passwordHash));
+    CHECK_EQ(std::string(q.devices[0]->name), std::string("炉, \"B\" "));
+    CHECK_EQ(q.devices[0]->type, DeviceType::Power);
+    CHECK_EQ(q.devices[0]->allowStudentReserve, false);
+}
+
+int main() { return labtest::runAll(); }
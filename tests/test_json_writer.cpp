@@ -0,0 +1,90 @@
+// 流式 JSON 写入器：嵌套到 kMaxDepth 层的对象 / 数组、需要转义的合法 UTF-8 字符串、整数边界与浮点数，
+// 输出与 nlohmann::json::dump() 逐字节一致
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "Check.h"
+#include "JsonWriter.h"
+#include "json.hpp"
+
+using nlohmann::json;
+
+TEST_CASE(nestingUpToMaxDepth) {
+    // 交替嵌套对象与数组共 32 层，每层都有多个元素（逗号位必须按层独立记录）
+    constexpr int kDepth = 32;
+    std::string out;
+    JsonWriter w(out);
+    json expected = json::array({kDepth});
+    for (int d = kDepth - 1; d >= 1; --d) {
+        expected = d % 2 ? json{{"a", d}, {"b", expected}, {"c", true}} : json::array({d, expected, false});
+    }
+    for (int d = 1; d < kDepth; ++d) {
+        if (d % 2) {
+            w.beginObject();
+            w.field("a", d);
+            w.key("b");
+        } else {
+            w.beginArray();
+            w.value(d);
+        }
+    }
+    w.beginArray();
+    w.value(kDepth);
+    w.endArray();
+    for (int d = kDepth - 1; d >= 1; --d) {
+        if (d % 2) {
+            w.field("c", true);
+            w.endObject();
+        } else {
+            w.value(false);
+            w.endArray();
+        }
+    }
+    CHECK_EQ(out, expected.dump());
+
+    // 同一个写入器接着写下一个顶层值：层级已全部退出
+    out.clear();
+    w.beginArray();
+    w.beginObject();
+    w.endObject();
+    w.beginArray();
+    w.endArray();
+    w.endArray();
+    CHECK_EQ(out, std::string("[{},[]]"));
+}
+
+TEST_CASE(stringsMatchDump) {
+    const char *samples[] = {
+        "", "plain", "引号\"与反斜杠\\", "换行\n回车\r制表\t退格\b换页\f", "控制\x01\x1f\x7f字符",
+        "3D打印机 A", "emoji 🧪", "路径/C:/lab", "\xE2\x80\xA8 行分隔符",
+    };
+    for (const char *s : samples) {
+        std::string out;
+        JsonWriter w(out);
+        w.value(s);
+        if (!CHECK_EQ(out, json(s).dump())) std::printf("  sample: \"%s\"\n", s);
+    }
+    // 内嵌 NUL 按长度写出
+    std::string withNul("a\0b", 3);
+    std::string out;
+    JsonWriter(out).value(withNul);
+    CHECK_EQ(out, json(withNul).dump());
+}
+
+TEST_CASE(numbersMatchDump) {
+    for (long long v : {0LL, 1LL, -1LL, 1700000000LL, static_cast<long long>(INT_MIN), LLONG_MAX, LLONG_MIN}) {
+        std::string out;
+        JsonWriter(out).value(v);
+        CHECK_EQ(out, json(v).dump());
+    }
+    for (double v : {0.0, -0.0, 0.1, 1.0 / 3, 1e300, -2.5e-308, 99.99, 100.0,
+                     std::numeric_limits<double>::infinity(), std::nan("")}) {
+        std::string out;
+        JsonWriter(out).value(v);
+        CHECK_EQ(out, json(v).dump());
+    }
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,288 @@
+// 共识复制：进程内的 3 节点集群（各节点独立的 LabManager、时钟与数据目录，经本机端口通信）。
+// 覆盖选举、提交后在跟随者上可见、主节点宕机后重新选举、任期变更后跟随者截断冲突日志、
+// 落后节点安装快照，以及无法提交时 propose 超时抛出 RaftUnavailable
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+
+#include "ApiJson.h"
+#include "Check.h"
+#include "Raft.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 取得 n 个当前空闲的本机端口：同时占住再一起释放，避免重复。
+// 须经 listen / stop 关闭监听套接字（只绑定不监听的 Server 析构时不关闭，端口复用时会分走连接）
+std::vector<int> freePorts(size_t n) {
+    std::vector<std::unique_ptr<httplib::Server>> holders;
+    std::vector<std::thread> threads;
+    std::vector<int> ports;
+    for (size_t i = 0; i < n; ++i) {
+        holders.push_back(std::make_unique<httplib::Server>());
+        httplib::Server &svr = *holders.back();
+        ports.push_back(svr.bind_to_any_port("127.0.0.1"));
+        threads.emplace_back([&svr] { svr.listen_after_bind(); });
+        svr.wait_until_ready();
+    }
+    for (auto &h : holders) h->stop();
+    for (auto &t : threads) t.join();
+    return ports;
+}
+
+bool waitUntil(const std::function<bool()> &cond, int seconds = 10) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// 一个节点：重启时整体重建 LabManager 与 RaftNode，状态由数据目录中的快照与日志恢复
+struct Node {
+    RaftOptions options;
+    std::unique_ptr<LabManager> mgr;
+    std::shared_ptr<PinnableClock> clock;
+    std::unique_ptr<RaftNode> raft;
+
+    bool start() {
+        mgr = std::make_unique<LabManager>();
+        clock = std::make_shared<PinnableClock>();
+        mgr->clock = clock;
+        raft = std::make_unique<RaftNode>(*mgr, *clock, options);
+        return raft->start();
+    }
+    void stop() {
+        raft.reset();
+        mgr.reset();
+    }
+    bool up() const { return raft != nullptr; }
+    RaftStatus status() const { return raft->status(); }
+
+    bool hasDevice(const std::string &name) const {
+        std::string out;
+        std::shared_lock<std::shared_mutex> lock(mgr->mutex);
+        writeDevicesResponse(out, *mgr, 0);
+        return out.find("\"" + name + "\"") != std::string::npos;
+    }
+    size_t devices() const {
+        std::shared_lock<std::shared_mutex> lock(mgr->mutex);
+        return mgr->deviceCount();
+    }
+};
+
+struct Cluster {
+    fs::path dir;
+    std::vector<Node> nodes;
+
+    explicit Cluster(const char *name, std::uint64_t snapshotEvery = 10000) {
+        dir = fs::temp_directory_path() / ("lab_raft_" + std::to_string(getpid()) + "_" + name);
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        std::vector<int> ports = freePorts(3);
+        std::vector<ShardEndpoint> peers;
+        for (int port : ports) peers.push_back({"127.0.0.1", port});
+        nodes.resize(3);
+        for (int i = 0; i < 3; ++i) {
+            RaftOptions &o = nodes[i].options;
+            o.id = i;
+            o.peers = peers;
+            o.dataDir = (dir / ("node" + std::to_string(i))).string();
+            o.apiAddress = "127.0.0.1:" + std::to_string(9000 + i);
+            o.electionTimeoutMs = 200;
+            o.heartbeatMs = 40;
+            o.commitTimeoutMs = 300;
+            o.snapshotEvery = snapshotEvery;
+            o.fsync = false;
+        }
+    }
+    ~Cluster() {
+        for (auto &n : nodes) n.stop();
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+    }
+
+    bool startAll() {
+        bool ok = true;
+        for (auto &n : nodes) ok = n.start() && ok;
+        return ok;
+    }
+
+    // 运行中的节点里恰有一个主节点且其余节点都已认它时返回其序号，否则返回 -1
+    int leader() const {
+        int found = -1;
+        std::uint64_t term = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (!nodes[i].up()) continue;
+            RaftStatus s = nodes[i].status();
+            if (s.role != RaftRole::Leader) continue;
+            if (found >= 0) return -1;
+            found = static_cast<int>(i);
+            term = s.term;
+        }
+        if (found < 0) return -1;
+        for (const auto &n : nodes) {
+            if (!n.up()) continue;
+            RaftStatus s = n.status();
+            if (s.term != term || s.leaderId != found) return -1;
+        }
+        return found;
+    }
+    int waitLeader() {
+        int id = -1;
+        waitUntil([&] { return (id = leader()) >= 0; });
+        return id;
+    }
+
+    // 在主节点上提交新增设备：主节点执行闭包，其余节点按日志重放同一请求体
+    void addDevice(int leaderId, const std::string &name) {
+        std::string body = R"({"type":1,"name":")" + name + R"(","allowStudent":true})";
+        nodes[leaderId].raft->propose(TraceRoute::AdminAdd, 0, body, [name](LabManager &m) {
+            m.addDevice(DeviceType::Precision, name, true);
+        });
+    }
+
+    // 运行中的节点都已应用到 index
+    bool waitApplied(std::uint64_t index) {
+        return waitUntil([&] {
+            for (const auto &n : nodes) {
+                if (n.up() && n.status().lastApplied < index) return false;
+            }
+            return true;
+        });
+    }
+};
+
+} // namespace
+
+TEST_CASE(electionAndReplication) {
+    Cluster c("basic");
+    REQUIRE(c.startAll());
+    int leader = c.waitLeader();
+    REQUIRE(leader >= 0);
+    CHECK(c.nodes[leader].status().term >= 1);
+
+    for (int i = 0; i < 5; ++i) c.addDevice(leader, "设备 " + std::to_string(i));
+    std::uint64_t committed = c.nodes[leader].status().commitIndex;
+    REQUIRE(c.waitApplied(committed));
+    size_t expected = c.nodes[leader].devices();
+    for (const auto &n : c.nodes) {
+        CHECK_EQ(n.devices(), expected);
+        CHECK(n.hasDevice("设备 4"));
+        CHECK_EQ(n.status().commitIndex, committed);
+    }
+}
+
+TEST_CASE(leaderFailover) {
+    Cluster c("failover");
+    REQUIRE(c.startAll());
+    int old = c.waitLeader();
+    REQUIRE(old >= 0);
+    c.addDevice(old, "宕机前");
+    std::uint64_t oldTerm = c.nodes[old].status().term;
+
+    c.nodes[old].stop();
+    int leader = c.waitLeader();
+    REQUIRE(leader >= 0);
+    CHECK(leader != old);
+    CHECK(c.nodes[leader].status().term > oldTerm);
+
+    // 新主节点保留已提交的修改并继续接受新修改
+    c.addDevice(leader, "宕机后");
+    REQUIRE(c.waitApplied(c.nodes[leader].status().commitIndex));
+    for (const auto &n : c.nodes) {
+        if (!n.up()) continue;
+        CHECK(n.hasDevice("宕机前"));
+        CHECK(n.hasDevice("宕机后"));
+    }
+
+    // 原主节点重启后作为跟随者追平
+    REQUIRE(c.nodes[old].start());
+    REQUIRE(c.waitApplied(c.nodes[leader].status().commitIndex));
+    CHECK(c.nodes[old].hasDevice("宕机后"));
+    CHECK(c.nodes[old].status().role == RaftRole::Follower);
+}
+
+TEST_CASE(proposeTimeoutAndLogTruncation) {
+    Cluster c("truncate");
+    REQUIRE(c.startAll());
+    int old = c.waitLeader();
+    REQUIRE(old >= 0);
+    c.addDevice(old, "已提交");
+    REQUIRE(c.waitApplied(c.nodes[old].status().commitIndex));
+
+    // 隔离主节点：其余两个节点停止，新条目只写入主节点本地，等待提交超时
+    std::vector<int> others;
+    for (int i = 0; i < 3; ++i) if (i != old) others.push_back(i);
+    for (int i : others) c.nodes[i].stop();
+    std::uint64_t before = c.nodes[old].status().lastIndex;
+    bool unavailable = false;
+    try {
+        c.addDevice(old, "未提交");
+    } catch (const RaftUnavailable &) {
+        unavailable = true;
+    }
+    CHECK(unavailable);
+    std::uint64_t orphan = c.nodes[old].status().lastIndex;
+    CHECK_EQ(orphan, before + 1);
+    CHECK(!c.nodes[old].hasDevice("未提交"));
+
+    // 原主节点下线期间，另外两个节点在更高任期中在同一位置提交不同的条目
+    c.nodes[old].stop();
+    for (int i : others) REQUIRE(c.nodes[i].start());
+    int leader = c.waitLeader();
+    REQUIRE(leader >= 0);
+    c.addDevice(leader, "新任期 1");
+    c.addDevice(leader, "新任期 2");
+    REQUIRE(c.nodes[leader].status().lastIndex >= orphan);
+
+    // 原主节点重启：冲突的条目被截断并替换为新主节点的日志（其最后条目的任期较旧，不会当选）
+    REQUIRE(c.nodes[old].start());
+    REQUIRE(c.waitApplied(c.nodes[leader].status().commitIndex));
+    leader = c.waitLeader();
+    REQUIRE(leader >= 0);
+    CHECK(leader != old);
+    for (const auto &n : c.nodes) {
+        CHECK(n.hasDevice("已提交"));
+        CHECK(n.hasDevice("新任期 2"));
+        CHECK(!n.hasDevice("未提交"));
+    }
+    CHECK_EQ(c.nodes[old].devices(), c.nodes[leader].devices());
+}
+
+TEST_CASE(laggingNodeInstallsSnapshot) {
+    Cluster c("snapshot", 20);
+    REQUIRE(c.startAll());
+    int leader = c.waitLeader();
+    REQUIRE(leader >= 0);
+    int lagging = (leader + 1) % 3;
+    c.addDevice(leader, "快照前");
+    REQUIRE(c.waitApplied(c.nodes[leader].status().commitIndex));
+    c.nodes[lagging].stop();
+
+    // 落后期间主节点生成快照并截断日志，落后节点所需的条目已不在日志中
+    for (int i = 0; i < 60; ++i) c.addDevice(leader, "批量 " + std::to_string(i));
+    REQUIRE(waitUntil([&] { return c.nodes[leader].status().snapshotIndex >= 40; }));
+
+    REQUIRE(c.nodes[lagging].start());
+    REQUIRE(c.waitApplied(c.nodes[leader].status().commitIndex));
+    RaftStatus s = c.nodes[lagging].status();
+    CHECK(s.snapshotIndex >= 40);
+    CHECK_EQ(c.nodes[lagging].devices(), c.nodes[leader].devices());
+    CHECK(c.nodes[lagging].hasDevice("快照前"));
+    CHECK(c.nodes[lagging].hasDevice("批量 59"));
+}
+
+int main() { return labtest::runAll(); }
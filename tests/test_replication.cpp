@@ -0,0 +1,203 @@
+// 主从复制：副本持续追平主节点；主节点生成快照并截断日志后，在线副本继续拉取，
+// 新加入的副本先安装快照再追平；导入的口令以哈希形式到达副本；快照中超出计数器的ID被拒绝
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "ApiJson.h"
+#include "Check.h"
+#include "Server.h"
+#include "StateSnapshot.h"
+#include "json.hpp"
+
+namespace {
+
+const ScryptParams kFast{4, 1, 1};
+
+ServerOptions baseOptions() {
+    ServerOptions o;
+    o.serveStatic = false;
+    o.compactInterval = 0;
+    o.timers = false;
+    o.verifyThreads = 1;
+    o.replicationSnapshotEvery = 1u << 30;   // 只在测试中手动生成快照
+    return o;
+}
+
+// 主节点：在任意空闲端口上提供业务接口与复制日志
+struct Primary {
+    LabManager mgr;
+    std::unique_ptr<ApiServer> server;
+    std::thread serving;
+    std::unique_ptr<httplib::Client> cli;
+
+    Primary() {
+        mgr.passwordParams = kFast;
+        mgr.seed();
+        ServerOptions o = baseOptions();
+        o.replicationPort = 0;
+        server = std::make_unique<ApiServer>(mgr, o);
+        int port = server->bindToAnyPort("127.0.0.1");
+        serving = std::thread([this] { server->listenAfterBind(); });
+        while (!server->http.is_running()) std::this_thread::yield();
+        cli = std::make_unique<httplib::Client>("127.0.0.1", port);
+    }
+    ~Primary() {
+        server->stop();
+        serving.join();
+    }
+
+    std::string login(const std::string &username) {
+        auto res = cli->Post("/api/login", R"({"username":")" + username + R"(","password":"123456"})", "application/json");
+        if (!res || res->status != 200) return std::string();
+        return nlohmann::json::parse(res->body).value("token", std::string());
+    }
+    int post(const std::string &path, const std::string &token, const std::string &body, const char *type = "application/json") {
+        auto res = cli->Post(path, {{"Authorization", "Bearer " + token}}, body, type);
+        return res ? res->status : -1;
+    }
+    int replicationPort() const { return server->replicationLog->port(); }
+    std::uint64_t lastSeq() const { return server->replicationLog->lastSeq(); }
+};
+
+// 副本：不对外提供接口，只运行拉取线程
+struct Replica {
+    LabManager mgr;
+    std::unique_ptr<ApiServer> server;
+
+    explicit Replica(int primaryPort) {
+        mgr.passwordParams = kFast;
+        mgr.seed();
+        ServerOptions o = baseOptions();
+        o.replicaHost = "127.0.0.1";
+        o.replicaPort = primaryPort;
+        server = std::make_unique<ApiServer>(mgr, o);
+    }
+    bool waitFor(std::uint64_t seq) const {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (server->replica->status().appliedSeq < seq) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+};
+
+// 在同一时刻下比较设备列表（含预约）与用户数
+bool sameState(LabManager &a, LabManager &b) {
+    std::time_t at = std::time(nullptr);
+    std::string x, y;
+    size_t usersA, usersB;
+    {
+        std::shared_lock<std::shared_mutex> lock(a.mutex);
+        writeDevicesResponse(x, a, at);
+        usersA = a.usersById.size();
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(b.mutex);
+        writeDevicesResponse(y, b, at);
+        usersB = b.usersById.size();
+    }
+    if (x != y) std::fprintf(stderr, "  设备列表不一致：\n  %s\n  %s\n", x.c_str(), y.c_str());
+    return x == y && usersA == usersB;
+}
+
+std::string reserveBody(int deviceId, std::time_t start, std::time_t end) {
+    return "{\"deviceId\":" + std::to_string(deviceId) + ",\"startTime\":" + std::to_string(start) +
+           ",\"endTime\":" + std::to_string(end) + "}";
+}
+
+} // namespace
+
+TEST_CASE(catchUpAcrossSnapshot) {
+    Primary primary;
+    std::string admin = primary.login("admin1");
+    std::string student = primary.login("student1");
+    REQUIRE(!admin.empty() && !student.empty());
+    REQUIRE(primary.replicationPort() > 0);
+
+    Replica early(primary.replicationPort());
+    std::time_t day = std::time(nullptr) + 86400;
+    for (int i = 0; i < 3; ++i) {
+        CHECK_EQ(primary.post("/api/admin/add", admin, R"({"type":1,"name":"显微镜 R)" + std::to_string(i) + R"(","allowStudent":true})"), 200);
+    }
+    CHECK_EQ(primary.post("/api/reserve", student, reserveBody(1, day, day + 3600)), 200);
+    CHECK_EQ(primary.post("/api/reserve", student, reserveBody(2, day + 7200, day + 9000)), 200);
+    CHECK_EQ(primary.post("/api/admin/import", admin, "user,student,imported,pw-imported,\ndevice,power,炉 R,,false\n", "text/csv"), 200);
+
+    REQUIRE(early.waitFor(primary.lastSeq()));
+    CHECK(sameState(primary.mgr, early.mgr));
+
+    // 在线副本已收到全部日志：快照覆盖的帧全部丢弃
+    std::uint64_t atSnapshot = primary.lastSeq();
+    primary.server->snapshotReplicationLog();
+    CHECK_EQ(primary.server->replicationLog->snapshotSeq(), atSnapshot);
+    CHECK_EQ(primary.server->replicationLog->firstSeq(), atSnapshot + 1);
+
+    // 截断之后继续修改：在线副本照常追平
+    CHECK_EQ(primary.post("/api/reserve", student, reserveBody(3, day + 20000, day + 21000)), 200);
+    CHECK_EQ(primary.post("/api/admin/add", admin, R"({"type":0,"name":"打印机 R","allowStudent":true})"), 200);
+    REQUIRE(early.waitFor(primary.lastSeq()));
+    CHECK(sameState(primary.mgr, early.mgr));
+
+    // 新副本的起点已被丢弃：安装快照后从快照之后继续
+    Replica late(primary.replicationPort());
+    REQUIRE(late.waitFor(primary.lastSeq()));
+    CHECK(sameState(primary.mgr, late.mgr));
+    CHECK_EQ(late.server->replica->status().appliedSeq, primary.lastSeq());
+
+    // 导入的口令：在线副本经日志负载、新副本经快照得到同一个哈希
+    auto hashOf = [](LabManager &m) {
+        std::shared_lock<std::shared_mutex> lock(m.mutex);
+        auto u = m.findUser("imported");
+        return u ? u->passwordHash : std::string();
+    };
+    std::string hash = hashOf(primary.mgr);
+    CHECK(verifyPasswordHash("pw-imported", hash));
+    CHECK_EQ(hashOf(early.mgr), hash);
+    CHECK_EQ(hashOf(late.mgr), hash);
+}
+
+// 反复安装同一快照：用户名经驻留复用，字符串池不随安装次数增长
+TEST_CASE(repeatedInstallsReuseStrings) {
+    LabManager primary;
+    primary.passwordParams = kFast;
+    primary.seed();
+    std::string snapshot;
+    writeStateSnapshot(snapshot, primary);
+
+    LabManager replica;
+    replica.passwordParams = kFast;
+    replica.seed();
+    REQUIRE(loadStateSnapshot(replica, snapshot));
+    size_t bytes = replica.strings.bytes(), size = replica.strings.size();
+    for (int i = 0; i < 5000; ++i) REQUIRE(loadStateSnapshot(replica, snapshot));   // 复制用户名时会超出一个 64 KiB 的块
+    CHECK_EQ(replica.strings.bytes(), bytes);
+    CHECK_EQ(replica.strings.size(), size);
+    CHECK(replica.findUser("student1") != nullptr);
+}
+
+// 用户 / 设备ID不小于快照里的计数器时整个快照被拒绝，副本保持原状（索引按最大ID开辟，不接受任意大的ID）
+TEST_CASE(rejectsIdsBeyondCounters) {
+    LabManager primary;
+    primary.passwordParams = kFast;
+    primary.seed();
+    std::string snapshot;
+    writeStateSnapshot(snapshot, primary);
+
+    LabManager replica;
+    replica.passwordParams = kFast;
+    replica.seed();
+    for (const char *table : {"users", "devices"}) {
+        nlohmann::json doc = nlohmann::json::parse(snapshot);
+        doc[table][0][0] = 1 << 30;
+        CHECK(!loadStateSnapshot(replica, doc.dump()));
+        doc[table][0][0] = table[0] == 'u' ? primary.nextUserId.load() : primary.nextDeviceId.load();
+        CHECK(!loadStateSnapshot(replica, doc.dump()));
+    }
+    CHECK_EQ(replica.usersById.size(), primary.usersById.size());
+    CHECK(replica.findUser("student1") != nullptr);
+    CHECK(loadStateSnapshot(replica, snapshot));
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,84 @@
+// 请求解码：各类输入对应的结构化错误码与出错字段
+#include "Check.h"
+#include "RequestDecoder.h"
+
+namespace {
+
+struct Row {
+    const char *body;
+    FieldMask required;
+    DecodeError error;
+    Field field;
+};
+
+const FieldMask kReserve = Field::DeviceId | Field::StartTime | Field::EndTime;
+
+} // namespace
+
+TEST_CASE(errorCodes) {
+    const Row rows[] = {
+        {R"({"deviceId":3,"startTime":100,"endTime":200})", kReserve, DecodeError::None, Field::None},
+        {R"({"deviceId":3,"startTime":100})", kReserve, DecodeError::MissingField, Field::EndTime},
+        {R"({})", kReserve, DecodeError::MissingField, Field::DeviceId},
+        {R"({"deviceId":"3","startTime":100,"endTime":200})", kReserve, DecodeError::WrongType, Field::DeviceId},
+        {R"({"deviceId":null})", kReserve, DecodeError::WrongType, Field::DeviceId},
+        {R"({"deviceId":true})", kReserve, DecodeError::WrongType, Field::DeviceId},
+        {R"({"deviceId":{"id":3}})", kReserve, DecodeError::WrongType, Field::DeviceId},
+        {R"({"deviceId":[3]})", kReserve, DecodeError::WrongType, Field::DeviceId},
+        {R"({"name":5})", static_cast<FieldMask>(Field::Name), DecodeError::WrongType, Field::Name},
+        {R"({"allowStudent":1})", 0, DecodeError::WrongType, Field::AllowStudent},
+        {R"({"deviceId":1.5})", static_cast<FieldMask>(Field::DeviceId), DecodeError::WrongType, Field::DeviceId},
+        {R"({"startTime":-0.25})", 0, DecodeError::WrongType, Field::StartTime},
+        {R"({"deviceId":1e300})", 0, DecodeError::WrongType, Field::DeviceId},
+        {R"({"appId":18446744073709551615})", 0, DecodeError::WrongType, Field::AppId},
+        {R"({"appId":9223372036854775808})", 0, DecodeError::WrongType, Field::AppId},
+        // ID 超出 int 范围：不交给调用方收窄（4294967297 收窄后是 1）
+        {R"({"deviceId":4294967297})", 0, DecodeError::InvalidValue, Field::DeviceId},
+        {R"({"appId":2147483648})", 0, DecodeError::InvalidValue, Field::AppId},
+        {R"({"holdId":-2147483649})", 0, DecodeError::InvalidValue, Field::HoldId},
+        {R"({"userId":1e12})", 0, DecodeError::InvalidValue, Field::UserId},
+        {R"({"startTime":4294967297,"deviceId":2147483647})", 0, DecodeError::None, Field::None},
+        // 未识别的键与嵌套值中超出范围的数不取值
+        {R"({"extra":1e300,"big":18446744073709551615,"deviceId":3})", 0, DecodeError::None, Field::None},
+        {R"({"nested":{"deviceId":-1e300},"list":[1e300,-1e300]})", 0, DecodeError::None, Field::None},
+        {R"([1,2])", 0, DecodeError::NotObject, Field::None},
+        {R"(42)", 0, DecodeError::NotObject, Field::None},
+        {R"(1e300)", 0, DecodeError::NotObject, Field::None},
+        {R"("text")", 0, DecodeError::NotObject, Field::None},
+        {R"(null)", 0, DecodeError::NotObject, Field::None},
+        {R"({"deviceId":3)", 0, DecodeError::Malformed, Field::None},
+        {R"({deviceId:3})", 0, DecodeError::Malformed, Field::None},
+        {"", 0, DecodeError::Malformed, Field::None},
+        // 未知键与嵌套结构中的同名键不参与解码
+        {R"({"extra":{"deviceId":"x"},"list":[null,"a"],"deviceId":7})", static_cast<FieldMask>(Field::DeviceId), DecodeError::None, Field::None},
+    };
+    for (const auto &row : rows) {
+        DecodedRequest out;
+        DecodeResult r = decodeRequest(row.body, out, row.required);
+        if (!CHECK_EQ(r.error, row.error) || !CHECK_EQ(r.field, row.field)) std::fprintf(stderr, "  请求体: %s\n", row.body);
+    }
+}
+
+TEST_CASE(values) {
+    DecodedRequest out;
+    DecodeResult r = decodeRequest(R"({"userId":1,"deviceId":2147483647,"startTime":1e3,"endTime":9223372036854775807,"allowStudent":false,"reason":"实验","holdId":4})", out);
+    REQUIRE(r.ok());
+    CHECK_EQ(out.userId, 1);
+    CHECK_EQ(out.deviceId, 2147483647LL);
+    CHECK_EQ(out.startTime, 1000);   // 整数值的浮点数按整数接受
+    CHECK_EQ(out.endTime, 9223372036854775807LL);
+    CHECK_EQ(out.allowStudent, false);
+    CHECK_EQ(out.reason, std::string("实验"));
+    CHECK_EQ(out.holdId, 4);
+    CHECK(out.has(Field::HoldId));
+    CHECK(!out.has(Field::AppId));
+}
+
+TEST_CASE(names) {
+    CHECK_EQ(std::string(decodeErrorName(DecodeError::WrongType)), std::string("wrong_type"));
+    CHECK_EQ(std::string(decodeErrorName(DecodeError::MissingField)), std::string("missing_field"));
+    CHECK_EQ(std::string(fieldName(Field::StartTime)), std::string("startTime"));
+    CHECK_EQ(std::string(fieldName(Field::HoldId)), std::string("holdId"));
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,117 @@
+// 用户预约索引：预约（含教师抢占学生）、借用归还、压缩归档、删除设备与状态快照恢复之后，
+// reservationsByUser 与遍历全部设备得到的结果一致，userReservations 与按设备筛选的结果一致
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "Check.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr std::time_t T0 = 1700000000;
+constexpr int kStudent = 1, kTeacher = 2;
+constexpr int kPrinter = 1, kMicroscope = 2, kCentrifuge = 3, kIncubator = 5;
+
+using Refs = std::map<int, std::vector<std::pair<int, std::time_t>>>;   // 用户ID -> 排序后的（设备ID, 开始时间）
+
+Refs fromIndex(const LabManager &mgr) {
+    Refs out;
+    for (const auto &entry : mgr.reservationsByUser) {
+        if (entry.second.empty()) continue;
+        auto &list = out[entry.first];
+        for (const auto &ref : entry.second) list.emplace_back(ref.deviceId, ref.start);
+        std::sort(list.begin(), list.end());
+    }
+    return out;
+}
+
+Refs fromScan(const LabManager &mgr) {
+    Refs out;
+    for (const auto &slot : mgr.devicesById) {
+        for (const auto &r : slot.value->reservations) out[r.userId].emplace_back(slot.id, r.startTime);
+    }
+    for (auto &entry : out) std::sort(entry.second.begin(), entry.second.end());
+    return out;
+}
+
+// 按设备遍历得到的“我的预约”：（开始时间, 设备ID, 结束时间, 借出）
+std::vector<std::tuple<std::time_t, int, std::time_t, bool>> scanUser(const LabManager &mgr, int userId, std::time_t now) {
+    std::vector<std::tuple<std::time_t, int, std::time_t, bool>> out;
+    for (const auto &slot : mgr.devicesById) {
+        for (const auto &r : slot.value->reservations) {
+            if (r.userId == userId && (r.borrowed || r.endTime > now)) out.emplace_back(r.startTime, slot.id, r.endTime, r.borrowed);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+bool consistent(const LabManager &mgr, std::time_t now) {
+    if (!CHECK(fromIndex(mgr) == fromScan(mgr))) return false;
+    for (int userId : {kStudent, kTeacher, 3}) {
+        std::vector<std::tuple<std::time_t, int, std::time_t, bool>> listed;
+        for (const auto &b : mgr.userReservations(userId, now)) {
+            listed.emplace_back(b.reservation.startTime, b.deviceId, b.reservation.endTime, b.reservation.borrowed);
+        }
+        if (!CHECK(listed == scanUser(mgr, userId, now))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE(indexMatchesFullScan) {
+    LabManager mgr;
+    auto clock = std::make_shared<ManualClock>(T0);
+    mgr.clock = clock;
+    mgr.passwordParams = ScryptParams{4, 1, 1};
+    mgr.seed();
+
+    REQUIRE(mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));
+    REQUIRE(mgr.reserve(kStudent, kPrinter, T0 + 10000, T0 + 11000));
+    REQUIRE(mgr.reserve(kStudent, kCentrifuge, T0 + 3600, T0 + 5400));
+    REQUIRE(mgr.reserve(kStudent, kIncubator, T0 + 600, T0 + 1200));
+    REQUIRE(mgr.reserve(kTeacher, kMicroscope, T0 + 20000, T0 + 21000));
+    CHECK(consistent(mgr, clock->now()));
+
+    // 教师抢占学生重叠的预约：被移除的条目同时移出学生的索引
+    REQUIRE(mgr.reserve(kTeacher, kPrinter, T0 + 3000, T0 + 4000));
+    CHECK_EQ(mgr.findDevice(kPrinter)->reservations.size(), size_t{2});
+    CHECK_EQ(mgr.userReservations(kStudent, clock->now()).size(), size_t{3});
+    CHECK(consistent(mgr, clock->now()));
+
+    // 压缩：爽约的培养箱预约归档
+    clock->set(T0 + 2000);
+    CHECK_EQ(mgr.compactReservations(clock->now()), size_t{1});
+    CHECK(consistent(mgr, clock->now()));
+
+    // 借用后在借出期间与归还之后
+    clock->set(T0 + 3700);
+    REQUIRE(mgr.borrow(kStudent, kCentrifuge, clock->now()));
+    CHECK(consistent(mgr, clock->now()));
+    clock->set(T0 + 4500);
+    REQUIRE(mgr.returnDevice(kStudent, kCentrifuge, clock->now()));
+    CHECK(consistent(mgr, clock->now()));
+
+    // 删除设备：其上的预约（教师已结束的与学生未开始的）一并移出索引
+    REQUIRE(mgr.deleteDevice(kPrinter));
+    CHECK(consistent(mgr, clock->now()));
+    CHECK(mgr.userReservations(kStudent, clock->now()).empty());
+
+    // 快照恢复后重建的索引与原节点一致
+    REQUIRE(mgr.reserve(kStudent, kCentrifuge, T0 + 30000, T0 + 31000));
+    std::string snapshot;
+    writeStateSnapshot(snapshot, mgr);
+    LabManager copy;
+    copy.clock = clock;
+    copy.passwordParams = mgr.passwordParams;
+    REQUIRE(loadStateSnapshot(copy, snapshot));
+    CHECK(fromIndex(copy) == fromIndex(mgr));
+    CHECK(consistent(copy, clock->now()));
+    CHECK_EQ(copy.userReservations(kStudent, clock->now()).size(), size_t{1});
+    CHECK_EQ(copy.userReservations(kTeacher, clock->now()).size(), size_t{1});
+}
+
+int main() { return labtest::runAll(); }
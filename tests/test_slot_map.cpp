@@ -0,0 +1,118 @@
+// 按ID索引的槽映射：插入 / 替换 / 查找 / 删除，删除后旧ID不再命中、空出的槽由下一次插入复用，
+// 同一ID删除后重新插入，遍历跳过空闲槽，以及与 std::map 对照的随机操作序列
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "SlotMap.h"
+
+namespace {
+
+struct Item {
+    int tag;
+};
+
+std::shared_ptr<Item> item(int tag) { return std::make_shared<Item>(Item{tag}); }
+
+// 按遍历顺序（即槽号顺序）列出的ID
+std::vector<int> idsInSlotOrder(const SlotMap<Item> &map) {
+    std::vector<int> out;
+    for (const auto &slot : map) out.push_back(slot.id);
+    return out;
+}
+
+} // namespace
+
+TEST_CASE(insertReplaceErase) {
+    SlotMap<Item> map;
+    CHECK(map.empty());
+    CHECK(map.get(1) == nullptr);
+    CHECK(map.get(-5) == nullptr);   // 负数转成 size_t 后远超索引范围，同样按不存在处理
+    CHECK(!map.erase(1));
+
+    map.insert(3, item(30));
+    map.insert(1, item(10));
+    CHECK_EQ(map.size(), size_t{2});
+    CHECK(!map.contains(2));
+    REQUIRE(map.get(3) != nullptr);
+    CHECK_EQ(map.get(3)->tag, 30);
+
+    // 替换：不占新槽，持有旧对象的 shared_ptr 不受影响
+    std::shared_ptr<Item> old = map.share(3);
+    map.insert(3, item(31));
+    CHECK_EQ(map.size(), size_t{2});
+    CHECK_EQ(map.get(3)->tag, 31);
+    CHECK_EQ(old->tag, 30);
+    CHECK(idsInSlotOrder(map) == (std::vector<int>{3, 1}));
+
+    CHECK(map.erase(3));
+    CHECK(!map.erase(3));
+    CHECK(map.get(3) == nullptr);
+    CHECK(map.share(3) == nullptr);
+    CHECK_EQ(map.size(), size_t{1});
+    CHECK(idsInSlotOrder(map) == (std::vector<int>{1}));
+}
+
+// 删除空出的槽由下一次插入复用（后删先用），旧ID指向的槽被其他ID占用后仍查不到旧ID
+TEST_CASE(slotReuseAfterErase) {
+    SlotMap<Item> map;
+    for (int id = 1; id <= 5; ++id) map.insert(id, item(id * 10));
+    std::weak_ptr<Item> erased = map.share(2);
+    REQUIRE(map.erase(2));
+    REQUIRE(map.erase(4));
+    CHECK(erased.expired());   // 删除时释放对象
+    CHECK(idsInSlotOrder(map) == (std::vector<int>{1, 3, 5}));
+
+    map.insert(9, item(90));
+    map.insert(8, item(80));
+    CHECK(idsInSlotOrder(map) == (std::vector<int>{1, 8, 3, 9, 5}));
+    CHECK(map.get(2) == nullptr);
+    CHECK(map.get(4) == nullptr);
+    CHECK_EQ(map.get(9)->tag, 90);
+    CHECK_EQ(map.get(8)->tag, 80);
+
+    // 空闲槽用完后追加新槽
+    map.insert(6, item(60));
+    CHECK(idsInSlotOrder(map) == (std::vector<int>{1, 8, 3, 9, 5, 6}));
+
+    // 同一ID删除后重新插入：查到的是新对象
+    REQUIRE(map.erase(3));
+    map.insert(3, item(33));
+    CHECK_EQ(map.get(3)->tag, 33);
+    CHECK_EQ(map.size(), size_t{6});
+}
+
+TEST_CASE(matchesStdMap) {
+    SlotMap<Item> map;
+    std::map<int, int> ref;
+    std::mt19937 rng(7);
+    map.reserve(64, 300);
+    for (int step = 0; step < 100000; ++step) {
+        int id = 1 + static_cast<int>(rng() % 300);
+        switch (rng() % 3) {
+            case 0: {
+                int tag = static_cast<int>(rng() % 1000);
+                map.insert(id, item(tag));
+                ref[id] = tag;
+                break;
+            }
+            case 1:
+                if (!CHECK_EQ(map.erase(id), ref.erase(id) == 1)) return;
+                break;
+            default: {
+                auto it = ref.find(id);
+                Item *v = map.get(id);
+                if (!CHECK_EQ(v != nullptr, it != ref.end())) return;
+                if (v && !CHECK_EQ(v->tag, it->second)) return;
+            }
+        }
+        if (!CHECK_EQ(map.size(), ref.size())) return;
+    }
+    std::map<int, int> listed;
+    for (const auto &slot : map) listed[slot.id] = slot.value->tag;
+    CHECK(listed == ref);
+}
+
+int main() { return labtest::runAll(); }
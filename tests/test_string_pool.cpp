@@ -0,0 +1,108 @@
+// 字符串驻留池：intern 相同内容返回同一份存储、store 不去重，池跨越多个块增长时已返回的视图
+// 地址与内容不变（含超过块大小四分之一单独分配的长串），空串不占存储，以及并发 intern 的去重
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "StringPool.h"
+
+TEST_CASE(internDeduplicates) {
+    StringPool pool;
+    std::string a = "3D打印机 A", b = "3D打印机 A";
+    std::string_view x = pool.intern(a);
+    std::string_view y = pool.intern(b);
+    CHECK(x == a);
+    CHECK(x.data() == y.data());   // 同一份存储，而不只是内容相等
+    CHECK(x.data() != a.data());   // 复制进池，不引用调用方的缓冲区
+    CHECK_EQ(pool.size(), size_t{1});
+    const size_t bytes = pool.bytes();
+    CHECK(pool.intern(std::string_view(a)).data() == x.data());
+    CHECK_EQ(pool.bytes(), bytes);
+
+    std::string_view z = pool.intern("离心机 X");
+    CHECK(z.data() != x.data());
+    CHECK_EQ(pool.size(), size_t{2});
+    // 内容是前缀关系的字符串各自独立
+    std::string_view prefix = pool.intern("3D打印机");
+    CHECK(prefix == "3D打印机");
+    CHECK(prefix.data() != x.data());
+    CHECK_EQ(pool.size(), size_t{3});
+}
+
+TEST_CASE(storeDoesNotDeduplicate) {
+    StringPool pool;
+    std::string_view x = pool.store("student1");
+    std::string_view y = pool.store("student1");
+    CHECK(x == y);
+    CHECK(x.data() != y.data());
+    CHECK_EQ(pool.size(), size_t{0});   // store 不进去重表
+    // store 过的内容 intern 时另存一份
+    std::string_view z = pool.intern("student1");
+    CHECK(z.data() != x.data() && z.data() != y.data());
+    CHECK(pool.intern("student1").data() == z.data());
+}
+
+TEST_CASE(viewsStableAcrossChunks) {
+    StringPool pool(256);
+    std::vector<std::string> expected;
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 5000; ++i) {
+        // 混合短串（切自当前块）与超过块大小四分之一的长串（单独分配）
+        std::string s = i % 50 == 0 ? std::string(100 + i % 7, static_cast<char>('a' + i % 26)) + std::to_string(i)
+                                    : "user" + std::to_string(i);
+        views.push_back(i % 2 ? pool.store(s) : pool.intern(s));
+        expected.push_back(std::move(s));
+    }
+    CHECK(pool.bytes() >= 5000 * 5);
+    CHECK(pool.bytes() / 256 > 50);   // 确实跨越了许多块
+    CHECK_EQ(pool.size(), size_t{2500});
+    for (size_t i = 0; i < views.size(); ++i) {
+        if (!CHECK(views[i] == expected[i])) break;
+    }
+    // 增长之后再 intern：返回最初的那份存储
+    for (size_t i = 0; i < views.size(); i += 2) {
+        if (!CHECK(pool.intern(expected[i]).data() == views[i].data())) break;
+    }
+}
+
+TEST_CASE(emptyStrings) {
+    StringPool pool;
+    CHECK(pool.intern("").empty());
+    CHECK(pool.store("").empty());
+    CHECK(pool.intern(std::string_view()).empty());
+    CHECK_EQ(pool.size(), size_t{0});
+    CHECK_EQ(pool.bytes(), size_t{0});
+    // 空串之后的非空串照常驻留
+    std::string_view x = pool.intern("admin1");
+    CHECK(x == "admin1");
+    CHECK(pool.intern("").empty());
+    CHECK_EQ(pool.size(), size_t{1});
+}
+
+TEST_CASE(concurrentIntern) {
+    StringPool pool(1024);
+    constexpr int kThreads = 4, kKeys = 2000;
+    std::vector<std::vector<std::string_view>> seen(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kKeys; ++i) {
+                int k = (i * 7 + t * 13) % kKeys;   // 各线程以不同顺序驻留同一批名称
+                seen[t].push_back(pool.intern("设备" + std::to_string(k)));
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    CHECK_EQ(pool.size(), static_cast<size_t>(kKeys));
+    for (int i = 0; i < kKeys; ++i) {
+        std::string_view first = pool.intern("设备" + std::to_string(i));
+        for (int t = 0; t < kThreads; ++t) {
+            int at = 0;
+            while ((at * 7 + t * 13) % kKeys != i) ++at;
+            if (!CHECK(seen[t][at].data() == first.data())) return;
+        }
+    }
+}
+
+int main() { return labtest::runAll(); }
@@ -0,0 +1,131 @@
+// 预约提醒与逾期（手动时钟）：同一批到期的定时器按固定顺序处理，开始 / 结束提醒的抑制条件，
+// 延长后按新的结束时间提醒，逾期扣分后重新排下一次（长时间未推进时跳过已经过的周期）
+#include <memory>
+
+#include "Check.h"
+#include "LabManager.h"
+
+namespace {
+
+constexpr std::time_t T0 = 1700000000;
+constexpr int kStudent = 1, kTeacher = 2;
+constexpr int kPrinter = 1, kMicroscope = 2, kCentrifuge = 3;
+
+struct Fixture {
+    LabManager mgr;
+    std::shared_ptr<ManualClock> clock = std::make_shared<ManualClock>(T0);
+
+    Fixture() {
+        mgr.clock = clock;
+        mgr.passwordParams = ScryptParams{4, 1, 1};
+        mgr.seed();
+        mgr.advanceTimers(T0);   // 与服务端一样，时间轮先推进到当前时刻
+    }
+    int credit(int userId) { return mgr.getUser(userId)->creditScore; }
+    // 自 from 起新增的通知
+    std::vector<LabManager::Notification> since(size_t from) const {
+        return std::vector<LabManager::Notification>(mgr.notifications.begin() + from, mgr.notifications.end());
+    }
+    bool mentions(const LabManager::Notification &n, const char *text) const {
+        return n.message.find(text) != std::string::npos;
+    }
+};
+
+} // namespace
+
+TEST_CASE(remindersFireInOrder) {
+    Fixture f;
+    REQUIRE(f.mgr.reserve(kStudent, kCentrifuge, T0 + 1800, T0 + 5400));
+    REQUIRE(f.mgr.reserve(kTeacher, kMicroscope, T0 + 1800, T0 + 5400));
+    REQUIRE(f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));
+    // nextTimerDue 按时间轮的槽取整，只保证不晚于真正的到期时刻
+    CHECK(f.mgr.nextTimerDue() <= T0 + 1800 - LabManager::kReminderLead);
+
+    // 同一时刻到期的两个开始提醒按设备ID处理，与预约先后无关
+    size_t mark = f.mgr.notifications.size();
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 1500), size_t{2});
+    auto fired = f.since(mark);
+    REQUIRE(fired.size() == 2);
+    CHECK_EQ(fired[0].userId, kTeacher);
+    CHECK(f.mentions(fired[0], "电子显微镜"));
+    CHECK_EQ(fired[1].userId, kStudent);
+    CHECK(f.mentions(fired[1], "离心机 X"));
+    CHECK(f.mentions(fired[1], "即将开始"));
+    CHECK_EQ(fired[1].createdAt, T0 + 1500);
+
+    f.clock->set(T0 + 1800);
+    REQUIRE(f.mgr.borrow(kTeacher, kMicroscope, f.clock->now()));
+
+    // 打印机的开始提醒在 T0+3000；显微镜已借出，结束前提醒在 T0+4800；离心机未借出，不提醒归还
+    mark = f.mgr.notifications.size();
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 3000), size_t{1});
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 5000), size_t{1});
+    fired = f.since(mark);
+    REQUIRE(fired.size() == 2);
+    CHECK_EQ(fired[0].userId, kStudent);
+    CHECK(f.mentions(fired[0], "3D打印机 A"));
+    CHECK_EQ(fired[1].userId, kTeacher);
+    CHECK(f.mentions(fired[1], "即将到期"));
+}
+
+TEST_CASE(remindersSuppressed) {
+    Fixture f;
+    REQUIRE(f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));
+    REQUIRE(f.mgr.reserve(kStudent, kCentrifuge, T0 + 3600, T0 + 7200));
+
+    // 一次推进越过开始时间：开始提醒不再发出
+    f.clock->set(T0 + 3700);
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 3700), size_t{0});
+    REQUIRE(f.mgr.borrow(kStudent, kPrinter, f.clock->now()));
+
+    // 延长后旧的结束提醒作废，按新的结束时间提醒
+    REQUIRE(f.mgr.extend(kStudent, kPrinter, T0 + 9000));
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 6800), size_t{0});
+    size_t mark = f.mgr.notifications.size();
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 8500), size_t{1});
+    auto fired = f.since(mark);
+    REQUIRE(fired.size() == 1);
+    CHECK(f.mentions(fired[0], "3D打印机 A"));
+    CHECK(f.mentions(fired[0], "即将到期"));
+
+    // 未借出的离心机到了逾期时刻也不扣分（由压缩按爽约处理）
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 7200 + LabManager::kOverdueInterval), size_t{0});
+    CHECK_EQ(f.credit(kStudent), 100);
+}
+
+TEST_CASE(overdueRearms) {
+    Fixture f;
+    REQUIRE(f.mgr.reserve(kStudent, kPrinter, T0 + 3600, T0 + 7200));
+    f.clock->set(T0 + 3600);
+    REQUIRE(f.mgr.borrow(kStudent, kPrinter, f.clock->now()));
+    CHECK_EQ(f.mgr.advanceTimers(T0 + 7000), size_t{1});   // 结束前提醒
+
+    // 结束后满一个周期扣分，之后每个周期再扣一次
+    const std::time_t first = T0 + 7200 + LabManager::kOverdueInterval;
+    CHECK_EQ(f.mgr.advanceTimers(first - 1), size_t{0});
+    CHECK_EQ(f.mgr.advanceTimers(first), size_t{1});
+    CHECK_EQ(f.credit(kStudent), 100 - LabManager::kOverduePenalty);
+    CHECK(f.mentions(f.mgr.notifications.back(), "已逾期"));
+    CHECK_EQ(f.mgr.advanceTimers(first + LabManager::kOverdueInterval - 1), size_t{0});
+    CHECK_EQ(f.mgr.advanceTimers(first + LabManager::kOverdueInterval), size_t{1});
+    CHECK_EQ(f.credit(kStudent), 100 - 2 * LabManager::kOverduePenalty);
+
+    // 长时间未推进：只扣一次，下一次排在推进时刻之后的第一个整周期
+    const std::time_t late = first + 6 * LabManager::kOverdueInterval + 100;
+    CHECK_EQ(f.mgr.advanceTimers(late), size_t{1});
+    CHECK_EQ(f.credit(kStudent), 100 - 3 * LabManager::kOverduePenalty);
+    CHECK_EQ(f.mgr.advanceTimers(first + 7 * LabManager::kOverdueInterval - 1), size_t{0});
+    CHECK_EQ(f.mgr.advanceTimers(first + 7 * LabManager::kOverdueInterval), size_t{1});
+    CHECK_EQ(f.credit(kStudent), 100 - 4 * LabManager::kOverduePenalty);
+
+    // 归还后不再扣分
+    f.clock->set(first + 7 * LabManager::kOverdueInterval + 10);
+    REQUIRE(f.mgr.returnDevice(kStudent, kPrinter, f.clock->now()));
+    int afterReturn = f.credit(kStudent);
+    size_t mark = f.mgr.notifications.size();
+    CHECK_EQ(f.mgr.advanceTimers(first + 10 * LabManager::kOverdueInterval), size_t{0});
+    CHECK_EQ(f.credit(kStudent), afterReturn);
+    CHECK_EQ(f.mgr.notifications.size(), mark);
+}
+
+int main() { return labtest::runAll(); }